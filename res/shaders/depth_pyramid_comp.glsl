@@ -0,0 +1,33 @@
+#version 450
+
+#define WORKGROUP_SIZE 8 // match VulkanDepthPyramid
+
+layout(local_size_x = WORKGROUP_SIZE, local_size_y = WORKGROUP_SIZE) in;
+
+layout(set = 0, binding = 0) uniform sampler2D src_level; // the depth buffer for level 0, the level below otherwise
+layout(set = 0, binding = 1, r32f) uniform writeonly image2D dst_level;
+
+// one invocation per texel of the level: the farthest depth of the 2x2 texels below it, the last texel of an odd row or column takes
+// in the one left over as well, so every texel of the level below is covered
+void main() {
+    ivec2 dst_size = imageSize(dst_level);
+    ivec2 dst_texel = ivec2(gl_GlobalInvocationID.xy);
+
+    if (any(greaterThanEqual(dst_texel, dst_size))) {
+        return;
+    }
+
+    ivec2 src_size = textureSize(src_level, 0);
+    ivec2 src_first = min(dst_texel * 2, src_size - 1);
+    ivec2 src_last = mix(min(dst_texel * 2 + 1, src_size - 1), src_size - 1, equal(dst_texel, dst_size - 1));
+
+    float depth = 0.0;
+
+    for (int y = src_first.y; y <= src_last.y; y++) {
+        for (int x = src_first.x; x <= src_last.x; x++) {
+            depth = max(depth, texelFetch(src_level, ivec2(x, y), 0).r);
+        }
+    }
+
+    imageStore(dst_level, dst_texel, vec4(depth));
+}
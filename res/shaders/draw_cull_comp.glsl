@@ -0,0 +1,245 @@
+#version 450
+#extension GL_EXT_buffer_reference : require
+#extension GL_EXT_buffer_reference2 : require
+
+#define CULL_FLAGS_FRUSTUM 1u
+#define CULL_FLAGS_COMPACT 2u
+#define CULL_FLAGS_COMMANDS 4u
+#define CULL_FLAGS_EARLY 8u
+#define CULL_FLAGS_OCCLUSION 16u
+
+// match ShaderStructures::CullStatistics
+#define STAT_FRUSTUM_CULLED_INSTANCES 0
+#define STAT_FRUSTUM_CULLED_TRIANGLES 1
+#define STAT_OCCLUSION_CULLED_INSTANCES 2
+#define STAT_OCCLUSION_CULLED_TRIANGLES 3
+#define STAT_DRAWN_INSTANCES 4
+#define STAT_DRAWN_TRIANGLES 5
+#define STAT_DRAWN_COMMANDS 6
+#define STAT_COUNT 7
+
+layout(local_size_x = 64) in;
+
+layout(set = 0, binding = 0) uniform sampler2D depth_pyramid; // farthest depth, see VulkanDepthPyramid
+
+struct DrawCullData {
+    uint first_index;
+    uint index_count;
+    uint first_instance;
+    uint batch;
+    uint batch_first_draw;
+};
+
+struct InstanceCullData {
+    vec4 ws_bounds_min; // w set to 1 for instances that are never culled
+    vec4 ws_bounds_max;
+    uint draw;
+    uint matrix;
+};
+
+struct DrawIndexedIndirectCommand {
+    uint index_count;
+    uint instance_count;
+    uint first_index;
+    int vertex_offset;
+    uint first_instance;
+};
+
+layout(buffer_reference, std430) readonly buffer CullDataBuffer { DrawCullData data[]; };
+layout(buffer_reference, std430) readonly buffer InstanceCullDataBuffer { InstanceCullData data[]; };
+layout(buffer_reference, std430) buffer InstanceCountsBuffer { uint data[]; };
+layout(buffer_reference, std430) writeonly buffer VisibleInstancesBuffer { uvec2 data[]; }; // matrix and draw index
+layout(buffer_reference, std430) writeonly buffer CommandsBuffer { DrawIndexedIndirectCommand data[]; };
+layout(buffer_reference, std430) buffer DrawCountsBuffer { uint data[]; };
+layout(buffer_reference, std430) buffer InstanceVisibilityBuffer { uint data[]; };
+layout(buffer_reference, std430) buffer StatisticsBuffer { uint data[STAT_COUNT]; };
+
+layout(buffer_reference, std430) readonly buffer CameraBuffer {
+    mat4 view_mat;
+    mat4 view_proj_mat;
+    vec4 ws_pos;
+};
+
+layout(push_constant) uniform PushConstants {
+    CameraBuffer cam_buf;
+    CullDataBuffer cull_buf;
+    InstanceCullDataBuffer instance_cull_buf;
+    InstanceCountsBuffer instance_counts_buf;
+    VisibleInstancesBuffer visible_instances_buf;
+    CommandsBuffer cmd_buf;
+    DrawCountsBuffer draw_counts_buf;
+    InstanceVisibilityBuffer instance_visibility_buf; // whether the instance passed the occlusion test of the previous frame
+    StatisticsBuffer statistics_buf;
+    uvec2 depth_extent;
+    uint depth_pyramid_levels;
+    uint draw_count;
+    uint instance_count;
+    uint flags;
+} pc;
+
+shared uint statistics[STAT_COUNT]; // summed per workgroup, so only a few invocations touch the global counters
+
+// planes of the clip volume (-w <= x, y <= w, 0 <= z <= w), pointing inwards
+bool is_visible(in vec3 ws_min, in vec3 ws_max) {
+    mat4 m = transpose(pc.cam_buf.view_proj_mat); // rows of the matrix
+
+    vec4 planes[6] = vec4[6](m[3] + m[0], m[3] - m[0], m[3] + m[1], m[3] - m[1], m[2], m[3] - m[2]);
+
+    for (int i = 0; i < 6; i++) {
+        // the corner furthest along the plane normal, if it is behind the plane the whole box is
+        vec3 ws_corner = mix(ws_min, ws_max, greaterThanEqual(planes[i].xyz, vec3(0.0)));
+
+        if (dot(planes[i].xyz, ws_corner) + planes[i].w < 0.0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// the box is hidden when its nearest depth is behind the farthest depth of the pyramid texels covering its screen rectangle,
+// the level is chosen so that the rectangle covers at most 2x2 of them
+bool is_occluded(in vec3 ws_min, in vec3 ws_max) {
+    vec2 ndc_min = vec2(1.0);
+    vec2 ndc_max = vec2(-1.0);
+    float nearest = 1.0;
+
+    for (int i = 0; i < 8; i++) {
+        vec3 ws_corner = mix(ws_min, ws_max, bvec3((i & 1) != 0, (i & 2) != 0, (i & 4) != 0));
+        vec4 cs_corner = pc.cam_buf.view_proj_mat * vec4(ws_corner, 1.0);
+
+        // boxes reaching in front of the near plane cannot be projected, they are kept
+        if (cs_corner.z < 0.0) {
+            return false;
+        }
+
+        vec3 ndc_corner = cs_corner.xyz / cs_corner.w;
+
+        ndc_min = min(ndc_min, ndc_corner.xy);
+        ndc_max = max(ndc_max, ndc_corner.xy);
+        nearest = min(nearest, ndc_corner.z);
+    }
+
+    ivec2 max_pixel = ivec2(pc.depth_extent) - 1;
+    ivec2 min_pixel = clamp(ivec2(floor((ndc_min * 0.5 + 0.5) * vec2(pc.depth_extent))), ivec2(0), max_pixel);
+    ivec2 last_pixel = clamp(ivec2(floor((ndc_max * 0.5 + 0.5) * vec2(pc.depth_extent))), ivec2(0), max_pixel);
+
+    // a texel of level n covers 2^(n+1) pixels, the last texel of a level the remaining ones as well
+    uint size = uint(max(last_pixel.x - min_pixel.x, last_pixel.y - min_pixel.y)) + 1u;
+    int level = size > 1u ? findMSB(size - 1u) : 0;
+    level = min(level, int(pc.depth_pyramid_levels) - 1);
+
+    ivec2 max_texel = textureSize(depth_pyramid, level) - 1;
+    ivec2 min_texel = min(min_pixel >> (level + 1), max_texel);
+    ivec2 last_texel = min(last_pixel >> (level + 1), max_texel);
+
+    float farthest = max(
+        max(texelFetch(depth_pyramid, min_texel, level).r, texelFetch(depth_pyramid, ivec2(last_texel.x, min_texel.y), level).r),
+        max(texelFetch(depth_pyramid, ivec2(min_texel.x, last_texel.y), level).r, texelFetch(depth_pyramid, last_texel, level).r)
+    );
+
+    return nearest > farthest;
+}
+
+// first dispatch, one invocation per instance: visible instances are appended to the range of their draw
+// with occlusion culling the frame is drawn twice: the early pass keeps the instances visible in the previous frame, the late pass tests
+// the others against the depth the early pass left in the pyramid, and records the visibility of all of them for the next frame
+void cull_instance(uint instance_index) {
+    if (instance_index >= pc.instance_count) {
+        return;
+    }
+
+    InstanceCullData instance = pc.instance_cull_buf.data[instance_index];
+
+    uint triangles = pc.cull_buf.data[instance.draw].index_count / 3u;
+    bool bounded = instance.ws_bounds_min.w == 0.0;
+
+    bool visible = (pc.flags & CULL_FLAGS_FRUSTUM) == 0u || !bounded || is_visible(instance.ws_bounds_min.xyz, instance.ws_bounds_max.xyz);
+    bool previously_visible = (pc.flags & (CULL_FLAGS_EARLY | CULL_FLAGS_OCCLUSION)) != 0u && pc.instance_visibility_buf.data[instance_index] != 0u;
+
+    if ((pc.flags & CULL_FLAGS_EARLY) != 0u) {
+        visible = visible && previously_visible; // everything else is counted by the late pass
+    } else if ((pc.flags & CULL_FLAGS_OCCLUSION) != 0u) {
+        bool occluded = visible && bounded && is_occluded(instance.ws_bounds_min.xyz, instance.ws_bounds_max.xyz);
+
+        pc.instance_visibility_buf.data[instance_index] = (visible && !occluded) ? 1u : 0u;
+
+        if (visible && previously_visible) {
+            return; // already drawn and counted by the early pass
+        }
+
+        if (occluded) {
+            atomicAdd(statistics[STAT_OCCLUSION_CULLED_INSTANCES], 1u);
+            atomicAdd(statistics[STAT_OCCLUSION_CULLED_TRIANGLES], triangles);
+
+            return;
+        }
+    }
+
+    if (!visible) {
+        if ((pc.flags & CULL_FLAGS_EARLY) == 0u) {
+            atomicAdd(statistics[STAT_FRUSTUM_CULLED_INSTANCES], 1u);
+            atomicAdd(statistics[STAT_FRUSTUM_CULLED_TRIANGLES], triangles);
+        }
+
+        return;
+    }
+
+    atomicAdd(statistics[STAT_DRAWN_INSTANCES], 1u);
+    atomicAdd(statistics[STAT_DRAWN_TRIANGLES], triangles);
+
+    uint slot = atomicAdd(pc.instance_counts_buf.data[instance.draw], 1u);
+
+    pc.visible_instances_buf.data[pc.cull_buf.data[instance.draw].first_instance + slot] = uvec2(instance.matrix, instance.draw);
+}
+
+// second dispatch, one invocation per draw: draws all of its visible instances
+void write_command(uint draw_index) {
+    if (draw_index >= pc.draw_count) {
+        return;
+    }
+
+    DrawCullData draw = pc.cull_buf.data[draw_index];
+
+    uint instance_count = pc.instance_counts_buf.data[draw_index];
+
+    if (instance_count != 0u) {
+        atomicAdd(statistics[STAT_DRAWN_COMMANDS], 1u);
+    }
+
+    uint command_index = draw_index;
+
+    if ((pc.flags & CULL_FLAGS_COMPACT) != 0u) {
+        if (instance_count == 0u) {
+            return;
+        }
+
+        command_index = draw.batch_first_draw + atomicAdd(pc.draw_counts_buf.data[draw.batch], 1u);
+    }
+
+    pc.cmd_buf.data[command_index].index_count = draw.index_count;
+    pc.cmd_buf.data[command_index].instance_count = instance_count;
+    pc.cmd_buf.data[command_index].first_index = draw.first_index;
+    pc.cmd_buf.data[command_index].vertex_offset = 0;
+    pc.cmd_buf.data[command_index].first_instance = draw.first_instance; // the vertex shader looks up the visible instances from here
+}
+
+void main() {
+    if (gl_LocalInvocationIndex < STAT_COUNT) {
+        statistics[gl_LocalInvocationIndex] = 0u;
+    }
+
+    barrier();
+
+    if ((pc.flags & CULL_FLAGS_COMMANDS) != 0u) {
+        write_command(gl_GlobalInvocationID.x);
+    } else {
+        cull_instance(gl_GlobalInvocationID.x);
+    }
+
+    barrier();
+
+    if (gl_LocalInvocationIndex < STAT_COUNT && statistics[gl_LocalInvocationIndex] != 0u) {
+        atomicAdd(pc.statistics_buf.data[gl_LocalInvocationIndex], statistics[gl_LocalInvocationIndex]);
+    }
+}
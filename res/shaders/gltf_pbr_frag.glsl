@@ -1,37 +1,71 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
+#extension GL_EXT_buffer_reference : require
+#extension GL_EXT_buffer_reference2 : require
 
 #define PI 3.1415926538
 
+// match VulkanLightClustering
+#define CLUSTER_COUNT_X 16u
+#define CLUSTER_COUNT_Y 9u
+#define CLUSTER_COUNT_Z 24u
+#define MAX_CLUSTER_LIGHTS 127u
+
+#define MATERIAL_FLAG_NORMAL_XY 1u // block compressed normal textures only store X and Y
+
+// textures the material has, missing ones are not sampled at all
+#define FEATURE_BASE_COLOR_TEXTURE 1u
+#define FEATURE_NORMAL_TEXTURE 2u
+#define FEATURE_METALLIC_ROUGHNESS_TEXTURE 4u
+#define FEATURE_OCCLUSION_TEXTURE 8u
+#define FEATURE_EMISSIVE_TEXTURE 16u
+
+// specialization constants, set per pipeline permutation (see GLTFPBRMaterial), the defaults enable everything
+layout(constant_id = 0) const uint FEATURES = 0xFFFFFFFFu;
+
+struct Light {
+    vec4 ws_pos; // w is the range
+    vec4 flux;
+};
+
+layout(buffer_reference, std430) readonly buffer LightsBuffer { Light data[]; };
+layout(buffer_reference, std430) readonly buffer ClusterLightsBuffer { uint data[]; }; // per cluster the light count followed by MAX_CLUSTER_LIGHTS indices
+
 layout(set = 1, binding = 0) uniform LightParameters {
-    vec4 ws_pos_0;
-    vec4 flux_0;
-    vec4 ws_pos_1;
-    vec4 flux_1;
-    vec4 ws_pos_2;
-    vec4 flux_2;
     vec4 ambient;
+    LightsBuffer lights_buf;
+    ClusterLightsBuffer cluster_lights_buf; // written by the clustering pass of this frame
+    vec4 cluster_params; // x and y scale fragment coordinates to tiles, z and w scale and bias the log of the view depth to slices
 } light_params_buf;
 
-layout(set = 2, binding = 0) uniform MaterialUniformParameters {
+struct MaterialParameters {
     vec4 base_col_factor;
     vec4 roughness_metallic_normal_factor;
     vec4 emissive_factor;
+    uint base_col_tx; // indices into the texture array
+    uint normal_tx;
+    uint metal_rough_tx;
+    uint occlusion_tx;
+    uint emissive_tx;
+    uint flags;
+};
+
+// parameters and textures of all materials, selected with the material index of the draw
+layout(set = 2, binding = 0) readonly buffer MaterialParametersBuffer {
+    MaterialParameters data[];
 } mat_param_buf;
 
-layout(set = 2, binding = 1) uniform sampler2D base_col_tx;
-layout(set = 2, binding = 2) uniform sampler2D normal_tx;
-layout(set = 2, binding = 3) uniform sampler2D metal_rough_tx;
-layout(set = 2, binding = 4) uniform sampler2D occlusion_tx;
-layout(set = 2, binding = 5) uniform sampler2D emissive_tx;
+layout(set = 2, binding = 1) uniform sampler2D textures[];
 
 layout(location = 0) in vec4 col_0;
 layout(location = 1) in vec2 uv_0;
-layout(location = 2) in vec3 ts_Ng;
-layout(location = 3) in vec3 ts_P;
-layout(location = 4) in vec3 ts_cam_pos;
-layout(location = 5) in vec3 ts_light_pos_0;
-layout(location = 6) in vec3 ts_light_pos_1;
-layout(location = 7) in vec3 ts_light_pos_2;
+layout(location = 2) in vec3 ws_Ng;
+layout(location = 3) in vec3 ws_T;
+layout(location = 4) in vec3 ws_B;
+layout(location = 5) in vec3 ws_P;
+layout(location = 6) in vec3 ws_V_unnormalized;
+layout(location = 7) in float vs_depth;
+layout(location = 8) flat in uint material;
 
 layout(location = 0) out vec4 out_col;
 
@@ -76,86 +110,98 @@ vec3 brdf_d_lambert(in vec3 base_col) {
     return base_col / PI;
 }
 
+// smooth falloff to zero at the range of the light, so lights can be left out of clusters beyond it
+float range_window(in float light_distance, in float range) {
+    float ratio = light_distance / range;
+    float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+
+    return window * window;
+}
+
+uint cluster_index() {
+    uvec2 tile = min(uvec2(gl_FragCoord.xy * light_params_buf.cluster_params.xy), uvec2(CLUSTER_COUNT_X - 1u, CLUSTER_COUNT_Y - 1u));
+    uint slice = uint(clamp(log(max(vs_depth, 1e-6)) * light_params_buf.cluster_params.z + light_params_buf.cluster_params.w, 0.0, float(CLUSTER_COUNT_Z - 1u)));
+
+    return tile.x + (tile.y + slice * CLUSTER_COUNT_Y) * CLUSTER_COUNT_X;
+}
+
 void main() {
-    vec3 ts_N = vec3(0.0);
+    MaterialParameters mat_params = mat_param_buf.data[material];
 
-    if (mat_param_buf.roughness_metallic_normal_factor.r == 0.0)
-    {
-        ts_N = normalize(texture(normal_tx, uv_0).rgb * 2.0 - 1.0);
-    }
-    else
-    {
-        ts_N = ts_Ng;
-    }
+    vec3 ts_N = vec3(0.0, 0.0, 1.0);
 
-    vec3 xrm = texture(metal_rough_tx, uv_0).rgb;
-    float occlusion_factor = texture(occlusion_tx, uv_0).r;
-    vec3 emissive_col = texture(emissive_tx, uv_0).rgb * mat_param_buf.emissive_factor.rgb;
+    // neighbouring fragments can belong to different draws, so the texture indices are not dynamically uniform
+    if ((FEATURES & FEATURE_NORMAL_TEXTURE) != 0u) {
+        ts_N = texture(textures[nonuniformEXT(mat_params.normal_tx)], uv_0).rgb * 2.0 - 1.0;
 
-    vec3 light_col_0 = light_params_buf.flux_0.rgb * light_params_buf.flux_0.w;
-    float light_distance_0 = length(ts_light_pos_0 - ts_P);
-    vec3 radiance_0 = light_col_0 / (light_distance_0 * light_distance_0 + 0.001);
+        if ((mat_params.flags & MATERIAL_FLAG_NORMAL_XY) != 0u) {
+            ts_N.z = sqrt(max(1.0 - dot(ts_N.xy, ts_N.xy), 0.0));
+        }
 
-    vec3 light_col_1 = light_params_buf.flux_1.rgb * light_params_buf.flux_1.w;
-    float light_distance_1 = length(ts_light_pos_1 - ts_P);
-    vec3 radiance_1 = light_col_1 / (light_distance_1 * light_distance_1 + 0.001);
+        ts_N = normalize(ts_N);
+    }
 
-    vec3 light_col_2 = light_params_buf.flux_2.rgb * light_params_buf.flux_2.w;
-    float light_distance_2 = length(ts_light_pos_2 - ts_P);
-    vec3 radiance_2 = light_col_2 / (light_distance_2 * light_distance_2 + 0.001);
+    vec3 xrm = vec3(1.0);
+    float occlusion_factor = 1.0;
+    vec3 base_col = mat_params.base_col_factor.rgb;
 
-    vec3 ts_V = normalize(ts_cam_pos - ts_P);
+    if ((FEATURES & FEATURE_METALLIC_ROUGHNESS_TEXTURE) != 0u) {
+        xrm = texture(textures[nonuniformEXT(mat_params.metal_rough_tx)], uv_0).rgb;
+    }
 
-    vec3 ts_L_0 = normalize(ts_light_pos_0 - ts_P);
-    vec3 ts_H_0 = normalize(ts_L_0 + ts_V);
+    if ((FEATURES & FEATURE_OCCLUSION_TEXTURE) != 0u) {
+        occlusion_factor = texture(textures[nonuniformEXT(mat_params.occlusion_tx)], uv_0).r;
+    }
 
-    vec3 ts_L_1 = normalize(ts_light_pos_1 - ts_P);
-    vec3 ts_H_1 = normalize(ts_L_1 + ts_V);
+    if ((FEATURES & FEATURE_BASE_COLOR_TEXTURE) != 0u) {
+        base_col *= texture(textures[nonuniformEXT(mat_params.base_col_tx)], uv_0).rgb;
+    }
 
-    vec3 ts_L_2 = normalize(ts_light_pos_2 - ts_P);
-    vec3 ts_H_2 = normalize(ts_L_2 + ts_V);
+    float roughness = xrm.g * mat_params.roughness_metallic_normal_factor.g;
+    float metalness = xrm.b * mat_params.roughness_metallic_normal_factor.b;
 
-    float roughness = xrm.g * mat_param_buf.roughness_metallic_normal_factor.g;
-    float metalness = xrm.b * mat_param_buf.roughness_metallic_normal_factor.b;
-    vec3 base_col = vec3(texture(base_col_tx, uv_0)) * mat_param_buf.base_col_factor.rgb;
+    vec3 ws_N = normalize(mat3(normalize(ws_T), normalize(ws_B), normalize(ws_Ng)) * ts_N);
+    vec3 ws_V = normalize(ws_V_unnormalized);
 
     vec3 ambient_factor = light_params_buf.ambient.rgb * light_params_buf.ambient.w * (occlusion_factor);
 
     vec3 diffuse = brdf_d_lambert(base_col);
 
-    vec3 specular_0 = brdf_s_cook_torrance(ts_L_0, ts_V, ts_N, ts_H_0, roughness * roughness);
-    vec3 specular_1 = brdf_s_cook_torrance(ts_L_1, ts_V, ts_N, ts_H_1, roughness * roughness);
-    vec3 specular_2 = brdf_s_cook_torrance(ts_L_2, ts_V, ts_N, ts_H_2, roughness * roughness);
+    out_col = vec4(ambient_factor * base_col, 1.0);
+
+    // only the lights reaching the cluster of the fragment are shaded
+    uint first_slot = cluster_index() * (MAX_CLUSTER_LIGHTS + 1u);
+    uint light_count = light_params_buf.cluster_lights_buf.data[first_slot];
 
-    float f_s_dielectric_0 = f_schlick_dielectric(ts_H_0, ts_V, 0.04);
-    float f_d_dielectric_0 = 1 - f_s_dielectric_0;
-    vec3 f_s_metallic_0 = f_schlick_metal(ts_H_0, ts_V, base_col);
+    for (uint i = 0u; i < light_count; i++) {
+        Light light = light_params_buf.lights_buf.data[light_params_buf.cluster_lights_buf.data[first_slot + 1u + i]];
 
-    float f_s_dielectric_1 = f_schlick_dielectric(ts_H_1, ts_V, 0.04);
-    float f_d_dielectric_1 = 1 - f_s_dielectric_1;
-    vec3 f_s_metallic_1 = f_schlick_metal(ts_H_1, ts_V, base_col);
+        vec3 light_col = light.flux.rgb * light.flux.w;
+        float light_distance = length(light.ws_pos.xyz - ws_P);
+        vec3 radiance = light_col * range_window(light_distance, light.ws_pos.w) / (light_distance * light_distance + 0.001);
 
-    float f_s_dielectric_2 = f_schlick_dielectric(ts_H_2, ts_V, 0.04);
-    float f_d_dielectric_2 = 1 - f_s_dielectric_2;
-    vec3 f_s_metallic_2 = f_schlick_metal(ts_H_2, ts_V, base_col);
+        vec3 ws_L = normalize(light.ws_pos.xyz - ws_P);
+        vec3 ws_H = normalize(ws_L + ws_V);
 
-    vec3 col_dielectric_0 = f_d_dielectric_0 * diffuse + f_s_dielectric_0 * specular_0;
-    vec3 col_metallic_0 = f_s_metallic_0 * specular_0;
+        vec3 specular = brdf_s_cook_torrance(ws_L, ws_V, ws_N, ws_H, roughness * roughness);
 
-    vec3 col_dielectric_1 = f_d_dielectric_1 * diffuse + f_s_dielectric_1 * specular_1;
-    vec3 col_metallic_1 = f_s_metallic_1 * specular_1;
+        float f_s_dielectric = f_schlick_dielectric(ws_H, ws_V, 0.04);
+        float f_d_dielectric = 1 - f_s_dielectric;
+        vec3 f_s_metallic = f_schlick_metal(ws_H, ws_V, base_col);
 
-    vec3 col_dielectric_2 = f_d_dielectric_2 * diffuse + f_s_dielectric_2 * specular_2;
-    vec3 col_metallic_2 = f_s_metallic_2 * specular_2;
+        vec3 col_dielectric = f_d_dielectric * diffuse + f_s_dielectric * specular;
+        vec3 col_metallic = f_s_metallic * specular;
 
-    vec3 final_col_0 = mix(col_dielectric_0, col_metallic_0, metalness);
-    vec3 final_col_1 = mix(col_dielectric_1, col_metallic_1, metalness);
-    vec3 final_col_2 = mix(col_dielectric_2, col_metallic_2, metalness);
+        vec3 final_col = mix(col_dielectric, col_metallic, metalness);
+
+        out_col = out_col + vec4(final_col * radiance * max(dot(ws_N, ws_L), 0.0), 0.0);
+    }
+
+    // glTF materials without an emissive texture do not emit here, matching the black default texture
+    if ((FEATURES & FEATURE_EMISSIVE_TEXTURE) != 0u) {
+        vec3 emissive_col = texture(textures[nonuniformEXT(mat_params.emissive_tx)], uv_0).rgb * mat_params.emissive_factor.rgb;
+        out_col = max(out_col, vec4(emissive_col, 1.0));
+    }
 
-    out_col = vec4(ambient_factor * base_col, 1.0);
-    out_col = out_col + vec4(final_col_0 * radiance_0 * max(dot(ts_N, ts_L_0), 0.0), 0.0);
-    out_col = out_col + vec4(final_col_1 * radiance_1 * max(dot(ts_N, ts_L_1), 0.0), 0.0);
-    out_col = out_col + vec4(final_col_2 * radiance_2 * max(dot(ts_N, ts_L_2), 0.0), 0.0);
-    out_col = max(out_col, vec4(emissive_col, 1.0));
     out_col = out_col * col_0;
 }
@@ -3,22 +3,17 @@
 #extension GL_EXT_buffer_reference2 : require
 #extension GL_EXT_buffer_reference_uvec2 : require
 
+#define FEATURE_VERTEX_COLORS 32u
+
+// specialization constants, set per pipeline permutation (see GLTFPBRMaterial), the defaults enable everything
+layout(constant_id = 0) const uint FEATURES = 0xFFFFFFFFu;
+
 layout(set = 0, binding = 0) uniform CameraMatrices {
     mat4 view_mat;
     mat4 view_proj_mat;
     vec4 ws_pos;
 } cam_mats_buf;
 
-layout(set = 1, binding = 0) uniform LightParameters {
-    vec4 ws_pos_0;
-    vec4 flux_0;
-    vec4 ws_pos_1;
-    vec4 flux_1;
-    vec4 ws_pos_2;
-    vec4 flux_2;
-    vec4 ambient;
-} light_params_buf;
-
 layout(buffer_reference, std430) readonly buffer PositionsBuffer { float data[]; }; // vec3s as float array
 layout(buffer_reference, std430) readonly buffer NormalsBuffer { float data[]; }; // vec3s as float array
 layout(buffer_reference, std430) readonly buffer TangentsBuffer { float data[]; }; // vec4s as float array
@@ -27,55 +22,71 @@ layout(buffer_reference, std430) readonly buffer Colors_0Buffer { float data[];
 layout(buffer_reference, std430) readonly buffer ModelMatrix { mat4 data[]; };
 layout(buffer_reference, std430) readonly buffer NormalMatrix { mat4 data[]; };
 
-layout(push_constant) uniform PushConstants {
+struct DrawData {
     PositionsBuffer P_buf;
     NormalsBuffer N_buf;
     TangentsBuffer T_buf;
     Texcoords_0Buffer uv0_buf;
     Colors_0Buffer col0_buf;
+    uint material; // index into the material parameters
+    uint padding;
+};
+
+layout(buffer_reference, std430) readonly buffer DrawDataBuffer { DrawData data[]; };
+layout(buffer_reference, std430) readonly buffer VisibleInstancesBuffer { uvec2 data[]; }; // matrix and draw index
+
+layout(push_constant) uniform PushConstants {
+    DrawDataBuffer draw_data_buf;
+    VisibleInstancesBuffer visible_instances_buf; // indexed with the instance index, written by the culling pass
     ModelMatrix model_mat_buf;
     NormalMatrix normal_mat_buf;
-} pc;
+} push;
 
 layout(location = 0) out vec4 out_col_0;
 layout(location = 1) out vec2 out_uv_0;
-layout(location = 2) out vec3 out_ts_Ng;
+layout(location = 2) out vec3 out_ws_Ng;
+layout(location = 3) out vec3 out_ws_T;
+layout(location = 4) out vec3 out_ws_B;
 
-layout(location = 3) out vec3 out_ts_P;
-layout(location = 4) out vec3 out_ts_cam_pos;
-layout(location = 5) out vec3 out_ts_light_pos_0;
-layout(location = 6) out vec3 out_ts_light_pos_1;
-layout(location = 7) out vec3 out_ts_light_pos_2;
+layout(location = 5) out vec3 out_ws_P;
+layout(location = 6) out vec3 out_ws_V; // towards the camera, not normalized so it interpolates linearly
+layout(location = 7) out float out_vs_depth; // selects the depth slice of the light clusters
+layout(location = 8) flat out uint out_material;
 
 void main() {
-    vec3 ms_P = vec3(pc.P_buf.data[gl_VertexIndex * 3 + 0], pc.P_buf.data[gl_VertexIndex * 3 + 1], pc.P_buf.data[gl_VertexIndex * 3 + 2]);
+    uvec2 instance = push.visible_instances_buf.data[gl_InstanceIndex];
+
+    DrawData draw = push.draw_data_buf.data[instance.y];
+    mat4 model_mat = push.model_mat_buf.data[instance.x];
 
-    gl_Position = cam_mats_buf.view_proj_mat * pc.model_mat_buf.data[0] * vec4(ms_P, 1.0);
+    vec3 ms_P = vec3(draw.P_buf.data[gl_VertexIndex * 3 + 0], draw.P_buf.data[gl_VertexIndex * 3 + 1], draw.P_buf.data[gl_VertexIndex * 3 + 2]);
+    vec4 ws_P = model_mat * vec4(ms_P, 1.0);
 
-    out_uv_0 = vec2(pc.uv0_buf.data[gl_VertexIndex * 2], pc.uv0_buf.data[gl_VertexIndex * 2 + 1]);
+    gl_Position = cam_mats_buf.view_proj_mat * ws_P;
 
-    out_ts_Ng = vec3(0.0, 0.0, 0.0);
+    out_uv_0 = vec2(draw.uv0_buf.data[gl_VertexIndex * 2], draw.uv0_buf.data[gl_VertexIndex * 2 + 1]);
 
-    mat3 normal_mat = mat3(pc.normal_mat_buf.data[0]);
+    mat3 normal_mat = mat3(push.normal_mat_buf.data[instance.x]);
 
-    vec3 ws_Ng = normalize(normal_mat * vec3(pc.N_buf.data[gl_VertexIndex * 3 + 0], pc.N_buf.data[gl_VertexIndex * 3 + 1], pc.N_buf.data[gl_VertexIndex * 3 + 2]));
+    vec3 ws_Ng = normalize(normal_mat * vec3(draw.N_buf.data[gl_VertexIndex * 3 + 0], draw.N_buf.data[gl_VertexIndex * 3 + 1], draw.N_buf.data[gl_VertexIndex * 3 + 2]));
 
-    vec3 ws_T = normalize(vec3(normal_mat * vec3(pc.T_buf.data[gl_VertexIndex * 4 + 0], pc.T_buf.data[gl_VertexIndex * 4 + 1], pc.T_buf.data[gl_VertexIndex * 4 + 2])));
+    vec3 ws_T = normalize(vec3(normal_mat * vec3(draw.T_buf.data[gl_VertexIndex * 4 + 0], draw.T_buf.data[gl_VertexIndex * 4 + 1], draw.T_buf.data[gl_VertexIndex * 4 + 2])));
 
-    vec3 ws_B = normalize(cross(ws_T, ws_Ng) * pc.T_buf.data[gl_VertexIndex * 4 + 3]);
+    vec3 ws_B = normalize(cross(ws_T, ws_Ng) * draw.T_buf.data[gl_VertexIndex * 4 + 3]);
 
-    mat3 ts_mat = transpose(mat3(ws_T, ws_B, ws_Ng));
+    // lighting happens in world space, the cluster lights cannot be moved to tangent space per vertex
+    out_ws_Ng = ws_Ng;
+    out_ws_T = ws_T;
+    out_ws_B = ws_B;
+    out_ws_P = ws_P.xyz;
+    out_ws_V = cam_mats_buf.ws_pos.xyz - ws_P.xyz;
+    out_vs_depth = -(cam_mats_buf.view_mat * ws_P).z;
 
-    out_ts_Ng = ts_mat * ws_Ng;
-    out_ts_P = ts_mat * vec3(pc.model_mat_buf.data[0] * vec4(ms_P, 1.0));
-    out_ts_cam_pos = ts_mat * cam_mats_buf.ws_pos.xyz;
-    out_ts_light_pos_0 = ts_mat * light_params_buf.ws_pos_0.xyz;
-    out_ts_light_pos_1 = ts_mat * light_params_buf.ws_pos_1.xyz;
-    out_ts_light_pos_2 = ts_mat * light_params_buf.ws_pos_2.xyz;
+    out_material = draw.material;
 
     out_col_0 = vec4(1.0, 1.0, 1.0, 1.0);
 
-    if (uvec2(pc.col0_buf) != uvec2(0)) {
-        out_col_0 = vec4(pc.col0_buf.data[gl_VertexIndex * 4], pc.col0_buf.data[gl_VertexIndex * 4 + 1], pc.col0_buf.data[gl_VertexIndex * 4 + 2],  pc.col0_buf.data[gl_VertexIndex * 4 + 3]);
+    if ((FEATURES & FEATURE_VERTEX_COLORS) != 0u && uvec2(draw.col0_buf) != uvec2(0)) {
+        out_col_0 = vec4(draw.col0_buf.data[gl_VertexIndex * 4], draw.col0_buf.data[gl_VertexIndex * 4 + 1], draw.col0_buf.data[gl_VertexIndex * 4 + 2],  draw.col0_buf.data[gl_VertexIndex * 4 + 3]);
     }
 }
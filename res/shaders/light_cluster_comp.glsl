@@ -0,0 +1,93 @@
+#version 450
+#extension GL_EXT_buffer_reference : require
+#extension GL_EXT_buffer_reference2 : require
+
+#define WORKGROUP_SIZE 64
+
+// match VulkanLightClustering
+#define CLUSTER_COUNT_X 16u
+#define CLUSTER_COUNT_Y 9u
+#define CLUSTER_COUNT_Z 24u
+#define CLUSTER_COUNT (CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z)
+#define MAX_CLUSTER_LIGHTS 127u
+
+layout(local_size_x = WORKGROUP_SIZE) in;
+
+struct Light {
+    vec4 ws_pos; // w is the range
+    vec4 flux;
+};
+
+layout(buffer_reference, std430) readonly buffer LightsBuffer { Light data[]; };
+layout(buffer_reference, std430) writeonly buffer ClusterLightsBuffer { uint data[]; }; // per cluster the light count followed by MAX_CLUSTER_LIGHTS indices
+
+layout(push_constant) uniform PushConstants {
+    mat4 view_mat;
+    LightsBuffer lights_buf;
+    ClusterLightsBuffer cluster_lights_buf;
+    vec2 proj_scale; // [0][0] and [1][1] of the projection matrix
+    float z_near;
+    float z_far;
+    uint light_count;
+} pc;
+
+// the lights are transformed once per workgroup and then tested by every cluster of it
+shared vec4 vs_lights[WORKGROUP_SIZE]; // view space position and range
+
+// one invocation per cluster, the clusters are ordered x, y, then z
+void main() {
+    uint cluster_index = gl_GlobalInvocationID.x;
+    uvec3 cluster = uvec3(cluster_index % CLUSTER_COUNT_X, (cluster_index / CLUSTER_COUNT_X) % CLUSTER_COUNT_Y, cluster_index / (CLUSTER_COUNT_X * CLUSTER_COUNT_Y));
+
+    // view space box of the cluster: the tile extruded between the depths of its slice, which grow exponentially from the near to the far plane
+    float depth_near = pc.z_near * pow(pc.z_far / pc.z_near, float(cluster.z) / float(CLUSTER_COUNT_Z));
+    float depth_far = pc.z_near * pow(pc.z_far / pc.z_near, float(cluster.z + 1u) / float(CLUSTER_COUNT_Z));
+
+    vec2 ndc_min = vec2(cluster.xy) / vec2(CLUSTER_COUNT_X, CLUSTER_COUNT_Y) * 2.0 - 1.0;
+    vec2 ndc_max = vec2(cluster.xy + 1u) / vec2(CLUSTER_COUNT_X, CLUSTER_COUNT_Y) * 2.0 - 1.0;
+
+    // tile corners at a view depth of 1, the projection may flip y
+    vec2 corner_a = ndc_min / pc.proj_scale;
+    vec2 corner_b = ndc_max / pc.proj_scale;
+
+    vec2 unit_min = min(corner_a, corner_b);
+    vec2 unit_max = max(corner_a, corner_b);
+
+    vec3 vs_min = vec3(min(unit_min * depth_near, unit_min * depth_far), -depth_far);
+    vec3 vs_max = vec3(max(unit_max * depth_near, unit_max * depth_far), -depth_near);
+
+    uint first_slot = cluster_index * (MAX_CLUSTER_LIGHTS + 1u);
+    uint count = 0u;
+
+    for (uint first_light = 0u; first_light < pc.light_count; first_light += WORKGROUP_SIZE) {
+        uint light_index = first_light + gl_LocalInvocationIndex;
+
+        if (light_index < pc.light_count) {
+            Light light = pc.lights_buf.data[light_index];
+            vs_lights[gl_LocalInvocationIndex] = vec4((pc.view_mat * vec4(light.ws_pos.xyz, 1.0)).xyz, light.ws_pos.w);
+        }
+
+        barrier();
+
+        uint chunk_count = min(uint(WORKGROUP_SIZE), pc.light_count - first_light);
+
+        for (uint i = 0u; i < chunk_count && count < MAX_CLUSTER_LIGHTS; i++) {
+            // sphere against box, from the closest point of the box to the light
+            vec3 offset = clamp(vs_lights[i].xyz, vs_min, vs_max) - vs_lights[i].xyz;
+
+            if (dot(offset, offset) <= vs_lights[i].w * vs_lights[i].w) {
+                if (cluster_index < CLUSTER_COUNT) {
+                    pc.cluster_lights_buf.data[first_slot + 1u + count] = first_light + i;
+                }
+
+                count++;
+            }
+        }
+
+        barrier();
+    }
+
+    if (cluster_index < CLUSTER_COUNT) {
+        pc.cluster_lights_buf.data[first_slot] = count;
+    }
+}
@@ -0,0 +1,294 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <stdexcept>
+
+// the widest instruction set enabled for the build is picked at compile time, with a scalar fallback for everything else
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SVMV_ACCESSOR_CONVERSION_AVX2
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#define SVMV_ACCESSOR_CONVERSION_SSE41
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SVMV_ACCESSOR_CONVERSION_SSE2
+#endif
+
+namespace SVMV
+{
+    namespace AccessorConversion
+    {
+        // converts accessor data of any glTF component type into tightly packed floats,
+        // normalized integers are mapped to [0, 1] (unsigned) or [-1, 1] (signed) as described in the glTF specification
+
+        template <typename ComponentType>
+        constexpr float normalizationScale()
+        {
+            return 1.0f / static_cast<float>(std::numeric_limits<ComponentType>::max());
+        }
+
+        template <typename ComponentType, bool Normalized>
+        inline float convertComponent(ComponentType value)
+        {
+            if constexpr (std::is_floating_point_v<ComponentType> || !Normalized)
+            {
+                return static_cast<float>(value);
+            }
+            else if constexpr (std::is_signed_v<ComponentType>)
+            {
+                return std::max(static_cast<float>(value) * normalizationScale<ComponentType>(), -1.0f);
+            }
+            else
+            {
+                return static_cast<float>(value) * normalizationScale<ComponentType>();
+            }
+        }
+
+        namespace details
+        {
+#if defined(SVMV_ACCESSOR_CONVERSION_SSE2) || defined(SVMV_ACCESSOR_CONVERSION_SSE41)
+            // widens four 8 or 16 bit components to 32 bit integers
+            template <typename ComponentType>
+            inline __m128i loadFourComponents(const ComponentType* source)
+            {
+                if constexpr (sizeof(ComponentType) == 1)
+                {
+                    int32_t packed;
+                    memcpy(&packed, source, sizeof(packed));
+                    __m128i value = _mm_cvtsi32_si128(packed);
+
+#if defined(SVMV_ACCESSOR_CONVERSION_SSE41)
+                    return std::is_signed_v<ComponentType> ? _mm_cvtepi8_epi32(value) : _mm_cvtepu8_epi32(value);
+#else
+                    if constexpr (std::is_signed_v<ComponentType>)
+                    {
+                        value = _mm_unpacklo_epi8(value, value);
+                        return _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 24);
+                    }
+                    else
+                    {
+                        value = _mm_unpacklo_epi8(value, _mm_setzero_si128());
+                        return _mm_unpacklo_epi16(value, _mm_setzero_si128());
+                    }
+#endif
+                }
+                else
+                {
+                    __m128i value = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source));
+
+#if defined(SVMV_ACCESSOR_CONVERSION_SSE41)
+                    return std::is_signed_v<ComponentType> ? _mm_cvtepi16_epi32(value) : _mm_cvtepu16_epi32(value);
+#else
+                    if constexpr (std::is_signed_v<ComponentType>)
+                    {
+                        return _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16);
+                    }
+                    else
+                    {
+                        return _mm_unpacklo_epi16(value, _mm_setzero_si128());
+                    }
+#endif
+                }
+            }
+#endif
+
+            // converts a flat run of components, this is the path taken by tightly packed accessors
+            template <typename ComponentType, bool Normalized>
+            void convertComponents(const ComponentType* source, float* destination, size_t componentCount)
+            {
+                size_t i = 0;
+
+                if constexpr (std::is_same_v<ComponentType, float>)
+                {
+                    memcpy(destination, source, componentCount * sizeof(float));
+
+                    return;
+                }
+                else if constexpr (sizeof(ComponentType) <= 2)
+                {
+#if defined(SVMV_ACCESSOR_CONVERSION_AVX2)
+                    const __m256 scale = _mm256_set1_ps(Normalized ? normalizationScale<ComponentType>() : 1.0f);
+                    const __m256 minimum = _mm256_set1_ps(-1.0f);
+
+                    for (; i + 8 <= componentCount; i += 8)
+                    {
+                        __m256i integers;
+
+                        if constexpr (sizeof(ComponentType) == 1)
+                        {
+                            __m128i value = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + i));
+                            integers = std::is_signed_v<ComponentType> ? _mm256_cvtepi8_epi32(value) : _mm256_cvtepu8_epi32(value);
+                        }
+                        else
+                        {
+                            __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+                            integers = std::is_signed_v<ComponentType> ? _mm256_cvtepi16_epi32(value) : _mm256_cvtepu16_epi32(value);
+                        }
+
+                        __m256 floats = _mm256_mul_ps(_mm256_cvtepi32_ps(integers), scale);
+
+                        if constexpr (Normalized && std::is_signed_v<ComponentType>)
+                        {
+                            floats = _mm256_max_ps(floats, minimum);
+                        }
+
+                        _mm256_storeu_ps(destination + i, floats);
+                    }
+#elif defined(SVMV_ACCESSOR_CONVERSION_SSE2) || defined(SVMV_ACCESSOR_CONVERSION_SSE41)
+                    const __m128 scale = _mm_set1_ps(Normalized ? normalizationScale<ComponentType>() : 1.0f);
+                    const __m128 minimum = _mm_set1_ps(-1.0f);
+
+                    for (; i + 4 <= componentCount; i += 4)
+                    {
+                        __m128 floats = _mm_mul_ps(_mm_cvtepi32_ps(loadFourComponents(source + i)), scale);
+
+                        if constexpr (Normalized && std::is_signed_v<ComponentType>)
+                        {
+                            floats = _mm_max_ps(floats, minimum);
+                        }
+
+                        _mm_storeu_ps(destination + i, floats);
+                    }
+#endif
+                }
+
+                for (; i < componentCount; i++)
+                {
+                    destination[i] = convertComponent<ComponentType, Normalized>(source[i]);
+                }
+            }
+
+            // converts interleaved or padded elements one at a time, the component counts are known at compile time so the inner loops unroll
+            template <typename ComponentType, size_t SourceComponentCount, size_t DestinationComponentCount, bool Normalized>
+            void convertElements(const std::byte* source, float* destination, size_t count, size_t byteStride, float fillerValue)
+            {
+                static_assert(SourceComponentCount <= DestinationComponentCount, "accessor conversion can only pad, not truncate");
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    ComponentType components[SourceComponentCount];
+                    memcpy(components, source, sizeof(components));
+
+                    for (size_t j = 0; j < SourceComponentCount; j++)
+                    {
+                        destination[j] = convertComponent<ComponentType, Normalized>(components[j]);
+                    }
+
+                    for (size_t j = SourceComponentCount; j < DestinationComponentCount; j++)
+                    {
+                        destination[j] = fillerValue;
+                    }
+
+                    destination += DestinationComponentCount;
+                    source += byteStride;
+                }
+            }
+        }
+
+        template <typename ComponentType, size_t SourceComponentCount, size_t DestinationComponentCount, bool Normalized>
+        void convertAccessor(const std::byte* source, float* destination, size_t count, size_t byteStride, float fillerValue)
+        {
+            if (SourceComponentCount == DestinationComponentCount && (byteStride == 0 || byteStride == sizeof(ComponentType) * SourceComponentCount)
+                && reinterpret_cast<uintptr_t>(source) % alignof(ComponentType) == 0)
+            {
+                details::convertComponents<ComponentType, Normalized>(reinterpret_cast<const ComponentType*>(source), destination, count * SourceComponentCount);
+            }
+            else
+            {
+                details::convertElements<ComponentType, SourceComponentCount, DestinationComponentCount, Normalized>(
+                    source, destination, count, (byteStride == 0) ? sizeof(ComponentType) * SourceComponentCount : byteStride, fillerValue
+                );
+            }
+        }
+
+        namespace details
+        {
+            template <typename ComponentType, bool Normalized, size_t SourceComponentCount>
+            void dispatchDestinationCount(const std::byte* source, float* destination, size_t count, size_t destinationComponentCount, size_t byteStride, float fillerValue)
+            {
+                switch (destinationComponentCount)
+                {
+                case 1:
+                    if constexpr (SourceComponentCount <= 1) { convertAccessor<ComponentType, SourceComponentCount, 1, Normalized>(source, destination, count, byteStride, fillerValue); return; }
+                    break;
+                case 2:
+                    if constexpr (SourceComponentCount <= 2) { convertAccessor<ComponentType, SourceComponentCount, 2, Normalized>(source, destination, count, byteStride, fillerValue); return; }
+                    break;
+                case 3:
+                    if constexpr (SourceComponentCount <= 3) { convertAccessor<ComponentType, SourceComponentCount, 3, Normalized>(source, destination, count, byteStride, fillerValue); return; }
+                    break;
+                case 4:
+                    convertAccessor<ComponentType, SourceComponentCount, 4, Normalized>(source, destination, count, byteStride, fillerValue);
+                    return;
+                }
+
+                throw std::runtime_error("accessor conversion: unsupported destination component count");
+            }
+
+            template <typename ComponentType, bool Normalized>
+            void dispatchComponentCounts(const std::byte* source, float* destination, size_t count, size_t sourceComponentCount, size_t destinationComponentCount, size_t byteStride, float fillerValue)
+            {
+                switch (sourceComponentCount)
+                {
+                case 1: dispatchDestinationCount<ComponentType, Normalized, 1>(source, destination, count, destinationComponentCount, byteStride, fillerValue); return;
+                case 2: dispatchDestinationCount<ComponentType, Normalized, 2>(source, destination, count, destinationComponentCount, byteStride, fillerValue); return;
+                case 3: dispatchDestinationCount<ComponentType, Normalized, 3>(source, destination, count, destinationComponentCount, byteStride, fillerValue); return;
+                case 4: dispatchDestinationCount<ComponentType, Normalized, 4>(source, destination, count, destinationComponentCount, byteStride, fillerValue); return;
+                }
+
+                throw std::runtime_error("accessor conversion: unsupported source component count");
+            }
+
+            template <typename ComponentType>
+            void dispatchNormalization(const std::byte* source, float* destination, size_t count, size_t sourceComponentCount, size_t destinationComponentCount, bool normalized, size_t byteStride, float fillerValue)
+            {
+                if (normalized)
+                {
+                    dispatchComponentCounts<ComponentType, true>(source, destination, count, sourceComponentCount, destinationComponentCount, byteStride, fillerValue);
+                }
+                else
+                {
+                    dispatchComponentCounts<ComponentType, false>(source, destination, count, sourceComponentCount, destinationComponentCount, byteStride, fillerValue);
+                }
+            }
+        }
+
+        enum class ComponentType : int
+        {
+            INT8, UINT8, INT16, UINT16, UINT32, FLOAT
+        };
+
+        // runtime entry point, picks the specialized kernel for the given layout; a byteStride of 0 means tightly packed
+        inline void convertAccessor(const std::byte* source, float* destination, size_t count, ComponentType componentType, bool normalized,
+            size_t sourceComponentCount, size_t destinationComponentCount, size_t byteStride, float fillerValue = 0.0f)
+        {
+            switch (componentType)
+            {
+            case ComponentType::INT8:
+                details::dispatchNormalization<int8_t>(source, destination, count, sourceComponentCount, destinationComponentCount, normalized, byteStride, fillerValue);
+                break;
+            case ComponentType::UINT8:
+                details::dispatchNormalization<uint8_t>(source, destination, count, sourceComponentCount, destinationComponentCount, normalized, byteStride, fillerValue);
+                break;
+            case ComponentType::INT16:
+                details::dispatchNormalization<int16_t>(source, destination, count, sourceComponentCount, destinationComponentCount, normalized, byteStride, fillerValue);
+                break;
+            case ComponentType::UINT16:
+                details::dispatchNormalization<uint16_t>(source, destination, count, sourceComponentCount, destinationComponentCount, normalized, byteStride, fillerValue);
+                break;
+            case ComponentType::UINT32:
+                details::dispatchNormalization<uint32_t>(source, destination, count, sourceComponentCount, destinationComponentCount, normalized, byteStride, fillerValue);
+                break;
+            case ComponentType::FLOAT:
+                details::dispatchComponentCounts<float, false>(source, destination, count, sourceComponentCount, destinationComponentCount, byteStride, fillerValue);
+                break;
+            }
+        }
+    }
+}
@@ -2,7 +2,7 @@
 
 using namespace SVMV;
 
-Application::Application(int width, int height, const std::string& name, const std::string& fileToLoad)
+Application::Application(int width, int height, const std::string& name, const std::string& fileToLoad, const Options& options/* = Options()*/)
 {
     glfwSetWindowIconifyCallback(_window.getWindow(), minimizedCallback);
     glfwSetKeyCallback(_window.getWindow(), keyCallback);
@@ -14,16 +14,14 @@ Application::Application(int width, int height, const std::string& name, const s
     _inputHandler.registerController(&_cameraController);
     _inputHandler.ignoreFirstMouseMovement();
 
+    _renderer.setLoadOptions(options.loadOptions);
+    _renderer.setScatteredLightCount(options.lightCount);
+    _renderer.setOcclusionCulling(options.occlusionCulling);
+    _renderer.setHostCulling(options.hostCulling);
+
     if (!fileToLoad.empty())
     {
-        try
-        {
-            _renderer.loadScene(Loader::loadScene(fileToLoad));
-        }
-        catch (...)
-        {
-            std::cout << "Error loading glTF file: " << fileToLoad << "; skipping model." << std::endl;
-        }
+        _renderer.requestScene(fileToLoad); // loaded in the background, the window is responsive in the meantime
     }
 
     loop();
@@ -52,7 +50,7 @@ void Application::loop()
         _cameraController.Process(deltaTime.count());
     }
 
-    _renderer.getDevice().waitIdle();
+    _renderer.waitIdle();
 }
 
 void Application::minimizedCallback(GLFWwindow* window, int minimized)
@@ -12,6 +12,17 @@ namespace SVMV
 {
     class Application
     {
+    public:
+        // renderer settings that can also be changed from the UI
+        struct Options
+        {
+            int lightCount              { 0 }; // scattered point lights added to the orbiting ones
+            bool occlusionCulling       { false };
+            bool hostCulling            { false };
+
+            Loader::LoadOptions loadOptions;
+        };
+
     private:
         GLFWwindowWrapper _window{ 1440, 1440, "SVMV", this };
         VulkanRenderer _renderer{ 1440, 1440, "SVMV", 3, _window };
@@ -24,7 +35,7 @@ namespace SVMV
 
     public:
         Application() = delete;
-        Application(int width, int height, const std::string& name, const std::string& fileToLoad);
+        Application(int width, int height, const std::string& name, const std::string& fileToLoad, const Options& options = Options());
 
         Application(const Application&) = delete;
         Application& operator=(const Application&) = delete;
@@ -26,12 +26,15 @@ namespace SVMV
         {
             this->attributeType = other.attributeType;
             this->elements = std::move(other.elements);
+            this->view = other.view;
+            this->viewOwner = std::move(other.viewOwner);
             this->type = other.type;
             this->size = other.size;
             this->count = other.count;
             this->componentCount = other.componentCount;
 
             other.attributeType = AttributeType::UNDEFINED;
+            other.view = nullptr;
             other.type = Type::UNDEFINED;
             other.size = 0;
             other.count = 0;
@@ -44,12 +47,15 @@ namespace SVMV
             {
                 this->attributeType = other.attributeType;
                 this->elements = std::move(other.elements);
+                this->view = other.view;
+                this->viewOwner = std::move(other.viewOwner);
                 this->type = other.type;
                 this->size = other.size;
                 this->count = other.count;
                 this->componentCount = other.componentCount;
 
                 other.attributeType = AttributeType::UNDEFINED;
+                other.view = nullptr;
                 other.type = Type::UNDEFINED;
                 other.size = 0;
                 other.count = 0;
@@ -61,9 +67,14 @@ namespace SVMV
 
         ~Attribute() = default;
 
+        const std::byte* getData() const noexcept { return (view != nullptr) ? view : elements.get(); }
+
         AttributeType attributeType{ AttributeType::UNDEFINED };
         std::unique_ptr<std::byte[]> elements{nullptr};
 
+        const std::byte* view{ nullptr }; // used instead of elements when the data is read in place, e.g. from a memory-mapped file
+        std::shared_ptr<const void> viewOwner; // keeps the memory behind view alive
+
         Type type{ Type::UNDEFINED };
         size_t size{ 0 };
         size_t count{ 0 };
@@ -0,0 +1,60 @@
+#include <SVMV/EmbeddedShaders.hxx>
+
+using namespace SVMV;
+
+#ifdef SVMV_EMBED_SHADERS
+namespace
+{
+    // the .spv.inc files are written by glslc -mfmt=num during the build, see CMakeLists.txt
+    constexpr uint32_t drawCullComp[] = {
+#include <draw_cull_comp.glsl.spv.inc>
+    };
+
+    constexpr uint32_t depthPyramidComp[] = {
+#include <depth_pyramid_comp.glsl.spv.inc>
+    };
+
+    constexpr uint32_t lightClusterComp[] = {
+#include <light_cluster_comp.glsl.spv.inc>
+    };
+
+    constexpr uint32_t gltfPBRVert[] = {
+#include <gltf_pbr_vert.glsl.spv.inc>
+    };
+
+    constexpr uint32_t gltfPBRFrag[] = {
+#include <gltf_pbr_frag.glsl.spv.inc>
+    };
+
+    struct EmbeddedShader
+    {
+        std::string_view file;
+        std::span<const uint32_t> code;
+    };
+
+    constexpr EmbeddedShader embeddedShaders[] = {
+        { "draw_cull_comp.glsl", drawCullComp },
+        { "depth_pyramid_comp.glsl", depthPyramidComp },
+        { "light_cluster_comp.glsl", lightClusterComp },
+        { "gltf_pbr_vert.glsl", gltfPBRVert },
+        { "gltf_pbr_frag.glsl", gltfPBRFrag }
+    };
+}
+#endif
+
+std::span<const uint32_t> EmbeddedShaders::find(const std::string& file)
+{
+#ifdef SVMV_EMBED_SHADERS
+    std::string fileName = std::filesystem::path(file).filename().string();
+
+    for (const auto& embeddedShader : embeddedShaders)
+    {
+        if (embeddedShader.file == fileName)
+        {
+            return embeddedShader.code;
+        }
+    }
+#endif
+
+    return {};
+}
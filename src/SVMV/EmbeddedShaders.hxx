@@ -0,0 +1,16 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <filesystem>
+#include <cstdint>
+
+namespace SVMV
+{
+    // SPIR-V compiled from res/shaders at build time when SVMV_EMBED_SHADERS is enabled, so no shader is compiled or read at startup
+    namespace EmbeddedShaders
+    {
+        std::span<const uint32_t> find(const std::string& file); // matched by file name, empty when the shader is not embedded
+    }
+}
@@ -0,0 +1,274 @@
+#include <SVMV/FrustumCulling.hxx>
+
+// the widest instruction set enabled for the build is picked at compile time, like in AccessorConversion.hxx
+#if defined(__AVX__) || defined(__AVX2__)
+#include <immintrin.h>
+#define SVMV_FRUSTUM_CULLING_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SVMV_FRUSTUM_CULLING_SSE2
+#endif
+
+using namespace SVMV;
+
+namespace
+{
+    // the corner of a box furthest along a plane normal only depends on the signs of the normal, so the component arrays are picked once per plane
+    struct PlaneCorner
+    {
+        const float* x  { nullptr };
+        const float* y  { nullptr };
+        const float* z  { nullptr };
+    };
+
+    PlaneCorner getPlaneCorner(const FrustumCulling::Bounds& bounds, const glm::vec4& plane)
+    {
+        PlaneCorner corner;
+        corner.x = (plane.x >= 0.0f) ? bounds.maxX.data() : bounds.minX.data();
+        corner.y = (plane.y >= 0.0f) ? bounds.maxY.data() : bounds.minY.data();
+        corner.z = (plane.z >= 0.0f) ? bounds.maxZ.data() : bounds.minZ.data();
+
+        return corner;
+    }
+}
+
+void FrustumCulling::Bounds::push(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+    minX.push_back(boundsMin.x);
+    minY.push_back(boundsMin.y);
+    minZ.push_back(boundsMin.z);
+    maxX.push_back(boundsMax.x);
+    maxY.push_back(boundsMax.y);
+    maxZ.push_back(boundsMax.z);
+
+    count++;
+}
+
+void FrustumCulling::Bounds::pushUnbounded()
+{
+    push(glm::vec3(std::numeric_limits<float>::lowest()), glm::vec3(std::numeric_limits<float>::max()));
+}
+
+void FrustumCulling::Bounds::pad()
+{
+    size_t boxCount = count;
+
+    while (minX.size() % groupSize != 0)
+    {
+        pushUnbounded();
+    }
+
+    count = boxCount;
+}
+
+size_t FrustumCulling::Bounds::getGroupCount() const noexcept
+{
+    return (count + groupSize - 1) / groupSize;
+}
+
+void FrustumCulling::computeBounds(const float* positions, size_t count, size_t stride, glm::vec3& boundsMin, glm::vec3& boundsMax)
+{
+    boundsMin = glm::vec3(std::numeric_limits<float>::max());
+    boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+
+    size_t first = 0; // of the positions left for the scalar loop
+
+    // the new value is the first operand of min and max, so NaN positions are skipped like by glm::min and glm::max
+#if defined(SVMV_FRUSTUM_CULLING_AVX) || defined(SVMV_FRUSTUM_CULLING_SSE2)
+    if (stride == 3)
+    {
+        // tightly packed positions are loaded as whole registers, three registers hold a block of blockSize positions
+        // and component k of a block always belongs to axis k % 3, so the axes are only separated once at the end
+#if defined(SVMV_FRUSTUM_CULLING_AVX)
+        constexpr size_t blockSize = 8;
+
+        __m256 blockMin[3] = { _mm256_set1_ps(boundsMin.x), _mm256_set1_ps(boundsMin.x), _mm256_set1_ps(boundsMin.x) };
+        __m256 blockMax[3] = { _mm256_set1_ps(boundsMax.x), _mm256_set1_ps(boundsMax.x), _mm256_set1_ps(boundsMax.x) };
+
+        for (; first + blockSize <= count; first += blockSize)
+        {
+            for (size_t i = 0; i < 3; i++)
+            {
+                __m256 components = _mm256_loadu_ps(positions + first * 3 + i * blockSize);
+
+                blockMin[i] = _mm256_min_ps(components, blockMin[i]);
+                blockMax[i] = _mm256_max_ps(components, blockMax[i]);
+            }
+        }
+
+        std::array<float, blockSize * 3> minComponents;
+        std::array<float, blockSize * 3> maxComponents;
+
+        for (size_t i = 0; i < 3; i++)
+        {
+            _mm256_storeu_ps(minComponents.data() + i * blockSize, blockMin[i]);
+            _mm256_storeu_ps(maxComponents.data() + i * blockSize, blockMax[i]);
+        }
+#else
+        constexpr size_t blockSize = 4;
+
+        __m128 blockMin[3] = { _mm_set1_ps(boundsMin.x), _mm_set1_ps(boundsMin.x), _mm_set1_ps(boundsMin.x) };
+        __m128 blockMax[3] = { _mm_set1_ps(boundsMax.x), _mm_set1_ps(boundsMax.x), _mm_set1_ps(boundsMax.x) };
+
+        for (; first + blockSize <= count; first += blockSize)
+        {
+            for (size_t i = 0; i < 3; i++)
+            {
+                __m128 components = _mm_loadu_ps(positions + first * 3 + i * blockSize);
+
+                blockMin[i] = _mm_min_ps(components, blockMin[i]);
+                blockMax[i] = _mm_max_ps(components, blockMax[i]);
+            }
+        }
+
+        std::array<float, blockSize * 3> minComponents;
+        std::array<float, blockSize * 3> maxComponents;
+
+        for (size_t i = 0; i < 3; i++)
+        {
+            _mm_storeu_ps(minComponents.data() + i * blockSize, blockMin[i]);
+            _mm_storeu_ps(maxComponents.data() + i * blockSize, blockMax[i]);
+        }
+#endif
+
+        for (size_t k = 0; k < minComponents.size(); k++)
+        {
+            boundsMin[k % 3] = std::min(boundsMin[k % 3], minComponents[k]);
+            boundsMax[k % 3] = std::max(boundsMax[k % 3], maxComponents[k]);
+        }
+    }
+    else
+    {
+        // wider positions are loaded one at a time, the fourth component is ignored
+        __m128 vertexMin = _mm_set1_ps(boundsMin.x);
+        __m128 vertexMax = _mm_set1_ps(boundsMax.x);
+
+        for (; first < count; first++)
+        {
+            __m128 position = _mm_loadu_ps(positions + first * stride);
+
+            vertexMin = _mm_min_ps(position, vertexMin);
+            vertexMax = _mm_max_ps(position, vertexMax);
+        }
+
+        std::array<float, 4> minComponents;
+        std::array<float, 4> maxComponents;
+
+        _mm_storeu_ps(minComponents.data(), vertexMin);
+        _mm_storeu_ps(maxComponents.data(), vertexMax);
+
+        boundsMin = glm::vec3(minComponents[0], minComponents[1], minComponents[2]);
+        boundsMax = glm::vec3(maxComponents[0], maxComponents[1], maxComponents[2]);
+    }
+#endif
+
+    // the positions after the last full block, or all of them without SIMD support
+    for (; first < count; first++)
+    {
+        glm::vec3 position(positions[first * stride], positions[first * stride + 1], positions[first * stride + 2]);
+
+        boundsMin = glm::min(boundsMin, position);
+        boundsMax = glm::max(boundsMax, position);
+    }
+}
+
+FrustumCulling::Planes FrustumCulling::extractPlanes(const glm::mat4& viewProjection)
+{
+    glm::mat4 m = glm::transpose(viewProjection); // rows of the matrix
+
+    return { m[3] + m[0], m[3] - m[0], m[3] + m[1], m[3] - m[1], m[2], m[3] - m[2] };
+}
+
+void FrustumCulling::cull(const Bounds& bounds, const Planes& planes, size_t firstGroup, size_t groupCount, uint8_t* masks)
+{
+    std::array<PlaneCorner, 6> corners;
+
+    for (size_t i = 0; i < planes.size(); i++)
+    {
+        corners[i] = getPlaneCorner(bounds, planes[i]);
+    }
+
+    for (size_t group = firstGroup; group < firstGroup + groupCount; group++)
+    {
+        size_t first = group * groupSize;
+
+#if defined(SVMV_FRUSTUM_CULLING_AVX)
+        __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        for (size_t i = 0; i < planes.size(); i++)
+        {
+            __m256 distance = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes[i].x), _mm256_loadu_ps(corners[i].x + first)), _mm256_mul_ps(_mm256_set1_ps(planes[i].y), _mm256_loadu_ps(corners[i].y + first))),
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes[i].z), _mm256_loadu_ps(corners[i].z + first)), _mm256_set1_ps(planes[i].w))
+            );
+
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_NLT_UQ)); // kept when the distance is NaN, like in the shader
+        }
+
+        masks[group] = static_cast<uint8_t>(_mm256_movemask_ps(visible));
+#elif defined(SVMV_FRUSTUM_CULLING_SSE2)
+        // the group is tested in two halves
+        __m128 visibleLow = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        __m128 visibleHigh = visibleLow;
+
+        for (size_t i = 0; i < planes.size(); i++)
+        {
+            __m128 x = _mm_set1_ps(planes[i].x);
+            __m128 y = _mm_set1_ps(planes[i].y);
+            __m128 z = _mm_set1_ps(planes[i].z);
+            __m128 w = _mm_set1_ps(planes[i].w);
+
+            __m128 distanceLow = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(x, _mm_loadu_ps(corners[i].x + first)), _mm_mul_ps(y, _mm_loadu_ps(corners[i].y + first))), _mm_add_ps(_mm_mul_ps(z, _mm_loadu_ps(corners[i].z + first)), w)
+            );
+            __m128 distanceHigh = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(x, _mm_loadu_ps(corners[i].x + first + 4)), _mm_mul_ps(y, _mm_loadu_ps(corners[i].y + first + 4))), _mm_add_ps(_mm_mul_ps(z, _mm_loadu_ps(corners[i].z + first + 4)), w)
+            );
+
+            visibleLow = _mm_and_ps(visibleLow, _mm_cmpnlt_ps(distanceLow, _mm_setzero_ps()));
+            visibleHigh = _mm_and_ps(visibleHigh, _mm_cmpnlt_ps(distanceHigh, _mm_setzero_ps()));
+        }
+
+        masks[group] = static_cast<uint8_t>(_mm_movemask_ps(visibleLow) | (_mm_movemask_ps(visibleHigh) << 4));
+#else
+        uint8_t mask = 0;
+
+        for (size_t box = 0; box < groupSize; box++)
+        {
+            bool visible = true;
+
+            for (size_t i = 0; i < planes.size() && visible; i++)
+            {
+                float distance = planes[i].x * corners[i].x[first + box] + planes[i].y * corners[i].y[first + box] + planes[i].z * corners[i].z[first + box] + planes[i].w;
+
+                visible = !(distance < 0.0f);
+            }
+
+            mask |= static_cast<uint8_t>(visible) << box;
+        }
+
+        masks[group] = mask;
+#endif
+    }
+}
+
+void FrustumCulling::cull(const Bounds& bounds, const Planes& planes, uint8_t* masks, ThreadPool& threadPool)
+{
+    size_t groupCount = bounds.getGroupCount();
+
+    if (bounds.count < minParallelCount || threadPool.getThreadCount() <= 1)
+    {
+        cull(bounds, planes, 0, groupCount, masks);
+
+        return;
+    }
+
+    size_t taskCount = (groupCount + groupsPerTask - 1) / groupsPerTask;
+
+    threadPool.parallelFor(taskCount, [&](size_t task)
+        {
+            size_t firstGroup = task * groupsPerTask;
+
+            cull(bounds, planes, firstGroup, std::min(groupsPerTask, groupCount - firstGroup), masks);
+        });
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <SVMV/ThreadPool.hxx>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <limits>
+#include <cstddef>
+#include <cstdint>
+
+namespace SVMV
+{
+    namespace FrustumCulling
+    {
+        static constexpr size_t groupSize = 8; // boxes tested per iteration, one bit of a visibility mask each
+        static constexpr size_t groupsPerTask = 512; // work split between the threads
+        static constexpr size_t minParallelCount = 16384; // fewer boxes are culled faster on the calling thread
+
+        // world space axis aligned boxes in structure of arrays form, so the kernels load one component of a whole group at once,
+        // the arrays are padded to full groups with boxes that are never culled
+        struct Bounds
+        {
+            std::vector<float> minX;
+            std::vector<float> minY;
+            std::vector<float> minZ;
+            std::vector<float> maxX;
+            std::vector<float> maxY;
+            std::vector<float> maxZ;
+
+            size_t count    { 0 }; // without the padding
+
+            void push(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+            void pushUnbounded(); // the largest box, it is never culled
+            void pad(); // after the last box was pushed
+
+            [[nodiscard]] size_t getGroupCount() const noexcept;
+        };
+
+        // planes of the clip volume (-w <= x, y <= w, 0 <= z <= w) in world space, pointing inwards, the same ones as in draw_cull_comp.glsl
+        using Planes = std::array<glm::vec4, 6>;
+
+        [[nodiscard]] Planes extractPlanes(const glm::mat4& viewProjection);
+
+        // object space bounds of count positions that are stride floats apart (at least 3), left inverted when count is 0
+        void computeBounds(const float* positions, size_t count, size_t stride, glm::vec3& boundsMin, glm::vec3& boundsMax);
+
+        // writes one mask per group into masks, bit i is set when box i of the group is not entirely behind a plane
+        void cull(const Bounds& bounds, const Planes& planes, size_t firstGroup, size_t groupCount, uint8_t* masks);
+        void cull(const Bounds& bounds, const Planes& planes, uint8_t* masks, ThreadPool& threadPool); // all groups, split between the threads for large counts
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <SVMV/Primitive.hxx>
+#include <SVMV/Attribute.hxx>
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace SVMV
+{
+    // produces the geometry of primitives that were loaded without their data (see Loader::LoadOptions::deferGeometry),
+    // so indices and attributes can be written straight into their final location, e.g. mapped staging memory
+    class GeometrySource
+    {
+    public:
+        virtual ~GeometrySource() = default;
+
+        // attributeDestinations follows the order of primitive.attributes and each destination has to hold attribute.size bytes,
+        // the index destination has to hold primitive.indexCount indices; safe to call concurrently for different primitives
+        virtual void writePrimitive(const Primitive& primitive, uint32_t* indexDestination, const std::vector<std::byte*>& attributeDestinations) const = 0;
+    };
+}
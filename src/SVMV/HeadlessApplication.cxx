@@ -0,0 +1,62 @@
+#include <SVMV/HeadlessApplication.hxx>
+
+using namespace SVMV;
+
+HeadlessApplication::HeadlessApplication(const Options& options)
+    : _renderer(options.width, options.height, "SVMV", 1),
+    _cameraController(true, 0.0f, 0.0f, options.cameraPosition, options.cameraPitch, options.cameraYaw)
+{
+    _renderer.setLoadOptions(options.loadOptions);
+    _renderer.setScatteredLightCount(options.lightCount);
+    _renderer.setOcclusionCulling(options.occlusionCulling);
+    _renderer.setHostCulling(options.hostCulling);
+
+    if (!options.fileToLoad.empty())
+    {
+        // fails the run, an empty frame would pass for a valid result in golden image and benchmark runs
+        try
+        {
+            _renderer.loadScene(Loader::loadScene(options.fileToLoad, _renderer.getLoadOptions()));
+        }
+        catch (const std::exception& exception)
+        {
+            throw std::runtime_error("headless: failed to load " + options.fileToLoad + " (" + exception.what() + ")");
+        }
+    }
+
+    _cameraController.Process(0.0f); // derives the look direction from the pitch and yaw
+    _renderer.setCamera(_cameraController.getCameraPosition(), _cameraController.getCameraFront(), _cameraController.getCameraUp(), 75.0f);
+
+    render(options.frameCount);
+
+    if (!options.outputFile.empty())
+    {
+        _renderer.saveFrame(options.outputFile);
+    }
+}
+
+void HeadlessApplication::render(int frameCount)
+{
+    std::chrono::high_resolution_clock::time_point time1 = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < frameCount; i++)
+    {
+        _renderer.draw();
+    }
+
+    _renderer.waitIdle();
+
+    std::chrono::high_resolution_clock::time_point time2 = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<float, std::milli> totalTime = std::chrono::duration_cast<std::chrono::duration<float, std::milli>>(time2 - time1);
+
+    if (frameCount > 0)
+    {
+        std::cout << "headless: rendered " << frameCount << " frames in " << totalTime.count() << " ms (" << totalTime.count() / frameCount << " ms per frame)" << std::endl;
+
+        ShaderStructures::CullStatistics statistics = _renderer.getCullStatistics();
+
+        std::cout << "headless: last frame drew " << statistics.drawnInstances << " instances (" << statistics.drawnTriangles << " triangles) with " << statistics.drawnCommands << " commands, "
+            << "frustum culled " << statistics.frustumCulledInstances << " (" << statistics.frustumCulledTriangles << " triangles), "
+            << "occlusion culled " << statistics.occlusionCulledInstances << " (" << statistics.occlusionCulledTriangles << " triangles)" << std::endl;
+    }
+}
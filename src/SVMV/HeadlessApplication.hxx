@@ -0,0 +1,55 @@
+#pragma once
+
+#include <SVMV/Loader.hxx>
+#include <SVMV/VulkanRenderer.hxx>
+#include <SVMV/CameraController.hxx>
+
+#include <chrono>
+#include <string>
+#include <stdexcept>
+
+namespace SVMV
+{
+    class HeadlessApplication
+    {
+    public:
+        struct Options
+        {
+            int width           { 1440 };
+            int height          { 1440 };
+            int frameCount      { 1 }; // frames rendered before the output is saved, useful for throughput measurements
+            int lightCount      { 0 }; // scattered point lights added to the orbiting ones
+
+            bool occlusionCulling { false }; // two-pass culling against a depth pyramid instead of frustum culling alone
+            bool hostCulling { false }; // frustum culling on the CPU instead of the culling pass, takes precedence over occlusion culling
+
+            std::string fileToLoad;
+            std::string outputFile  { "frame.png" };
+
+            glm::vec3 cameraPosition    { 1.22f, 0.0f, 2.14f };
+            float cameraPitch           { -0.16f };
+            float cameraYaw             { -115.0f };
+
+            Loader::LoadOptions loadOptions;
+        };
+
+    public:
+        HeadlessApplication() = delete;
+        HeadlessApplication(const Options& options); // throws when the scene cannot be loaded or the frame cannot be saved
+
+        HeadlessApplication(const HeadlessApplication&) = delete;
+        HeadlessApplication& operator=(const HeadlessApplication&) = delete;
+
+        HeadlessApplication(HeadlessApplication&& other) = delete;
+        HeadlessApplication& operator=(HeadlessApplication&& other) = delete;
+
+        ~HeadlessApplication() = default;
+
+    private:
+        void render(int frameCount);
+
+    private:
+        VulkanRenderer _renderer;
+        CameraControllerNoclip _cameraController;
+    };
+}
@@ -0,0 +1,71 @@
+#include <SVMV/ImageDecoder.hxx>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <new>
+
+using namespace SVMV;
+
+namespace
+{
+    // stb_image allocates with new[], so Texture::data can take ownership of the pixels it returns
+    void* allocatePixels(size_t size)
+    {
+        return new (std::nothrow) std::byte[size];
+    }
+
+    void freePixels(void* pointer)
+    {
+        delete[] static_cast<std::byte*>(pointer);
+    }
+
+    void* reallocatePixels(void* pointer, size_t oldSize, size_t newSize)
+    {
+        std::byte* newPointer = new (std::nothrow) std::byte[newSize];
+
+        if (newPointer != nullptr && pointer != nullptr)
+        {
+            memcpy(newPointer, pointer, std::min(oldSize, newSize));
+        }
+
+        freePixels(pointer);
+
+        return newPointer;
+    }
+}
+
+// a private copy of the decoder, separate from the one compiled into tinygltf
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_MALLOC(size) allocatePixels(size)
+#define STBI_FREE(pointer) freePixels(pointer)
+#define STBI_REALLOC_SIZED(pointer, oldSize, newSize) reallocatePixels(pointer, oldSize, newSize)
+#include <stb_image.h>
+
+std::shared_ptr<Texture> ImageDecoder::decode(const std::byte* data, size_t size)
+{
+    if (size > INT_MAX)
+    {
+        throw std::runtime_error("image decoder: image is too large");
+    }
+
+    int width = 0;
+    int height = 0;
+    int componentCount = 0;
+
+    stbi_uc* pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(data), static_cast<int>(size), &width, &height, &componentCount, STBI_rgb_alpha);
+
+    if (pixels == nullptr)
+    {
+        throw std::runtime_error(std::string("image decoder: failed to decode image (") + stbi_failure_reason() + ")");
+    }
+
+    std::shared_ptr<Texture> texture = std::make_shared<Texture>();
+    texture->width = static_cast<unsigned>(width);
+    texture->height = static_cast<unsigned>(height);
+    texture->data = std::unique_ptr<std::byte[]>(reinterpret_cast<std::byte*>(pixels));
+    texture->size = static_cast<size_t>(width) * height * 4;
+
+    return texture;
+}
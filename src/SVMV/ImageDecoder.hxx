@@ -0,0 +1,17 @@
+#pragma once
+
+#include <SVMV/Texture.hxx>
+
+#include <memory>
+#include <string>
+#include <cstddef>
+#include <stdexcept>
+
+namespace SVMV
+{
+    // decodes PNG, JPEG and the other formats of stb_image, safe to call from several threads at once
+    namespace ImageDecoder
+    {
+        std::shared_ptr<Texture> decode(const std::byte* data, size_t size); // always expanded to RGBA8, the texture owns the decoded pixels without a copy
+    }
+}
@@ -0,0 +1,153 @@
+#include <SVMV/KTX2.hxx>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace SVMV;
+
+namespace
+{
+    constexpr uint8_t identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A }; // «KTX 20»\r\n\x1A\n
+
+    constexpr size_t headerSize = 80; // identifier, header and index, followed by the level index
+    constexpr size_t levelIndexEntrySize = 24; // byte offset, byte length and uncompressed byte length
+
+    // the VkFormat values stored in the header, sRGB and UNORM variants share an encoding and the material picks the view format
+    constexpr uint32_t formatR8G8B8A8Unorm = 37;
+    constexpr uint32_t formatR8G8B8A8Srgb = 43;
+    constexpr uint32_t formatBC1RGBAUnorm = 133;
+    constexpr uint32_t formatBC1RGBASrgb = 134;
+    constexpr uint32_t formatBC3Unorm = 137;
+    constexpr uint32_t formatBC3Srgb = 138;
+    constexpr uint32_t formatBC4Unorm = 139;
+    constexpr uint32_t formatBC5Unorm = 141;
+    constexpr uint32_t formatBC7Unorm = 145;
+    constexpr uint32_t formatBC7Srgb = 146;
+
+    uint32_t readUint32(const std::byte* data, size_t offset)
+    {
+        uint32_t value;
+        memcpy(&value, data + offset, sizeof(value));
+
+        return value;
+    }
+
+    uint64_t readUint64(const std::byte* data, size_t offset)
+    {
+        uint64_t value;
+        memcpy(&value, data + offset, sizeof(value));
+
+        return value;
+    }
+
+    TextureEncoding convertFormat(uint32_t vkFormat)
+    {
+        switch (vkFormat)
+        {
+        case formatR8G8B8A8Unorm:
+        case formatR8G8B8A8Srgb:
+            return TextureEncoding::RGBA8;
+        case formatBC1RGBAUnorm:
+        case formatBC1RGBASrgb:
+            return TextureEncoding::BC1;
+        case formatBC3Unorm:
+        case formatBC3Srgb:
+            return TextureEncoding::BC3;
+        case formatBC4Unorm:
+            return TextureEncoding::BC4;
+        case formatBC5Unorm:
+            return TextureEncoding::BC5;
+        case formatBC7Unorm:
+        case formatBC7Srgb:
+            return TextureEncoding::BC7;
+        default:
+            throw std::runtime_error("KTX2: unsupported format " + std::to_string(vkFormat));
+        }
+    }
+}
+
+bool KTX2::isKTX2(const std::byte* data, size_t size) noexcept
+{
+    return size >= sizeof(identifier) && memcmp(data, identifier, sizeof(identifier)) == 0;
+}
+
+std::shared_ptr<Texture> KTX2::load(const std::byte* data, size_t size)
+{
+    if (!isKTX2(data, size) || size < headerSize)
+    {
+        throw std::runtime_error("KTX2: invalid header");
+    }
+
+    uint32_t vkFormat = readUint32(data, 12);
+    uint32_t width = readUint32(data, 20);
+    uint32_t height = readUint32(data, 24);
+    uint32_t depth = readUint32(data, 28);
+    uint32_t layerCount = readUint32(data, 32);
+    uint32_t faceCount = readUint32(data, 36);
+    uint32_t levelCount = std::max(readUint32(data, 40), 1u); // 0 asks the reader to generate the mipmaps, only the base level is stored
+    uint32_t supercompressionScheme = readUint32(data, 44);
+
+    if (width == 0 || height == 0 || depth > 1 || layerCount > 1 || faceCount != 1)
+    {
+        throw std::runtime_error("KTX2: only 2D textures are supported");
+    }
+
+    if (supercompressionScheme != 0)
+    {
+        throw std::runtime_error("KTX2: supercompressed textures are not supported");
+    }
+
+    if (levelCount > TextureMipmaps::getLevelCount(width, height) || headerSize + levelCount * levelIndexEntrySize > size)
+    {
+        throw std::runtime_error("KTX2: invalid level index");
+    }
+
+    std::shared_ptr<Texture> texture = std::make_shared<Texture>();
+    texture->width = width;
+    texture->height = height;
+    texture->encoding = convertFormat(vkFormat);
+
+    std::vector<size_t> sourceOffsets(levelCount);
+    std::vector<size_t> levelSizes(levelCount);
+
+    for (uint32_t level = 0; level < levelCount; level++)
+    {
+        uint32_t levelWidth = std::max(width >> level, 1u);
+        uint32_t levelHeight = std::max(height >> level, 1u);
+
+        size_t expectedSize = texture->encoding == TextureEncoding::RGBA8
+            ? static_cast<size_t>(levelWidth) * levelHeight * 4
+            : TextureCompression::getEncodedSize(texture->encoding, levelWidth, levelHeight);
+
+        uint64_t byteOffset = readUint64(data, headerSize + level * levelIndexEntrySize);
+        uint64_t byteLength = readUint64(data, headerSize + level * levelIndexEntrySize + 8);
+
+        if (byteLength != expectedSize || byteOffset > size || byteLength > size - byteOffset)
+        {
+            throw std::runtime_error("KTX2: level " + std::to_string(level) + " is out of bounds or has an unexpected size");
+        }
+
+        sourceOffsets[level] = byteOffset;
+        levelSizes[level] = expectedSize;
+
+        texture->levelOffsets.push_back(texture->size);
+        texture->size += expectedSize;
+    }
+
+    // the file stores the smallest level first, the texture starts with the full size one like the generated chains
+    texture->data = std::make_unique_for_overwrite<std::byte[]>(texture->size);
+
+    for (uint32_t level = 0; level < levelCount; level++)
+    {
+        memcpy(texture->data.get() + texture->levelOffsets[level], data + sourceOffsets[level], levelSizes[level]);
+    }
+
+    // uncompressed textures without mipmaps get them generated when they are uploaded
+    if (texture->encoding == TextureEncoding::RGBA8 && levelCount == 1)
+    {
+        texture->levelOffsets.clear();
+    }
+
+    return texture;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <SVMV/Texture.hxx>
+#include <SVMV/TextureMipmaps.hxx>
+#include <SVMV/TextureCompression.hxx>
+
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace SVMV
+{
+    // reader of KTX2 containers whose payload is already in a format the GPU samples directly, the levels are copied without decoding
+    // only 2D textures without supercompression in RGBA8, BC1 (with alpha), BC3, BC4, BC5 or BC7 are supported
+    namespace KTX2
+    {
+        bool isKTX2(const std::byte* data, size_t size) noexcept; // checks the file identifier
+
+        std::shared_ptr<Texture> load(const std::byte* data, size_t size); // the levels are stored from the full size one down
+    }
+}
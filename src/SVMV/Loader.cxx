@@ -2,20 +2,44 @@
 
 using namespace SVMV;
 
-std::shared_ptr<Scene> Loader::loadScene(const std::string& filePath)
+std::shared_ptr<Scene> Loader::loadScene(const std::string& filePath, const LoadOptions& options/* = LoadOptions()*/)
 {
+    ThreadPool threadPool(options.threadCount);
+
+    if (options.useSceneCache)
+    {
+        std::shared_ptr<Scene> cachedScene = SceneCache::load(filePath, options.compressTextures);
+
+        if (cachedScene != nullptr)
+        {
+            cachedScene->nodes.updateTransforms(&threadPool);
+
+            return cachedScene;
+        }
+    }
+
+    // the file is mapped instead of read so the format can be detected from the magic bytes without parsing it twice,
+    // and so the BIN chunk of binary files can be read in place
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(filePath);
+
+    if (file->getSize() > std::numeric_limits<unsigned>::max())
+    {
+        throw std::runtime_error("loader: file is too large: " + filePath);
+    }
+
+    bool binary = details::isBinaryGLTF(file->getData(), file->getSize());
+    std::string baseDirectory = std::filesystem::path(filePath).parent_path().string();
+
     tinygltf::TinyGLTF gltfContext;
+    gltfContext.SetImageLoader(details::loadImageData, nullptr);
 
     std::shared_ptr<tinygltf::Model> gltfScene = std::make_shared<tinygltf::Model>();
     std::string error;
     std::string warning;
 
-    bool result = gltfContext.LoadASCIIFromFile(gltfScene.get(), &error, &warning, filePath);
-
-    if (!result)
-    {
-        result = gltfContext.LoadBinaryFromFile(gltfScene.get(), &error, &warning, filePath);
-    }
+    bool result = binary
+        ? gltfContext.LoadBinaryFromMemory(gltfScene.get(), &error, &warning, reinterpret_cast<const unsigned char*>(file->getData()), static_cast<unsigned>(file->getSize()), baseDirectory)
+        : gltfContext.LoadASCIIFromString(gltfScene.get(), &error, &warning, reinterpret_cast<const char*>(file->getData()), static_cast<unsigned>(file->getSize()), baseDirectory);
 
     if (!result)
     {
@@ -26,46 +50,179 @@ std::shared_ptr<Scene> Loader::loadScene(const std::string& filePath)
         if (!error.empty())
         {
             std::cout << "tinygltf: error: " + error << std::endl;
-            throw std::runtime_error("tinigltf: failed to load file: " + filePath);
         }
+
+        throw std::runtime_error("tinigltf: failed to load file: " + filePath);
+    }
+
+    details::SourceBuffers sourceBuffers = details::getSourceBuffers(gltfScene, file, binary);
+
+    std::shared_ptr<details::GLTFGeometrySource> geometrySource = options.deferGeometry ? std::make_shared<details::GLTFGeometrySource>(gltfScene, sourceBuffers) : nullptr;
+
+    std::shared_ptr<Scene> scene = details::processScene(gltfScene, sourceBuffers, geometrySource.get(), threadPool);
+    scene->geometrySource = geometrySource;
+
+    if (options.compressTextures)
+    {
+        details::compressTextures(scene->materials, threadPool); // before the scene is cached, so later loads skip the encoding
     }
 
-    std::shared_ptr<Scene> scene = details::processScene(gltfScene);
+    scene->nodes.updateTransforms(&threadPool);
+
+    if (options.useSceneCache && !options.deferGeometry) // a scene with deferred geometry has no data to cache
+    {
+        SceneCache::save(*scene, filePath, details::getExternalDependencies(gltfScene), options.compressTextures);
+    }
 
     return scene;
 }
 
-std::shared_ptr<Scene> Loader::details::processScene(std::shared_ptr<tinygltf::Model> gltfScene)
+std::vector<std::string> Loader::details::getExternalDependencies(std::shared_ptr<tinygltf::Model> gltfScene)
 {
-    std::shared_ptr<Scene> scene = std::make_shared<Scene>();
+    std::vector<std::string> dependencies;
+
+    auto insertDependency = [&](const std::string& uri)
+        {
+            if (uri.empty() || uri.rfind("data:", 0) == 0)
+            {
+                return; // embedded data URIs are part of the source file itself
+            }
 
-    scene->materials = processMaterials(gltfScene);
-    scene->meshes = processMeshes(gltfScene, scene->materials);
-    scene->root = std::make_shared<Node>();
+            // the URIs are percent-encoded, the files are resolved with the same decoding tinygltf applies when loading them
+            std::string path;
 
-    if (gltfScene->defaultScene != -1)
+            if (!tinygltf::URIDecode(uri, &path, nullptr))
+            {
+                path = uri;
+            }
+
+            if (std::find(dependencies.begin(), dependencies.end(), path) == dependencies.end())
+            {
+                dependencies.push_back(path);
+            }
+        };
+
+    for (const auto& gltfBuffer : gltfScene->buffers)
+    {
+        insertDependency(gltfBuffer.uri);
+    }
+
+    for (const auto& gltfImage : gltfScene->images)
     {
-        for (int nodeIndex : gltfScene->scenes[gltfScene->defaultScene].nodes)
+        insertDependency(gltfImage.uri);
+    }
+
+    return dependencies;
+}
+
+bool Loader::details::isBinaryGLTF(const std::byte* data, size_t size)
+{
+    return size >= 4 && memcmp(data, "glTF", 4) == 0;
+}
+
+std::span<const std::byte> Loader::details::findBinaryChunk(const std::byte* data, size_t size)
+{
+    // GLB layout: 12 byte header (magic, version, length), followed by chunks of (length, type, data) padded to 4 bytes, the first chunk is JSON
+
+    constexpr uint32_t binaryChunkType = 0x004E4942; // "BIN"
+
+    size_t offset = 12;
+
+    while (offset + 8 <= size)
+    {
+        uint32_t chunkLength = 0;
+        uint32_t chunkType = 0;
+
+        memcpy(&chunkLength, data + offset, sizeof(uint32_t));
+        memcpy(&chunkType, data + offset + 4, sizeof(uint32_t));
+
+        offset += 8;
+
+        if (chunkLength > size - offset)
+        {
+            break;
+        }
+
+        if (chunkType == binaryChunkType)
         {
-            scene->root->children.push_back(processNodeHierarchy(gltfScene, gltfScene->nodes[nodeIndex], scene->meshes));
+            return std::span<const std::byte>(data + offset, chunkLength);
         }
+
+        offset += (static_cast<size_t>(chunkLength) + 3) & ~static_cast<size_t>(3);
     }
-    else if (gltfScene->scenes.size() > 0)
+
+    return {};
+}
+
+Loader::details::SourceBuffers Loader::details::getSourceBuffers(std::shared_ptr<tinygltf::Model> gltfScene, std::shared_ptr<const MappedFile> mappedFile, bool binary)
+{
+    SourceBuffers sourceBuffers;
+    sourceBuffers.mappedFile = mappedFile;
+
+    std::span<const std::byte> binaryChunk = binary ? findBinaryChunk(mappedFile->getData(), mappedFile->getSize()) : std::span<const std::byte>();
+
+    for (size_t i = 0; i < gltfScene->buffers.size(); i++)
     {
-        for (int nodeIndex : gltfScene->scenes[0].nodes)
+        tinygltf::Buffer& gltfBuffer = gltfScene->buffers[i];
+
+        if (i == 0 && binary && gltfBuffer.uri.empty() && !binaryChunk.empty() && gltfBuffer.data.size() <= binaryChunk.size())
         {
-            scene->root->children.push_back(processNodeHierarchy(gltfScene, gltfScene->nodes[nodeIndex], scene->meshes));
+            // tinygltf copies the BIN chunk while parsing (the encoded images are copied out of it), afterwards the mapped chunk is used and the copy is released
+            sourceBuffers.buffers.push_back(binaryChunk.first(gltfBuffer.data.size()));
+            sourceBuffers.mapped.push_back(true);
+
+            std::vector<unsigned char>().swap(gltfBuffer.data);
         }
+        else
+        {
+            sourceBuffers.buffers.push_back(std::as_bytes(std::span<const unsigned char>(gltfBuffer.data)));
+            sourceBuffers.mapped.push_back(false);
+        }
+    }
+
+    return sourceBuffers;
+}
+
+const std::byte* Loader::details::getAccessorData(std::shared_ptr<tinygltf::Model> gltfScene, const SourceBuffers& sourceBuffers, const tinygltf::Accessor& gltfAccessor, size_t elementSize)
+{
+    const tinygltf::BufferView& gltfBufferView = gltfScene->bufferViews.at(gltfAccessor.bufferView);
+    std::span<const std::byte> buffer = sourceBuffers.buffers.at(gltfBufferView.buffer);
+
+    size_t byteStride = (gltfBufferView.byteStride == 0) ? elementSize : gltfBufferView.byteStride;
+    size_t offset = gltfBufferView.byteOffset + gltfAccessor.byteOffset;
+
+    if (gltfAccessor.count > 0 && offset + (gltfAccessor.count - 1) * byteStride + elementSize > buffer.size())
+    {
+        throw std::runtime_error("loader: accessor exceeds the bounds of its buffer");
+    }
+
+    return buffer.data() + offset;
+}
+
+std::shared_ptr<Scene> Loader::details::processScene(std::shared_ptr<tinygltf::Model> gltfScene, const SourceBuffers& sourceBuffers, GLTFGeometrySource* geometrySource, ThreadPool& threadPool)
+{
+    std::shared_ptr<Scene> scene = std::make_shared<Scene>();
+
+    scene->materials = processMaterials(gltfScene, threadPool);
+    scene->meshes = processMeshes(gltfScene, sourceBuffers, geometrySource, scene->materials, threadPool);
+
+    if (gltfScene->defaultScene != -1)
+    {
+        scene->nodes = processNodes(gltfScene, gltfScene->scenes.at(gltfScene->defaultScene).nodes, scene->meshes.size());
+    }
+    else if (gltfScene->scenes.size() > 0)
+    {
+        scene->nodes = processNodes(gltfScene, gltfScene->scenes[0].nodes, scene->meshes.size());
     }
 
     return scene;
 }
 
-std::vector<std::shared_ptr<Material>> Loader::details::processMaterials(std::shared_ptr<tinygltf::Model> gltfScene)
+std::vector<std::shared_ptr<Material>> Loader::details::processMaterials(std::shared_ptr<tinygltf::Model> gltfScene, ThreadPool& threadPool)
 {
     std::vector<std::shared_ptr<Material>> materials;
 
-    std::vector<std::shared_ptr<Texture>> textures = processTextures(gltfScene);
+    std::vector<std::shared_ptr<Texture>> textures = processTextures(gltfScene, threadPool);
 
     for (const auto& gltfMaterial : gltfScene->materials)
     {
@@ -92,35 +249,195 @@ std::vector<std::shared_ptr<Material>> Loader::details::processMaterials(std::sh
     return materials;
 }
 
-std::vector<std::shared_ptr<Texture>> Loader::details::processTextures(std::shared_ptr<tinygltf::Model> gltfScene)
+std::vector<std::shared_ptr<Texture>> Loader::details::processTextures(std::shared_ptr<tinygltf::Model> gltfScene, ThreadPool& threadPool)
 {
-    std::vector<std::shared_ptr<Texture>> textures;
+    std::vector<std::shared_ptr<Texture>> textures(gltfScene->textures.size());
 
     // TODO: create placeholder texture for when there is no source
 
+    std::vector<std::shared_ptr<Texture>> images = decodeImages(gltfScene, threadPool);
+
+    for (size_t index = 0; index < textures.size(); index++)
+    {
+        int source = getImageSource(gltfScene->textures[index]);
+
+        // textures referencing the same image share its decoded data
+        textures[index] = (source != -1) ? images.at(source) : std::make_shared<Texture>();
+    }
+
+    return textures;
+}
+
+int Loader::details::getImageSource(const tinygltf::Texture& gltfTexture)
+{
+    // the source of the extension takes precedence, the regular one is a fallback for viewers that do not support it
+    auto extension = gltfTexture.extensions.find("KHR_texture_basisu");
+
+    if (extension != gltfTexture.extensions.end() && extension->second.Has("source"))
+    {
+        return extension->second.Get("source").GetNumberAsInt();
+    }
+
+    return gltfTexture.source;
+}
+
+std::vector<std::shared_ptr<Texture>> Loader::details::decodeImages(std::shared_ptr<tinygltf::Model> gltfScene, ThreadPool& threadPool)
+{
+    std::vector<std::shared_ptr<Texture>> images(gltfScene->images.size());
+
+    // only the images textures resolve to are decoded, not the fallbacks of KTX2 textures or images no texture uses, their bytes are released right away
+    std::vector<bool> used(images.size(), false);
+
     for (const auto& gltfTexture : gltfScene->textures)
     {
-        std::shared_ptr<Texture> texture = std::make_shared<Texture>();
+        int source = getImageSource(gltfTexture);
+
+        if (source >= 0 && static_cast<size_t>(source) < used.size())
+        {
+            used[source] = true;
+        }
+    }
+
+    std::vector<size_t> order;
+
+    for (size_t index = 0; index < images.size(); index++)
+    {
+        if (used[index])
+        {
+            order.push_back(index);
+        }
+        else
+        {
+            std::vector<unsigned char>().swap(gltfScene->images[index].image);
+        }
+    }
+
+    // images are independent of each other, the largest ones are started first so a big image at the end does not leave the other threads idle
+    std::stable_sort(order.begin(), order.end(), [&](size_t first, size_t second) { return gltfScene->images[first].image.size() > gltfScene->images[second].image.size(); });
 
-        if (gltfTexture.source != -1)
+    threadPool.parallelFor(order.size(), [&](size_t orderIndex)
         {
-            tinygltf::Image gltfImage = gltfScene->images[gltfTexture.source];
+            size_t index = order[orderIndex];
+            tinygltf::Image& gltfImage = gltfScene->images[index];
+
+            const std::byte* data = reinterpret_cast<const std::byte*>(gltfImage.image.data());
+            size_t size = gltfImage.image.size();
+
+            if (size == 0)
+            {
+                images[index] = std::make_shared<Texture>();
+            }
+            else if (KTX2::isKTX2(data, size))
+            {
+                images[index] = KTX2::load(data, size); // already in a GPU format, copied without decoding
+            }
+            else
+            {
+                images[index] = ImageDecoder::decode(data, size);
+            }
+
+            std::vector<unsigned char>().swap(gltfImage.image); // the encoded bytes are not needed anymore
+        });
 
-            texture->width = gltfImage.width;
-            texture->height = gltfImage.height;
+    return images;
+}
 
-            texture->data = std::make_unique<std::byte[]>(gltfImage.width * gltfImage.height * 4); // tinyglTF expands images to RGBA by default
-            texture->size = gltfImage.width * gltfImage.height * 4;
+bool Loader::details::loadImageData(
+    tinygltf::Image* image, const int imageIndex, std::string* error, std::string* warning,
+    int requiredWidth, int requiredHeight, const unsigned char* bytes, int size, void* userData
+)
+{
+    // tinygltf would decode the images one after another while parsing, instead the encoded bytes are kept and decoded in parallel by decodeImages
+    image->image.assign(bytes, bytes + size);
+    image->as_is = true;
 
-            memcpy(texture->data.get(), gltfImage.image.data(), gltfImage.width * gltfImage.height * 4);
+    return true;
+}
 
-            std::byte* debug = texture->data.get();
+Loader::details::TextureUsage Loader::details::getTextureUsage(const std::string& propertyName)
+{
+    // normal maps only need X and Y (Z is reconstructed when shading) and occlusion maps a single channel
+    if (propertyName == "baseColorTexture" || propertyName == "emissiveTexture")
+    {
+        return TextureUsage{ TextureEncoding::BC7, true };
+    }
+    else if (propertyName == "metallicRoughnessTexture")
+    {
+        return TextureUsage{ TextureEncoding::BC7, false };
+    }
+    else if (propertyName == "normalTexture")
+    {
+        return TextureUsage{ TextureEncoding::BC5, false };
+    }
+    else if (propertyName == "occlusionTexture")
+    {
+        return TextureUsage{ TextureEncoding::BC4, false };
+    }
+
+    return TextureUsage();
+}
+
+void Loader::details::compressTextures(const std::vector<std::shared_ptr<Material>>& materials, ThreadPool& threadPool)
+{
+    std::map<std::pair<const Texture*, TextureUsage>, std::shared_ptr<Texture>> encodedTextures;
+    std::unordered_map<const Texture*, size_t> usageCounts;
+
+    auto forEachTextureProperty = [&](auto function)
+        {
+            for (const auto& material : materials)
+            {
+                for (const auto& [name, property] : material->properties)
+                {
+                    if (property->getType() == PropertyType::TEXTURE)
+                    {
+                        TextureProperty* textureProperty = static_cast<TextureProperty*>(property.get());
+
+                        // textures read from KTX2 files are already in their final format
+                        if (textureProperty->data != nullptr && textureProperty->data->getData() != nullptr && textureProperty->data->encoding == TextureEncoding::RGBA8 && textureProperty->data->levelOffsets.empty())
+                        {
+                            function(*textureProperty, getTextureUsage(name));
+                        }
+                    }
+                }
+            }
+        };
+
+    forEachTextureProperty([&](TextureProperty& textureProperty, TextureUsage usage)
+        {
+            if (encodedTextures.emplace(std::make_pair(textureProperty.data.get(), usage), textureProperty.data).second)
+            {
+                usageCounts[textureProperty.data.get()]++;
+            }
+        });
+
+    // a texture with a single use is compressed in place, the others are copied first so every use still starts from the original data
+    for (auto& [key, texture] : encodedTextures)
+    {
+        if (key.second.encoding == TextureEncoding::RGBA8)
+        {
+            continue;
         }
 
-        textures.push_back(texture);
+        if (usageCounts[key.first] > 1)
+        {
+            std::shared_ptr<Texture> copy = std::make_shared<Texture>();
+            copy->width = texture->width;
+            copy->height = texture->height;
+            copy->size = texture->size;
+            copy->data = std::make_unique_for_overwrite<std::byte[]>(texture->size);
+            memcpy(copy->data.get(), texture->getData(), texture->size);
+
+            texture = copy;
+        }
+
+        // the blocks of each level are encoded in parallel, the pool cannot be used for the textures themselves as well
+        TextureCompression::compress(*texture, key.second.encoding, key.second.srgb, &threadPool);
     }
 
-    return textures;
+    forEachTextureProperty([&](TextureProperty& textureProperty, TextureUsage usage)
+        {
+            textureProperty.data = encodedTextures.at(std::make_pair(textureProperty.data.get(), usage));
+        });
 }
 
 void Loader::details::processAndInsertFloatProperty(std::shared_ptr<Material> targetMaterial, const std::string& name, float gltfFloat)
@@ -184,25 +501,15 @@ void Loader::details::processAndInsertTextureProperty(const std::vector<std::sha
     }
 }
 
-void Loader::details::generateTangents(std::shared_ptr<Primitive> primitive)
+void Loader::details::generateTangents(const TangentSpaceData& data)
 {
-    Attribute tangentAttribute;
-    tangentAttribute.attributeType = AttributeType::TANGENT;
-    tangentAttribute.componentCount = 4;
-    tangentAttribute.count = getAttributeByType(primitive.get(), AttributeType::NORMAL)->count;
-    tangentAttribute.type = Type::FLOAT;
-    tangentAttribute.size = tangentAttribute.count * tangentAttribute.componentCount * sizeof(float);
-    tangentAttribute.elements = std::make_unique_for_overwrite<std::byte[]>(tangentAttribute.size);
-
-    primitive->attributes.push_back(std::move(tangentAttribute));
-
     SMikkTSpaceContext context = {};
-    context.m_pUserData = primitive.get();
+    context.m_pUserData = const_cast<TangentSpaceData*>(&data);
 
     SMikkTSpaceInterface interface = {};
     interface.m_getNumFaces = [](const SMikkTSpaceContext* context) -> int
     {
-        return ((Primitive*)(context->m_pUserData))->indices.size() / 3;
+        return static_cast<int>(((TangentSpaceData*)(context->m_pUserData))->indexCount / 3);
     };
 
     interface.m_getNumVerticesOfFace = [](const SMikkTSpaceContext* context, int face) -> int
@@ -212,58 +519,46 @@ void Loader::details::generateTangents(std::shared_ptr<Primitive> primitive)
 
     interface.m_getPosition = [](const SMikkTSpaceContext* context, float fvPosOut[], const int face, const int vert)
     {
-        Primitive* primitive = (Primitive*)(context->m_pUserData);
-        Attribute* attribute = getAttributeByType(primitive, AttributeType::POSITION);
-
-        float* positions = (float*)(attribute->elements.get());
+        TangentSpaceData* data = (TangentSpaceData*)(context->m_pUserData);
 
-        int index = primitive->indices[face * 3 + vert] * attribute->componentCount;
+        size_t index = static_cast<size_t>(data->indices[face * 3 + vert]) * data->positionComponentCount;
 
-        fvPosOut[0] = positions[index];
-        fvPosOut[1] = positions[index + 1];
-        fvPosOut[2] = positions[index + 2];
+        fvPosOut[0] = data->positions[index];
+        fvPosOut[1] = data->positions[index + 1];
+        fvPosOut[2] = data->positions[index + 2];
     };
 
     interface.m_getNormal = [](const SMikkTSpaceContext* context, float fvNormOut[], const int face, const int vert)
     {
-        Primitive* primitive = (Primitive*)(context->m_pUserData);
-        Attribute* attribute = getAttributeByType(primitive, AttributeType::NORMAL);
+        TangentSpaceData* data = (TangentSpaceData*)(context->m_pUserData);
 
-        float* normals = (float*)(attribute->elements.get());
+        size_t index = static_cast<size_t>(data->indices[face * 3 + vert]) * data->normalComponentCount;
 
-        int index = primitive->indices[face * 3 + vert] * attribute->componentCount;
-
-        fvNormOut[0] = normals[index];
-        fvNormOut[1] = normals[index + 1];
-        fvNormOut[2] = normals[index + 2];
+        fvNormOut[0] = data->normals[index];
+        fvNormOut[1] = data->normals[index + 1];
+        fvNormOut[2] = data->normals[index + 2];
     };
 
     interface.m_getTexCoord = [](const SMikkTSpaceContext* context, float fvTexcOut[], const int face, const int vert)
     {
-        Primitive* primitive = (Primitive*)(context->m_pUserData);
-        Attribute* attribute = getAttributeByType(primitive, AttributeType::TEXCOORD_0);
-
-        float* texcoords = (float*)(attribute->elements.get());
+        TangentSpaceData* data = (TangentSpaceData*)(context->m_pUserData);
 
-        int index = primitive->indices[face * 3 + vert] * attribute->componentCount;
+        size_t index = static_cast<size_t>(data->indices[face * 3 + vert]) * data->texcoordComponentCount;
 
-        fvTexcOut[0] = texcoords[index];
-        fvTexcOut[1] = texcoords[index + 1];
+        fvTexcOut[0] = data->texcoords[index];
+        fvTexcOut[1] = data->texcoords[index + 1];
     };
 
     interface.m_setTSpaceBasic = [](const SMikkTSpaceContext* context, const float fvTangent[], const float sign, const int face, const int vert)
     {
-        Primitive* primitive = (Primitive*)(context->m_pUserData);
-        Attribute* attribute = getAttributeByType(primitive, AttributeType::TANGENT);
-
-        float* tangents = (float*)(attribute->elements.get());
+        TangentSpaceData* data = (TangentSpaceData*)(context->m_pUserData);
 
-        int index = primitive->indices[face * 3 + vert] * attribute->componentCount;
+        size_t index = static_cast<size_t>(data->indices[face * 3 + vert]) * 4;
 
-        tangents[index] = fvTangent[0];
-        tangents[index + 1] = fvTangent[1];
-        tangents[index + 2] = fvTangent[2];
-        tangents[index + 3] = sign;
+        data->tangents[index] = fvTangent[0];
+        data->tangents[index + 1] = fvTangent[1];
+        data->tangents[index + 2] = fvTangent[2];
+        data->tangents[index + 3] = sign;
     };
 
     context.m_pInterface = &interface;
@@ -271,15 +566,54 @@ void Loader::details::generateTangents(std::shared_ptr<Primitive> primitive)
     genTangSpaceDefault(&context);
 }
 
-std::vector<std::shared_ptr<Mesh>> Loader::details::processMeshes(std::shared_ptr<tinygltf::Model> gltfScene, const std::vector<std::shared_ptr<Material>>& materials)
+std::vector<std::shared_ptr<Mesh>> Loader::details::processMeshes(std::shared_ptr<tinygltf::Model> gltfScene, const SourceBuffers& sourceBuffers, GLTFGeometrySource* geometrySource, const std::vector<std::shared_ptr<Material>>& materials, ThreadPool& threadPool)
 {
+    // primitives are independent of each other, so they are processed as one flat list and then regrouped per mesh,
+    // keeping the original order so the result is identical to processing them serially
+    std::vector<std::pair<size_t, size_t>> primitiveIndices; // mesh index, primitive index
+    std::vector<std::vector<std::shared_ptr<Primitive>>> processedPrimitives(gltfScene->meshes.size());
+
+    for (size_t meshIndex = 0; meshIndex < gltfScene->meshes.size(); meshIndex++)
+    {
+        processedPrimitives[meshIndex].resize(gltfScene->meshes[meshIndex].primitives.size());
+
+        for (size_t primitiveIndex = 0; primitiveIndex < gltfScene->meshes[meshIndex].primitives.size(); primitiveIndex++)
+        {
+            primitiveIndices.push_back({ meshIndex, primitiveIndex });
+        }
+    }
+
+    threadPool.parallelFor(primitiveIndices.size(), [&](size_t index)
+        {
+            auto [meshIndex, primitiveIndex] = primitiveIndices[index];
+
+            const tinygltf::Primitive& gltfPrimitive = gltfScene->meshes[meshIndex].primitives[primitiveIndex];
+
+            processedPrimitives[meshIndex][primitiveIndex] = (geometrySource != nullptr)
+                ? createPrimitiveLayout(gltfScene, gltfPrimitive, materials)
+                : processPrimitive(gltfScene, sourceBuffers, gltfPrimitive, materials);
+        });
+
     std::vector<std::shared_ptr<Mesh>> meshes;
 
-    for (const auto& gltfMesh : gltfScene->meshes)
+    for (size_t meshIndex = 0; meshIndex < processedPrimitives.size(); meshIndex++)
     {
         std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>();
 
-        mesh->primitives = processPrimitives(gltfScene, gltfMesh, materials);
+        for (size_t primitiveIndex = 0; primitiveIndex < processedPrimitives[meshIndex].size(); primitiveIndex++)
+        {
+            std::shared_ptr<Primitive>& primitive = processedPrimitives[meshIndex][primitiveIndex];
+
+            if (primitive != nullptr)
+            {
+                if (geometrySource != nullptr)
+                {
+                    geometrySource->insertPrimitive(primitive.get(), &gltfScene->meshes[meshIndex].primitives[primitiveIndex]);
+                }
+
+                mesh->primitives.push_back(std::move(primitive));
+            }
+        }
 
         meshes.push_back(mesh);
     }
@@ -287,278 +621,399 @@ std::vector<std::shared_ptr<Mesh>> Loader::details::processMeshes(std::shared_pt
     return meshes;
 }
 
-std::vector<std::shared_ptr<Primitive>> Loader::details::processPrimitives(std::shared_ptr<tinygltf::Model> gltfScene, const tinygltf::Mesh& gltfMesh, const std::vector<std::shared_ptr<Material>>& materials)
+std::shared_ptr<Primitive> Loader::details::processPrimitive(std::shared_ptr<tinygltf::Model> gltfScene, const SourceBuffers& sourceBuffers, const tinygltf::Primitive& gltfPrimitive, const std::vector<std::shared_ptr<Material>>& materials)
 {
-    std::vector<std::shared_ptr<Primitive>> primitives;
+    std::shared_ptr<Primitive> primitive = createPrimitiveLayout(gltfScene, gltfPrimitive, materials);
+
+    if (primitive == nullptr)
+    {
+        return nullptr;
+    }
 
-    for (const auto& gltfPrimitive : gltfMesh.primitives)
+    primitive->indices.resize(primitive->indexCount);
+
+    std::vector<std::byte*> attributeDestinations;
+
+    for (auto& attribute : primitive->attributes)
     {
-        std::shared_ptr<Primitive> primitive = std::make_shared<Primitive>();
+        auto iterator = gltfPrimitive.attributes.find(getAttributeName(attribute.attributeType));
+        const std::byte* inPlaceData = (iterator != gltfPrimitive.attributes.end()) ? getInPlaceAttributeData(gltfScene, sourceBuffers, gltfScene->accessors[iterator->second], attribute.componentCount) : nullptr;
 
-        if (gltfPrimitive.material != -1)
+        if (inPlaceData != nullptr)
         {
-            primitive->material = materials.at(gltfPrimitive.material);
+            // already in the final layout, referenced straight from the mapped file instead of being copied
+            attribute.view = inPlaceData;
+            attribute.viewOwner = sourceBuffers.mappedFile;
+
+            attributeDestinations.push_back(nullptr);
         }
         else
         {
-            //primitive->material = createDefaultMaterial();
+            attribute.elements = std::make_unique_for_overwrite<std::byte[]>(attribute.size);
+
+            attributeDestinations.push_back(attribute.elements.get());
         }
+    }
 
-        if (gltfPrimitive.indices != -1)
-        {
-            tinygltf::Accessor gltfIndices = gltfScene->accessors[gltfPrimitive.indices];
-            tinygltf::BufferView gltfBufferView = gltfScene->bufferViews[gltfIndices.bufferView];
+    writePrimitiveData(gltfScene, sourceBuffers, gltfPrimitive, *primitive, primitive->indices.data(), attributeDestinations);
 
-            int byteStride = (gltfBufferView.byteStride == 0) ? tinygltf::GetComponentSizeInBytes(gltfIndices.componentType) : gltfBufferView.byteStride;
+    if (primitive->boundsMin.x > primitive->boundsMax.x)
+    {
+        computePositionBounds(*primitive);
+    }
 
-            primitive->indices.reserve(gltfIndices.count);
+    return primitive;
+}
 
-            switch (gltfIndices.componentType)
-            {
-            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
-            {
-                std::byte* source = reinterpret_cast<std::byte*>(gltfScene->buffers[gltfBufferView.buffer].data.data() + gltfIndices.byteOffset + gltfBufferView.byteOffset);
+void Loader::details::computePositionBounds(Primitive& primitive)
+{
+    const Attribute* positions = getAttributeByType(&primitive, AttributeType::POSITION);
 
-                for (int i = 0; i < gltfIndices.count; i++)
-                {
-                    primitive->indices.push_back(*(reinterpret_cast<uint32_t*>(source)));
-                    source += byteStride;
-                }
-            }
-            break;
+    if (positions == nullptr || positions->count == 0 || positions->componentCount < 3)
+    {
+        return; // left inverted, the primitive is never culled
+    }
 
-            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-            {
-                std::byte* source = reinterpret_cast<std::byte*>(gltfScene->buffers[gltfBufferView.buffer].data.data() + gltfIndices.byteOffset + gltfBufferView.byteOffset);
+    FrustumCulling::computeBounds(reinterpret_cast<const float*>(positions->getData()), positions->count, static_cast<size_t>(positions->componentCount), primitive.boundsMin, primitive.boundsMax);
+}
 
-                for (int i = 0; i < gltfIndices.count; i++)
-                {
-                    primitive->indices.push_back(*(reinterpret_cast<uint16_t*>(source)));
-                    source += byteStride;
-                }
-            }
-            break;
+std::shared_ptr<Primitive> Loader::details::createPrimitiveLayout(std::shared_ptr<tinygltf::Model> gltfScene, const tinygltf::Primitive& gltfPrimitive, const std::vector<std::shared_ptr<Material>>& materials)
+{
+    if (gltfPrimitive.attributes.find("POSITION") == gltfPrimitive.attributes.end()
+        || gltfPrimitive.attributes.find("NORMAL") == gltfPrimitive.attributes.end()
+        || gltfPrimitive.attributes.find("TEXCOORD_0") == gltfPrimitive.attributes.end())
+    {
+        std::cout << "ERROR: Attempting to load a primitive with missing position, normal or texcoord_0 attribute.\n";
 
-            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-            {
-                std::byte* source = reinterpret_cast<std::byte*>(gltfScene->buffers[gltfBufferView.buffer].data.data() + gltfIndices.byteOffset + gltfBufferView.byteOffset);
+        return nullptr;
+    }
 
-                for (int i = 0; i < gltfIndices.count; i++)
-                {
-                    primitive->indices.push_back(*(reinterpret_cast<uint8_t*>(source)));
-                    source += byteStride;
-                }
-            }
-            break;
+    std::shared_ptr<Primitive> primitive = std::make_shared<Primitive>();
 
-            default:
-                throw std::runtime_error("loader: attempting to load primitive with invalid index type");
-                break;
-            }
-        }
+    if (gltfPrimitive.material != -1)
+    {
+        primitive->material = materials.at(gltfPrimitive.material);
+    }
+    else
+    {
+        //primitive->material = createDefaultMaterial();
+    }
+
+    if (gltfPrimitive.indices != -1)
+    {
+        primitive->indexCount = gltfScene->accessors[gltfPrimitive.indices].count;
+    }
+
+    std::array<const char*, 5> attributeNames{ "POSITION", "NORMAL", "TANGENT", "TEXCOORD_0", "COLOR_0" };
 
-        std::array<const char*, 5> attributeNames{ "POSITION", "NORMAL", "TANGENT", "TEXCOORD_0", "COLOR_0" };
+    for (const auto& attributeName : attributeNames)
+    {
+        auto iterator = gltfPrimitive.attributes.find(attributeName);
 
-        for (const auto& attributeName : attributeNames)
+        if (iterator != gltfPrimitive.attributes.end())
         {
-            if (gltfPrimitive.attributes.find(attributeName) != gltfPrimitive.attributes.end())
-            {
-                tinygltf::Accessor gltfAttribute = gltfScene->accessors[gltfPrimitive.attributes.at(attributeName)]; // TODO: make sure the index here isn't -1?
-                tinygltf::BufferView gltfBufferView = gltfScene->bufferViews[gltfAttribute.bufferView];
+            const tinygltf::Accessor& gltfAttribute = gltfScene->accessors[iterator->second];
 
-                int finalComponentCount = (attributeName == "COLOR_0") ? 4 : tinygltf::GetNumComponentsInType(gltfAttribute.type);
-                int byteStride = (gltfBufferView.byteStride == 0) ? (tinygltf::GetComponentSizeInBytes(gltfAttribute.componentType) * finalComponentCount) : gltfBufferView.byteStride;
+            int finalComponentCount = (std::string_view(attributeName) == "COLOR_0") ? 4 : tinygltf::GetNumComponentsInType(gltfAttribute.type);
 
-                Attribute attribute;
-                attribute.attributeType = convertAttributeName(attributeName);
-                attribute.type = Type::FLOAT;
-                attribute.size = gltfAttribute.count * finalComponentCount * tinygltf::GetComponentSizeInBytes(gltfAttribute.componentType);
-                attribute.count = gltfAttribute.count;
-                attribute.componentCount = finalComponentCount;
+            Attribute attribute;
+            attribute.attributeType = convertAttributeName(attributeName);
+            attribute.type = Type::FLOAT;
+            attribute.size = gltfAttribute.count * finalComponentCount * sizeof(float);
+            attribute.count = gltfAttribute.count;
+            attribute.componentCount = finalComponentCount;
 
-                attribute.elements = std::make_unique_for_overwrite<std::byte[]>(gltfAttribute.count * finalComponentCount * tinygltf::GetComponentSizeInBytes(gltfAttribute.componentType));
+            // glTF requires the bounds of positions, so they are known without reading the data
+            if (attribute.attributeType == AttributeType::POSITION && gltfAttribute.minValues.size() >= 3 && gltfAttribute.maxValues.size() >= 3)
+            {
+                primitive->boundsMin = glm::vec3(gltfAttribute.minValues[0], gltfAttribute.minValues[1], gltfAttribute.minValues[2]);
+                primitive->boundsMax = glm::vec3(gltfAttribute.maxValues[0], gltfAttribute.maxValues[1], gltfAttribute.maxValues[2]);
+            }
 
-                std::unique_ptr<float[]> denormalized = nullptr;
+            primitive->attributes.push_back(std::move(attribute));
+        }
+    }
 
-                std::byte* source = reinterpret_cast<std::byte*>(gltfScene->buffers[gltfBufferView.buffer].data.data() + gltfAttribute.byteOffset + gltfBufferView.byteOffset);
+    if (gltfPrimitive.attributes.find("TANGENT") == gltfPrimitive.attributes.end())
+    {
+        // generated from the other attributes when the data is written
+        Attribute tangentAttribute;
+        tangentAttribute.attributeType = AttributeType::TANGENT;
+        tangentAttribute.componentCount = 4;
+        tangentAttribute.count = getAttributeByType(primitive.get(), AttributeType::NORMAL)->count;
+        tangentAttribute.type = Type::FLOAT;
+        tangentAttribute.size = tangentAttribute.count * tangentAttribute.componentCount * sizeof(float);
+
+        primitive->attributes.push_back(std::move(tangentAttribute));
+    }
 
-                if (gltfAttribute.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE)
-                {
-                    denormalized = getDenormalizedByteAccessorData(reinterpret_cast<uint8_t*>(source), gltfAttribute.count, tinygltf::GetNumComponentsInType(gltfAttribute.type), gltfBufferView.byteStride);
-                    source = reinterpret_cast<std::byte*>(denormalized.get());
-                    byteStride = sizeof(float) * finalComponentCount;
-                }
-                else if (gltfAttribute.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
-                {
-                    denormalized = getDenormalizedShortAccessorData(reinterpret_cast<uint16_t*>(source), gltfAttribute.count, tinygltf::GetNumComponentsInType(gltfAttribute.type), gltfBufferView.byteStride);
-                    source = reinterpret_cast<std::byte*>(denormalized.get());
-                    byteStride = sizeof(float) * finalComponentCount;
-                }
+    return primitive;
+}
 
-                if (finalComponentCount == tinygltf::GetNumComponentsInType(gltfAttribute.type))
-                {
-                    copyAccessorToDestination(
-                        source, attribute.elements.get(), gltfAttribute.count, tinygltf::GetNumComponentsInType(gltfAttribute.type),
-                        tinygltf::GetComponentSizeInBytes(gltfAttribute.componentType), byteStride
-                    );
-                }
-                else
-                {
-                    float fillerValue = 1.0f; // for color attributes, where the filled alpha value is 1.0f
-                    copyMismatchedAccessorToDestination(
-                        source, attribute.elements.get(), gltfAttribute.count, tinygltf::GetNumComponentsInType(gltfAttribute.type),
-                        finalComponentCount, &fillerValue, tinygltf::GetComponentSizeInBytes(gltfAttribute.componentType), byteStride
-                    );
-                }
+void Loader::details::writePrimitiveData(
+    std::shared_ptr<tinygltf::Model> gltfScene, const SourceBuffers& sourceBuffers, const tinygltf::Primitive& gltfPrimitive,
+    const Primitive& primitive, uint32_t* indexDestination, const std::vector<std::byte*>& attributeDestinations)
+{
+    if (gltfPrimitive.indices != -1 && indexDestination != nullptr)
+    {
+        const tinygltf::Accessor& gltfIndices = gltfScene->accessors[gltfPrimitive.indices];
+        const tinygltf::BufferView& gltfBufferView = gltfScene->bufferViews[gltfIndices.bufferView];
 
-                primitive->attributes.push_back(std::move(attribute));
-            }
-        }
+        int byteStride = (gltfBufferView.byteStride == 0) ? tinygltf::GetComponentSizeInBytes(gltfIndices.componentType) : gltfBufferView.byteStride;
 
-        if (gltfPrimitive.attributes.find("POSITION") != gltfPrimitive.attributes.end()
-            && gltfPrimitive.attributes.find("NORMAL") != gltfPrimitive.attributes.end()
-            && gltfPrimitive.attributes.find("TEXCOORD_0") != gltfPrimitive.attributes.end())
+        switch (gltfIndices.componentType)
+        {
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
         {
-            if (gltfPrimitive.attributes.find("TANGENT") == gltfPrimitive.attributes.end())
+            const std::byte* source = getAccessorData(gltfScene, sourceBuffers, gltfIndices, tinygltf::GetComponentSizeInBytes(gltfIndices.componentType));
+
+            for (size_t i = 0; i < gltfIndices.count; i++)
             {
-                generateTangents(primitive);
+                indexDestination[i] = *(reinterpret_cast<const uint32_t*>(source));
+                source += byteStride;
             }
-
-            primitives.push_back(primitive);
         }
-        else
+        break;
+
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
         {
-            std::cout << "ERROR: Attempting to load a primitive with missing position, normal or texcoord_0 attribute.\n";
+            const std::byte* source = getAccessorData(gltfScene, sourceBuffers, gltfIndices, tinygltf::GetComponentSizeInBytes(gltfIndices.componentType));
+
+            for (size_t i = 0; i < gltfIndices.count; i++)
+            {
+                indexDestination[i] = *(reinterpret_cast<const uint16_t*>(source));
+                source += byteStride;
+            }
         }
-    }
+        break;
 
-    return primitives;
-}
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+        {
+            const std::byte* source = getAccessorData(gltfScene, sourceBuffers, gltfIndices, tinygltf::GetComponentSizeInBytes(gltfIndices.componentType));
 
-std::shared_ptr<Node> Loader::details::processNodeHierarchy(std::shared_ptr<tinygltf::Model> gltfScene, const tinygltf::Node& gltfNode, const std::vector<std::shared_ptr<Mesh>>& meshes)
-{
-    std::shared_ptr<Node> node = processNode(gltfNode, meshes);
+            for (size_t i = 0; i < gltfIndices.count; i++)
+            {
+                indexDestination[i] = *(reinterpret_cast<const uint8_t*>(source));
+                source += byteStride;
+            }
+        }
+        break;
 
-    for (int index : gltfNode.children)
-    {
-        node->children.push_back(processNodeHierarchy(gltfScene, gltfScene->nodes.at(index), meshes));
+        default:
+            throw std::runtime_error("loader: attempting to load primitive with invalid index type");
+            break;
+        }
     }
 
-    return node;
-}
-
-std::shared_ptr<Node> Loader::details::processNode(const tinygltf::Node& gltfNode, const std::vector<std::shared_ptr<Mesh>>& meshes)
-{
-    std::shared_ptr<Node> node = std::make_shared<Node>();
+    TangentSpaceData tangentSpaceData;
+    bool generateTangentData = false;
 
-    if (gltfNode.matrix.size() != 0)
-    {
-        node->transform = glm::make_mat4(gltfNode.matrix.data());
-    }
-    else
+    for (size_t i = 0; i < primitive.attributes.size(); i++)
     {
-        glm::mat4 scale(1.0f);
-        glm::mat4 rotate(1.0f);
-        glm::mat4 translate(1.0f);
+        const Attribute& attribute = primitive.attributes[i];
+        std::byte* destination = attributeDestinations[i];
 
-        if (gltfNode.translation.size() != 0)
+        const float* data = reinterpret_cast<const float*>((destination != nullptr) ? destination : attribute.getData());
+
+        switch (attribute.attributeType)
         {
-            translate = glm::translate(translate, glm::vec3(gltfNode.translation[0], gltfNode.translation[1], gltfNode.translation[2]));
+        case AttributeType::POSITION:
+            tangentSpaceData.positions = data;
+            tangentSpaceData.positionComponentCount = attribute.componentCount;
+            break;
+        case AttributeType::NORMAL:
+            tangentSpaceData.normals = data;
+            tangentSpaceData.normalComponentCount = attribute.componentCount;
+            break;
+        case AttributeType::TEXCOORD_0:
+            tangentSpaceData.texcoords = data;
+            tangentSpaceData.texcoordComponentCount = attribute.componentCount;
+            break;
+        case AttributeType::TANGENT:
+            tangentSpaceData.tangents = reinterpret_cast<float*>(destination);
+            break;
+        default:
+            break;
         }
-        if (gltfNode.rotation.size() != 0)
+
+        auto iterator = gltfPrimitive.attributes.find(getAttributeName(attribute.attributeType));
+
+        if (iterator == gltfPrimitive.attributes.end())
         {
-            rotate = glm::toMat4(glm::quat(gltfNode.rotation[3], gltfNode.rotation[0], gltfNode.rotation[1], gltfNode.rotation[2]));
+            generateTangentData = (attribute.attributeType == AttributeType::TANGENT);
+
+            continue;
         }
-        if (gltfNode.scale.size() != 0)
+
+        if (destination == nullptr)
         {
-            scale = glm::scale(scale, glm::vec3(gltfNode.scale[0], gltfNode.scale[1], gltfNode.scale[2]));
+            continue; // referenced in place
         }
 
-        node->transform = translate * rotate * scale * node->transform;
+        const tinygltf::Accessor& gltfAttribute = gltfScene->accessors[iterator->second];
+        const tinygltf::BufferView& gltfBufferView = gltfScene->bufferViews[gltfAttribute.bufferView];
+
+        int sourceComponentCount = tinygltf::GetNumComponentsInType(gltfAttribute.type);
+
+        const std::byte* source = getAccessorData(gltfScene, sourceBuffers, gltfAttribute, tinygltf::GetComponentSizeInBytes(gltfAttribute.componentType) * sourceComponentCount);
+
+        AccessorConversion::convertAccessor(
+            source, reinterpret_cast<float*>(destination), gltfAttribute.count, convertComponentType(gltfAttribute.componentType), gltfAttribute.normalized,
+            sourceComponentCount, attribute.componentCount, gltfBufferView.byteStride, 1.0f // for color attributes, where the filled alpha value is 1.0f
+        );
+    }
+
+    if (generateTangentData && tangentSpaceData.tangents != nullptr)
+    {
+        tangentSpaceData.indices = indexDestination;
+        tangentSpaceData.indexCount = (indexDestination != nullptr) ? primitive.indexCount : 0;
+
+        generateTangents(tangentSpaceData);
     }
+}
+
+const std::byte* Loader::details::getInPlaceAttributeData(std::shared_ptr<tinygltf::Model> gltfScene, const SourceBuffers& sourceBuffers, const tinygltf::Accessor& gltfAttribute, int finalComponentCount)
+{
+    const tinygltf::BufferView& gltfBufferView = gltfScene->bufferViews.at(gltfAttribute.bufferView);
 
-    if (gltfNode.mesh != -1)
+    int sourceComponentCount = tinygltf::GetNumComponentsInType(gltfAttribute.type);
+
+    if (!sourceBuffers.mapped.at(gltfBufferView.buffer) || gltfAttribute.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT || sourceComponentCount != finalComponentCount
+        || (gltfBufferView.byteStride != 0 && gltfBufferView.byteStride != sizeof(float) * sourceComponentCount))
     {
-        node->mesh = meshes.at(gltfNode.mesh);
+        return nullptr;
     }
 
-    return node;
+    const std::byte* source = getAccessorData(gltfScene, sourceBuffers, gltfAttribute, sizeof(float) * sourceComponentCount);
+
+    return (reinterpret_cast<uintptr_t>(source) % alignof(float) == 0) ? source : nullptr;
 }
 
-std::shared_ptr<Material> Loader::details::createDefaultMaterial()
+Loader::details::GLTFGeometrySource::GLTFGeometrySource(std::shared_ptr<tinygltf::Model> gltfScene, const SourceBuffers& sourceBuffers)
+    : _gltfScene(gltfScene), _sourceBuffers(sourceBuffers)
 {
-    std::shared_ptr<Material> material = std::make_shared<Material>();
-    material->materialTypeName = "glTFPBR";
+}
 
-    return material;
+void Loader::details::GLTFGeometrySource::insertPrimitive(const Primitive* primitive, const tinygltf::Primitive* gltfPrimitive)
+{
+    _primitives[primitive] = gltfPrimitive;
 }
 
-void Loader::details::copyAccessorToDestination(std::byte* source, std::byte* destination, size_t count, size_t componentCount, size_t componentSize, size_t byteStride)
+void Loader::details::GLTFGeometrySource::writePrimitive(const Primitive& primitive, uint32_t* indexDestination, const std::vector<std::byte*>& attributeDestinations) const
 {
-    for (int i = 0; i < count; i++)
-    {
-        memcpy(destination, source, componentCount * componentSize);
+    auto iterator = _primitives.find(&primitive);
 
-        destination += componentCount * componentSize;
-        source += byteStride;
+    if (iterator == _primitives.end())
+    {
+        throw std::runtime_error("loader: attempting to write geometry of a primitive that does not belong to the source");
     }
+
+    writePrimitiveData(_gltfScene, _sourceBuffers, *iterator->second, primitive, indexDestination, attributeDestinations);
 }
 
-void Loader::details::copyMismatchedAccessorToDestination(std::byte* source, std::byte* destination, size_t count, size_t sourceComponentCount, size_t destinationComponentCount, void* fillerValue, size_t componentSize, size_t byteStride)
+SceneGraph Loader::details::processNodes(std::shared_ptr<tinygltf::Model> gltfScene, const std::vector<int>& rootNodes, size_t meshCount)
 {
-    for (int i = 0; i < count; i++)
+    SceneGraph nodes;
+
+    // glTF node indices in breadth first order together with the index of their parent in the scene graph,
+    // every entry becomes the scene graph node with the same index
+    std::vector<std::pair<int, int32_t>> queue;
+    std::vector<bool> visited(gltfScene->nodes.size(), false);
+
+    for (int nodeIndex : rootNodes)
     {
-        memcpy(destination, source, sourceComponentCount * componentSize);
-        destination += sourceComponentCount * componentSize;
+        queue.push_back({ nodeIndex, SceneGraph::noParent });
+    }
+
+    for (size_t head = 0; head < queue.size(); head++)
+    {
+        auto [nodeIndex, parent] = queue[head];
+
+        const tinygltf::Node& gltfNode = gltfScene->nodes.at(nodeIndex);
+
+        if (visited[nodeIndex])
+        {
+            throw std::runtime_error("loader: node hierarchy is not a tree");
+        }
+
+        visited[nodeIndex] = true;
 
-        for (int i = 0; i < (destinationComponentCount - sourceComponentCount); i++)
+        if (gltfNode.mesh < -1 || gltfNode.mesh >= static_cast<int>(meshCount))
         {
-            memcpy(destination, fillerValue, 1);
-            destination += 1;
+            throw std::runtime_error("loader: node references a missing mesh");
         }
 
-        source += byteStride;
+        uint32_t index = nodes.addNode(parent, processNodeTransform(gltfNode), gltfNode.mesh);
+
+        for (int childIndex : gltfNode.children)
+        {
+            queue.push_back({ childIndex, static_cast<int32_t>(index) });
+        }
     }
+
+    return nodes;
 }
 
-std::unique_ptr<float[]> Loader::details::getDenormalizedByteAccessorData(uint8_t* source, size_t count, size_t componentCount, size_t byteStride)
+glm::mat4 Loader::details::processNodeTransform(const tinygltf::Node& gltfNode)
 {
-    std::unique_ptr<float[]> data = std::make_unique_for_overwrite<float[]>(count * componentCount);
+    glm::mat4 transform(1.0f);
 
-    size_t maximum = std::powl(2, sizeof(uint8_t) * 8) - 1;
-
-    for (int i = 0; i < count * componentCount; i += componentCount)
+    if (gltfNode.matrix.size() != 0)
+    {
+        transform = glm::make_mat4(gltfNode.matrix.data());
+    }
+    else
     {
-        for (int j = 0; j < componentCount; j++)
+        glm::mat4 scale(1.0f);
+        glm::mat4 rotate(1.0f);
+        glm::mat4 translate(1.0f);
+
+        if (gltfNode.translation.size() != 0)
         {
-            data.get()[i + j] = static_cast<float>(source[j]) / maximum;
+            translate = glm::translate(translate, glm::vec3(gltfNode.translation[0], gltfNode.translation[1], gltfNode.translation[2]));
+        }
+        if (gltfNode.rotation.size() != 0)
+        {
+            rotate = glm::toMat4(glm::quat(gltfNode.rotation[3], gltfNode.rotation[0], gltfNode.rotation[1], gltfNode.rotation[2]));
+        }
+        if (gltfNode.scale.size() != 0)
+        {
+            scale = glm::scale(scale, glm::vec3(gltfNode.scale[0], gltfNode.scale[1], gltfNode.scale[2]));
         }
 
-        source += byteStride;
+        transform = translate * rotate * scale;
     }
 
-    return data;
+    return transform;
 }
 
-std::unique_ptr<float[]> Loader::details::getDenormalizedShortAccessorData(uint16_t* source, size_t count, size_t componentCount, size_t byteStride)
+std::shared_ptr<Material> Loader::details::createDefaultMaterial()
 {
-    // TODO: assert byteStride is a multiple of: sizeof(uint16_t) * componentCount 
-
-    std::unique_ptr<float[]> data = std::make_unique_for_overwrite<float[]>(count * componentCount);
+    std::shared_ptr<Material> material = std::make_shared<Material>();
+    material->materialTypeName = "glTFPBR";
 
-    size_t maximum = std::powl(2, sizeof(uint16_t) * 8) - 1;
+    return material;
+}
 
-    for (int i = 0; i < count * componentCount; i += componentCount)
+AccessorConversion::ComponentType Loader::details::convertComponentType(int gltfComponentType)
+{
+    switch (gltfComponentType)
     {
-        for (int j = 0; j < componentCount; j++)
-        {
-            data.get()[i + j] = static_cast<float>(source[j]) / maximum;
-        }
-
-        source = reinterpret_cast<uint16_t*>((reinterpret_cast<uint8_t*>(source) + byteStride));
+    case TINYGLTF_COMPONENT_TYPE_BYTE:
+        return AccessorConversion::ComponentType::INT8;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+        return AccessorConversion::ComponentType::UINT8;
+    case TINYGLTF_COMPONENT_TYPE_SHORT:
+        return AccessorConversion::ComponentType::INT16;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+        return AccessorConversion::ComponentType::UINT16;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+        return AccessorConversion::ComponentType::UINT32;
+    case TINYGLTF_COMPONENT_TYPE_FLOAT:
+        return AccessorConversion::ComponentType::FLOAT;
+    default:
+        throw std::runtime_error("loader: attempting to load accessor with invalid component type");
     }
-
-    return data;
 }
 
 Attribute* Loader::details::getAttributeByType(Primitive* primitive, AttributeType type)
@@ -602,3 +1057,22 @@ AttributeType Loader::details::convertAttributeName(const std::string& attribute
         return AttributeType::UNDEFINED;
     }
 }
+
+const char* Loader::details::getAttributeName(AttributeType attributeType)
+{
+    switch (attributeType)
+    {
+    case AttributeType::POSITION:
+        return "POSITION";
+    case AttributeType::NORMAL:
+        return "NORMAL";
+    case AttributeType::TANGENT:
+        return "TANGENT";
+    case AttributeType::TEXCOORD_0:
+        return "TEXCOORD_0";
+    case AttributeType::COLOR_0:
+        return "COLOR_0";
+    default:
+        return "";
+    }
+}
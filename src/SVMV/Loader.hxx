@@ -11,13 +11,22 @@
 #include <vulkan/vulkan.hpp>
 
 #include <SVMV/Scene.hxx>
-#include <SVMV/Node.hxx>
+#include <SVMV/SceneGraph.hxx>
 #include <SVMV/Mesh.hxx>
 #include <SVMV/Primitive.hxx>
 #include <SVMV/Attribute.hxx>
 #include <SVMV/Material.hxx>
 #include <SVMV/Property.hxx>
 #include <SVMV/Texture.hxx>
+#include <SVMV/TextureCompression.hxx>
+#include <SVMV/KTX2.hxx>
+#include <SVMV/ImageDecoder.hxx>
+#include <SVMV/ThreadPool.hxx>
+#include <SVMV/AccessorConversion.hxx>
+#include <SVMV/SceneCache.hxx>
+#include <SVMV/MappedFile.hxx>
+#include <SVMV/GeometrySource.hxx>
+#include <SVMV/FrustumCulling.hxx>
 
 #include <memory>
 #include <string>
@@ -25,23 +34,108 @@
 #include <vector>
 #include <array>
 #include <unordered_set>
+#include <unordered_map>
+#include <map>
+#include <thread>
+#include <span>
+#include <filesystem>
+#include <limits>
+#include <numeric>
+#include <algorithm>
 
 namespace SVMV
 {
     namespace Loader
     {
-        std::shared_ptr<Scene> loadScene(const std::string& filePath);
+        struct LoadOptions
+        {
+            unsigned threadCount{ std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1u }; // 1 processes everything on the calling thread
+            bool useSceneCache{ true }; // reuse (and write) a processed copy of the scene stored next to the source file
+            bool deferGeometry{ false }; // only describe the primitives, their data is written later through Scene::geometrySource
+            bool compressTextures{ false }; // block compress the textures of materials (BC7, BC5 or BC4 depending on their use), the device has to support BC formats
+        };
+
+        std::shared_ptr<Scene> loadScene(const std::string& filePath, const LoadOptions& options = LoadOptions());
 
         void appendScene(std::shared_ptr<Scene> scene, const std::string& filePath, glm::mat4 appendedSceneTransformOffset = glm::mat4(0.0f)); // TODO
-        void appendScene(std::shared_ptr<Scene> scene, std::shared_ptr<Node> node, glm::mat4 appendedSceneTransformOffset = glm::mat4(0.0f)); // TODO
+        void appendScene(std::shared_ptr<Scene> scene, const SceneGraph& nodes, glm::mat4 appendedSceneTransformOffset = glm::mat4(0.0f)); // TODO
 
         namespace details
         {
-            std::shared_ptr<Scene> processScene(std::shared_ptr<tinygltf::Model> gltfScene);
+            // where accessor data is read from, buffers of binary glTF files point straight into the memory-mapped file
+            struct SourceBuffers
+            {
+                std::vector<std::span<const std::byte>> buffers;
+                std::vector<bool> mapped; // whether the buffer lives in mappedFile, attributes can then reference it without a copy
+
+                std::shared_ptr<const MappedFile> mappedFile;
+            };
+
+            bool isBinaryGLTF(const std::byte* data, size_t size);
+            std::span<const std::byte> findBinaryChunk(const std::byte* data, size_t size); // BIN chunk of a GLB file, empty if there is none
+            SourceBuffers getSourceBuffers(std::shared_ptr<tinygltf::Model> gltfScene, std::shared_ptr<const MappedFile> mappedFile, bool binary);
+            const std::byte* getAccessorData(std::shared_ptr<tinygltf::Model> gltfScene, const SourceBuffers& sourceBuffers, const tinygltf::Accessor& gltfAccessor, size_t elementSize);
+
+            std::vector<std::string> getExternalDependencies(std::shared_ptr<tinygltf::Model> gltfScene); // files referenced by URI, relative to the source file
+
+            // writes the geometry of primitives loaded with LoadOptions::deferGeometry, keeps the parsed glTF file and its buffers alive
+            class GLTFGeometrySource : public GeometrySource
+            {
+            public:
+                GLTFGeometrySource(std::shared_ptr<tinygltf::Model> gltfScene, const SourceBuffers& sourceBuffers);
+
+                void insertPrimitive(const Primitive* primitive, const tinygltf::Primitive* gltfPrimitive);
+
+                void writePrimitive(const Primitive& primitive, uint32_t* indexDestination, const std::vector<std::byte*>& attributeDestinations) const override;
+
+            private:
+                std::shared_ptr<tinygltf::Model> _gltfScene;
+                SourceBuffers _sourceBuffers;
+
+                std::unordered_map<const Primitive*, const tinygltf::Primitive*> _primitives;
+            };
+
+            // inputs of the MikkTSpace callbacks, attribute data is tightly packed floats
+            struct TangentSpaceData
+            {
+                const uint32_t* indices         { nullptr };
+                size_t indexCount               { 0 };
+
+                const float* positions          { nullptr };
+                const float* normals            { nullptr };
+                const float* texcoords          { nullptr };
+                float* tangents                 { nullptr }; // 4 components per vertex
+
+                int positionComponentCount      { 3 };
+                int normalComponentCount        { 3 };
+                int texcoordComponentCount      { 2 };
+            };
+
+            std::shared_ptr<Scene> processScene(std::shared_ptr<tinygltf::Model> gltfScene, const SourceBuffers& sourceBuffers, GLTFGeometrySource* geometrySource, ThreadPool& threadPool); // primitives only get a layout when geometrySource is set
+
+            std::vector<std::shared_ptr<Material>> processMaterials(std::shared_ptr<tinygltf::Model> gltfScene, ThreadPool& threadPool);
+
+            std::vector<std::shared_ptr<Texture>> processTextures(std::shared_ptr<tinygltf::Model> gltfScene, ThreadPool& threadPool);
+            std::vector<std::shared_ptr<Texture>> decodeImages(std::shared_ptr<tinygltf::Model> gltfScene, ThreadPool& threadPool); // one texture per image a texture resolves to and null for the rest, releases the encoded bytes
+            int getImageSource(const tinygltf::Texture& gltfTexture); // -1 if the texture has none
+
+            // image loader callback of tinygltf that only records the encoded bytes, marked with Image::as_is
+            bool loadImageData(
+                tinygltf::Image* image, const int imageIndex, std::string* error, std::string* warning,
+                int requiredWidth, int requiredHeight, const unsigned char* bytes, int size, void* userData
+            );
+
+            // how a texture is compressed depends on the material property it is used for
+            struct TextureUsage
+            {
+                TextureEncoding encoding    { TextureEncoding::RGBA8 };
+                bool srgb                   { false }; // color data, filtered in linear space
 
-            std::vector<std::shared_ptr<Material>> processMaterials(std::shared_ptr<tinygltf::Model> gltfScene);
+                auto operator<=>(const TextureUsage&) const = default;
+            };
 
-            std::vector<std::shared_ptr<Texture>> processTextures(std::shared_ptr<tinygltf::Model> gltfScene);
+            TextureUsage getTextureUsage(const std::string& propertyName); // properties that are not known stay uncompressed
+            void compressTextures(const std::vector<std::shared_ptr<Material>>& materials, ThreadPool& threadPool); // textures used in several ways get one copy per encoding
 
             void processAndInsertFloatProperty(std::shared_ptr<Material> targetMaterial, const std::string& name, float gltfFloat);
             void processAndInsertFloatVector4Property(std::shared_ptr<Material> targetMaterial, const std::string& name, const std::vector<double>& gltfFactor);
@@ -49,25 +143,29 @@ namespace SVMV
             void processAndInsertTextureProperty(const std::vector<std::shared_ptr<Texture>>& textures, std::shared_ptr<Material> targetMaterial, const std::string& name, const tinygltf::NormalTextureInfo& gltfTextureInfo);
             void processAndInsertTextureProperty(const std::vector<std::shared_ptr<Texture>>& textures, std::shared_ptr<Material> targetMaterial, const std::string& name, const tinygltf::OcclusionTextureInfo& gltfTextureInfo);
 
-            void generateTangents(std::shared_ptr<Primitive> primitive);
+            void generateTangents(const TangentSpaceData& data);
 
-            std::vector<std::shared_ptr<Mesh>> processMeshes(std::shared_ptr<tinygltf::Model> gltfScene, const std::vector<std::shared_ptr<Material>>& materials);
-            std::vector<std::shared_ptr<Primitive>> processPrimitives(std::shared_ptr<tinygltf::Model> gltfScene, const tinygltf::Mesh& gltfMesh, const std::vector<std::shared_ptr<Material>>& materials);
+            std::vector<std::shared_ptr<Mesh>> processMeshes(std::shared_ptr<tinygltf::Model> gltfScene, const SourceBuffers& sourceBuffers, GLTFGeometrySource* geometrySource, const std::vector<std::shared_ptr<Material>>& materials, ThreadPool& threadPool);
+            std::shared_ptr<Primitive> processPrimitive(std::shared_ptr<tinygltf::Model> gltfScene, const SourceBuffers& sourceBuffers, const tinygltf::Primitive& gltfPrimitive, const std::vector<std::shared_ptr<Material>>& materials); // returns nullptr for unsupported primitives
+            std::shared_ptr<Primitive> createPrimitiveLayout(std::shared_ptr<tinygltf::Model> gltfScene, const tinygltf::Primitive& gltfPrimitive, const std::vector<std::shared_ptr<Material>>& materials); // material, counts and attribute metadata without any data
+            void writePrimitiveData(
+                std::shared_ptr<tinygltf::Model> gltfScene, const SourceBuffers& sourceBuffers, const tinygltf::Primitive& gltfPrimitive,
+                const Primitive& primitive, uint32_t* indexDestination, const std::vector<std::byte*>& attributeDestinations); // null attribute destinations are skipped
+            void computePositionBounds(Primitive& primitive); // from the written positions, for accessors without min and max
+            const std::byte* getInPlaceAttributeData(std::shared_ptr<tinygltf::Model> gltfScene, const SourceBuffers& sourceBuffers, const tinygltf::Accessor& gltfAttribute, int finalComponentCount); // nullptr if the data needs a conversion
 
-            std::shared_ptr<Node> processNodeHierarchy(std::shared_ptr<tinygltf::Model> gltfScene, const tinygltf::Node& gltfNode, const std::vector<std::shared_ptr<Mesh>>& meshes);
-            std::shared_ptr<Node> processNode(const tinygltf::Node& gltfNode, const std::vector<std::shared_ptr<Mesh>>& meshes);
+            SceneGraph processNodes(std::shared_ptr<tinygltf::Model> gltfScene, const std::vector<int>& rootNodes, size_t meshCount); // breadth first, without recursion
+            glm::mat4 processNodeTransform(const tinygltf::Node& gltfNode);
 
             std::shared_ptr<Material> createDefaultMaterial();
 
-            void copyAccessorToDestination(std::byte* source, std::byte* destination, size_t count, size_t componentCount, size_t componentSize, size_t byteStride);
-            void copyMismatchedAccessorToDestination(std::byte* source, std::byte* destination, size_t count, size_t sourceComponentCount, size_t destinationComponentCount, void* fillerValue, size_t componentSize, size_t byteStride);
+            AccessorConversion::ComponentType convertComponentType(int gltfComponentType);
 
-            std::unique_ptr<float[]> getDenormalizedByteAccessorData(uint8_t* source, size_t count, size_t componentCount, size_t byteStride);
-            std::unique_ptr<float[]> getDenormalizedShortAccessorData(uint16_t* source, size_t count, size_t componentCount, size_t byteStride);
 
             Attribute* getAttributeByType(Primitive* primitive, AttributeType type);
 
             AttributeType convertAttributeName(const std::string& attributeName);
+            const char* getAttributeName(AttributeType attributeType);
         }
     }
 }
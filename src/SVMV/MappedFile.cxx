@@ -0,0 +1,209 @@
+#include <SVMV/MappedFile.hxx>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace SVMV;
+
+MappedFile::MappedFile(const std::string& filePath)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error("mapped file: failed to open file: " + filePath);
+    }
+
+    _file = file;
+
+    LARGE_INTEGER fileSize = {};
+
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        release();
+        throw std::runtime_error("mapped file: failed to query file size: " + filePath);
+    }
+
+    _size = static_cast<size_t>(fileSize.QuadPart);
+
+    if (_size == 0)
+    {
+        _open = true;
+
+        return; // empty files cannot be mapped, they are represented by a null pointer and a size of 0
+    }
+
+    _mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (_mapping == nullptr)
+    {
+        release();
+        throw std::runtime_error("mapped file: failed to create file mapping: " + filePath);
+    }
+
+    _data = reinterpret_cast<const std::byte*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+
+    if (_data == nullptr)
+    {
+        release();
+        throw std::runtime_error("mapped file: failed to map file: " + filePath);
+    }
+#else
+    _fileDescriptor = open(filePath.c_str(), O_RDONLY);
+
+    if (_fileDescriptor == -1)
+    {
+        throw std::runtime_error("mapped file: failed to open file: " + filePath);
+    }
+
+    struct stat fileStatus = {};
+
+    if (fstat(_fileDescriptor, &fileStatus) != 0)
+    {
+        release();
+        throw std::runtime_error("mapped file: failed to query file size: " + filePath);
+    }
+
+    _size = static_cast<size_t>(fileStatus.st_size);
+
+    if (_size == 0)
+    {
+        _open = true;
+
+        return; // empty files cannot be mapped, they are represented by a null pointer and a size of 0
+    }
+
+    void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fileDescriptor, 0);
+
+    if (data == MAP_FAILED)
+    {
+        release();
+        throw std::runtime_error("mapped file: failed to map file: " + filePath);
+    }
+
+    _data = reinterpret_cast<const std::byte*>(data);
+
+    madvise(data, _size, MADV_SEQUENTIAL);
+#endif
+
+    _open = true;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    this->_data = other._data;
+    this->_size = other._size;
+    this->_open = other._open;
+#ifdef _WIN32
+    this->_file = other._file;
+    this->_mapping = other._mapping;
+
+    other._file = nullptr;
+    other._mapping = nullptr;
+#else
+    this->_fileDescriptor = other._fileDescriptor;
+
+    other._fileDescriptor = -1;
+#endif
+
+    other._data = nullptr;
+    other._size = 0;
+    other._open = false;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+
+        this->_data = other._data;
+        this->_size = other._size;
+        this->_open = other._open;
+#ifdef _WIN32
+        this->_file = other._file;
+        this->_mapping = other._mapping;
+
+        other._file = nullptr;
+        other._mapping = nullptr;
+#else
+        this->_fileDescriptor = other._fileDescriptor;
+
+        other._fileDescriptor = -1;
+#endif
+
+        other._data = nullptr;
+        other._size = 0;
+        other._open = false;
+    }
+
+    return *this;
+}
+
+MappedFile::~MappedFile()
+{
+    release();
+}
+
+MappedFile::operator bool() const noexcept
+{
+    return _open;
+}
+
+const std::byte* MappedFile::getData() const noexcept
+{
+    return _data;
+}
+
+size_t MappedFile::getSize() const noexcept
+{
+    return _size;
+}
+
+void MappedFile::release() noexcept
+{
+#ifdef _WIN32
+    if (_data != nullptr)
+    {
+        UnmapViewOfFile(_data);
+    }
+
+    if (_mapping != nullptr)
+    {
+        CloseHandle(_mapping);
+    }
+
+    if (_file != nullptr)
+    {
+        CloseHandle(_file);
+    }
+
+    _file = nullptr;
+    _mapping = nullptr;
+#else
+    if (_data != nullptr)
+    {
+        munmap(const_cast<std::byte*>(_data), _size);
+    }
+
+    if (_fileDescriptor != -1)
+    {
+        close(_fileDescriptor);
+    }
+
+    _fileDescriptor = -1;
+#endif
+
+    _data = nullptr;
+    _size = 0;
+    _open = false;
+}
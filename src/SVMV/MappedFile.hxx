@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <stdexcept>
+
+namespace SVMV
+{
+    // read-only memory mapping of a whole file, the mapping stays valid for the lifetime of the object
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        MappedFile(const std::string& filePath);
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        ~MappedFile();
+
+        operator bool() const noexcept;
+
+        [[nodiscard]] const std::byte* getData() const noexcept;
+        [[nodiscard]] size_t getSize() const noexcept;
+
+    private:
+        void release() noexcept;
+
+    private:
+        const std::byte* _data  { nullptr };
+        size_t _size            { 0 };
+        bool _open              { false };
+
+#ifdef _WIN32
+        void* _file             { nullptr };
+        void* _mapping          { nullptr };
+#else
+        int _fileDescriptor     { -1 };
+#endif
+    };
+}
@@ -9,6 +9,7 @@
 #include <set>
 #include <memory>
 #include <algorithm>
+#include <limits>
 
 namespace SVMV
 {
@@ -18,8 +19,18 @@ namespace SVMV
     struct Primitive
     {
         std::vector<uint32_t> indices;
+        size_t indexCount{ 0 }; // also set when the geometry is deferred and indices is empty
+        const uint32_t* indexView{ nullptr }; // used instead of indices when they are read in place, e.g. from a memory-mapped file
+        std::shared_ptr<const void> indexViewOwner; // keeps the memory behind indexView alive
         std::vector<Attribute> attributes;
 
+        // object space bounds of the positions, left inverted when they are unknown
+        glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+        glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+
         std::shared_ptr<Material> material;
+
+        const uint32_t* getIndices() const noexcept { return (indexView != nullptr) ? indexView : indices.data(); }
+        bool isDeferred() const noexcept // the geometry source writes the data later { return indexView == nullptr && indices.size() != indexCount; }
     };
 }
\ No newline at end of file
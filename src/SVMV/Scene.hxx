@@ -1,19 +1,23 @@
 #pragma once
 
+#include <SVMV/SceneGraph.hxx>
+
 #include <memory>
 #include <vector>
 
 namespace SVMV
 {
-    struct Node;
     struct Mesh;
     struct Material;
+    class GeometrySource;
 
     struct Scene
     {
-        std::shared_ptr<Node> root;
+        SceneGraph nodes; // mesh indices refer to meshes
 
         std::vector<std::shared_ptr<Mesh>> meshes;
         std::vector<std::shared_ptr<Material>> materials;
+
+        std::shared_ptr<GeometrySource> geometrySource; // set when the primitives were loaded without their data
     };
 }
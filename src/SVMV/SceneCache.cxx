@@ -0,0 +1,611 @@
+#include <SVMV/SceneCache.hxx>
+
+using namespace SVMV;
+
+namespace
+{
+    constexpr char cacheMagic[8] = { 'S', 'V', 'M', 'V', 'S', 'C', 'N', '\0' };
+    constexpr size_t blobAlignment = 16; // blobs are aligned relative to the start of the file, which is page aligned when mapped
+}
+
+std::string SceneCache::getCachePath(const std::string& filePath)
+{
+    return filePath + ".svmvcache";
+}
+
+std::shared_ptr<Scene> SceneCache::load(const std::string& filePath, bool compressedTextures/* = false*/)
+{
+    std::string cachePath = getCachePath(filePath);
+
+    std::error_code error;
+
+    if (!std::filesystem::exists(cachePath, error))
+    {
+        return nullptr;
+    }
+
+    try
+    {
+        // the textures and geometry point into the mapping, which stays open as long as any of them is alive
+        std::shared_ptr<const MappedFile> cacheFile = std::make_shared<const MappedFile>(cachePath);
+        details::Reader reader(cacheFile->getData(), cacheFile->getSize());
+
+        if (memcmp(reader.readBytes(sizeof(cacheMagic)), cacheMagic, sizeof(cacheMagic)) != 0 || reader.read<uint32_t>() != version)
+        {
+            std::cout << "scene cache: ignoring cache with an unsupported format: " << cachePath << std::endl;
+
+            return nullptr;
+        }
+
+        if (reader.read<uint32_t>() != static_cast<uint32_t>(compressedTextures))
+        {
+            std::cout << "scene cache: texture compression setting changed, ignoring cache: " << cachePath << std::endl;
+
+            return nullptr;
+        }
+
+        uint32_t keyCount = reader.read<uint32_t>();
+
+        for (uint32_t i = 0; i < keyCount; i++)
+        {
+            if (!details::isKeyValid(reader, filePath))
+            {
+                std::cout << "scene cache: source file changed, ignoring cache: " << cachePath << std::endl;
+
+                return nullptr;
+            }
+        }
+
+        std::vector<std::shared_ptr<Texture>> textures(reader.read<uint32_t>());
+
+        for (auto& texture : textures)
+        {
+            texture = details::readTexture(reader, cacheFile);
+        }
+
+        std::shared_ptr<Scene> scene = std::make_shared<Scene>();
+
+        scene->materials.resize(reader.read<uint32_t>());
+
+        for (auto& material : scene->materials)
+        {
+            material = details::readMaterial(reader, textures);
+        }
+
+        scene->meshes.resize(reader.read<uint32_t>());
+
+        for (auto& mesh : scene->meshes)
+        {
+            mesh = details::readMesh(reader, scene->materials, cacheFile);
+        }
+
+        scene->nodes = details::readNodes(reader, scene->meshes.size());
+
+        return scene;
+    }
+    catch (const std::exception& exception)
+    {
+        std::cout << "scene cache: ignoring invalid cache: " << cachePath << " (" << exception.what() << ")" << std::endl;
+
+        return nullptr;
+    }
+}
+
+void SceneCache::save(const Scene& scene, const std::string& filePath, const std::vector<std::string>& dependencies, bool compressedTextures/* = false*/)
+{
+    std::string cachePath = getCachePath(filePath);
+    // written separately and renamed so an interrupted write never leaves a truncated cache behind, the suffix keeps instances saving the same scene at once apart
+    std::string temporaryPath = cachePath + ".tmp" + std::to_string(std::random_device()());
+
+    try
+    {
+        std::vector<details::FileKey> keys;
+        keys.push_back(details::hashFile(filePath, ""));
+
+        std::filesystem::path baseDirectory = std::filesystem::path(filePath).parent_path();
+
+        for (const auto& dependency : dependencies)
+        {
+            keys.push_back(details::hashFile((baseDirectory / dependency).string(), dependency));
+        }
+
+        std::vector<const Texture*> textures;
+        std::unordered_map<const Texture*, int32_t> textureIndices;
+
+        for (const auto& material : scene.materials)
+        {
+            for (const auto& [name, property] : material->properties)
+            {
+                if (property->getType() == PropertyType::TEXTURE)
+                {
+                    const Texture* texture = static_cast<TextureProperty*>(property.get())->data.get();
+
+                    if (texture != nullptr && !textureIndices.contains(texture))
+                    {
+                        textureIndices[texture] = static_cast<int32_t>(textures.size());
+                        textures.push_back(texture);
+                    }
+                }
+            }
+        }
+
+        std::unordered_map<const Material*, int32_t> materialIndices;
+
+        for (size_t i = 0; i < scene.materials.size(); i++)
+        {
+            materialIndices[scene.materials[i].get()] = static_cast<int32_t>(i);
+        }
+
+        details::Writer writer(temporaryPath);
+
+        writer.writeBytes(cacheMagic, sizeof(cacheMagic));
+        writer.write<uint32_t>(version);
+        writer.write<uint32_t>(static_cast<uint32_t>(compressedTextures));
+
+        writer.write<uint32_t>(static_cast<uint32_t>(keys.size()));
+
+        for (const auto& key : keys)
+        {
+            details::writeKey(writer, key);
+        }
+
+        writer.write<uint32_t>(static_cast<uint32_t>(textures.size()));
+
+        for (const Texture* texture : textures)
+        {
+            details::writeTexture(writer, *texture);
+        }
+
+        writer.write<uint32_t>(static_cast<uint32_t>(scene.materials.size()));
+
+        for (const auto& material : scene.materials)
+        {
+            details::writeMaterial(writer, *material, textureIndices);
+        }
+
+        writer.write<uint32_t>(static_cast<uint32_t>(scene.meshes.size()));
+
+        for (const auto& mesh : scene.meshes)
+        {
+            details::writeMesh(writer, *mesh, materialIndices);
+        }
+
+        details::writeNodes(writer, scene.nodes);
+
+        writer.close();
+
+        std::filesystem::rename(temporaryPath, cachePath);
+    }
+    catch (const std::exception& exception)
+    {
+        std::cout << "scene cache: failed to write cache: " << cachePath << " (" << exception.what() << ")" << std::endl;
+
+        std::error_code error;
+        std::filesystem::remove(temporaryPath, error);
+    }
+}
+
+uint64_t SceneCache::hashData(const std::byte* data, size_t size)
+{
+    // not cryptographic, only meant to detect changed files; four independent lanes keep the multiplier busy so hashing runs close to memory bandwidth
+
+    constexpr uint64_t prime1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+    constexpr uint64_t prime3 = 0x165667B19E3779F9ull;
+
+    uint64_t lanes[4] = { prime1 + prime2, prime2, 0, 0 - prime1 };
+
+    size_t offset = 0;
+
+    for (; offset + 32 <= size; offset += 32)
+    {
+        for (size_t i = 0; i < 4; i++)
+        {
+            uint64_t word;
+            memcpy(&word, data + offset + i * 8, sizeof(word));
+
+            lanes[i] = std::rotl(lanes[i] + word * prime2, 31) * prime1;
+        }
+    }
+
+    uint64_t hash = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+    hash += static_cast<uint64_t>(size) * prime3;
+
+    for (; offset < size; offset++)
+    {
+        hash = std::rotl(hash ^ (static_cast<uint64_t>(data[offset]) * prime3), 11) * prime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+SceneCache::details::FileKey SceneCache::details::hashFile(const std::string& filePath, const std::string& keyPath)
+{
+    MappedFile file(filePath);
+
+    FileKey key;
+    key.path = keyPath;
+    key.size = file.getSize();
+    key.hash = hashData(file.getData(), file.getSize());
+
+    return key;
+}
+
+SceneCache::details::Writer::Writer(const std::string& filePath)
+{
+    _file.open(filePath, std::ios::binary | std::ios::trunc);
+
+    if (!_file.is_open())
+    {
+        throw std::runtime_error("scene cache: failed to open file for writing: " + filePath);
+    }
+}
+
+void SceneCache::details::Writer::writeBytes(const void* data, size_t size)
+{
+    _file.write(reinterpret_cast<const char*>(data), size);
+    _offset += size;
+
+    if (!_file)
+    {
+        throw std::runtime_error("scene cache: failed to write to file");
+    }
+}
+
+void SceneCache::details::Writer::writeBlob(const void* data, size_t size)
+{
+    write<uint64_t>(size);
+
+    constexpr char padding[blobAlignment] = {};
+    writeBytes(padding, (blobAlignment - _offset % blobAlignment) % blobAlignment);
+
+    writeBytes(data, size);
+}
+
+void SceneCache::details::Writer::writeString(const std::string& string)
+{
+    write<uint32_t>(static_cast<uint32_t>(string.size()));
+    writeBytes(string.data(), string.size());
+}
+
+void SceneCache::details::Writer::close()
+{
+    _file.close();
+
+    if (_file.fail())
+    {
+        throw std::runtime_error("scene cache: failed to finish writing file");
+    }
+}
+
+SceneCache::details::Reader::Reader(const std::byte* data, size_t size)
+{
+    _data = data;
+    _size = size;
+}
+
+const std::byte* SceneCache::details::Reader::readBytes(size_t size)
+{
+    if (size > _size - _offset)
+    {
+        throw std::runtime_error("scene cache: unexpected end of file");
+    }
+
+    const std::byte* data = _data + _offset;
+    _offset += size;
+
+    return data;
+}
+
+const std::byte* SceneCache::details::Reader::readBlob(size_t& size)
+{
+    size = read<uint64_t>();
+    readBytes((blobAlignment - _offset % blobAlignment) % blobAlignment);
+
+    return readBytes(size);
+}
+
+std::string SceneCache::details::Reader::readString()
+{
+    uint32_t size = read<uint32_t>();
+    const std::byte* data = readBytes(size);
+
+    return std::string(reinterpret_cast<const char*>(data), size);
+}
+
+void SceneCache::details::writeKey(Writer& writer, const FileKey& key)
+{
+    writer.writeString(key.path);
+    writer.write<uint64_t>(key.size);
+    writer.write<uint64_t>(key.hash);
+}
+
+bool SceneCache::details::isKeyValid(Reader& reader, const std::string& filePath)
+{
+    std::string keyPath = reader.readString();
+    uint64_t size = reader.read<uint64_t>();
+    uint64_t hash = reader.read<uint64_t>();
+
+    std::string path = keyPath.empty() ? filePath : (std::filesystem::path(filePath).parent_path() / keyPath).string();
+
+    std::error_code error;
+
+    if (!std::filesystem::exists(path, error) || std::filesystem::file_size(path, error) != size)
+    {
+        return false; // checked first so a changed file is usually rejected without hashing it
+    }
+
+    return hashFile(path, keyPath).hash == hash;
+}
+
+void SceneCache::details::writeTexture(Writer& writer, const Texture& texture)
+{
+    writer.write<uint32_t>(texture.width);
+    writer.write<uint32_t>(texture.height);
+    writer.write<uint32_t>(static_cast<uint32_t>(texture.encoding));
+
+    writer.write<uint32_t>(static_cast<uint32_t>(texture.levelOffsets.size()));
+
+    for (size_t levelOffset : texture.levelOffsets)
+    {
+        writer.write<uint64_t>(levelOffset);
+    }
+
+    writer.writeBlob(texture.getData(), texture.size);
+}
+
+std::shared_ptr<Texture> SceneCache::details::readTexture(Reader& reader, const std::shared_ptr<const MappedFile>& cacheFile)
+{
+    std::shared_ptr<Texture> texture = std::make_shared<Texture>();
+
+    texture->width = reader.read<uint32_t>();
+    texture->height = reader.read<uint32_t>();
+    texture->encoding = static_cast<TextureEncoding>(reader.read<uint32_t>());
+
+    texture->levelOffsets.resize(reader.read<uint32_t>());
+
+    for (auto& levelOffset : texture->levelOffsets)
+    {
+        levelOffset = reader.read<uint64_t>();
+    }
+
+    const std::byte* data = reader.readBlob(texture->size);
+
+    validateTexture(*texture);
+
+    if (texture->size > 0)
+    {
+        texture->view = data;
+        texture->viewOwner = cacheFile;
+    }
+
+    return texture;
+}
+
+void SceneCache::details::validateTexture(const Texture& texture)
+{
+    if (static_cast<uint32_t>(texture.encoding) > static_cast<uint32_t>(TextureEncoding::BC1) || texture.levelOffsets.size() > TextureMipmaps::getLevelCount(texture.width, texture.height))
+    {
+        throw std::runtime_error("scene cache: invalid texture format");
+    }
+
+    // images that could not be decoded are cached without data
+    if (texture.levelOffsets.empty() && texture.size > 0 && (texture.encoding != TextureEncoding::RGBA8 || static_cast<size_t>(texture.width) * texture.height * 4 > texture.size))
+    {
+        throw std::runtime_error("scene cache: texture data is smaller than its size");
+    }
+
+    for (size_t level = 0; level < texture.levelOffsets.size(); level++)
+    {
+        uint32_t levelWidth = std::max(texture.width >> level, 1u);
+        uint32_t levelHeight = std::max(texture.height >> level, 1u);
+
+        size_t levelSize = texture.encoding == TextureEncoding::RGBA8
+            ? static_cast<size_t>(levelWidth) * levelHeight * 4
+            : TextureCompression::getEncodedSize(texture.encoding, levelWidth, levelHeight);
+
+        if (texture.levelOffsets[level] > texture.size || levelSize > texture.size - texture.levelOffsets[level])
+        {
+            throw std::runtime_error("scene cache: texture level " + std::to_string(level) + " is out of bounds");
+        }
+    }
+}
+
+void SceneCache::details::writeMaterial(Writer& writer, const Material& material, const std::unordered_map<const Texture*, int32_t>& textureIndices)
+{
+    writer.writeString(material.materialTypeName);
+    writer.writeString(material.materialName);
+
+    writer.write<uint32_t>(static_cast<uint32_t>(material.properties.size()));
+
+    for (const auto& [key, property] : material.properties)
+    {
+        PropertyType type = property->getType();
+
+        writer.writeString(key);
+        writer.writeString(property->name);
+        writer.write<int32_t>(static_cast<int32_t>(type));
+
+        switch (type)
+        {
+        case PropertyType::FLOAT:
+            writer.write<float>(static_cast<FloatProperty*>(property.get())->data);
+            break;
+
+        case PropertyType::FLOAT_VECTOR_4:
+            writer.write<glm::vec4>(static_cast<FloatVector4Property*>(property.get())->data);
+            break;
+
+        case PropertyType::TEXTURE:
+            writer.write<int32_t>(getIndex(textureIndices, static_cast<const Texture*>(static_cast<TextureProperty*>(property.get())->data.get())));
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+std::shared_ptr<Material> SceneCache::details::readMaterial(Reader& reader, const std::vector<std::shared_ptr<Texture>>& textures)
+{
+    std::shared_ptr<Material> material = std::make_shared<Material>();
+
+    material->materialTypeName = reader.readString();
+    material->materialName = reader.readString();
+
+    uint32_t propertyCount = reader.read<uint32_t>();
+
+    for (uint32_t i = 0; i < propertyCount; i++)
+    {
+        std::string key = reader.readString();
+        std::string name = reader.readString();
+
+        std::shared_ptr<Property> property;
+
+        switch (static_cast<PropertyType>(reader.read<int32_t>()))
+        {
+        case PropertyType::FLOAT:
+        {
+            std::shared_ptr<FloatProperty> floatProperty = std::make_shared<FloatProperty>();
+            floatProperty->data = reader.read<float>();
+            property = floatProperty;
+        }
+        break;
+
+        case PropertyType::FLOAT_VECTOR_4:
+        {
+            std::shared_ptr<FloatVector4Property> factorProperty = std::make_shared<FloatVector4Property>();
+            factorProperty->data = reader.read<glm::vec4>();
+            property = factorProperty;
+        }
+        break;
+
+        case PropertyType::TEXTURE:
+        {
+            std::shared_ptr<TextureProperty> textureProperty = std::make_shared<TextureProperty>();
+            textureProperty->data = getByIndex(textures, reader.read<int32_t>());
+            property = textureProperty;
+        }
+        break;
+
+        default:
+            property = std::make_shared<Property>();
+            break;
+        }
+
+        property->name = name;
+        material->properties[key] = property;
+    }
+
+    return material;
+}
+
+void SceneCache::details::writeMesh(Writer& writer, const Mesh& mesh, const std::unordered_map<const Material*, int32_t>& materialIndices)
+{
+    writer.write<uint32_t>(static_cast<uint32_t>(mesh.primitives.size()));
+
+    for (const auto& primitive : mesh.primitives)
+    {
+        writer.write<int32_t>(getIndex(materialIndices, static_cast<const Material*>(primitive->material.get())));
+        writer.writeBlob(primitive->getIndices(), primitive->indexCount * sizeof(uint32_t));
+        writer.write<glm::vec3>(primitive->boundsMin);
+        writer.write<glm::vec3>(primitive->boundsMax);
+
+        writer.write<uint32_t>(static_cast<uint32_t>(primitive->attributes.size()));
+
+        for (const auto& attribute : primitive->attributes)
+        {
+            writer.write<int32_t>(static_cast<int32_t>(attribute.attributeType));
+            writer.write<int32_t>(static_cast<int32_t>(attribute.type));
+            writer.write<uint64_t>(attribute.count);
+            writer.write<int32_t>(attribute.componentCount);
+            writer.writeBlob(attribute.getData(), attribute.size);
+        }
+    }
+}
+
+std::shared_ptr<Mesh> SceneCache::details::readMesh(Reader& reader, const std::vector<std::shared_ptr<Material>>& materials, const std::shared_ptr<const MappedFile>& cacheFile)
+{
+    std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>();
+
+    mesh->primitives.resize(reader.read<uint32_t>());
+
+    for (auto& primitive : mesh->primitives)
+    {
+        primitive = std::make_shared<Primitive>();
+        primitive->material = getByIndex(materials, reader.read<int32_t>());
+
+        size_t indicesSize = 0;
+        const std::byte* indices = reader.readBlob(indicesSize);
+
+        // blobs are aligned, so the indices can be read from the mapping directly
+        primitive->indexCount = indicesSize / sizeof(uint32_t);
+
+        if (primitive->indexCount > 0)
+        {
+            primitive->indexView = reinterpret_cast<const uint32_t*>(indices);
+            primitive->indexViewOwner = cacheFile;
+        }
+
+        primitive->boundsMin = reader.read<glm::vec3>();
+        primitive->boundsMax = reader.read<glm::vec3>();
+
+        primitive->attributes.resize(reader.read<uint32_t>());
+
+        for (auto& attribute : primitive->attributes)
+        {
+            attribute.attributeType = static_cast<AttributeType>(reader.read<int32_t>());
+            attribute.type = static_cast<Type>(reader.read<int32_t>());
+            attribute.count = reader.read<uint64_t>();
+            attribute.componentCount = reader.read<int32_t>();
+
+            const std::byte* elements = reader.readBlob(attribute.size);
+
+            attribute.view = elements;
+            attribute.viewOwner = cacheFile;
+        }
+    }
+
+    return mesh;
+}
+
+void SceneCache::details::writeNodes(Writer& writer, const SceneGraph& nodes)
+{
+    writer.write<uint32_t>(static_cast<uint32_t>(nodes.getNodeCount()));
+
+    for (size_t i = 0; i < nodes.getNodeCount(); i++)
+    {
+        writer.write<int32_t>(nodes.parents[i]);
+        writer.write<glm::mat4>(nodes.localTransforms[i]);
+        writer.write<int32_t>(nodes.meshIndices[i]);
+    }
+}
+
+SceneGraph SceneCache::details::readNodes(Reader& reader, size_t meshCount)
+{
+    SceneGraph nodes;
+
+    uint32_t nodeCount = reader.read<uint32_t>();
+
+    for (uint32_t i = 0; i < nodeCount; i++)
+    {
+        int32_t parentIndex = reader.read<int32_t>();
+        glm::mat4 transform = reader.read<glm::mat4>();
+        int32_t meshIndex = reader.read<int32_t>();
+
+        if (meshIndex < SceneGraph::noMesh || meshIndex >= static_cast<int32_t>(meshCount))
+        {
+            throw std::runtime_error("scene cache: invalid mesh index");
+        }
+
+        nodes.addNode(parentIndex, transform, meshIndex); // rejects hierarchies that are not stored breadth first
+    }
+
+    return nodes;
+}
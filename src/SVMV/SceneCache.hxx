@@ -0,0 +1,152 @@
+#pragma once
+
+#include <SVMV/Scene.hxx>
+#include <SVMV/SceneGraph.hxx>
+#include <SVMV/Mesh.hxx>
+#include <SVMV/Primitive.hxx>
+#include <SVMV/Attribute.hxx>
+#include <SVMV/Material.hxx>
+#include <SVMV/Property.hxx>
+#include <SVMV/Texture.hxx>
+#include <SVMV/TextureCompression.hxx>
+#include <SVMV/MappedFile.hxx>
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <filesystem>
+#include <random>
+#include <utility>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+namespace SVMV
+{
+    // on-disk cache of a fully processed scene, stored next to the source file and validated against a content hash of the source and its dependencies
+    namespace SceneCache
+    {
+        constexpr uint32_t version = 5; // bump whenever the format or the output of the loader changes
+
+        std::string getCachePath(const std::string& filePath);
+
+        // compressedTextures has to match between saving and loading, the cache of the other setting is treated as outdated
+        std::shared_ptr<Scene> load(const std::string& filePath, bool compressedTextures = false); // returns nullptr when there is no valid cache for the file
+        void save(const Scene& scene, const std::string& filePath, const std::vector<std::string>& dependencies, bool compressedTextures = false); // dependencies are external files referenced by the source, relative to its directory
+
+        uint64_t hashData(const std::byte* data, size_t size);
+
+        namespace details
+        {
+            struct FileKey
+            {
+                std::string path; // relative to the directory of the source file, empty for the source file itself
+                uint64_t size   { 0 };
+                uint64_t hash   { 0 };
+            };
+
+            FileKey hashFile(const std::string& filePath, const std::string& keyPath);
+
+            class Writer
+            {
+            public:
+                Writer(const std::string& filePath);
+
+                void writeBytes(const void* data, size_t size);
+                void writeBlob(const void* data, size_t size); // writes the size followed by the aligned data
+                void writeString(const std::string& string);
+
+                template <typename T>
+                void write(const T& value)
+                {
+                    writeBytes(&value, sizeof(T));
+                }
+
+                void close();
+
+            private:
+                std::ofstream _file;
+                size_t _offset  { 0 };
+            };
+
+            class Reader
+            {
+            public:
+                Reader(const std::byte* data, size_t size);
+
+                const std::byte* readBytes(size_t size);
+                const std::byte* readBlob(size_t& size);
+                std::string readString();
+
+                template <typename T>
+                T read()
+                {
+                    T value;
+                    memcpy(&value, readBytes(sizeof(T)), sizeof(T));
+
+                    return value;
+                }
+
+            private:
+                const std::byte* _data  { nullptr };
+                size_t _size            { 0 };
+                size_t _offset          { 0 };
+            };
+
+            void writeKey(Writer& writer, const FileKey& key);
+            bool isKeyValid(Reader& reader, const std::string& filePath);
+
+            void writeTexture(Writer& writer, const Texture& texture);
+            std::shared_ptr<Texture> readTexture(Reader& reader, const std::shared_ptr<const MappedFile>& cacheFile);
+            void validateTexture(const Texture& texture); // throws when the levels do not fit into the data, so a corrupt cache falls back to a full load
+
+            void writeMaterial(Writer& writer, const Material& material, const std::unordered_map<const Texture*, int32_t>& textureIndices);
+            std::shared_ptr<Material> readMaterial(Reader& reader, const std::vector<std::shared_ptr<Texture>>& textures);
+
+            void writeMesh(Writer& writer, const Mesh& mesh, const std::unordered_map<const Material*, int32_t>& materialIndices);
+            std::shared_ptr<Mesh> readMesh(Reader& reader, const std::vector<std::shared_ptr<Material>>& materials, const std::shared_ptr<const MappedFile>& cacheFile);
+
+            void writeNodes(Writer& writer, const SceneGraph& nodes); // mesh indices are stored as they are, meshes are written in the order of the scene
+            SceneGraph readNodes(Reader& reader, size_t meshCount);
+
+            template <typename T>
+            int32_t getIndex(const std::unordered_map<const T*, int32_t>& indices, const T* pointer)
+            {
+                if (pointer == nullptr)
+                {
+                    return -1;
+                }
+
+                auto iterator = indices.find(pointer);
+
+                if (iterator == indices.end())
+                {
+                    throw std::runtime_error("scene cache: scene references an object that is not part of the scene");
+                }
+
+                return iterator->second;
+            }
+
+            template <typename T>
+            std::shared_ptr<T> getByIndex(const std::vector<std::shared_ptr<T>>& objects, int32_t index)
+            {
+                if (index == -1)
+                {
+                    return nullptr;
+                }
+
+                if (index < 0 || index >= static_cast<int32_t>(objects.size()))
+                {
+                    throw std::runtime_error("scene cache: invalid object index");
+                }
+
+                return objects[index];
+            }
+        }
+    }
+}
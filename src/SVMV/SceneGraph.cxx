@@ -0,0 +1,78 @@
+#include <SVMV/SceneGraph.hxx>
+
+using namespace SVMV;
+
+uint32_t SceneGraph::addNode(int32_t parent, const glm::mat4& localTransform, int32_t meshIndex/* = noMesh*/)
+{
+    uint32_t index = static_cast<uint32_t>(parents.size());
+
+    // the parent has to be on the last depth, which starts a new one, or on the depth before it
+    if (parent == noParent)
+    {
+        if (depthOffsets.size() > 1)
+        {
+            throw std::runtime_error("scene graph: root nodes have to be added first");
+        }
+
+        if (depthOffsets.empty())
+        {
+            depthOffsets.push_back(0);
+        }
+    }
+    else if (parent < 0 || static_cast<uint32_t>(parent) >= index)
+    {
+        throw std::runtime_error("scene graph: parent has to be added before its children");
+    }
+    else if (static_cast<uint32_t>(parent) >= depthOffsets.back())
+    {
+        depthOffsets.push_back(index);
+    }
+    else if (depthOffsets.size() < 2 || static_cast<uint32_t>(parent) < depthOffsets[depthOffsets.size() - 2])
+    {
+        throw std::runtime_error("scene graph: nodes have to be added breadth first");
+    }
+
+    parents.push_back(parent);
+    meshIndices.push_back(meshIndex);
+    localTransforms.push_back(localTransform);
+
+    return index;
+}
+
+void SceneGraph::updateTransforms(ThreadPool* threadPool/* = nullptr*/)
+{
+    worldTransforms.resize(parents.size());
+    normalMatrices.resize(parents.size());
+
+    auto updateNode = [this](size_t index)
+        {
+            int32_t parent = parents[index];
+
+            worldTransforms[index] = parent == noParent ? localTransforms[index] : worldTransforms[parent] * localTransforms[index];
+            normalMatrices[index] = glm::transpose(glm::inverse(worldTransforms[index]));
+        };
+
+    // the parents of a depth are all on the previous one, so the nodes of a depth are independent of each other
+    for (size_t depth = 0; depth < depthOffsets.size(); depth++)
+    {
+        size_t begin = depthOffsets[depth];
+        size_t end = depth + 1 < depthOffsets.size() ? depthOffsets[depth + 1] : parents.size();
+
+        if (threadPool != nullptr && end - begin >= parallelDepthSize)
+        {
+            threadPool->parallelFor(end - begin, [&](size_t index) { updateNode(begin + index); });
+        }
+        else
+        {
+            for (size_t index = begin; index < end; index++)
+            {
+                updateNode(index);
+            }
+        }
+    }
+}
+
+size_t SceneGraph::getNodeCount() const noexcept
+{
+    return parents.size();
+}
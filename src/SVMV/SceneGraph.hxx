@@ -0,0 +1,40 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <SVMV/ThreadPool.hxx>
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace SVMV
+{
+    // node hierarchy flattened into contiguous arrays, one element per node
+    // nodes are stored breadth first, so parents precede their children and the nodes of each depth are contiguous,
+    // which lets the world transforms be propagated one depth at a time without recursion
+    struct SceneGraph
+    {
+        static constexpr int32_t noParent = -1;
+        static constexpr int32_t noMesh = -1;
+        static constexpr size_t parallelDepthSize = 4096; // depths with fewer nodes are updated on the calling thread
+
+        std::vector<int32_t> parents;
+        std::vector<int32_t> meshIndices; // into Scene::meshes
+        std::vector<glm::mat4> localTransforms;
+
+        // written by updateTransforms
+        std::vector<glm::mat4> worldTransforms;
+        std::vector<glm::mat4> normalMatrices; // mat4 for alignment, 4th dimension is dropped in shader
+
+        std::vector<uint32_t> depthOffsets; // first node of each depth
+
+        uint32_t addNode(int32_t parent, const glm::mat4& localTransform, int32_t meshIndex = noMesh); // throws unless the nodes are added breadth first
+        void updateTransforms(ThreadPool* threadPool = nullptr);
+
+        [[nodiscard]] size_t getNodeCount() const noexcept;
+    };
+}
@@ -0,0 +1,103 @@
+#include <SVMV/ShaderCache.hxx>
+
+using namespace SVMV;
+
+namespace
+{
+    constexpr char cacheMagic[8] = { 'S', 'V', 'M', 'V', 'S', 'P', 'V', '\0' };
+    constexpr uint32_t spirvMagic = 0x07230203;
+
+    struct CacheHeader
+    {
+        char magic[8]       { };
+        uint32_t version    { 0 };
+        uint32_t wordCount  { 0 };
+        uint64_t key        { 0 };
+    };
+}
+
+std::string ShaderCache::getCachePath(const std::string& filePath)
+{
+    return filePath + ".spvcache";
+}
+
+uint64_t ShaderCache::getKey(const std::string& source, const std::string& options)
+{
+    std::string keyData = source;
+    keyData.push_back('\0');
+    keyData += options;
+
+    return SceneCache::hashData(reinterpret_cast<const std::byte*>(keyData.data()), keyData.size());
+}
+
+std::vector<uint32_t> ShaderCache::load(const std::string& filePath, uint64_t key)
+{
+    std::string cachePath = getCachePath(filePath);
+
+    std::ifstream file(cachePath, std::ios::binary);
+
+    if (!file.is_open())
+    {
+        return {};
+    }
+
+    CacheHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if (!file || memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.version != version || header.key != key || header.wordCount == 0)
+    {
+        return {}; // outdated caches are overwritten after compiling
+    }
+
+    std::vector<uint32_t> code(header.wordCount);
+    file.read(reinterpret_cast<char*>(code.data()), code.size() * sizeof(uint32_t));
+
+    if (!file || code.front() != spirvMagic)
+    {
+        std::cout << "shader cache: ignoring invalid cache: " << cachePath << std::endl;
+
+        return {};
+    }
+
+    return code;
+}
+
+void ShaderCache::save(const std::string& filePath, uint64_t key, const std::vector<uint32_t>& code)
+{
+    std::string cachePath = getCachePath(filePath);
+    std::string temporaryPath = cachePath + ".tmp" + std::to_string(std::random_device()()); // several instances can start at once, each writes its own file and the rename keeps readers from seeing a partial one
+
+    try
+    {
+        CacheHeader header;
+        memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+        header.version = version;
+        header.wordCount = static_cast<uint32_t>(code.size());
+        header.key = key;
+
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+
+        if (!file.is_open())
+        {
+            throw std::runtime_error("failed to open file for writing");
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(code.data()), code.size() * sizeof(uint32_t));
+        file.close();
+
+        if (file.fail())
+        {
+            throw std::runtime_error("failed to write file");
+        }
+
+        std::filesystem::rename(temporaryPath, cachePath);
+    }
+    catch (const std::exception& exception)
+    {
+        std::cout << "shader cache: failed to write cache: " << cachePath << " (" << exception.what() << ")" << std::endl;
+
+        std::error_code error;
+        std::filesystem::remove(temporaryPath, error);
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <SVMV/SceneCache.hxx>
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <random>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace SVMV
+{
+    // on-disk cache of compiled SPIR-V, stored next to the GLSL source and keyed by a hash of the source and the compile options
+    namespace ShaderCache
+    {
+        constexpr uint32_t version = 1; // bump whenever the format or the compile setup changes
+
+        std::string getCachePath(const std::string& filePath);
+
+        uint64_t getKey(const std::string& source, const std::string& options); // options describe everything besides the source that affects the output
+
+        std::vector<uint32_t> load(const std::string& filePath, uint64_t key); // returns an empty vector when there is no valid cache for the key
+        void save(const std::string& filePath, uint64_t key, const std::vector<uint32_t>& code);
+    }
+}
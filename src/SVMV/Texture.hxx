@@ -1,15 +1,31 @@
 #pragma once
 
 #include <memory>
+#include <vector>
+#include <cstddef>
 
 namespace SVMV
 {
+    enum class TextureEncoding
+    {
+        RGBA8, BC7, BC5, BC4, BC3, BC1 // BC3 and BC1 are only read from KTX2 files, not encoded
+    };
+
     struct Texture
     {
         unsigned width      { 0 };
         unsigned height     { 0 };
 
-        std::unique_ptr<std::byte[]> data; // in RGBA format
+        TextureEncoding encoding    { TextureEncoding::RGBA8 };
+
+        std::unique_ptr<std::byte[]> data; // in RGBA format, or the whole mip chain of a block compressed texture
         size_t size     { 0 };
+
+        const std::byte* view   { nullptr }; // used instead of data when the pixels are read in place, e.g. from a memory-mapped file
+        std::shared_ptr<const void> viewOwner; // keeps the memory behind view alive
+
+        [[nodiscard]] const std::byte* getData() const noexcept { return (view != nullptr) ? view : data.get(); }
+
+        std::vector<size_t> levelOffsets; // of the mip levels in data, empty for RGBA textures whose mipmaps are generated when uploaded
     };
 }
@@ -0,0 +1,415 @@
+#include <SVMV/TextureCompression.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+using namespace SVMV;
+
+namespace
+{
+    constexpr size_t texelSize = 4; // RGBA8
+    constexpr uint32_t blockDimension = 4;
+    constexpr size_t blockTexelCount = blockDimension * blockDimension;
+
+    constexpr uint32_t bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 }; // of the 4 bit indices
+
+    // packs fields starting at the least significant bit of the first byte, the destination has to be zeroed
+    class BitWriter
+    {
+    public:
+        BitWriter(uint8_t* destination)
+            : _destination(destination)
+        {
+        }
+
+        void write(uint32_t value, uint32_t bitCount)
+        {
+            for (uint32_t bit = 0; bit < bitCount; bit++, _offset++)
+            {
+                _destination[_offset / 8] |= static_cast<uint8_t>(((value >> bit) & 1) << (_offset % 8));
+            }
+        }
+
+    private:
+        uint8_t* _destination   { nullptr };
+        uint32_t _offset        { 0 };
+    };
+
+    // texels outside the image repeat the last row or column
+    void loadBlock(const uint8_t* source, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, uint8_t* texels)
+    {
+        for (uint32_t y = 0; y < blockDimension; y++)
+        {
+            size_t sourceY = std::min(blockY * blockDimension + y, height - 1);
+
+            for (uint32_t x = 0; x < blockDimension; x++)
+            {
+                size_t sourceX = std::min(blockX * blockDimension + x, width - 1);
+
+                memcpy(texels + (y * blockDimension + x) * texelSize, source + (sourceY * width + sourceX) * texelSize, texelSize);
+            }
+        }
+    }
+
+    // mode 6: a single subset with 7 bit RGBA endpoints, a shared low bit per endpoint and 4 bit indices
+    void quantizeBC7Endpoint(const float endpoint[4], uint32_t quantized[4], uint32_t& pBit)
+    {
+        float bestError = std::numeric_limits<float>::max();
+
+        for (uint32_t candidate = 0; candidate < 2; candidate++)
+        {
+            uint32_t values[4];
+            float error = 0.0f;
+
+            for (size_t channel = 0; channel < texelSize; channel++)
+            {
+                values[channel] = static_cast<uint32_t>(std::clamp((endpoint[channel] - candidate) / 2.0f + 0.5f, 0.0f, 127.0f));
+
+                float difference = static_cast<float>(values[channel] * 2 + candidate) - endpoint[channel];
+                error += difference * difference;
+            }
+
+            if (error < bestError)
+            {
+                bestError = error;
+                pBit = candidate;
+                memcpy(quantized, values, sizeof(values));
+            }
+        }
+    }
+}
+
+size_t TextureCompression::getBlockSize(TextureEncoding encoding) noexcept
+{
+    switch (encoding)
+    {
+    case TextureEncoding::BC7:
+    case TextureEncoding::BC5:
+    case TextureEncoding::BC3:
+        return 16;
+    case TextureEncoding::BC4:
+    case TextureEncoding::BC1:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+size_t TextureCompression::getEncodedSize(TextureEncoding encoding, uint32_t width, uint32_t height) noexcept
+{
+    size_t blockCountX = (width + blockDimension - 1) / blockDimension;
+    size_t blockCountY = (height + blockDimension - 1) / blockDimension;
+
+    return blockCountX * blockCountY * getBlockSize(encoding);
+}
+
+void TextureCompression::encodeBC7Block(const uint8_t* texels, uint8_t* destination)
+{
+    // the endpoints span the principal axis of the block's colors, which fits gradients far better than the bounding box diagonal
+
+    float mean[4] = {};
+
+    for (size_t i = 0; i < blockTexelCount; i++)
+    {
+        for (size_t channel = 0; channel < texelSize; channel++)
+        {
+            mean[channel] += texels[i * texelSize + channel] / static_cast<float>(blockTexelCount);
+        }
+    }
+
+    float covariance[4][4] = {};
+
+    for (size_t i = 0; i < blockTexelCount; i++)
+    {
+        for (size_t row = 0; row < texelSize; row++)
+        {
+            for (size_t column = 0; column < texelSize; column++)
+            {
+                covariance[row][column] += (texels[i * texelSize + row] - mean[row]) * (texels[i * texelSize + column] - mean[column]);
+            }
+        }
+    }
+
+    float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+    for (int iteration = 0; iteration < 8; iteration++)
+    {
+        float product[4] = {};
+        float length = 0.0f;
+
+        for (size_t row = 0; row < texelSize; row++)
+        {
+            for (size_t column = 0; column < texelSize; column++)
+            {
+                product[row] += covariance[row][column] * axis[column];
+            }
+
+            length += product[row] * product[row];
+        }
+
+        if (length < 1e-12f)
+        {
+            break; // a uniform block, or the axis is perpendicular to all variation; the mean alone describes it well
+        }
+
+        length = std::sqrt(length);
+
+        for (size_t channel = 0; channel < texelSize; channel++)
+        {
+            axis[channel] = product[channel] / length;
+        }
+    }
+
+    float minimumProjection = std::numeric_limits<float>::max();
+    float maximumProjection = std::numeric_limits<float>::lowest();
+
+    for (size_t i = 0; i < blockTexelCount; i++)
+    {
+        float projection = 0.0f;
+
+        for (size_t channel = 0; channel < texelSize; channel++)
+        {
+            projection += (texels[i * texelSize + channel] - mean[channel]) * axis[channel];
+        }
+
+        minimumProjection = std::min(minimumProjection, projection);
+        maximumProjection = std::max(maximumProjection, projection);
+    }
+
+    float endpoints[2][4];
+
+    for (size_t channel = 0; channel < texelSize; channel++)
+    {
+        endpoints[0][channel] = std::clamp(mean[channel] + minimumProjection * axis[channel], 0.0f, 255.0f);
+        endpoints[1][channel] = std::clamp(mean[channel] + maximumProjection * axis[channel], 0.0f, 255.0f);
+    }
+
+    uint32_t quantized[2][4];
+    uint32_t pBits[2] = { 0, 0 };
+
+    quantizeBC7Endpoint(endpoints[0], quantized[0], pBits[0]);
+    quantizeBC7Endpoint(endpoints[1], quantized[1], pBits[1]);
+
+    int32_t palette[16][4];
+
+    for (size_t index = 0; index < 16; index++)
+    {
+        for (size_t channel = 0; channel < texelSize; channel++)
+        {
+            uint32_t first = quantized[0][channel] * 2 + pBits[0];
+            uint32_t second = quantized[1][channel] * 2 + pBits[1];
+
+            palette[index][channel] = static_cast<int32_t>(((64 - bc7Weights[index]) * first + bc7Weights[index] * second + 32) >> 6);
+        }
+    }
+
+    uint32_t indices[blockTexelCount];
+
+    for (size_t i = 0; i < blockTexelCount; i++)
+    {
+        int32_t bestError = std::numeric_limits<int32_t>::max();
+
+        for (uint32_t index = 0; index < 16; index++)
+        {
+            int32_t error = 0;
+
+            for (size_t channel = 0; channel < texelSize; channel++)
+            {
+                int32_t difference = palette[index][channel] - texels[i * texelSize + channel];
+                error += difference * difference;
+            }
+
+            if (error < bestError)
+            {
+                bestError = error;
+                indices[i] = index;
+            }
+        }
+    }
+
+    // the highest bit of the first index is implicitly 0, swapping the endpoints mirrors the indices to make it so
+    if (indices[0] >= 8)
+    {
+        std::swap(quantized[0], quantized[1]);
+        std::swap(pBits[0], pBits[1]);
+
+        for (auto& index : indices)
+        {
+            index = 15 - index;
+        }
+    }
+
+    memset(destination, 0, 16);
+
+    BitWriter writer(destination);
+    writer.write(1 << 6, 7); // mode 6
+
+    for (size_t channel = 0; channel < texelSize; channel++)
+    {
+        writer.write(quantized[0][channel], 7);
+        writer.write(quantized[1][channel], 7);
+    }
+
+    writer.write(pBits[0], 1);
+    writer.write(pBits[1], 1);
+
+    writer.write(indices[0], 3);
+
+    for (size_t i = 1; i < blockTexelCount; i++)
+    {
+        writer.write(indices[i], 4);
+    }
+}
+
+void TextureCompression::encodeBC5Block(const uint8_t* texels, uint8_t* destination)
+{
+    encodeBC4Block(texels, 0, destination);
+    encodeBC4Block(texels, 1, destination + 8);
+}
+
+void TextureCompression::encodeBC4Block(const uint8_t* texels, size_t channel, uint8_t* destination)
+{
+    uint8_t minimum = 255;
+    uint8_t maximum = 0;
+
+    for (size_t i = 0; i < blockTexelCount; i++)
+    {
+        minimum = std::min(minimum, texels[i * texelSize + channel]);
+        maximum = std::max(maximum, texels[i * texelSize + channel]);
+    }
+
+    // with the first endpoint larger than the second, the palette holds both endpoints and the six values evenly spaced between them
+    destination[0] = maximum;
+    destination[1] = minimum;
+
+    uint64_t indices = 0;
+
+    if (maximum > minimum)
+    {
+        int32_t palette[8] = { maximum, minimum };
+
+        for (int32_t i = 1; i < 7; i++)
+        {
+            palette[i + 1] = ((7 - i) * maximum + i * minimum + 3) / 7;
+        }
+
+        for (size_t i = 0; i < blockTexelCount; i++)
+        {
+            int32_t value = texels[i * texelSize + channel];
+
+            uint64_t bestIndex = 0;
+            int32_t bestError = std::abs(palette[0] - value);
+
+            for (uint64_t index = 1; index < 8; index++)
+            {
+                int32_t error = std::abs(palette[index] - value);
+
+                if (error < bestError)
+                {
+                    bestError = error;
+                    bestIndex = index;
+                }
+            }
+
+            indices |= bestIndex << (i * 3);
+        }
+    }
+
+    for (size_t i = 0; i < 6; i++)
+    {
+        destination[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+    }
+}
+
+void TextureCompression::compress(Texture& texture, TextureEncoding encoding, bool srgb, ThreadPool* threadPool/* = nullptr*/)
+{
+    if (texture.encoding != TextureEncoding::RGBA8)
+    {
+        throw std::runtime_error("texture compression: texture is already compressed");
+    }
+
+    if (encoding == TextureEncoding::RGBA8 || texture.getData() == nullptr)
+    {
+        return;
+    }
+
+    if (encoding != TextureEncoding::BC7 && encoding != TextureEncoding::BC5 && encoding != TextureEncoding::BC4)
+    {
+        throw std::runtime_error("texture compression: there is no encoder for the requested format");
+    }
+
+    // block compressed formats cannot be blitted, so the whole chain is generated here
+    TextureMipmaps::MipChain mipChain = TextureMipmaps::generate(texture.getData(), texture.width, texture.height, srgb, threadPool);
+
+    size_t blockSize = getBlockSize(encoding);
+
+    std::vector<size_t> levelOffsets;
+    size_t size = 0;
+
+    for (size_t level = 0; level < mipChain.levelOffsets.size(); level++)
+    {
+        levelOffsets.push_back(size);
+        size += getEncodedSize(encoding, std::max(texture.width >> level, 1u), std::max(texture.height >> level, 1u));
+    }
+
+    std::unique_ptr<std::byte[]> data = std::make_unique_for_overwrite<std::byte[]>(size);
+
+    for (size_t level = 0; level < mipChain.levelOffsets.size(); level++)
+    {
+        const uint8_t* source = reinterpret_cast<const uint8_t*>(mipChain.data.get() + mipChain.levelOffsets[level]);
+        uint8_t* destination = reinterpret_cast<uint8_t*>(data.get() + levelOffsets[level]);
+
+        uint32_t levelWidth = std::max(texture.width >> level, 1u);
+        uint32_t levelHeight = std::max(texture.height >> level, 1u);
+
+        uint32_t blockCountX = (levelWidth + blockDimension - 1) / blockDimension;
+        uint32_t blockCountY = (levelHeight + blockDimension - 1) / blockDimension;
+
+        auto encodeBlockRow = [&](size_t blockY)
+            {
+                uint8_t texels[blockTexelCount * texelSize];
+
+                for (uint32_t blockX = 0; blockX < blockCountX; blockX++)
+                {
+                    loadBlock(source, levelWidth, levelHeight, blockX, static_cast<uint32_t>(blockY), texels);
+
+                    uint8_t* block = destination + (blockY * blockCountX + blockX) * blockSize;
+
+                    switch (encoding)
+                    {
+                    case TextureEncoding::BC7:
+                        encodeBC7Block(texels, block);
+                        break;
+                    case TextureEncoding::BC5:
+                        encodeBC5Block(texels, block);
+                        break;
+                    default:
+                        encodeBC4Block(texels, 0, block);
+                        break;
+                    }
+                }
+            };
+
+        if (threadPool != nullptr && blockCountY >= parallelBlockRowCount)
+        {
+            threadPool->parallelFor(blockCountY, encodeBlockRow);
+        }
+        else
+        {
+            for (uint32_t blockY = 0; blockY < blockCountY; blockY++)
+            {
+                encodeBlockRow(blockY);
+            }
+        }
+    }
+
+    texture.encoding = encoding;
+    texture.data = std::move(data);
+    texture.view = nullptr;
+    texture.viewOwner.reset();
+    texture.size = size;
+    texture.levelOffsets = std::move(levelOffsets);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <SVMV/Texture.hxx>
+#include <SVMV/TextureMipmaps.hxx>
+#include <SVMV/ThreadPool.hxx>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SVMV
+{
+    // CPU encoder for the block compressed formats, each 4x4 block of texels is encoded independently
+    namespace TextureCompression
+    {
+        static constexpr size_t parallelBlockRowCount = 16; // levels with fewer rows of blocks are encoded on the calling thread
+
+        size_t getBlockSize(TextureEncoding encoding) noexcept; // in bytes, 0 for RGBA8
+        size_t getEncodedSize(TextureEncoding encoding, uint32_t width, uint32_t height) noexcept; // of a single level, partial blocks at the edges are padded
+
+        // the blocks are 16 RGBA texels in row order
+        void encodeBC7Block(const uint8_t* texels, uint8_t* destination); // RGBA
+        void encodeBC5Block(const uint8_t* texels, uint8_t* destination); // red and green
+        void encodeBC4Block(const uint8_t* texels, size_t channel, uint8_t* destination); // a single channel
+
+        // replaces the RGBA data of the texture with its complete block compressed mip chain, srgb textures are filtered in linear space
+        void compress(Texture& texture, TextureEncoding encoding, bool srgb, ThreadPool* threadPool = nullptr);
+    }
+}
@@ -0,0 +1,134 @@
+#include <SVMV/TextureMipmaps.hxx>
+
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace SVMV;
+
+namespace
+{
+    constexpr size_t texelSize = 4; // RGBA8
+
+    const std::array<float, 256>& getLinearValues()
+    {
+        static const std::array<float, 256> linearValues = []()
+            {
+                std::array<float, 256> values;
+
+                for (size_t i = 0; i < values.size(); i++)
+                {
+                    float value = static_cast<float>(i) / 255.0f;
+                    values[i] = (value <= 0.04045f) ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+                }
+
+                return values;
+            }();
+
+        return linearValues;
+    }
+
+    uint8_t encodeSRGB(float linearValue)
+    {
+        float value = (linearValue <= 0.0031308f) ? linearValue * 12.92f : 1.055f * std::pow(linearValue, 1.0f / 2.4f) - 0.055f;
+
+        return static_cast<uint8_t>(std::clamp(value * 255.0f + 0.5f, 0.0f, 255.0f));
+    }
+
+    void filterRow(const uint8_t* source, uint32_t sourceWidth, uint32_t sourceHeight, uint8_t* destination, uint32_t width, uint32_t row, bool srgb)
+    {
+        const std::array<float, 256>& linearValues = getLinearValues();
+
+        // the second texel is clamped to the edge, so odd sizes repeat their last row or column
+        const uint8_t* sourceRows[2] = {
+            source + std::min(row * 2, sourceHeight - 1) * sourceWidth * texelSize,
+            source + std::min(row * 2 + 1, sourceHeight - 1) * sourceWidth * texelSize
+        };
+
+        uint8_t* destinationTexel = destination + static_cast<size_t>(row) * width * texelSize;
+
+        for (uint32_t x = 0; x < width; x++, destinationTexel += texelSize)
+        {
+            size_t left = std::min(x * 2, sourceWidth - 1) * texelSize;
+            size_t right = std::min(x * 2 + 1, sourceWidth - 1) * texelSize;
+
+            const uint8_t* texels[4] = { sourceRows[0] + left, sourceRows[0] + right, sourceRows[1] + left, sourceRows[1] + right };
+
+            for (size_t channel = 0; channel < texelSize; channel++)
+            {
+                if (srgb && channel < 3)
+                {
+                    float sum = linearValues[texels[0][channel]] + linearValues[texels[1][channel]] + linearValues[texels[2][channel]] + linearValues[texels[3][channel]];
+
+                    destinationTexel[channel] = encodeSRGB(sum * 0.25f);
+                }
+                else
+                {
+                    unsigned sum = texels[0][channel] + texels[1][channel] + texels[2][channel] + texels[3][channel];
+
+                    destinationTexel[channel] = static_cast<uint8_t>((sum + 2) / 4);
+                }
+            }
+        }
+    }
+}
+
+uint32_t TextureMipmaps::getLevelCount(uint32_t width, uint32_t height) noexcept
+{
+    uint32_t levelCount = 1;
+
+    for (uint32_t size = std::max(width, height); size > 1; size /= 2)
+    {
+        levelCount++;
+    }
+
+    return levelCount;
+}
+
+TextureMipmaps::MipChain TextureMipmaps::generate(const std::byte* data, uint32_t width, uint32_t height, bool srgb, ThreadPool* threadPool/* = nullptr*/)
+{
+    MipChain mipChain;
+
+    uint32_t levelCount = getLevelCount(width, height);
+
+    for (uint32_t level = 0; level < levelCount; level++)
+    {
+        mipChain.levelOffsets.push_back(mipChain.size);
+        mipChain.size += static_cast<size_t>(std::max(width >> level, 1u)) * std::max(height >> level, 1u) * texelSize;
+    }
+
+    mipChain.data = std::make_unique_for_overwrite<std::byte[]>(mipChain.size);
+    memcpy(mipChain.data.get(), data, static_cast<size_t>(width) * height * texelSize);
+
+    for (uint32_t level = 1; level < levelCount; level++)
+    {
+        const uint8_t* source = reinterpret_cast<const uint8_t*>(mipChain.data.get() + mipChain.levelOffsets[level - 1]);
+        uint8_t* destination = reinterpret_cast<uint8_t*>(mipChain.data.get() + mipChain.levelOffsets[level]);
+
+        uint32_t sourceWidth = std::max(width >> (level - 1), 1u);
+        uint32_t sourceHeight = std::max(height >> (level - 1), 1u);
+        uint32_t levelWidth = std::max(width >> level, 1u);
+        uint32_t levelHeight = std::max(height >> level, 1u);
+
+        auto filterLevelRow = [&](size_t row)
+            {
+                filterRow(source, sourceWidth, sourceHeight, destination, levelWidth, static_cast<uint32_t>(row), srgb);
+            };
+
+        // each level only depends on the previous one, so its rows are independent
+        if (threadPool != nullptr && levelHeight >= parallelRowCount)
+        {
+            threadPool->parallelFor(levelHeight, filterLevelRow);
+        }
+        else
+        {
+            for (uint32_t row = 0; row < levelHeight; row++)
+            {
+                filterLevelRow(row);
+            }
+        }
+    }
+
+    return mipChain;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <SVMV/ThreadPool.hxx>
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace SVMV
+{
+    namespace TextureMipmaps
+    {
+        // complete mip chain of an RGBA8 image, the levels are tightly packed one after another starting with the full size one
+        struct MipChain
+        {
+            std::unique_ptr<std::byte[]> data;
+            size_t size     { 0 };
+
+            std::vector<size_t> levelOffsets; // one per level
+        };
+
+        static constexpr size_t parallelRowCount = 256; // levels with fewer rows are filtered on the calling thread
+
+        uint32_t getLevelCount(uint32_t width, uint32_t height) noexcept; // down to 1x1
+
+        // 2x2 box filter of each level from the previous one, the color channels of sRGB images are averaged in linear space
+        MipChain generate(const std::byte* data, uint32_t width, uint32_t height, bool srgb, ThreadPool* threadPool = nullptr);
+    }
+}
@@ -0,0 +1,108 @@
+#include <SVMV/ThreadPool.hxx>
+
+#include <algorithm>
+
+using namespace SVMV;
+
+ThreadPool::ThreadPool(unsigned threadCount)
+{
+    if (threadCount > 1)
+    {
+        for (unsigned i = 0; i < threadCount; i++)
+        {
+            _workers.emplace_back([this]() { workerLoop(); });
+        }
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+
+    _condition.notify_all();
+
+    for (auto& worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t index)>& function)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (_workers.empty())
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            function(i);
+        }
+
+        return;
+    }
+
+    // a few chunks per thread so uneven work (e.g. one huge primitive) still balances out
+    size_t chunkCount = std::min(count, _workers.size() * 4);
+    size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(chunkCount);
+
+    for (size_t begin = 0; begin < count; begin += chunkSize)
+    {
+        size_t end = std::min(begin + chunkSize, count);
+
+        futures.push_back(submit([begin, end, &function]()
+            {
+                for (size_t i = begin; i < end; i++)
+                {
+                    function(i);
+                }
+            }));
+    }
+
+    // get() rethrows the first exception thrown by a chunk, after every chunk has stopped touching the captured state
+    for (auto& future : futures)
+    {
+        future.wait();
+    }
+
+    for (auto& future : futures)
+    {
+        future.get();
+    }
+}
+
+unsigned ThreadPool::getThreadCount() const noexcept
+{
+    return std::max<unsigned>(static_cast<unsigned>(_workers.size()), 1);
+}
+
+void ThreadPool::workerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+
+            if (_stopping && _tasks.empty())
+            {
+                return;
+            }
+
+            task = std::move(_tasks.front());
+            _tasks.pop();
+        }
+
+        task();
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <queue>
+#include <vector>
+#include <type_traits>
+
+namespace SVMV
+{
+    class ThreadPool
+    {
+    public:
+        ThreadPool() = default;
+        ThreadPool(unsigned threadCount); // a thread count of 0 or 1 runs every task on the calling thread
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ThreadPool(ThreadPool&& other) = delete;
+        ThreadPool& operator=(ThreadPool&& other) = delete;
+
+        ~ThreadPool();
+
+        template <typename Function>
+        std::future<std::invoke_result_t<Function>> submit(Function&& function)
+        {
+            using ResultType = std::invoke_result_t<Function>;
+
+            auto task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<Function>(function));
+            std::future<ResultType> future = task->get_future();
+
+            if (_workers.empty())
+            {
+                (*task)();
+                return future;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _tasks.push([task]() { (*task)(); });
+            }
+
+            _condition.notify_one();
+
+            return future;
+        }
+
+        // splits [0, count) into chunks and blocks until all of them are processed, must not be called from inside a pool task
+        void parallelFor(size_t count, const std::function<void(size_t index)>& function);
+
+        [[nodiscard]] unsigned getThreadCount() const noexcept;
+
+    private:
+        void workerLoop();
+
+    private:
+        std::vector<std::thread> _workers;
+        std::queue<std::function<void()>> _tasks;
+
+        std::mutex _mutex;
+        std::condition_variable _condition;
+        bool _stopping{ false };
+    };
+}
@@ -2,7 +2,10 @@
 
 using namespace SVMV;
 
-VulkanBuffer::VulkanBuffer(vk::raii::Device* device, VmaAllocator vmaAllocator, size_t bufferSize, vk::Flags<vk::BufferUsageFlagBits> bufferUsage, bool enableWriting/* = false*/)
+VulkanBuffer::VulkanBuffer(
+    vk::raii::Device* device, VmaAllocator vmaAllocator, size_t bufferSize, vk::Flags<vk::BufferUsageFlagBits> bufferUsage, bool enableWriting/* = false*/,
+    std::vector<uint32_t> queueFamilies/* = {}*/
+)
 {
     _allocator = vmaAllocator;
 
@@ -10,6 +13,17 @@ VulkanBuffer::VulkanBuffer(vk::raii::Device* device, VmaAllocator vmaAllocator,
     bufferCreateInfo.setSize(bufferSize);
     bufferCreateInfo.setUsage(bufferUsage);
 
+    std::sort(queueFamilies.begin(), queueFamilies.end());
+    queueFamilies.erase(std::unique(queueFamilies.begin(), queueFamilies.end()), queueFamilies.end());
+
+    if (queueFamilies.size() > 1)
+    {
+        bufferCreateInfo.setSharingMode(vk::SharingMode::eConcurrent);
+        bufferCreateInfo.setQueueFamilyIndices(queueFamilies);
+
+        _concurrent = true;
+    }
+
     VmaAllocationCreateInfo vmaAllocationInfo = {};
     vmaAllocationInfo.usage = VMA_MEMORY_USAGE_AUTO;
     if (enableWriting)
@@ -37,10 +51,12 @@ VulkanBuffer::VulkanBuffer(VulkanBuffer&& other) noexcept
     this->_allocator = other._allocator;
     this->_allocation = other._allocation;
     this->_size = other._size;
+    this->_concurrent = other._concurrent;
 
     other._allocator = nullptr;
     other._allocation = nullptr;
     other._size = 0;
+    other._concurrent = false;
 }
 
 VulkanBuffer& VulkanBuffer::operator=(VulkanBuffer&& other) noexcept
@@ -58,10 +74,12 @@ VulkanBuffer& VulkanBuffer::operator=(VulkanBuffer&& other) noexcept
         this->_allocator = other._allocator;
         this->_allocation = other._allocation;
         this->_size = other._size;
+        this->_concurrent = other._concurrent;
 
         other._allocator = nullptr;
         other._allocation = nullptr;
         other._size = 0;
+        other._concurrent = false;
     }
 
     return *this;
@@ -110,8 +128,13 @@ const vk::DeviceAddress VulkanBuffer::getAddress(const vk::Device& device) const
     return device.getBufferAddress(deviceAddressInfo);
 }
 
-VulkanGPUBuffer::VulkanGPUBuffer(vk::raii::Device* device, VmaAllocator vmaAllocator, size_t bufferSize, vk::Flags<vk::BufferUsageFlagBits> bufferUsage)
-    : VulkanBuffer(device, vmaAllocator, bufferSize, bufferUsage)
+bool VulkanBuffer::isConcurrent() const noexcept
+{
+    return _concurrent;
+}
+
+VulkanGPUBuffer::VulkanGPUBuffer(vk::raii::Device* device, VmaAllocator vmaAllocator, size_t bufferSize, vk::Flags<vk::BufferUsageFlagBits> bufferUsage, std::vector<uint32_t> queueFamilies/* = {}*/)
+    : VulkanBuffer(device, vmaAllocator, bufferSize, bufferUsage, false, std::move(queueFamilies))
 {}
 
 VulkanGPUBuffer::VulkanGPUBuffer(VulkanGPUBuffer&& other) noexcept
@@ -191,10 +214,22 @@ VulkanStagingBuffer::~VulkanStagingBuffer()
     }
 }
 
-void VulkanStagingBuffer::pushData(void* data, size_t size)
+void VulkanStagingBuffer::pushData(const void* data, size_t size)
+{
+    memcpy(allocate(size), data, size);
+}
+
+std::byte* VulkanStagingBuffer::allocate(size_t size)
 {
-    memcpy(_mappedData + _filledSize, data, size);
+    if (size > _capacity - _filledSize)
+    {
+        throw std::runtime_error("vulkan: staging buffer overflow");
+    }
+
+    std::byte* region = _mappedData + _filledSize;
     _filledSize += size;
+
+    return region;
 }
 
 void VulkanStagingBuffer::resetDataPointer()
@@ -214,6 +249,8 @@ void VulkanStagingBuffer::copyToBuffer(const VulkanBuffer& destination, size_t s
     copy.setSrcOffset(0);
     copy.setDstOffset(offset);
 
+    vmaFlushAllocation(_allocator, _allocation, 0, sizeToCopy); // no-op for host-coherent memory
+
     // TODO: have this wait for fence for the copy
 
     /*vk::raii::Fence* fence = */_immediateSubmit->submit([&](vk::CommandBuffer commandBuffer)
@@ -277,3 +314,51 @@ void VulkanUniformBuffer::setData(void* data, size_t size)
         memcpy(_mappedData, data, size);
     }
 }
+
+VulkanReadbackBuffer::VulkanReadbackBuffer(vk::raii::Device* device, VmaAllocator vmaAllocator, size_t bufferSize)
+    : VulkanBuffer(device, vmaAllocator, bufferSize, vk::BufferUsageFlagBits::eTransferDst, true)
+{
+    vmaMapMemory(_allocator, _allocation, reinterpret_cast<void**>(&_mappedData));
+}
+
+VulkanReadbackBuffer::VulkanReadbackBuffer(VulkanReadbackBuffer&& other) noexcept
+    : VulkanBuffer(std::move(other))
+{
+    this->_mappedData = other._mappedData;
+
+    other._mappedData = nullptr;
+}
+
+VulkanReadbackBuffer& VulkanReadbackBuffer::operator=(VulkanReadbackBuffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (this->_allocator != nullptr && this->_allocation != nullptr)
+        {
+            vmaUnmapMemory(this->_allocator, this->_allocation);
+        }
+
+        VulkanBuffer::operator=(std::move(other));
+
+        this->_mappedData = other._mappedData;
+
+        other._mappedData = nullptr;
+    }
+
+    return *this;
+}
+
+VulkanReadbackBuffer::~VulkanReadbackBuffer()
+{
+    if (_allocator != nullptr && _allocation != nullptr)
+    {
+        vmaUnmapMemory(_allocator, _allocation);
+    }
+}
+
+const std::byte* VulkanReadbackBuffer::getData()
+{
+    vmaInvalidateAllocation(_allocator, _allocation, 0, VK_WHOLE_SIZE);
+
+    return _mappedData;
+}
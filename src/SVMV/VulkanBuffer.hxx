@@ -6,6 +6,8 @@
 #include <vk_mem_alloc.h>
 
 #include <memory>
+#include <vector>
+#include <algorithm>
 
 namespace SVMV
 {
@@ -13,7 +15,10 @@ namespace SVMV
     {
     public:
         VulkanBuffer() = default;
-        VulkanBuffer(vk::raii::Device* device, VmaAllocator vmaAllocator, size_t bufferSize, vk::Flags<vk::BufferUsageFlagBits> bufferUsage, bool enableWriting = false);
+        VulkanBuffer(
+            vk::raii::Device* device, VmaAllocator vmaAllocator, size_t bufferSize, vk::Flags<vk::BufferUsageFlagBits> bufferUsage, bool enableWriting = false,
+            std::vector<uint32_t> queueFamilies = {}
+        ); // shared concurrently between the queue families if they contain more than one distinct family
 
         VulkanBuffer(const VulkanBuffer&) = delete;
         VulkanBuffer& operator=(const VulkanBuffer&) = delete;
@@ -30,6 +35,7 @@ namespace SVMV
         [[nodiscard]] const VmaAllocation getAllocation() const;
         [[nodiscard]] const size_t getSize() const;
         [[nodiscard]] const vk::DeviceAddress getAddress(const vk::Device& device) const; // TODO: get address at creation and make this a getter
+        [[nodiscard]] bool isConcurrent() const noexcept; // no queue family ownership transfers are needed
 
     protected:
         vk::raii::Buffer _buffer    { nullptr };
@@ -37,7 +43,8 @@ namespace SVMV
         VmaAllocator _allocator     { nullptr };
         VmaAllocation _allocation   { nullptr };
 
-        size_t _size    { 0 };
+        size_t _size        { 0 };
+        bool _concurrent    { false };
     };
 
     // GPU BUFFER
@@ -46,7 +53,7 @@ namespace SVMV
     {
     public:
         VulkanGPUBuffer() = default;
-        VulkanGPUBuffer(vk::raii::Device* device, VmaAllocator vmaAllocator, size_t bufferSize, vk::Flags<vk::BufferUsageFlagBits> bufferUsage);
+        VulkanGPUBuffer(vk::raii::Device* device, VmaAllocator vmaAllocator, size_t bufferSize, vk::Flags<vk::BufferUsageFlagBits> bufferUsage, std::vector<uint32_t> queueFamilies = {});
 
         VulkanGPUBuffer(const VulkanGPUBuffer&) = delete;
         VulkanGPUBuffer& operator=(const VulkanGPUBuffer&) = delete;
@@ -74,7 +81,8 @@ namespace SVMV
 
         ~VulkanStagingBuffer();
 
-        void pushData(void* data, size_t size);
+        void pushData(const void* data, size_t size);
+        [[nodiscard]] std::byte* allocate(size_t size); // reserves the next size bytes of mapped memory for the caller to write into
         void resetDataPointer();
 
         void copyToBuffer(const VulkanBuffer& destination);
@@ -107,4 +115,25 @@ namespace SVMV
     private:
         std::byte* _mappedData      { nullptr };
     };
+
+    // READBACK BUFFER
+
+    class VulkanReadbackBuffer : public VulkanBuffer
+    {
+    public:
+        VulkanReadbackBuffer() = default;
+        VulkanReadbackBuffer(vk::raii::Device* device, VmaAllocator vmaAllocator, size_t bufferSize);
+
+        VulkanReadbackBuffer(const VulkanReadbackBuffer&) = delete;
+        VulkanReadbackBuffer& operator=(const VulkanReadbackBuffer&) = delete;
+
+        VulkanReadbackBuffer(VulkanReadbackBuffer&& other) noexcept;
+        VulkanReadbackBuffer& operator=(VulkanReadbackBuffer&& other) noexcept;
+
+        ~VulkanReadbackBuffer();
+
+        [[nodiscard]] const std::byte* getData(); // invalidates the mapped range before returning it
+    private:
+        std::byte* _mappedData      { nullptr };
+    };
 }
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include <SVMV/VulkanDepthPyramid.hxx>
+
+using namespace SVMV;
+
+VulkanDepthPyramid::VulkanDepthPyramid(vk::raii::Device* device, VmaAllocator memoryAllocator, const shaderc::Compiler& compiler, const vk::raii::PipelineCache& pipelineCache)
+    : _device(device), _memoryAllocator(memoryAllocator)
+{
+    _shader = VulkanShader(*_device, compiler, VulkanShader::ShaderType::COMPUTE, "depth_pyramid_comp.glsl");
+
+    // the source level is fetched through a sampler, as the depth buffer cannot be a storage image
+    vk::DescriptorSetLayoutBinding reductionBindings[2];
+    reductionBindings[0].setBinding(0);
+    reductionBindings[0].setDescriptorCount(1);
+    reductionBindings[0].setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
+    reductionBindings[0].setStageFlags(vk::ShaderStageFlagBits::eCompute);
+
+    reductionBindings[1].setBinding(1);
+    reductionBindings[1].setDescriptorCount(1);
+    reductionBindings[1].setDescriptorType(vk::DescriptorType::eStorageImage);
+    reductionBindings[1].setStageFlags(vk::ShaderStageFlagBits::eCompute);
+
+    vk::DescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo;
+    descriptorSetLayoutCreateInfo.setBindings(reductionBindings);
+
+    _reductionDescriptorSetLayout = vk::raii::DescriptorSetLayout(*_device, descriptorSetLayoutCreateInfo);
+
+    descriptorSetLayoutCreateInfo.setBindings(reductionBindings[0]);
+
+    _descriptorSetLayout = vk::raii::DescriptorSetLayout(*_device, descriptorSetLayoutCreateInfo);
+
+    vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo;
+    pipelineLayoutCreateInfo.setSetLayouts(*_reductionDescriptorSetLayout);
+
+    _pipelineLayout = vk::raii::PipelineLayout(*_device, pipelineLayoutCreateInfo);
+
+    _pipeline = VulkanUtilities::createComputePipeline(*_device, pipelineCache, _pipelineLayout, _shader.getModule());
+
+    vk::SamplerCreateInfo samplerCreateInfo;
+    samplerCreateInfo.setMagFilter(vk::Filter::eNearest);
+    samplerCreateInfo.setMinFilter(vk::Filter::eNearest);
+    samplerCreateInfo.setMipmapMode(vk::SamplerMipmapMode::eNearest);
+    samplerCreateInfo.setAddressModeU(vk::SamplerAddressMode::eClampToEdge);
+    samplerCreateInfo.setAddressModeV(vk::SamplerAddressMode::eClampToEdge);
+    samplerCreateInfo.setAddressModeW(vk::SamplerAddressMode::eClampToEdge);
+    samplerCreateInfo.setMaxLod(vk::LodClampNone);
+
+    _sampler = vk::raii::Sampler(*_device, samplerCreateInfo);
+}
+
+VulkanDepthPyramid::VulkanDepthPyramid(VulkanDepthPyramid&& other) noexcept
+{
+    this->_device = other._device;
+    this->_memoryAllocator = other._memoryAllocator;
+    this->_shader = std::move(other._shader);
+    this->_reductionDescriptorSetLayout = std::move(other._reductionDescriptorSetLayout);
+    this->_descriptorSetLayout = std::move(other._descriptorSetLayout);
+    this->_pipelineLayout = std::move(other._pipelineLayout);
+    this->_pipeline = std::move(other._pipeline);
+    this->_sampler = std::move(other._sampler);
+    this->_image = std::move(other._image);
+    this->_levelViews = std::move(other._levelViews);
+    this->_descriptorPool = std::move(other._descriptorPool);
+    this->_reductionDescriptorSets = std::move(other._reductionDescriptorSets);
+    this->_descriptorSet = std::move(other._descriptorSet);
+    this->_depthExtent = other._depthExtent;
+    this->_levelCount = other._levelCount;
+
+    other._device = nullptr;
+    other._memoryAllocator = nullptr;
+    other._depthExtent = vk::Extent2D(0, 0);
+    other._levelCount = 0;
+}
+
+VulkanDepthPyramid& VulkanDepthPyramid::operator=(VulkanDepthPyramid&& other) noexcept
+{
+    if (this != &other)
+    {
+        // the sets have to be freed before their pool is destroyed
+        this->_descriptorSet.clear();
+        this->_reductionDescriptorSets.clear();
+
+        this->_device = other._device;
+        this->_memoryAllocator = other._memoryAllocator;
+        this->_shader = std::move(other._shader);
+        this->_reductionDescriptorSetLayout = std::move(other._reductionDescriptorSetLayout);
+        this->_descriptorSetLayout = std::move(other._descriptorSetLayout);
+        this->_pipelineLayout = std::move(other._pipelineLayout);
+        this->_pipeline = std::move(other._pipeline);
+        this->_sampler = std::move(other._sampler);
+        this->_levelViews = std::move(other._levelViews);
+        this->_image = std::move(other._image);
+        this->_descriptorPool = std::move(other._descriptorPool);
+        this->_reductionDescriptorSets = std::move(other._reductionDescriptorSets);
+        this->_descriptorSet = std::move(other._descriptorSet);
+        this->_depthExtent = other._depthExtent;
+        this->_levelCount = other._levelCount;
+
+        other._device = nullptr;
+        other._memoryAllocator = nullptr;
+        other._depthExtent = vk::Extent2D(0, 0);
+        other._levelCount = 0;
+    }
+
+    return *this;
+}
+
+void VulkanDepthPyramid::resize(const VulkanImage& depthBuffer)
+{
+    _descriptorSet.clear();
+    _reductionDescriptorSets.clear();
+    _descriptorPool.clear();
+    _levelViews.clear();
+
+    _depthExtent = vk::Extent2D(depthBuffer.getExtent().width, depthBuffer.getExtent().height);
+
+    // the usual mip chain down to a single texel, the last texel of a level also covers the odd row or column of the level below
+    vk::Extent2D extent(std::max(1u, _depthExtent.width / 2), std::max(1u, _depthExtent.height / 2));
+
+    _levelCount = 1;
+
+    while ((std::max(extent.width, extent.height) >> _levelCount) > 0)
+    {
+        _levelCount++;
+    }
+
+    _image = VulkanImage(
+        _device, _memoryAllocator, extent, vk::Format::eR32Sfloat, vk::ImageAspectFlagBits::eColor, vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled, _levelCount
+    );
+
+    for (uint32_t level = 0; level < _levelCount; level++)
+    {
+        vk::ImageViewCreateInfo imageViewCreateInfo;
+        imageViewCreateInfo.setViewType(vk::ImageViewType::e2D);
+        imageViewCreateInfo.setImage(_image.getImage());
+        imageViewCreateInfo.setFormat(vk::Format::eR32Sfloat);
+        imageViewCreateInfo.setSubresourceRange(vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, level, 1, 0, 1 });
+
+        _levelViews.emplace_back(*_device, imageViewCreateInfo);
+    }
+
+    vk::DescriptorPoolSize poolSizes[2];
+    poolSizes[0].setType(vk::DescriptorType::eCombinedImageSampler);
+    poolSizes[0].setDescriptorCount(_levelCount + 1);
+
+    poolSizes[1].setType(vk::DescriptorType::eStorageImage);
+    poolSizes[1].setDescriptorCount(_levelCount);
+
+    vk::DescriptorPoolCreateInfo descriptorPoolCreateInfo;
+    descriptorPoolCreateInfo.setFlags(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet);
+    descriptorPoolCreateInfo.setMaxSets(_levelCount + 1);
+    descriptorPoolCreateInfo.setPoolSizes(poolSizes);
+
+    _descriptorPool = vk::raii::DescriptorPool(*_device, descriptorPoolCreateInfo);
+
+    std::vector<vk::DescriptorSetLayout> setLayouts(_levelCount, *_reductionDescriptorSetLayout);
+
+    vk::DescriptorSetAllocateInfo descriptorSetAllocateInfo;
+    descriptorSetAllocateInfo.setDescriptorPool(*_descriptorPool);
+    descriptorSetAllocateInfo.setSetLayouts(setLayouts);
+
+    _reductionDescriptorSets = vk::raii::DescriptorSets(*_device, descriptorSetAllocateInfo);
+
+    descriptorSetAllocateInfo.setSetLayouts(*_descriptorSetLayout);
+
+    _descriptorSet = std::move(vk::raii::DescriptorSets(*_device, descriptorSetAllocateInfo).front());
+
+    // the pyramid stays in the general layout, it is written and sampled by compute shaders only
+    std::vector<vk::DescriptorImageInfo> sourceInfos(_levelCount);
+    std::vector<vk::DescriptorImageInfo> destinationInfos(_levelCount);
+    std::vector<vk::WriteDescriptorSet> writes;
+
+    for (uint32_t level = 0; level < _levelCount; level++)
+    {
+        if (level == 0)
+        {
+            sourceInfos[level] = vk::DescriptorImageInfo(*_sampler, *depthBuffer.getImageView(), vk::ImageLayout::eShaderReadOnlyOptimal);
+        }
+        else
+        {
+            sourceInfos[level] = vk::DescriptorImageInfo(*_sampler, *_levelViews[level - 1], vk::ImageLayout::eGeneral);
+        }
+
+        destinationInfos[level] = vk::DescriptorImageInfo(nullptr, *_levelViews[level], vk::ImageLayout::eGeneral);
+
+        writes.push_back(vk::WriteDescriptorSet(*_reductionDescriptorSets[level], 0, 0, vk::DescriptorType::eCombinedImageSampler, sourceInfos[level]));
+        writes.push_back(vk::WriteDescriptorSet(*_reductionDescriptorSets[level], 1, 0, vk::DescriptorType::eStorageImage, destinationInfos[level]));
+    }
+
+    vk::DescriptorImageInfo pyramidInfo(*_sampler, *_image.getImageView(), vk::ImageLayout::eGeneral);
+
+    writes.push_back(vk::WriteDescriptorSet(*_descriptorSet, 0, 0, vk::DescriptorType::eCombinedImageSampler, pyramidInfo));
+
+    _device->updateDescriptorSets(writes, nullptr);
+}
+
+void VulkanDepthPyramid::recordBuild(const vk::raii::CommandBuffer& commandBuffer) const
+{
+    // every level is rewritten, so the previous contents are discarded, after the culling of the previous frame read them
+    vk::ImageMemoryBarrier discardBarrier;
+    discardBarrier.setOldLayout(vk::ImageLayout::eUndefined);
+    discardBarrier.setNewLayout(vk::ImageLayout::eGeneral);
+    discardBarrier.setDstAccessMask(vk::AccessFlagBits::eShaderWrite);
+    discardBarrier.setImage(_image.getImage());
+    discardBarrier.setSubresourceRange(vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, _levelCount, 0, 1 });
+
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, nullptr, discardBarrier);
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *_pipeline);
+
+    vk::ImageMemoryBarrier levelBarrier;
+    levelBarrier.setOldLayout(vk::ImageLayout::eGeneral);
+    levelBarrier.setNewLayout(vk::ImageLayout::eGeneral);
+    levelBarrier.setSrcAccessMask(vk::AccessFlagBits::eShaderWrite);
+    levelBarrier.setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+    levelBarrier.setImage(_image.getImage());
+
+    for (uint32_t level = 0; level < _levelCount; level++)
+    {
+        uint32_t width = std::max(1u, _image.getExtent().width >> level);
+        uint32_t height = std::max(1u, _image.getExtent().height >> level);
+
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *_pipelineLayout, 0, *_reductionDescriptorSets[level], nullptr);
+        commandBuffer.dispatch((width + workgroupSize - 1) / workgroupSize, (height + workgroupSize - 1) / workgroupSize, 1);
+
+        // the next level reads this one, and after the last one the culling pass reads them all
+        levelBarrier.setSubresourceRange(vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, level, 1, 0, 1 });
+
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, nullptr, levelBarrier);
+    }
+}
+
+const vk::raii::DescriptorSetLayout& VulkanDepthPyramid::getDescriptorSetLayout() const noexcept
+{
+    return _descriptorSetLayout;
+}
+
+const vk::raii::DescriptorSet& VulkanDepthPyramid::getDescriptorSet() const noexcept
+{
+    return _descriptorSet;
+}
+
+vk::Extent2D VulkanDepthPyramid::getDepthExtent() const noexcept
+{
+    return _depthExtent;
+}
+
+uint32_t VulkanDepthPyramid::getLevelCount() const noexcept
+{
+    return _levelCount;
+}
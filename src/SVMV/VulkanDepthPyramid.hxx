@@ -0,0 +1,67 @@
+#pragma once
+
+#include <SVMV/VulkanImage.hxx>
+#include <SVMV/VulkanShader.hxx>
+#include <SVMV/VulkanUtilities.hxx>
+
+#include <vulkan/vulkan_raii.hpp>
+#include <vk_mem_alloc.h>
+#include <shaderc/shaderc.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+namespace SVMV
+{
+    // hierarchical depth buffer for occlusion culling: level 0 is the depth buffer at half its resolution, and every texel of a level
+    // holds the farthest depth of the texels it covers in the level below, so a single texel fetch bounds the depth of a screen region
+    class VulkanDepthPyramid
+    {
+    public:
+        static constexpr uint32_t workgroupSize = 8; // local_size_x and local_size_y of the reduction shader
+
+    public:
+        VulkanDepthPyramid() = default;
+        VulkanDepthPyramid(vk::raii::Device* device, VmaAllocator memoryAllocator, const shaderc::Compiler& compiler, const vk::raii::PipelineCache& pipelineCache);
+
+        VulkanDepthPyramid(const VulkanDepthPyramid&) = delete;
+        VulkanDepthPyramid& operator=(const VulkanDepthPyramid&) = delete;
+
+        VulkanDepthPyramid(VulkanDepthPyramid&& other) noexcept;
+        VulkanDepthPyramid& operator=(VulkanDepthPyramid&& other) noexcept;
+
+        ~VulkanDepthPyramid() = default;
+
+        void resize(const VulkanImage& depthBuffer); // recreates the pyramid for the extent of the depth buffer, the device has to be idle
+
+        // the depth buffer has to be in eShaderReadOnlyOptimal with its writes visible to compute shaders, the pyramid is readable by compute shaders afterwards
+        void recordBuild(const vk::raii::CommandBuffer& commandBuffer) const;
+
+        [[nodiscard]] const vk::raii::DescriptorSetLayout& getDescriptorSetLayout() const noexcept; // a single sampler covering all levels
+        [[nodiscard]] const vk::raii::DescriptorSet& getDescriptorSet() const noexcept;
+        [[nodiscard]] vk::Extent2D getDepthExtent() const noexcept; // of the depth buffer the pyramid was built for
+        [[nodiscard]] uint32_t getLevelCount() const noexcept;
+
+    private:
+        vk::raii::Device* _device           { nullptr };
+        VmaAllocator _memoryAllocator       { nullptr };
+
+        VulkanShader _shader;
+        vk::raii::DescriptorSetLayout _reductionDescriptorSetLayout     { nullptr };
+        vk::raii::DescriptorSetLayout _descriptorSetLayout              { nullptr };
+        vk::raii::PipelineLayout _pipelineLayout                        { nullptr };
+        vk::raii::Pipeline _pipeline                                    { nullptr };
+        vk::raii::Sampler _sampler                                      { nullptr }; // nearest, the shaders only fetch texels
+
+        VulkanImage _image;
+        std::vector<vk::raii::ImageView> _levelViews;
+
+        vk::raii::DescriptorPool _descriptorPool                        { nullptr }; // recreated with the pyramid
+        std::vector<vk::raii::DescriptorSet> _reductionDescriptorSets; // one per level, reading the level below or the depth buffer and writing the level
+        vk::raii::DescriptorSet _descriptorSet                          { nullptr };
+
+        vk::Extent2D _depthExtent   { 0, 0 };
+        uint32_t _levelCount        { 0 };
+    };
+}
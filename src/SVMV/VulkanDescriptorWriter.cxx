@@ -61,3 +61,20 @@ void VulkanDescriptorWriter::writeImageAndSampler(
 
     _device->updateDescriptorSets(writeDescriptorSet, nullptr);
 }
+
+void VulkanDescriptorWriter::writeImagesAndSamplers(const vk::raii::DescriptorSet& descriptorSet, const std::vector<vk::DescriptorImageInfo>& imageInfos, int binding)
+{
+    if (imageInfos.empty())
+    {
+        return;
+    }
+
+    vk::WriteDescriptorSet writeDescriptorSet;
+    writeDescriptorSet.setDstBinding(binding);
+    writeDescriptorSet.setDstSet(descriptorSet);
+    writeDescriptorSet.setDstArrayElement(0);
+    writeDescriptorSet.setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
+    writeDescriptorSet.setImageInfo(imageInfos);
+
+    _device->updateDescriptorSets(writeDescriptorSet, nullptr);
+}
@@ -5,6 +5,8 @@
 #include <SVMV/VulkanBuffer.hxx>
 #include <SVMV/VulkanImage.hxx>
 
+#include <vector>
+
 namespace SVMV
 {
     class VulkanDescriptorWriter
@@ -27,6 +29,7 @@ namespace SVMV
             const vk::raii::DescriptorSet& descriptorSet, const VulkanImage& image,
             vk::ImageLayout imageLayout, const vk::raii::Sampler& sampler, int binding
         );
+        void writeImagesAndSamplers(const vk::raii::DescriptorSet& descriptorSet, const std::vector<vk::DescriptorImageInfo>& imageInfos, int binding); // consecutive array elements starting at 0
 
     private:
         vk::raii::Device* _device;
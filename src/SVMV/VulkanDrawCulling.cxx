@@ -0,0 +1,530 @@
+#include <SVMV/VulkanDrawCulling.hxx>
+
+using namespace SVMV;
+
+namespace
+{
+    // offsets of the results of the host culling in the staging buffers, the statistics come first so they are copied with a single region
+    struct HostCullLayout
+    {
+        size_t visibleInstances     { 0 };
+        size_t commands             { 0 };
+        size_t drawCounts           { 0 };
+        size_t size                 { 0 };
+    };
+
+    HostCullLayout getHostCullLayout(const VulkanScene& scene)
+    {
+        HostCullLayout layout;
+        layout.visibleInstances = sizeof(ShaderStructures::CullStatistics);
+        layout.commands = layout.visibleInstances + scene.instanceCount * sizeof(glm::uvec2);
+        layout.drawCounts = layout.commands + scene.drawCount * sizeof(vk::DrawIndexedIndirectCommand);
+        layout.size = layout.drawCounts + scene.batchCount * sizeof(uint32_t);
+
+        return layout;
+    }
+}
+
+VulkanDrawCulling::VulkanDrawCulling(
+    vk::raii::Device* device, VmaAllocator memoryAllocator, const shaderc::Compiler& compiler, const vk::raii::PipelineCache& pipelineCache, std::vector<uint32_t> queueFamilies, int framesInFlight, bool drawIndirectCount,
+    const vk::raii::DescriptorSetLayout& depthPyramidLayout
+)
+    : _device(device), _memoryAllocator(memoryAllocator), _queueFamilies(std::move(queueFamilies)), _framesInFlight(framesInFlight), _drawIndirectCount(drawIndirectCount)
+{
+    _shader = VulkanShader(*_device, compiler, VulkanShader::ShaderType::COMPUTE, "draw_cull_comp.glsl");
+
+    vk::PushConstantRange pushConstantRange;
+    pushConstantRange.setOffset(0);
+    pushConstantRange.setSize(sizeof(ShaderStructures::CullPushConstants));
+    pushConstantRange.setStageFlags(vk::ShaderStageFlagBits::eCompute);
+
+    vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo;
+    pipelineLayoutCreateInfo.setSetLayouts(*depthPyramidLayout);
+    pipelineLayoutCreateInfo.setPushConstantRanges(pushConstantRange);
+
+    _pipelineLayout = vk::raii::PipelineLayout(*_device, pipelineLayoutCreateInfo);
+
+    _pipeline = VulkanUtilities::createComputePipeline(*_device, pipelineCache, _pipelineLayout, _shader.getModule());
+
+    vk::BufferUsageFlags statisticsUsage = vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress;
+
+    for (int i = 0; i < _framesInFlight; i++)
+    {
+        _statisticsGPUBuffers.emplace_back(_device, _memoryAllocator, sizeof(ShaderStructures::CullStatistics), statisticsUsage, _queueFamilies);
+        _statisticsReadbackBuffers.emplace_back(_device, _memoryAllocator, sizeof(ShaderStructures::CullStatistics));
+    }
+}
+
+VulkanDrawCulling::VulkanDrawCulling(VulkanDrawCulling&& other) noexcept
+{
+    this->_device = other._device;
+    this->_memoryAllocator = other._memoryAllocator;
+    this->_queueFamilies = std::move(other._queueFamilies);
+    this->_framesInFlight = other._framesInFlight;
+    this->_drawIndirectCount = other._drawIndirectCount;
+    this->_shader = std::move(other._shader);
+    this->_pipelineLayout = std::move(other._pipelineLayout);
+    this->_pipeline = std::move(other._pipeline);
+    this->_statisticsGPUBuffers = std::move(other._statisticsGPUBuffers);
+    this->_statisticsReadbackBuffers = std::move(other._statisticsReadbackBuffers);
+
+    other._device = nullptr;
+    other._memoryAllocator = nullptr;
+    other._framesInFlight = 0;
+    other._drawIndirectCount = false;
+}
+
+VulkanDrawCulling& VulkanDrawCulling::operator=(VulkanDrawCulling&& other) noexcept
+{
+    if (this != &other)
+    {
+        this->_device = other._device;
+        this->_memoryAllocator = other._memoryAllocator;
+        this->_queueFamilies = std::move(other._queueFamilies);
+        this->_framesInFlight = other._framesInFlight;
+        this->_drawIndirectCount = other._drawIndirectCount;
+        this->_shader = std::move(other._shader);
+        this->_pipelineLayout = std::move(other._pipelineLayout);
+        this->_pipeline = std::move(other._pipeline);
+        this->_statisticsGPUBuffers = std::move(other._statisticsGPUBuffers);
+        this->_statisticsReadbackBuffers = std::move(other._statisticsReadbackBuffers);
+
+        other._device = nullptr;
+        other._memoryAllocator = nullptr;
+        other._framesInFlight = 0;
+        other._drawIndirectCount = false;
+    }
+
+    return *this;
+}
+
+void VulkanDrawCulling::createDrawBuffers(VulkanScene& scene, VulkanUploadManager* uploadManager) const
+{
+    std::vector<ShaderStructures::DrawData> drawData;
+    std::vector<ShaderStructures::DrawCullData> cullData;
+    std::vector<ShaderStructures::InstanceCullData> instanceCullData;
+
+    for (auto& context : scene.contexts)
+    {
+        const std::vector<VulkanDrawable>& drawables = context.second.drawables;
+
+        // the material is selected per draw, so all draws of a context share the bound descriptor sets, and only draws of different permutations need another pipeline
+        std::vector<uint32_t> drawableOrder(drawables.size());
+        std::iota(drawableOrder.begin(), drawableOrder.end(), 0);
+        std::stable_sort(drawableOrder.begin(), drawableOrder.end(), [&](uint32_t a, uint32_t b) { return drawables[a].features < drawables[b].features; });
+
+        context.second.batches.clear();
+
+        for (uint32_t drawableIndex : drawableOrder)
+        {
+            const VulkanDrawable& drawable = drawables[drawableIndex];
+
+            if (context.second.batches.empty() || context.second.batches.back().features != drawable.features)
+            {
+                VulkanDrawBatch newBatch;
+                newBatch.index = scene.batchCount++;
+                newBatch.firstDraw = static_cast<uint32_t>(drawData.size());
+                newBatch.features = drawable.features;
+
+                context.second.batches.push_back(newBatch);
+            }
+
+            VulkanDrawBatch& batch = context.second.batches.back();
+            batch.drawCount++;
+
+            uint32_t drawIndex = static_cast<uint32_t>(drawData.size());
+
+            ShaderStructures::DrawData draw;
+            draw.positions = drawable.attributeAddresses.positions;
+            draw.normals = drawable.attributeAddresses.normals;
+            draw.tangents = drawable.attributeAddresses.tangents;
+            draw.texcoords_0 = drawable.attributeAddresses.texcoords_0;
+            draw.colors_0 = drawable.attributeAddresses.colors_0;
+            draw.material = drawable.materialIndex;
+
+            ShaderStructures::DrawCullData cull;
+            cull.firstIndex = drawable.firstIndex;
+            cull.indexCount = drawable.indexCount;
+            cull.firstInstance = static_cast<uint32_t>(instanceCullData.size());
+            cull.batch = batch.index;
+            cull.batchFirstDraw = batch.firstDraw;
+
+            // the instances of a draw are consecutive, so its visible instances can be written to the same range
+            for (const auto& instance : drawable.instances)
+            {
+                ShaderStructures::InstanceCullData instanceCull;
+                instanceCull.boundsMin = glm::vec4(instance.boundsMin, instance.bounded ? 0.0f : 1.0f);
+                instanceCull.boundsMax = glm::vec4(instance.boundsMax, 0.0f);
+                instanceCull.draw = drawIndex;
+                instanceCull.matrix = instance.matrixIndex;
+
+                instanceCullData.push_back(instanceCull);
+
+                if (instance.bounded)
+                {
+                    scene.instanceBounds.push(instance.boundsMin, instance.boundsMax);
+                }
+                else
+                {
+                    scene.instanceBounds.pushUnbounded();
+                }
+
+                scene.instanceMatrices.push_back(instance.matrixIndex);
+            }
+
+            drawData.push_back(draw);
+            cullData.push_back(cull);
+        }
+    }
+
+    scene.drawCount = static_cast<uint32_t>(drawData.size());
+    scene.instanceCount = static_cast<uint32_t>(instanceCullData.size());
+
+    scene.instanceBounds.pad();
+    scene.instanceVisibilityMasks.resize(scene.instanceBounds.getGroupCount());
+    scene.drawCullData = cullData;
+
+    if (scene.drawCount == 0)
+    {
+        return;
+    }
+
+    vk::BufferUsageFlags inputUsage = vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress;
+    vk::BufferUsageFlags outputUsage = vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress | vk::BufferUsageFlagBits::eIndirectBuffer;
+
+    // the draw data is only read by the vertex shader, everything else is also accessed by the culling pass which may run on another queue family
+    scene.drawDataGPUBuffer = VulkanGPUBuffer(_device, _memoryAllocator, drawData.size() * sizeof(ShaderStructures::DrawData), inputUsage);
+    scene.cullDataGPUBuffer = VulkanGPUBuffer(_device, _memoryAllocator, cullData.size() * sizeof(ShaderStructures::DrawCullData), inputUsage, _queueFamilies);
+    scene.instanceCullDataGPUBuffer = VulkanGPUBuffer(_device, _memoryAllocator, instanceCullData.size() * sizeof(ShaderStructures::InstanceCullData), inputUsage, _queueFamilies);
+
+    uploadManager->uploadBuffer(scene.drawDataGPUBuffer, drawData.data(), scene.drawDataGPUBuffer.getSize());
+    uploadManager->uploadBuffer(scene.cullDataGPUBuffer, cullData.data(), scene.cullDataGPUBuffer.getSize());
+    uploadManager->uploadBuffer(scene.instanceCullDataGPUBuffer, instanceCullData.data(), scene.instanceCullDataGPUBuffer.getSize());
+
+    // nothing counts as visible before the first occlusion test, so the first early pass draws nothing and the late pass everything
+    std::vector<uint32_t> instanceVisibility(scene.instanceCount, 0);
+
+    scene.instanceVisibilityGPUBuffer = VulkanGPUBuffer(_device, _memoryAllocator, instanceVisibility.size() * sizeof(uint32_t), inputUsage, _queueFamilies);
+    uploadManager->uploadBuffer(scene.instanceVisibilityGPUBuffer, instanceVisibility.data(), scene.instanceVisibilityGPUBuffer.getSize());
+
+    for (int i = 0; i < _framesInFlight; i++)
+    {
+        scene.instanceCountGPUBuffers.emplace_back(_device, _memoryAllocator, scene.drawCount * sizeof(uint32_t), outputUsage, _queueFamilies);
+        scene.visibleInstanceGPUBuffers.emplace_back(_device, _memoryAllocator, scene.instanceCount * sizeof(glm::uvec2), outputUsage, _queueFamilies);
+        scene.indirectCommandGPUBuffers.emplace_back(_device, _memoryAllocator, scene.drawCount * sizeof(vk::DrawIndexedIndirectCommand), outputUsage, _queueFamilies);
+        scene.drawCountGPUBuffers.emplace_back(_device, _memoryAllocator, scene.batchCount * sizeof(uint32_t), outputUsage, _queueFamilies);
+    }
+}
+
+void VulkanDrawCulling::recordCulling(
+    const vk::raii::CommandBuffer& commandBuffer, const VulkanScene& scene, int frameIndex, vk::DeviceAddress camera, bool frustumCulling, CullPass pass, const VulkanDepthPyramid& depthPyramid
+) const
+{
+    if (scene.drawCount == 0)
+    {
+        return;
+    }
+
+    const VulkanGPUBuffer& instanceCounts = scene.instanceCountGPUBuffers[frameIndex];
+    const VulkanGPUBuffer& visibleInstances = scene.visibleInstanceGPUBuffers[frameIndex];
+    const VulkanGPUBuffer& commands = scene.indirectCommandGPUBuffers[frameIndex];
+    const VulkanGPUBuffer& drawCounts = scene.drawCountGPUBuffers[frameIndex];
+    const VulkanGPUBuffer& statistics = _statisticsGPUBuffers[frameIndex];
+
+    // the visible instances of each draw and, when compacting, the visible draws of each batch are counted with atomics
+    std::vector<vk::BufferMemoryBarrier> fillBarriers;
+
+    vk::BufferMemoryBarrier fillBarrier;
+    fillBarrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+    fillBarrier.setDstAccessMask(vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+    fillBarrier.setBuffer(*instanceCounts.getBuffer());
+    fillBarrier.setSize(vk::WholeSize);
+
+    commandBuffer.fillBuffer(*instanceCounts.getBuffer(), 0, vk::WholeSize, 0);
+    fillBarriers.push_back(fillBarrier);
+
+    if (_drawIndirectCount)
+    {
+        commandBuffer.fillBuffer(*drawCounts.getBuffer(), 0, vk::WholeSize, 0);
+        fillBarriers.push_back(fillBarrier.setBuffer(*drawCounts.getBuffer()));
+    }
+
+    // the statistics of a frame are summed over its passes
+    if (pass != CullPass::LATE)
+    {
+        commandBuffer.fillBuffer(*statistics.getBuffer(), 0, vk::WholeSize, 0);
+        fillBarriers.push_back(fillBarrier.setBuffer(*statistics.getBuffer()));
+    }
+
+    vk::PipelineStageFlags srcStages = vk::PipelineStageFlagBits::eTransfer;
+
+    if (pass != CullPass::FULL)
+    {
+        // the late pass of the previous frame wrote the visibility, and the late pass reuses the buffers the draws of the early pass read
+        srcStages |= vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexShader;
+
+        vk::BufferMemoryBarrier visibilityBarrier;
+        visibilityBarrier.setSrcAccessMask(vk::AccessFlagBits::eShaderWrite);
+        visibilityBarrier.setDstAccessMask(vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+        visibilityBarrier.setBuffer(*scene.instanceVisibilityGPUBuffer.getBuffer());
+        visibilityBarrier.setSize(vk::WholeSize);
+
+        fillBarriers.push_back(visibilityBarrier);
+
+        if (pass == CullPass::LATE)
+        {
+            fillBarriers.push_back(visibilityBarrier.setBuffer(*statistics.getBuffer()));
+        }
+    }
+
+    commandBuffer.pipelineBarrier(srcStages, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, fillBarriers, nullptr);
+
+    ShaderStructures::CullPushConstants constants;
+    constants.camera = camera;
+    constants.cullData = scene.cullDataGPUBuffer.getAddress(*_device);
+    constants.instanceCullData = scene.instanceCullDataGPUBuffer.getAddress(*_device);
+    constants.instanceCounts = instanceCounts.getAddress(*_device);
+    constants.visibleInstances = visibleInstances.getAddress(*_device);
+    constants.commands = commands.getAddress(*_device);
+    constants.drawCounts = drawCounts.getAddress(*_device);
+    constants.instanceVisibility = scene.instanceVisibilityGPUBuffer.getAddress(*_device);
+    constants.statistics = statistics.getAddress(*_device);
+    constants.depthExtent = glm::uvec2(depthPyramid.getDepthExtent().width, depthPyramid.getDepthExtent().height);
+    constants.depthPyramidLevels = depthPyramid.getLevelCount();
+    constants.drawCount = scene.drawCount;
+    constants.instanceCount = scene.instanceCount;
+    constants.flags = (frustumCulling ? ShaderStructures::CULL_FLAGS_FRUSTUM : 0) | (_drawIndirectCount ? ShaderStructures::CULL_FLAGS_COMPACT : 0);
+
+    if (pass == CullPass::EARLY)
+    {
+        constants.flags |= ShaderStructures::CULL_FLAGS_EARLY;
+    }
+    else if (pass == CullPass::LATE)
+    {
+        constants.flags |= ShaderStructures::CULL_FLAGS_OCCLUSION;
+    }
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *_pipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *_pipelineLayout, 0, *depthPyramid.getDescriptorSet(), nullptr);
+
+    // first the instances are culled, then one command is written per draw with the number of its visible instances
+    commandBuffer.pushConstants<ShaderStructures::CullPushConstants>(*_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, constants);
+    commandBuffer.dispatch((scene.instanceCount + workgroupSize - 1) / workgroupSize, 1, 1);
+
+    vk::BufferMemoryBarrier countBarriers[2];
+    countBarriers[0].setSrcAccessMask(vk::AccessFlagBits::eShaderWrite);
+    countBarriers[0].setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+    countBarriers[0].setBuffer(*instanceCounts.getBuffer());
+    countBarriers[0].setSize(vk::WholeSize);
+    countBarriers[1] = countBarriers[0];
+    countBarriers[1].setDstAccessMask(vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+    countBarriers[1].setBuffer(*statistics.getBuffer());
+
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, countBarriers, nullptr);
+
+    constants.flags |= ShaderStructures::CULL_FLAGS_COMMANDS;
+
+    commandBuffer.pushConstants<ShaderStructures::CullPushConstants>(*_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, constants);
+    commandBuffer.dispatch((scene.drawCount + workgroupSize - 1) / workgroupSize, 1, 1);
+
+    // needed when the draws are recorded into the same queue, a semaphore wait covers the compute queue
+    vk::BufferMemoryBarrier outputBarriers[3];
+    outputBarriers[0].setSrcAccessMask(vk::AccessFlagBits::eShaderWrite);
+    outputBarriers[0].setDstAccessMask(vk::AccessFlagBits::eIndirectCommandRead);
+    outputBarriers[0].setBuffer(*commands.getBuffer());
+    outputBarriers[0].setSize(vk::WholeSize);
+    outputBarriers[1] = outputBarriers[0];
+    outputBarriers[1].setBuffer(*drawCounts.getBuffer());
+    outputBarriers[2] = outputBarriers[0];
+    outputBarriers[2].setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+    outputBarriers[2].setBuffer(*visibleInstances.getBuffer());
+
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexShader, {}, nullptr, outputBarriers, nullptr);
+
+    if (pass == CullPass::EARLY)
+    {
+        return;
+    }
+
+    // read back by the host once the frame's fence was waited for
+    vk::BufferMemoryBarrier statisticsBarrier;
+    statisticsBarrier.setSrcAccessMask(vk::AccessFlagBits::eShaderWrite);
+    statisticsBarrier.setDstAccessMask(vk::AccessFlagBits::eTransferRead);
+    statisticsBarrier.setBuffer(*statistics.getBuffer());
+    statisticsBarrier.setSize(vk::WholeSize);
+
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, statisticsBarrier, nullptr);
+
+    const VulkanReadbackBuffer& readback = _statisticsReadbackBuffers[frameIndex];
+
+    commandBuffer.copyBuffer(*statistics.getBuffer(), *readback.getBuffer(), vk::BufferCopy(0, 0, sizeof(ShaderStructures::CullStatistics)));
+
+    vk::BufferMemoryBarrier readbackBarrier;
+    readbackBarrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+    readbackBarrier.setDstAccessMask(vk::AccessFlagBits::eHostRead);
+    readbackBarrier.setBuffer(*readback.getBuffer());
+    readbackBarrier.setSize(vk::WholeSize);
+
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, nullptr, readbackBarrier, nullptr);
+}
+
+void VulkanDrawCulling::cullOnHost(VulkanScene& scene, int frameIndex, const glm::mat4& viewProjection, bool frustumCulling, ThreadPool& threadPool) const
+{
+    if (scene.drawCount == 0)
+    {
+        return;
+    }
+
+    HostCullLayout layout = getHostCullLayout(scene);
+
+    if (scene.hostCullStagingBuffers.empty())
+    {
+        for (int i = 0; i < _framesInFlight; i++)
+        {
+            scene.hostCullStagingBuffers.emplace_back(_device, nullptr, _memoryAllocator, layout.size);
+        }
+    }
+
+    uint8_t* masks = scene.instanceVisibilityMasks.data();
+
+    if (frustumCulling)
+    {
+        FrustumCulling::cull(scene.instanceBounds, FrustumCulling::extractPlanes(viewProjection), masks, threadPool);
+    }
+    else
+    {
+        std::fill(scene.instanceVisibilityMasks.begin(), scene.instanceVisibilityMasks.end(), uint8_t(0xFF));
+    }
+
+    VulkanStagingBuffer& stagingBuffer = scene.hostCullStagingBuffers[frameIndex];
+    stagingBuffer.resetDataPointer();
+
+    std::byte* data = stagingBuffer.allocate(layout.size);
+
+    ShaderStructures::CullStatistics statistics;
+    glm::uvec2* visibleInstances = reinterpret_cast<glm::uvec2*>(data + layout.visibleInstances);
+    vk::DrawIndexedIndirectCommand* commands = reinterpret_cast<vk::DrawIndexedIndirectCommand*>(data + layout.commands);
+    uint32_t* drawCounts = reinterpret_cast<uint32_t*>(data + layout.drawCounts);
+
+    std::fill(drawCounts, drawCounts + scene.batchCount, 0);
+
+    // the same output as the two dispatches of the culling pass, except that the visible instances of a draw stay in order
+    for (uint32_t drawIndex = 0; drawIndex < scene.drawCount; drawIndex++)
+    {
+        const ShaderStructures::DrawCullData& draw = scene.drawCullData[drawIndex];
+
+        uint32_t endInstance = (drawIndex + 1 < scene.drawCount) ? scene.drawCullData[drawIndex + 1].firstInstance : scene.instanceCount;
+        uint32_t triangles = draw.indexCount / 3;
+        uint32_t instanceCount = 0;
+
+        for (uint32_t instanceIndex = draw.firstInstance; instanceIndex < endInstance; instanceIndex++)
+        {
+            if ((masks[instanceIndex / FrustumCulling::groupSize] & (1u << (instanceIndex % FrustumCulling::groupSize))) != 0)
+            {
+                visibleInstances[draw.firstInstance + instanceCount++] = glm::uvec2(scene.instanceMatrices[instanceIndex], drawIndex);
+            }
+        }
+
+        uint32_t culledCount = endInstance - draw.firstInstance - instanceCount;
+
+        statistics.frustumCulledInstances += culledCount;
+        statistics.frustumCulledTriangles += culledCount * triangles;
+        statistics.drawnInstances += instanceCount;
+        statistics.drawnTriangles += instanceCount * triangles;
+
+        if (instanceCount != 0)
+        {
+            statistics.drawnCommands++;
+        }
+
+        uint32_t commandIndex = drawIndex;
+
+        if (_drawIndirectCount)
+        {
+            if (instanceCount == 0)
+            {
+                continue;
+            }
+
+            commandIndex = draw.batchFirstDraw + drawCounts[draw.batch]++;
+        }
+
+        commands[commandIndex] = vk::DrawIndexedIndirectCommand(draw.indexCount, instanceCount, draw.firstIndex, 0, draw.firstInstance);
+    }
+
+    memcpy(data, &statistics, sizeof(statistics));
+
+    vmaFlushAllocation(stagingBuffer.getAllocator(), stagingBuffer.getAllocation(), 0, layout.size);
+}
+
+void VulkanDrawCulling::recordHostCulling(const vk::raii::CommandBuffer& commandBuffer, const VulkanScene& scene, int frameIndex) const
+{
+    if (scene.drawCount == 0 || scene.hostCullStagingBuffers.empty())
+    {
+        return;
+    }
+
+    HostCullLayout layout = getHostCullLayout(scene);
+
+    const vk::raii::Buffer& stagingBuffer = scene.hostCullStagingBuffers[frameIndex].getBuffer();
+    const VulkanGPUBuffer& visibleInstances = scene.visibleInstanceGPUBuffers[frameIndex];
+    const VulkanGPUBuffer& commands = scene.indirectCommandGPUBuffers[frameIndex];
+    const VulkanGPUBuffer& drawCounts = scene.drawCountGPUBuffers[frameIndex];
+    const VulkanReadbackBuffer& readback = _statisticsReadbackBuffers[frameIndex];
+
+    commandBuffer.copyBuffer(*stagingBuffer, *visibleInstances.getBuffer(), vk::BufferCopy(layout.visibleInstances, 0, layout.commands - layout.visibleInstances));
+    commandBuffer.copyBuffer(*stagingBuffer, *commands.getBuffer(), vk::BufferCopy(layout.commands, 0, layout.drawCounts - layout.commands));
+    commandBuffer.copyBuffer(*stagingBuffer, *drawCounts.getBuffer(), vk::BufferCopy(layout.drawCounts, 0, layout.size - layout.drawCounts));
+
+    // the statistics go straight to the readback buffer, nothing on the device counts them
+    commandBuffer.copyBuffer(*stagingBuffer, *readback.getBuffer(), vk::BufferCopy(0, 0, sizeof(ShaderStructures::CullStatistics)));
+
+    vk::BufferMemoryBarrier outputBarriers[3];
+    outputBarriers[0].setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+    outputBarriers[0].setDstAccessMask(vk::AccessFlagBits::eIndirectCommandRead);
+    outputBarriers[0].setBuffer(*commands.getBuffer());
+    outputBarriers[0].setSize(vk::WholeSize);
+    outputBarriers[1] = outputBarriers[0];
+    outputBarriers[1].setBuffer(*drawCounts.getBuffer());
+    outputBarriers[2] = outputBarriers[0];
+    outputBarriers[2].setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+    outputBarriers[2].setBuffer(*visibleInstances.getBuffer());
+
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexShader, {}, nullptr, outputBarriers, nullptr);
+
+    vk::BufferMemoryBarrier readbackBarrier;
+    readbackBarrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+    readbackBarrier.setDstAccessMask(vk::AccessFlagBits::eHostRead);
+    readbackBarrier.setBuffer(*readback.getBuffer());
+    readbackBarrier.setSize(vk::WholeSize);
+
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, nullptr, readbackBarrier, nullptr);
+}
+
+void VulkanDrawCulling::recordDraws(const vk::raii::CommandBuffer& commandBuffer, const VulkanScene& scene, const VulkanDrawBatch& batch, int frameIndex) const
+{
+    const VulkanGPUBuffer& commands = scene.indirectCommandGPUBuffers[frameIndex];
+    const VulkanGPUBuffer& drawCounts = scene.drawCountGPUBuffers[frameIndex];
+
+    vk::DeviceSize commandsOffset = batch.firstDraw * sizeof(vk::DrawIndexedIndirectCommand);
+
+    if (_drawIndirectCount)
+    {
+        commandBuffer.drawIndexedIndirectCount(
+            *commands.getBuffer(), commandsOffset, *drawCounts.getBuffer(), batch.index * sizeof(uint32_t), batch.drawCount, sizeof(vk::DrawIndexedIndirectCommand)
+        );
+    }
+    else
+    {
+        // culled draws are left in place with an instance count of 0
+        commandBuffer.drawIndexedIndirect(*commands.getBuffer(), commandsOffset, batch.drawCount, sizeof(vk::DrawIndexedIndirectCommand));
+    }
+}
+
+ShaderStructures::CullStatistics VulkanDrawCulling::getStatistics(int frameIndex)
+{
+    ShaderStructures::CullStatistics statistics;
+    memcpy(&statistics, _statisticsReadbackBuffers[frameIndex].getData(), sizeof(statistics));
+
+    return statistics;
+}
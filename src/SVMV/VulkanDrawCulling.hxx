@@ -0,0 +1,92 @@
+#pragma once
+
+#include <SVMV/VulkanScene.hxx>
+#include <SVMV/VulkanBuffer.hxx>
+#include <SVMV/VulkanShader.hxx>
+#include <SVMV/VulkanShaderStructures.hxx>
+#include <SVMV/VulkanUtilities.hxx>
+#include <SVMV/VulkanUploadManager.hxx>
+#include <SVMV/VulkanDepthPyramid.hxx>
+#include <SVMV/FrustumCulling.hxx>
+#include <SVMV/ThreadPool.hxx>
+
+#include <vulkan/vulkan_raii.hpp>
+#include <vk_mem_alloc.h>
+#include <shaderc/shaderc.hpp>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace SVMV
+{
+    // GPU-driven drawing: a compute pass frustum culls all instances of a scene and writes one instanced indirect command per drawable,
+    // so the draws of each shader permutation of a material context are drawn with a single indirect call
+    // with occlusion culling the scene is culled and drawn twice per frame, see CullPass
+    // the scene can also be frustum culled on the host, whose results are copied into the same buffers the draws read
+    class VulkanDrawCulling
+    {
+    public:
+        static constexpr uint32_t workgroupSize = 64; // local_size_x of the culling shader
+
+        enum class CullPass
+        {
+            FULL,   // frustum culling only
+            EARLY,  // the instances that were visible in the previous frame, their depth is reduced into the depth pyramid afterwards
+            LATE    // the remaining instances that pass the test against the depth pyramid, the draws of the early pass have to be recorded before
+        };
+
+    public:
+        VulkanDrawCulling() = default;
+        VulkanDrawCulling(
+            vk::raii::Device* device, VmaAllocator memoryAllocator, const shaderc::Compiler& compiler, const vk::raii::PipelineCache& pipelineCache, std::vector<uint32_t> queueFamilies, int framesInFlight, bool drawIndirectCount,
+            const vk::raii::DescriptorSetLayout& depthPyramidLayout
+        ); // queueFamilies are the families that access the buffers written by the culling pass, drawIndirectCount selects compaction of the visible draws
+
+        VulkanDrawCulling(const VulkanDrawCulling&) = delete;
+        VulkanDrawCulling& operator=(const VulkanDrawCulling&) = delete;
+
+        VulkanDrawCulling(VulkanDrawCulling&& other) noexcept;
+        VulkanDrawCulling& operator=(VulkanDrawCulling&& other) noexcept;
+
+        ~VulkanDrawCulling() = default;
+
+        // makes one batch per shader permutation of the drawables of each context and uploads the per-draw data, safe to call from the loading thread
+        void createDrawBuffers(VulkanScene& scene, VulkanUploadManager* uploadManager) const;
+
+        // the full pass can run on the graphics or the compute queue, the indirect buffers are shared by both, the early and late passes of a frame run on the graphics queue
+        // camera is the address of the frame's GlobalUniformBuffer, the depth pyramid is only read by the late pass but always has to be created
+        void recordCulling(
+            const vk::raii::CommandBuffer& commandBuffer, const VulkanScene& scene, int frameIndex, vk::DeviceAddress camera, bool frustumCulling, CullPass pass, const VulkanDepthPyramid& depthPyramid
+        ) const;
+        // writes the draws of the visible instances into the staging buffer of the frame index, which the device must no longer read
+        void cullOnHost(VulkanScene& scene, int frameIndex, const glm::mat4& viewProjection, bool frustumCulling, ThreadPool& threadPool) const;
+        void recordHostCulling(const vk::raii::CommandBuffer& commandBuffer, const VulkanScene& scene, int frameIndex) const; // copies the results of cullOnHost, instead of the full pass
+
+        void recordDraws(const vk::raii::CommandBuffer& commandBuffer, const VulkanScene& scene, const VulkanDrawBatch& batch, int frameIndex) const; // the pipeline of the batch has to be bound
+
+        // of the last frame culled with the index, complete once its fence was waited for
+        [[nodiscard]] ShaderStructures::CullStatistics getStatistics(int frameIndex);
+
+    private:
+        vk::raii::Device* _device           { nullptr };
+        VmaAllocator _memoryAllocator       { nullptr };
+
+        std::vector<uint32_t> _queueFamilies;
+        int _framesInFlight         { 0 };
+        bool _drawIndirectCount     { false };
+
+        VulkanShader _shader;
+        vk::raii::PipelineLayout _pipelineLayout    { nullptr };
+        vk::raii::Pipeline _pipeline                { nullptr };
+
+        std::vector<VulkanGPUBuffer> _statisticsGPUBuffers; // per frame in flight, counted by the culling passes
+        std::vector<VulkanReadbackBuffer> _statisticsReadbackBuffers; // per frame in flight, copied from the counters after the last pass
+    };
+}
@@ -7,6 +7,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 #include <SVMV/Attribute.hxx>
 
@@ -21,16 +22,29 @@ namespace SVMV
         vk::DeviceAddress colors_0          { 0 };
     };
 
+    // one node referencing the primitive of a drawable
+    struct VulkanDrawableInstance
+    {
+        uint32_t matrixIndex    { 0 }; // into the model and normal matrix buffers of the scene
+
+        // world space, instances without bounds are never culled
+        glm::vec3 boundsMin     { 0.0f };
+        glm::vec3 boundsMax     { 0.0f };
+        bool bounded            { false };
+    };
+
+    // a primitive uploaded once and drawn for all of its instances with a single instanced draw
     struct VulkanDrawable
     {
         uint32_t firstIndex     { 0 };
         uint32_t indexCount     { 0 };
 
-        vk::DeviceAddress modelMatrixAddress        { 0 };
-        vk::DeviceAddress normalMatrixAddress       { 0 };
         AttributeAddresses attributeAddresses;
 
-        vk::DescriptorSet descriptorSet      { nullptr };
+        uint32_t materialIndex  { 0 }; // into the parameters of the context's material
+        uint32_t features       { 0 }; // shader permutation, the features of the material and the primitive
+
+        std::vector<VulkanDrawableInstance> instances;
 
         void setAddress(AttributeType type, vk::DeviceAddress value)
         {
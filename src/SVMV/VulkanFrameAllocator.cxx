@@ -0,0 +1,123 @@
+#include <SVMV/VulkanFrameAllocator.hxx>
+
+using namespace SVMV;
+
+VulkanFrameAllocator::VulkanFrameAllocator(
+    vk::raii::Device* device, VmaAllocator vmaAllocator, const vk::PhysicalDeviceLimits& limits, int framesInFlight, size_t frameSize/* = defaultFrameSize*/, std::vector<uint32_t> queueFamilies/* = {}*/
+)
+{
+    // both limits are powers of two, so the larger one satisfies both
+    _alignment = std::max<size_t>(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+    _frameSize = (frameSize + _alignment - 1) & ~(_alignment - 1);
+
+    _buffer = VulkanBuffer(
+        device, vmaAllocator, _frameSize * framesInFlight, vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress, true,
+        std::move(queueFamilies)
+    );
+    _address = _buffer.getAddress(*device);
+
+    if (vmaMapMemory(_buffer.getAllocator(), _buffer.getAllocation(), reinterpret_cast<void**>(&_mappedData)) != VK_SUCCESS)
+    {
+        throw std::runtime_error("vma: failed to map frame allocator buffer");
+    }
+}
+
+VulkanFrameAllocator::VulkanFrameAllocator(VulkanFrameAllocator&& other) noexcept
+{
+    this->_buffer = std::move(other._buffer);
+    this->_mappedData = other._mappedData;
+    this->_address = other._address;
+    this->_frameSize = other._frameSize;
+    this->_alignment = other._alignment;
+    this->_frameBegin = other._frameBegin;
+    this->_head = other._head;
+
+    other._mappedData = nullptr;
+    other._address = 0;
+    other._frameSize = 0;
+    other._alignment = 1;
+    other._frameBegin = 0;
+    other._head = 0;
+}
+
+VulkanFrameAllocator& VulkanFrameAllocator::operator=(VulkanFrameAllocator&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+
+        this->_buffer = std::move(other._buffer);
+        this->_mappedData = other._mappedData;
+        this->_address = other._address;
+        this->_frameSize = other._frameSize;
+        this->_alignment = other._alignment;
+        this->_frameBegin = other._frameBegin;
+        this->_head = other._head;
+
+        other._mappedData = nullptr;
+        other._address = 0;
+        other._frameSize = 0;
+        other._alignment = 1;
+        other._frameBegin = 0;
+        other._head = 0;
+    }
+
+    return *this;
+}
+
+VulkanFrameAllocator::~VulkanFrameAllocator()
+{
+    release();
+}
+
+void VulkanFrameAllocator::beginFrame(int frameIndex)
+{
+    _frameBegin = frameIndex * _frameSize;
+    _head = _frameBegin;
+}
+
+void VulkanFrameAllocator::flush()
+{
+    if (_head != _frameBegin)
+    {
+        vmaFlushAllocation(_buffer.getAllocator(), _buffer.getAllocation(), _frameBegin, _head - _frameBegin);
+    }
+}
+
+VulkanFrameAllocator::Allocation VulkanFrameAllocator::allocate(size_t size)
+{
+    size_t offset = (_head + _alignment - 1) & ~(_alignment - 1);
+
+    if (offset + size > _frameBegin + _frameSize)
+    {
+        throw std::runtime_error("frame allocator: out of memory for the current frame");
+    }
+
+    _head = offset + size;
+
+    Allocation allocation;
+    allocation.data = _mappedData + offset;
+    allocation.offset = static_cast<uint32_t>(offset);
+
+    return allocation;
+}
+
+const VulkanBuffer& VulkanFrameAllocator::getBuffer() const noexcept
+{
+    return _buffer;
+}
+
+vk::DeviceAddress VulkanFrameAllocator::getAddress(uint32_t offset) const noexcept
+{
+    return _address + offset;
+}
+
+void VulkanFrameAllocator::release() noexcept
+{
+    if (_mappedData != nullptr)
+    {
+        vmaUnmapMemory(_buffer.getAllocator(), _buffer.getAllocation());
+
+        _mappedData = nullptr;
+    }
+}
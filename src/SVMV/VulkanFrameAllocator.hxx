@@ -0,0 +1,76 @@
+#pragma once
+
+#include <SVMV/VulkanBuffer.hxx>
+
+#include <vulkan/vulkan_raii.hpp>
+#include <vk_mem_alloc.h>
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace SVMV
+{
+    // linear allocator over a persistently mapped buffer that is split into one region per frame in flight,
+    // hands out sub-ranges aligned for dynamic uniform and storage buffer offsets, so descriptors pointing at the buffer are written once
+    // allocations stay valid until their frame's region is reused framesInFlight frames later
+    class VulkanFrameAllocator
+    {
+    public:
+        static constexpr size_t defaultFrameSize = 64 * 1024;
+
+        struct Allocation
+        {
+            std::byte* data     { nullptr };
+            uint32_t offset     { 0 }; // from the start of the buffer, passed as the dynamic offset
+        };
+
+    public:
+        VulkanFrameAllocator() = default;
+        VulkanFrameAllocator(
+            vk::raii::Device* device, VmaAllocator vmaAllocator, const vk::PhysicalDeviceLimits& limits, int framesInFlight, size_t frameSize = defaultFrameSize, std::vector<uint32_t> queueFamilies = {}
+        ); // queueFamilies are the families that read the allocations, the buffer is shared concurrently between them
+
+        VulkanFrameAllocator(const VulkanFrameAllocator&) = delete;
+        VulkanFrameAllocator& operator=(const VulkanFrameAllocator&) = delete;
+
+        VulkanFrameAllocator(VulkanFrameAllocator&& other) noexcept;
+        VulkanFrameAllocator& operator=(VulkanFrameAllocator&& other) noexcept;
+
+        ~VulkanFrameAllocator();
+
+        void beginFrame(int frameIndex); // the GPU must be done with the frame's previous allocations
+        void flush(); // makes this frame's writes visible to the device, a no-op on coherent memory
+
+        Allocation allocate(size_t size);
+
+        template <typename T>
+        uint32_t push(const T& data)
+        {
+            Allocation allocation = allocate(sizeof(T));
+            memcpy(allocation.data, &data, sizeof(T));
+
+            return allocation.offset;
+        }
+
+        [[nodiscard]] const VulkanBuffer& getBuffer() const noexcept;
+        [[nodiscard]] vk::DeviceAddress getAddress(uint32_t offset) const noexcept; // of an allocation, for shaders reading it through a buffer reference
+
+    private:
+        void release() noexcept;
+
+    private:
+        VulkanBuffer _buffer;
+        std::byte* _mappedData      { nullptr };
+        vk::DeviceAddress _address  { 0 };
+
+        size_t _frameSize           { 0 };
+        size_t _alignment           { 1 };
+
+        size_t _frameBegin          { 0 };
+        size_t _head                { 0 }; // next free byte of the current frame's region
+    };
+}
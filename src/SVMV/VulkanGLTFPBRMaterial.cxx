@@ -4,52 +4,43 @@
 using namespace SVMV;
 
 GLTFPBRMaterial::GLTFPBRMaterial(
-    vk::raii::Device* device, VmaAllocator memoryAllocator, VulkanUtilities::ImmediateSubmit* immediateSubmit, const vk::raii::RenderPass& renderPass, const vk::raii::DescriptorSetLayout& globalDescriptorSetLayout,
-    const vk::raii::DescriptorSetLayout& lightDescriptorSetLayout, VulkanUtilities::DescriptorAllocator* descriptorAllocator, VulkanDescriptorWriter* descriptorWriter, const shaderc::Compiler& compiler
+    const vk::raii::PhysicalDevice* physicalDevice, vk::raii::Device* device, VmaAllocator memoryAllocator, VulkanUploadManager* uploadManager, const vk::raii::RenderPass& renderPass,
+    const vk::raii::DescriptorSetLayout& globalDescriptorSetLayout, const vk::raii::DescriptorSetLayout& lightDescriptorSetLayout, VulkanDescriptorWriter* descriptorWriter,
+    const shaderc::Compiler& compiler, const vk::raii::PipelineCache& pipelineCache, VulkanTextureCache* textureCache, uint32_t textureCountLimit
 )
-    : _device(device), _memoryAllocator(memoryAllocator), _immediateSubmit(immediateSubmit), _descriptorAllocator(descriptorAllocator), _descriptorWriter(descriptorWriter)
+    : _physicalDevice(physicalDevice), _device(device), _memoryAllocator(memoryAllocator), _uploadManager(uploadManager), _descriptorWriter(descriptorWriter), _textureCache(textureCache),
+    _renderPass(&renderPass), _pipelineCache(&pipelineCache),
+    _textureCountLimit(std::min(textureCountLimit, maxTextureCount)), _maxAnisotropy(std::min(physicalDevice->getProperties().limits.maxSamplerAnisotropy, maxAnisotropy))
 {
     _vertexShader = VulkanShader(*_device, compiler, VulkanShader::ShaderType::VERTEX, "gltf_pbr_vert.glsl");
     _fragmentShader = VulkanShader(*_device, compiler, VulkanShader::ShaderType::FRAGMENT, "gltf_pbr_frag.glsl");
 
-    vk::DescriptorSetLayoutBinding descriptorSetLayoutBingings[6];
+    vk::DescriptorSetLayoutBinding descriptorSetLayoutBingings[2];
+
+    // parameters of all materials
     descriptorSetLayoutBingings[0].setBinding(0);
     descriptorSetLayoutBingings[0].setDescriptorCount(1);
-    descriptorSetLayoutBingings[0].setDescriptorType(vk::DescriptorType::eUniformBuffer);
+    descriptorSetLayoutBingings[0].setDescriptorType(vk::DescriptorType::eStorageBuffer);
     descriptorSetLayoutBingings[0].setStageFlags(vk::ShaderStageFlagBits::eFragment);
 
-    // base color texture
+    // textures of all materials, the set is allocated with the texture count of the scene
     descriptorSetLayoutBingings[1].setBinding(1);
-    descriptorSetLayoutBingings[1].setDescriptorCount(1);
+    descriptorSetLayoutBingings[1].setDescriptorCount(_textureCountLimit);
     descriptorSetLayoutBingings[1].setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
     descriptorSetLayoutBingings[1].setStageFlags(vk::ShaderStageFlagBits::eFragment);
 
-    // normal texture
-    descriptorSetLayoutBingings[2].setBinding(2);
-    descriptorSetLayoutBingings[2].setDescriptorCount(1);
-    descriptorSetLayoutBingings[2].setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
-    descriptorSetLayoutBingings[2].setStageFlags(vk::ShaderStageFlagBits::eFragment);
-
-    // metallic roughness texture
-    descriptorSetLayoutBingings[3].setBinding(3);
-    descriptorSetLayoutBingings[3].setDescriptorCount(1);
-    descriptorSetLayoutBingings[3].setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
-    descriptorSetLayoutBingings[3].setStageFlags(vk::ShaderStageFlagBits::eFragment);
-
-    // occlusion texture
-    descriptorSetLayoutBingings[4].setBinding(4);
-    descriptorSetLayoutBingings[4].setDescriptorCount(1);
-    descriptorSetLayoutBingings[4].setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
-    descriptorSetLayoutBingings[4].setStageFlags(vk::ShaderStageFlagBits::eFragment);
-
-    // emissive texture
-    descriptorSetLayoutBingings[5].setBinding(5);
-    descriptorSetLayoutBingings[5].setDescriptorCount(1);
-    descriptorSetLayoutBingings[5].setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
-    descriptorSetLayoutBingings[5].setStageFlags(vk::ShaderStageFlagBits::eFragment);
+    vk::DescriptorBindingFlags descriptorBindingFlags[2] = {
+        {},
+        vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eVariableDescriptorCount | vk::DescriptorBindingFlagBits::eUpdateAfterBind
+    };
+
+    vk::DescriptorSetLayoutBindingFlagsCreateInfo descriptorSetLayoutBindingFlagsCreateInfo;
+    descriptorSetLayoutBindingFlagsCreateInfo.setBindingFlags(descriptorBindingFlags);
 
     vk::DescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo;
     descriptorSetLayoutCreateInfo.setBindings(descriptorSetLayoutBingings);
+    descriptorSetLayoutCreateInfo.setFlags(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool);
+    descriptorSetLayoutCreateInfo.setPNext(&descriptorSetLayoutBindingFlagsCreateInfo);
 
     _descriptorSetLayout = vk::raii::DescriptorSetLayout(*_device, descriptorSetLayoutCreateInfo);
 
@@ -66,29 +57,29 @@ GLTFPBRMaterial::GLTFPBRMaterial(
 
     _pipelineLayout = vk::raii::PipelineLayout(*_device, pipelineLayoutCreateInfo);
 
-    _pipeline = VulkanUtilities::createPipeline(*device, _pipelineLayout, renderPass, _vertexShader.getModule(), _fragmentShader.getModule());
-
     createDefaultResources();
 }
 
 GLTFPBRMaterial::GLTFPBRMaterial(GLTFPBRMaterial&& other) noexcept
 {
+    this->_physicalDevice = other._physicalDevice;
     this->_device = other._device;
     this->_memoryAllocator = std::move(other._memoryAllocator);
-    this->_immediateSubmit = other._immediateSubmit;
-    this->_descriptorAllocator = other._descriptorAllocator;
+    this->_uploadManager = other._uploadManager;
     this->_descriptorWriter = other._descriptorWriter;
+    this->_textureCache = other._textureCache;
+    this->_renderPass = other._renderPass;
+    this->_pipelineCache = other._pipelineCache;
+    this->_textureCountLimit = other._textureCountLimit;
+    this->_maxAnisotropy = other._maxAnisotropy;
 
-    this->_pipeline = std::move(other._pipeline);
+    this->_pipelines = std::move(other._pipelines);
     this->_pipelineLayout = std::move(other._pipelineLayout);
     this->_descriptorSetLayout = std::move(other._descriptorSetLayout);
 
     this->_vertexShader = std::move(other._vertexShader);
     this->_fragmentShader = std::move(other._fragmentShader);
 
-    this->_resources = std::move(other._resources);
-    this->_descriptorSets = std::move(other._descriptorSets);
-
     this->_defaultSampler = std::move(other._defaultSampler);
     this->_defaultBaseColorImage = std::move(other._defaultBaseColorImage);
     this->_defaultNormalImage = std::move(other._defaultNormalImage);
@@ -96,32 +87,56 @@ GLTFPBRMaterial::GLTFPBRMaterial(GLTFPBRMaterial&& other) noexcept
     this->_defaultOcclusionImage = std::move(other._defaultOcclusionImage);
     this->_defaultEmissiveImage = std::move(other._defaultEmissiveImage);
 
+    this->_defaultBaseColorTexture = other._defaultBaseColorTexture;
+    this->_defaultNormalTexture = other._defaultNormalTexture;
+    this->_defaultMetallicRoughnessTexture = other._defaultMetallicRoughnessTexture;
+    this->_defaultOcclusionTexture = other._defaultOcclusionTexture;
+    this->_defaultEmissiveTexture = other._defaultEmissiveTexture;
+
+    this->_images = std::move(other._images);
+    this->_samplers = std::move(other._samplers);
+    this->_textures = std::move(other._textures);
+    this->_textureIndices = std::move(other._textureIndices);
+
+    this->_parameters = std::move(other._parameters);
+    this->_features = std::move(other._features);
+    this->_parameterBuffer = std::move(other._parameterBuffer);
+
+    this->_descriptorPool = std::move(other._descriptorPool);
+    this->_descriptorSet = std::move(other._descriptorSet);
+
+    other._physicalDevice = nullptr;
     other._device = nullptr;
-    other._immediateSubmit = nullptr;
-    other._descriptorAllocator = nullptr;
+    other._uploadManager = nullptr;
     other._descriptorWriter = nullptr;
+    other._textureCache = nullptr;
+    other._renderPass = nullptr;
+    other._pipelineCache = nullptr;
+    other._textureCountLimit = 0;
 }
 
 GLTFPBRMaterial& GLTFPBRMaterial::operator=(GLTFPBRMaterial&& other) noexcept
 {
     if (this != &other)
     {
+        this->_physicalDevice = other._physicalDevice;
         this->_device = other._device;
         this->_memoryAllocator = std::move(other._memoryAllocator);
-        this->_immediateSubmit = other._immediateSubmit;
-        this->_descriptorAllocator = other._descriptorAllocator;
+        this->_uploadManager = other._uploadManager;
         this->_descriptorWriter = other._descriptorWriter;
+        this->_textureCache = other._textureCache;
+        this->_renderPass = other._renderPass;
+        this->_pipelineCache = other._pipelineCache;
+        this->_textureCountLimit = other._textureCountLimit;
+        this->_maxAnisotropy = other._maxAnisotropy;
 
-        this->_pipeline = std::move(other._pipeline);
+        this->_pipelines = std::move(other._pipelines);
         this->_pipelineLayout = std::move(other._pipelineLayout);
         this->_descriptorSetLayout = std::move(other._descriptorSetLayout);
 
         this->_vertexShader = std::move(other._vertexShader);
         this->_fragmentShader = std::move(other._fragmentShader);
 
-        this->_resources = std::move(other._resources);
-        this->_descriptorSets = std::move(other._descriptorSets);
-
         this->_defaultSampler = std::move(other._defaultSampler);
         this->_defaultBaseColorImage = std::move(other._defaultBaseColorImage);
         this->_defaultNormalImage = std::move(other._defaultNormalImage);
@@ -129,32 +144,127 @@ GLTFPBRMaterial& GLTFPBRMaterial::operator=(GLTFPBRMaterial&& other) noexcept
         this->_defaultOcclusionImage = std::move(other._defaultOcclusionImage);
         this->_defaultEmissiveImage = std::move(other._defaultEmissiveImage);
 
+        this->_defaultBaseColorTexture = other._defaultBaseColorTexture;
+        this->_defaultNormalTexture = other._defaultNormalTexture;
+        this->_defaultMetallicRoughnessTexture = other._defaultMetallicRoughnessTexture;
+        this->_defaultOcclusionTexture = other._defaultOcclusionTexture;
+        this->_defaultEmissiveTexture = other._defaultEmissiveTexture;
+
+        this->_images = std::move(other._images);
+        this->_samplers = std::move(other._samplers);
+        this->_textures = std::move(other._textures);
+        this->_textureIndices = std::move(other._textureIndices);
+
+        this->_parameters = std::move(other._parameters);
+        this->_features = std::move(other._features);
+        this->_parameterBuffer = std::move(other._parameterBuffer);
+
+        this->_descriptorSet = vk::raii::DescriptorSet(nullptr); // freed before the pool it was allocated from
+        this->_descriptorPool = std::move(other._descriptorPool);
+        this->_descriptorSet = std::move(other._descriptorSet);
+
+        other._physicalDevice = nullptr;
         other._device = nullptr;
-        other._immediateSubmit = nullptr;
-        other._descriptorAllocator = nullptr;
+        other._uploadManager = nullptr;
         other._descriptorWriter = nullptr;
+        other._textureCache = nullptr;
+        other._renderPass = nullptr;
+        other._pipelineCache = nullptr;
+        other._textureCountLimit = 0;
     }
     
     return *this;
 }
 
-vk::DescriptorSet GLTFPBRMaterial::createDescriptorSet(std::shared_ptr<Material> material)
+uint32_t GLTFPBRMaterial::addMaterial(std::shared_ptr<Material> material, ThreadPool* threadPool/* = nullptr*/)
 {
-    vk::raii::DescriptorSet descriptorSet = _descriptorAllocator->allocateSet(_descriptorSetLayout);
-    MaterialResources resources;
+    MaterialParameters parameters;
+
+    processParameters(parameters, material);
+    processTextures(parameters, material, threadPool);
 
-    processUniformParameters(descriptorSet, resources, material);
-    processTextures(descriptorSet, resources, material);
+    // textures that were missing or could not be read use the default images, which the shaders then skip
+    uint32_t features = 0;
+    features |= (parameters.baseColorTexture != _defaultBaseColorTexture) ? featureBaseColorTexture : 0;
+    features |= (parameters.normalTexture != _defaultNormalTexture) ? featureNormalTexture : 0;
+    features |= (parameters.metallicRoughnessTexture != _defaultMetallicRoughnessTexture) ? featureMetallicRoughnessTexture : 0;
+    features |= (parameters.occlusionTexture != _defaultOcclusionTexture) ? featureOcclusionTexture : 0;
+    features |= (parameters.emissiveTexture != _defaultEmissiveTexture) ? featureEmissiveTexture : 0;
 
-    _resources.push_back(std::move(resources));
-    _descriptorSets.push_back(std::move(descriptorSet));
+    _parameters.push_back(parameters);
+    _features.push_back(features);
 
-    return *_descriptorSets.back();
+    return static_cast<uint32_t>(_parameters.size() - 1);
 }
 
-const vk::raii::Pipeline* GLTFPBRMaterial::getPipeline() const
+void GLTFPBRMaterial::createDescriptorSet()
 {
-    return &_pipeline;
+    uint32_t textureCount = static_cast<uint32_t>(_textures.size());
+    size_t parameterSize = _parameters.size() * sizeof(MaterialParameters);
+
+    _parameterBuffer = VulkanGPUBuffer(_device, _memoryAllocator, parameterSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eStorageBuffer);
+    _uploadManager->uploadBuffer(_parameterBuffer, _parameters.data(), parameterSize);
+
+    // a dedicated pool, as the texture array can be larger than what the shared pools hold
+    vk::DescriptorPoolSize poolSizes[2];
+    poolSizes[0].setType(vk::DescriptorType::eStorageBuffer);
+    poolSizes[0].setDescriptorCount(1);
+
+    poolSizes[1].setType(vk::DescriptorType::eCombinedImageSampler);
+    poolSizes[1].setDescriptorCount(textureCount);
+
+    vk::DescriptorPoolCreateInfo descriptorPoolCreateInfo;
+    descriptorPoolCreateInfo.setFlags(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind | vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet);
+    descriptorPoolCreateInfo.setMaxSets(1);
+    descriptorPoolCreateInfo.setPoolSizes(poolSizes);
+
+    _descriptorPool = vk::raii::DescriptorPool(*_device, descriptorPoolCreateInfo);
+
+    vk::DescriptorSetVariableDescriptorCountAllocateInfo variableDescriptorCountAllocateInfo;
+    variableDescriptorCountAllocateInfo.setDescriptorCounts(textureCount);
+
+    vk::DescriptorSetAllocateInfo descriptorSetAllocateInfo;
+    descriptorSetAllocateInfo.setDescriptorPool(*_descriptorPool);
+    descriptorSetAllocateInfo.setSetLayouts(*_descriptorSetLayout);
+    descriptorSetAllocateInfo.setPNext(&variableDescriptorCountAllocateInfo);
+
+    _descriptorSet = std::move(vk::raii::DescriptorSets(*_device, descriptorSetAllocateInfo).front());
+
+    _descriptorWriter->writeBuffer(_descriptorSet, _parameterBuffer, 0, 0, static_cast<int>(parameterSize), vk::DescriptorType::eStorageBuffer);
+    _descriptorWriter->writeImagesAndSamplers(_descriptorSet, _textures, 1);
+}
+
+uint32_t GLTFPBRMaterial::getFeatures(uint32_t materialIndex) const
+{
+    return _features[materialIndex];
+}
+
+const vk::raii::Pipeline& GLTFPBRMaterial::getPipeline(uint32_t features)
+{
+    auto pipelineIterator = _pipelines.find(features);
+
+    if (pipelineIterator != _pipelines.end())
+    {
+        return pipelineIterator->second;
+    }
+
+    PipelineSpecialization specialization;
+    specialization.features = features;
+
+    vk::SpecializationMapEntry specializationMapEntries[1] = {
+        vk::SpecializationMapEntry(0, offsetof(PipelineSpecialization, features), sizeof(uint32_t))
+    };
+
+    vk::SpecializationInfo specializationInfo;
+    specializationInfo.setMapEntries(specializationMapEntries);
+    specializationInfo.setDataSize(sizeof(specialization));
+    specializationInfo.setPData(&specialization);
+
+    vk::raii::Pipeline pipeline = VulkanUtilities::createPipeline(
+        *_device, *_pipelineCache, _pipelineLayout, *_renderPass, _vertexShader.getModule(), _fragmentShader.getModule(), &specializationInfo
+    );
+
+    return _pipelines.emplace(features, std::move(pipeline)).first->second;
 }
 
 const vk::raii::PipelineLayout* GLTFPBRMaterial::getPipelineLayout() const
@@ -162,6 +272,11 @@ const vk::raii::PipelineLayout* GLTFPBRMaterial::getPipelineLayout() const
     return &_pipelineLayout;
 }
 
+const vk::raii::DescriptorSet* GLTFPBRMaterial::getDescriptorSet() const
+{
+    return &_descriptorSet;
+}
+
 void GLTFPBRMaterial::createDefaultResources()
 {
     uint32_t dimension = 32; // arbitrary small dimensions
@@ -174,25 +289,19 @@ void GLTFPBRMaterial::createDefaultResources()
     }
 
     _defaultBaseColorImage = VulkanImage(
-        _device, _immediateSubmit, _memoryAllocator, vk::Extent2D{ dimension, dimension },
+        _device, _uploadManager, _memoryAllocator, vk::Extent2D{ dimension, dimension },
         vk::Format::eR8G8B8A8Srgb, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled, data.get(),
         dimension* dimension * 4
     );
 
     _defaultMetallicRoughnessImage = VulkanImage(
-        _device, _immediateSubmit, _memoryAllocator, vk::Extent2D{ dimension, dimension },
-        vk::Format::eR8G8B8A8Unorm, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled, data.get(),
-        dimension* dimension * 4
-    );
-
-    _defaultMetallicRoughnessImage = VulkanImage(
-        _device, _immediateSubmit, _memoryAllocator, vk::Extent2D{ dimension, dimension },
+        _device, _uploadManager, _memoryAllocator, vk::Extent2D{ dimension, dimension },
         vk::Format::eR8G8B8A8Unorm, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled, data.get(),
         dimension* dimension * 4
     );
 
     _defaultOcclusionImage = VulkanImage(
-        _device, _immediateSubmit, _memoryAllocator, vk::Extent2D{ dimension, dimension },
+        _device, _uploadManager, _memoryAllocator, vk::Extent2D{ dimension, dimension },
         vk::Format::eR8G8B8A8Unorm, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled, data.get(),
         dimension* dimension * 4
     );
@@ -203,13 +312,13 @@ void GLTFPBRMaterial::createDefaultResources()
     }
 
     _defaultEmissiveImage = VulkanImage(
-        _device, _immediateSubmit, _memoryAllocator, vk::Extent2D{ dimension, dimension },
+        _device, _uploadManager, _memoryAllocator, vk::Extent2D{ dimension, dimension },
         vk::Format::eR8G8B8A8Srgb, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled, data.get(),
         dimension* dimension * 4
     );
 
     _defaultNormalImage = VulkanImage(
-        _device, _immediateSubmit, _memoryAllocator, vk::Extent2D{ dimension, dimension },
+        _device, _uploadManager, _memoryAllocator, vk::Extent2D{ dimension, dimension },
         vk::Format::eR8G8B8A8Unorm, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled, data.get(),
         dimension * dimension * 4
     );
@@ -220,118 +329,110 @@ void GLTFPBRMaterial::createDefaultResources()
     samplerCreateInfo.setAddressModeU(vk::SamplerAddressMode::eRepeat);
     samplerCreateInfo.setAddressModeV(vk::SamplerAddressMode::eRepeat);
     samplerCreateInfo.setAddressModeW(vk::SamplerAddressMode::eRepeat);
-    samplerCreateInfo.setAnisotropyEnable(vk::False);
-    samplerCreateInfo.setMaxAnisotropy(4);
+    samplerCreateInfo.setAnisotropyEnable(vk::True);
+    samplerCreateInfo.setMaxAnisotropy(_maxAnisotropy);
     samplerCreateInfo.setBorderColor(vk::BorderColor::eIntOpaqueBlack);
     samplerCreateInfo.setUnnormalizedCoordinates(vk::False);
     samplerCreateInfo.setCompareEnable(vk::False);
     samplerCreateInfo.setCompareOp(vk::CompareOp::eAlways);
     samplerCreateInfo.setMipmapMode(vk::SamplerMipmapMode::eLinear);
+    samplerCreateInfo.setMinLod(0.0f);
+    samplerCreateInfo.setMaxLod(vk::LodClampNone);
 
     _defaultSampler = vk::raii::Sampler(*_device, samplerCreateInfo);
+
+    _defaultBaseColorTexture = addTexture(_defaultBaseColorImage, _defaultSampler);
+    _defaultNormalTexture = addTexture(_defaultNormalImage, _defaultSampler);
+    _defaultMetallicRoughnessTexture = addTexture(_defaultMetallicRoughnessImage, _defaultSampler);
+    _defaultOcclusionTexture = addTexture(_defaultOcclusionImage, _defaultSampler);
+    _defaultEmissiveTexture = addTexture(_defaultEmissiveImage, _defaultSampler);
 }
 
-void GLTFPBRMaterial::processUniformParameters(vk::raii::DescriptorSet& descriptorSet, MaterialResources& resources, std::shared_ptr<Material> material)
+void GLTFPBRMaterial::processParameters(MaterialParameters& parameters, std::shared_ptr<Material> material)
 {
-    GLTFPBRMaterial::MaterialUniformParameters uniformParameters;
-
     if (material->properties.contains("baseColorFactor"))
     {
         try
         {
             FloatVector4Property* baseColorFactorProperty = dynamic_cast<FloatVector4Property*>(material->properties["baseColorFactor"].get());
-            uniformParameters.baseColorFactor = baseColorFactorProperty->data;
+            parameters.baseColorFactor = baseColorFactorProperty->data;
         }
         catch (std::bad_cast)
         {
-            uniformParameters.baseColorFactor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+            parameters.baseColorFactor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
         }
     }
     else
     {
-        uniformParameters.baseColorFactor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+        parameters.baseColorFactor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
     }
     if (material->properties.contains("emissiveFactor"))
     {
         try
         {
             FloatVector4Property* emissiveFactorProperty = dynamic_cast<FloatVector4Property*>(material->properties["emissiveFactor"].get());
-            uniformParameters.emissiveFactor = emissiveFactorProperty->data;
+            parameters.emissiveFactor = emissiveFactorProperty->data;
         }
         catch (std::bad_cast)
         {
-            uniformParameters.baseColorFactor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+            parameters.baseColorFactor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
         }
     }
     else
     {
-        uniformParameters.baseColorFactor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+        parameters.baseColorFactor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
     }
     if (material->properties.contains("rougnessFactor"))
     {
         try
         {
             FloatProperty* rougnessFactorProperty = dynamic_cast<FloatProperty*>(material->properties["rougnessFactor"].get());
-            uniformParameters.roughnessMetallicNormalFactors.g = rougnessFactorProperty->data;
+            parameters.roughnessMetallicNormalFactors.g = rougnessFactorProperty->data;
         }
         catch (std::bad_cast)
         {
-            uniformParameters.roughnessMetallicNormalFactors.g = 1.0f;
+            parameters.roughnessMetallicNormalFactors.g = 1.0f;
         }
     }
     else
     {
-        uniformParameters.roughnessMetallicNormalFactors.g = 1.0f;
+        parameters.roughnessMetallicNormalFactors.g = 1.0f;
     }
     if (material->properties.contains("metallicFactor"))
     {
         try
         {
             FloatProperty* metallicFactorProperty = dynamic_cast<FloatProperty*>(material->properties["metallicFactor"].get());
-            uniformParameters.roughnessMetallicNormalFactors.b = metallicFactorProperty->data;
+            parameters.roughnessMetallicNormalFactors.b = metallicFactorProperty->data;
         }
         catch (std::bad_cast)
         {
-            uniformParameters.roughnessMetallicNormalFactors.b = 1.0f;
+            parameters.roughnessMetallicNormalFactors.b = 1.0f;
         }
     }
     else
     {
-        uniformParameters.roughnessMetallicNormalFactors.b = 1.0f;
-    }
-
-    if (material->properties.contains("normalTexture"))
-    {
-        uniformParameters.roughnessMetallicNormalFactors.r = 0.0f;
+        parameters.roughnessMetallicNormalFactors.b = 1.0f;
     }
-    else
-    {
-        uniformParameters.roughnessMetallicNormalFactors.r = 1.0f;
-    }
-
-    resources.uniformBuffer = VulkanUniformBuffer(_device, _memoryAllocator, sizeof(GLTFPBRMaterial::MaterialUniformParameters));
-    resources.uniformBuffer.setData(&uniformParameters, sizeof(GLTFPBRMaterial::MaterialUniformParameters));
-
-    _descriptorWriter->writeBuffer(descriptorSet, resources.uniformBuffer, 0, 0, sizeof(GLTFPBRMaterial::MaterialUniformParameters), vk::DescriptorType::eUniformBuffer);
 }
 
-void GLTFPBRMaterial::processTextures(vk::raii::DescriptorSet& descriptorSet, MaterialResources& resources, std::shared_ptr<Material> material)
+void GLTFPBRMaterial::processTextures(MaterialParameters& parameters, std::shared_ptr<Material> material, ThreadPool* threadPool)
 {
     if (material->properties.contains("baseColorTexture"))
     {
         try
         {
             TextureProperty* textureProperty = dynamic_cast<TextureProperty*>(material->properties["baseColorTexture"].get());
-            processCombinedImageSampler(descriptorSet, 1, resources.baseColorImage, resources.baseColorSampler, textureProperty, vk::Format::eR8G8B8A8Srgb);
+            parameters.baseColorTexture = processCombinedImageSampler(textureProperty, vk::Format::eR8G8B8A8Srgb, _defaultBaseColorTexture, threadPool);
         }
         catch (std::bad_cast)
         {
-            _descriptorWriter->writeImageAndSampler(descriptorSet, _defaultBaseColorImage, vk::ImageLayout::eShaderReadOnlyOptimal, _defaultSampler, 1);
+            parameters.baseColorTexture = _defaultBaseColorTexture;
         }
     }
     else
     {
-        _descriptorWriter->writeImageAndSampler(descriptorSet, _defaultBaseColorImage, vk::ImageLayout::eShaderReadOnlyOptimal, _defaultSampler, 1);
+        parameters.baseColorTexture = _defaultBaseColorTexture;
     }
 
     if (material->properties.contains("normalTexture"))
@@ -339,16 +440,21 @@ void GLTFPBRMaterial::processTextures(vk::raii::DescriptorSet& descriptorSet, Ma
         try
         {
             TextureProperty* textureProperty = dynamic_cast<TextureProperty*>(material->properties["normalTexture"].get());
-            processCombinedImageSampler(descriptorSet, 2, resources.normalImage, resources.normalSampler, textureProperty, vk::Format::eR8G8B8A8Unorm);
+            parameters.normalTexture = processCombinedImageSampler(textureProperty, vk::Format::eR8G8B8A8Unorm, _defaultNormalTexture, threadPool);
+
+            if (textureProperty->data->encoding == TextureEncoding::BC5 && parameters.normalTexture != _defaultNormalTexture)
+            {
+                parameters.flags |= normalTextureXYFlag;
+            }
         }
         catch (std::bad_cast)
         {
-            _descriptorWriter->writeImageAndSampler(descriptorSet, _defaultNormalImage, vk::ImageLayout::eShaderReadOnlyOptimal, _defaultSampler, 2);
+            parameters.normalTexture = _defaultNormalTexture;
         }
     }
     else
     {
-        _descriptorWriter->writeImageAndSampler(descriptorSet, _defaultNormalImage, vk::ImageLayout::eShaderReadOnlyOptimal, _defaultSampler, 2);
+        parameters.normalTexture = _defaultNormalTexture;
     }
 
     if (material->properties.contains("metallicRoughnessTexture"))
@@ -356,16 +462,16 @@ void GLTFPBRMaterial::processTextures(vk::raii::DescriptorSet& descriptorSet, Ma
         try
         {
             TextureProperty* textureProperty = dynamic_cast<TextureProperty*>(material->properties["metallicRoughnessTexture"].get());
-            processCombinedImageSampler(descriptorSet, 3, resources.metallicRoughnessImage, resources.metallicRoughnessSampler, textureProperty, vk::Format::eR8G8B8A8Unorm);
+            parameters.metallicRoughnessTexture = processCombinedImageSampler(textureProperty, vk::Format::eR8G8B8A8Unorm, _defaultMetallicRoughnessTexture, threadPool);
         }
         catch (std::bad_cast)
         {
-            _descriptorWriter->writeImageAndSampler(descriptorSet, _defaultMetallicRoughnessImage, vk::ImageLayout::eShaderReadOnlyOptimal, _defaultSampler, 3);
+            parameters.metallicRoughnessTexture = _defaultMetallicRoughnessTexture;
         }
     }
     else
     {
-        _descriptorWriter->writeImageAndSampler(descriptorSet, _defaultMetallicRoughnessImage, vk::ImageLayout::eShaderReadOnlyOptimal, _defaultSampler, 3);
+        parameters.metallicRoughnessTexture = _defaultMetallicRoughnessTexture;
     }
 
     if (material->properties.contains("occlusionTexture"))
@@ -373,16 +479,16 @@ void GLTFPBRMaterial::processTextures(vk::raii::DescriptorSet& descriptorSet, Ma
         try
         {
             TextureProperty* textureProperty = dynamic_cast<TextureProperty*>(material->properties["occlusionTexture"].get());
-            processCombinedImageSampler(descriptorSet, 4, resources.occlusionImage, resources.occlusionSampler, textureProperty, vk::Format::eR8G8B8A8Unorm);
+            parameters.occlusionTexture = processCombinedImageSampler(textureProperty, vk::Format::eR8G8B8A8Unorm, _defaultOcclusionTexture, threadPool);
         }
         catch (std::bad_cast)
         {
-            _descriptorWriter->writeImageAndSampler(descriptorSet, _defaultOcclusionImage, vk::ImageLayout::eShaderReadOnlyOptimal, _defaultSampler, 4);
+            parameters.occlusionTexture = _defaultOcclusionTexture;
         }
     }
     else
     {
-        _descriptorWriter->writeImageAndSampler(descriptorSet, _defaultOcclusionImage, vk::ImageLayout::eShaderReadOnlyOptimal, _defaultSampler, 4);
+        parameters.occlusionTexture = _defaultOcclusionTexture;
     }
 
     if (material->properties.contains("emissiveTexture"))
@@ -390,26 +496,48 @@ void GLTFPBRMaterial::processTextures(vk::raii::DescriptorSet& descriptorSet, Ma
         try
         {
             TextureProperty* textureProperty = dynamic_cast<TextureProperty*>(material->properties["emissiveTexture"].get());
-            processCombinedImageSampler(descriptorSet, 5, resources.emissiveImage, resources.emissiveSampler, textureProperty, vk::Format::eR8G8B8A8Srgb);
+            parameters.emissiveTexture = processCombinedImageSampler(textureProperty, vk::Format::eR8G8B8A8Srgb, _defaultEmissiveTexture, threadPool);
         }
         catch (std::bad_cast)
         {
-            _descriptorWriter->writeImageAndSampler(descriptorSet, _defaultEmissiveImage, vk::ImageLayout::eShaderReadOnlyOptimal, _defaultSampler, 5);
+            parameters.emissiveTexture = _defaultEmissiveTexture;
         }
     }
     else
     {
-        _descriptorWriter->writeImageAndSampler(descriptorSet, _defaultEmissiveImage, vk::ImageLayout::eShaderReadOnlyOptimal, _defaultSampler, 5);
+        parameters.emissiveTexture = _defaultEmissiveTexture;
     }
 }
 
-void GLTFPBRMaterial::processCombinedImageSampler(vk::raii::DescriptorSet& descriptorSet, int binding, VulkanImage& image, vk::raii::Sampler& sampler, const TextureProperty* textureProperty, vk::Format imageFormat)
+uint32_t GLTFPBRMaterial::processCombinedImageSampler(const TextureProperty* textureProperty, vk::Format imageFormat, uint32_t defaultTexture, ThreadPool* threadPool)
 {
-    image = VulkanImage(
-        _device, _immediateSubmit, _memoryAllocator, vk::Extent2D{ textureProperty->data->width, textureProperty->data->height },
-        imageFormat, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled, textureProperty->data->data.get(),
-        textureProperty->data->size
-    );
+    const Texture& texture = *textureProperty->data;
+
+    auto textureIndex = _textureIndices.find({ &texture, imageFormat });
+
+    if (textureIndex != _textureIndices.end())
+    {
+        return textureIndex->second;
+    }
+
+    vk::Format requestedFormat = imageFormat;
+
+    if (texture.encoding != TextureEncoding::RGBA8)
+    {
+        imageFormat = getCompressedFormat(texture.encoding, imageFormat == vk::Format::eR8G8B8A8Srgb);
+
+        // only textures compressed while loading are left uncompressed on such devices, ones read from KTX2 files are replaced
+        if (!(_physicalDevice->getFormatProperties(imageFormat).optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage))
+        {
+            std::cout << "GLTFPBRMaterial: warning: block compressed texture not supported by the device, using the default texture" << std::endl;
+
+            _textureIndices[{ &texture, requestedFormat }] = defaultTexture; // warned about once
+
+            return defaultTexture;
+        }
+    }
+
+    std::shared_ptr<const VulkanImage> image = _textureCache->getImage(texture, imageFormat, [&]() { return createImage(texture, imageFormat, threadPool); });
 
     vk::SamplerCreateInfo samplerCreateInfo;
     samplerCreateInfo.setMagFilter(vk::Filter::eLinear);
@@ -417,15 +545,102 @@ void GLTFPBRMaterial::processCombinedImageSampler(vk::raii::DescriptorSet& descr
     samplerCreateInfo.setAddressModeU(vk::SamplerAddressMode::eRepeat);
     samplerCreateInfo.setAddressModeV(vk::SamplerAddressMode::eRepeat);
     samplerCreateInfo.setAddressModeW(vk::SamplerAddressMode::eRepeat);
-    samplerCreateInfo.setAnisotropyEnable(vk::False);
-    samplerCreateInfo.setMaxAnisotropy(4);
+    samplerCreateInfo.setAnisotropyEnable(vk::True);
+    samplerCreateInfo.setMaxAnisotropy(_maxAnisotropy);
     samplerCreateInfo.setBorderColor(vk::BorderColor::eIntOpaqueBlack);
     samplerCreateInfo.setUnnormalizedCoordinates(vk::False);
     samplerCreateInfo.setCompareEnable(vk::False);
     samplerCreateInfo.setCompareOp(vk::CompareOp::eAlways);
     samplerCreateInfo.setMipmapMode(vk::SamplerMipmapMode::eLinear);
+    samplerCreateInfo.setMinLod(0.0f);
+    samplerCreateInfo.setMaxLod(static_cast<float>(image->getMipLevels()));
+
+    std::shared_ptr<const vk::raii::Sampler> sampler = _textureCache->getSampler(samplerCreateInfo);
+
+    uint32_t index = addTexture(*image, *sampler);
+
+    _images.push_back(std::move(image));
+    _samplers.push_back(std::move(sampler));
+    _textureIndices[{ &texture, requestedFormat }] = index;
+
+    return index;
+}
+
+uint32_t GLTFPBRMaterial::addTexture(const VulkanImage& image, const vk::raii::Sampler& sampler)
+{
+    if (_textures.size() >= _textureCountLimit)
+    {
+        throw std::runtime_error("glTFPBR material: scene has more textures than the texture array can hold");
+    }
+
+    vk::DescriptorImageInfo descriptorImageInfo;
+    descriptorImageInfo.setImageView(image.getImageView());
+    descriptorImageInfo.setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+    descriptorImageInfo.setSampler(sampler);
+
+    _textures.push_back(descriptorImageInfo);
+
+    return static_cast<uint32_t>(_textures.size() - 1);
+}
+
+VulkanImage GLTFPBRMaterial::createImage(const Texture& texture, vk::Format imageFormat, ThreadPool* threadPool)
+{
+    uint32_t mipLevels = TextureMipmaps::getLevelCount(texture.width, texture.height);
+
+    // block compressed textures and those read from KTX2 files come with their mip chain, which is uploaded as it is
+    if (!texture.levelOffsets.empty())
+    {
+        mipLevels = static_cast<uint32_t>(texture.levelOffsets.size());
+
+        return VulkanImage(
+            _device, _uploadManager, _memoryAllocator, vk::Extent2D{ texture.width, texture.height },
+            imageFormat, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled, texture.getData(),
+            texture.size, mipLevels, texture.levelOffsets
+        );
+    }
+    // the full chain keeps minified textures from aliasing and their texels in the cache, blitted on the GPU where the format allows it
+    else if (supportsMipmapBlits(imageFormat))
+    {
+        return VulkanImage(
+            _device, _uploadManager, _memoryAllocator, vk::Extent2D{ texture.width, texture.height },
+            imageFormat, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled, texture.getData(),
+            texture.size, mipLevels
+        );
+    }
+    else
+    {
+        TextureMipmaps::MipChain mipChain = TextureMipmaps::generate(texture.getData(), texture.width, texture.height, imageFormat == vk::Format::eR8G8B8A8Srgb, threadPool);
 
-    sampler = vk::raii::Sampler(*_device, samplerCreateInfo);
+        return VulkanImage(
+            _device, _uploadManager, _memoryAllocator, vk::Extent2D{ texture.width, texture.height },
+            imageFormat, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled, mipChain.data.get(),
+            mipChain.size, mipLevels, mipChain.levelOffsets
+        );
+    }
+}
 
-    _descriptorWriter->writeImageAndSampler(descriptorSet, image, vk::ImageLayout::eShaderReadOnlyOptimal, sampler, binding);
+bool GLTFPBRMaterial::supportsMipmapBlits(vk::Format format) const
+{
+    vk::FormatFeatureFlags requiredFeatures = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+
+    return (_physicalDevice->getFormatProperties(format).optimalTilingFeatures & requiredFeatures) == requiredFeatures;
+}
+
+vk::Format GLTFPBRMaterial::getCompressedFormat(TextureEncoding encoding, bool srgb)
+{
+    switch (encoding)
+    {
+    case TextureEncoding::BC7:
+        return srgb ? vk::Format::eBc7SrgbBlock : vk::Format::eBc7UnormBlock;
+    case TextureEncoding::BC5:
+        return vk::Format::eBc5UnormBlock;
+    case TextureEncoding::BC4:
+        return vk::Format::eBc4UnormBlock;
+    case TextureEncoding::BC3:
+        return srgb ? vk::Format::eBc3SrgbBlock : vk::Format::eBc3UnormBlock;
+    case TextureEncoding::BC1:
+        return srgb ? vk::Format::eBc1RgbaSrgbBlock : vk::Format::eBc1RgbaUnormBlock;
+    default:
+        throw std::runtime_error("GLTFPBRMaterial: texture is not block compressed");
+    }
 }
@@ -3,13 +3,17 @@
 #include <SVMV/Material.hxx>
 #include <SVMV/Property.hxx>
 #include <SVMV/Texture.hxx>
+#include <SVMV/TextureMipmaps.hxx>
+#include <SVMV/ThreadPool.hxx>
 #include <SVMV/VulkanMaterial.hxx>
 #include <SVMV/VulkanImage.hxx>
 #include <SVMV/VulkanBuffer.hxx>
 #include <SVMV/VulkanShader.hxx>
 #include <SVMV/VulkanShaderStructures.hxx>
 #include <SVMV/VulkanUtilities.hxx>
+#include <SVMV/VulkanUploadManager.hxx>
 #include <SVMV/VulkanDescriptorWriter.hxx>
+#include <SVMV/VulkanTextureCache.hxx>
 
 #include <vulkan/vulkan.hpp>
 #include <VkBootstrap.h>
@@ -20,45 +24,58 @@
 
 #include <vector>
 #include <memory>
+#include <map>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
 
 namespace SVMV
 {
+    // bindless: the parameters of all materials of a scene live in one storage buffer and all of their textures in one array,
+    // so a single descriptor set is bound for every draw and the shaders select the material with the index from the draw data
     class GLTFPBRMaterial
     {
     public:
-        struct MaterialUniformParameters
+        static constexpr uint32_t maxTextureCount = 1 << 16; // upper bound of the texture array, lowered to the device limits
+        static constexpr float maxAnisotropy = 16.0f; // lowered to the device limit
+
+        static constexpr uint32_t normalTextureXYFlag = 1; // the normal texture only stores X and Y, Z is reconstructed in the fragment shader
+
+        // shader features of a draw, the pipelines are specialized on them so missing textures are never sampled (FEATURE_* in the shaders)
+        static constexpr uint32_t featureBaseColorTexture           = 1 << 0;
+        static constexpr uint32_t featureNormalTexture              = 1 << 1;
+        static constexpr uint32_t featureMetallicRoughnessTexture   = 1 << 2;
+        static constexpr uint32_t featureOcclusionTexture           = 1 << 3;
+        static constexpr uint32_t featureEmissiveTexture            = 1 << 4;
+        static constexpr uint32_t featureVertexColors               = 1 << 5; // set per primitive instead of per material
+
+        // element of the material storage buffer
+        struct MaterialParameters
         {
             glm::vec4 baseColorFactor                   { 1.0f };
-            glm::vec4 roughnessMetallicNormalFactors    { 1.0f }; // same format as the roughnessMetallicTexture (G and B channels), with the R channel containing a bool for the presence of the normal texture
+            glm::vec4 roughnessMetallicNormalFactors    { 1.0f }; // same format as the roughnessMetallicTexture (G and B channels), the R channel is unused
             glm::vec4 emissiveFactor                    { 1.0f };
 
-            // padding to align to 256 bytes
-            glm::vec4 padding[13];
-        };
+            // indices into the texture array
+            uint32_t baseColorTexture                   { 0 };
+            uint32_t normalTexture                      { 0 };
+            uint32_t metallicRoughnessTexture           { 0 };
+            uint32_t occlusionTexture                   { 0 };
+            uint32_t emissiveTexture                    { 0 };
 
-        struct MaterialResources
-        {
-            VulkanUniformBuffer uniformBuffer;
-
-            VulkanImage baseColorImage;
-            VulkanImage normalImage;
-            VulkanImage metallicRoughnessImage;
-            VulkanImage occlusionImage;
-            VulkanImage emissiveImage;
-
-            vk::raii::Sampler baseColorSampler              { nullptr };
-            vk::raii::Sampler normalSampler                 { nullptr };
-            vk::raii::Sampler metallicRoughnessSampler      { nullptr };
-            vk::raii::Sampler occlusionSampler              { nullptr };
-            vk::raii::Sampler emissiveSampler               { nullptr };
+            uint32_t flags                              { 0 };
+            uint32_t padding[2]                         { 0, 0 }; // std430 array stride
         };
 
     public:
         GLTFPBRMaterial() = default;
         GLTFPBRMaterial(
-            vk::raii::Device* device, VmaAllocator memoryAllocator, VulkanUtilities::ImmediateSubmit* immediateSubmit, const vk::raii::RenderPass& renderPass, const vk::raii::DescriptorSetLayout& globalDescriptorSetLayout,
-            const vk::raii::DescriptorSetLayout& lightDescriptorSetLayout, VulkanUtilities::DescriptorAllocator* descriptorAllocator, VulkanDescriptorWriter* descriptorWriter, const shaderc::Compiler& compiler
-        );
+            const vk::raii::PhysicalDevice* physicalDevice, vk::raii::Device* device, VmaAllocator memoryAllocator, VulkanUploadManager* uploadManager, const vk::raii::RenderPass& renderPass,
+            const vk::raii::DescriptorSetLayout& globalDescriptorSetLayout, const vk::raii::DescriptorSetLayout& lightDescriptorSetLayout, VulkanDescriptorWriter* descriptorWriter,
+            const shaderc::Compiler& compiler, const vk::raii::PipelineCache& pipelineCache, VulkanTextureCache* textureCache, uint32_t textureCountLimit
+        ); // textureCountLimit is the size of the texture array in the set layout, at most maxTextureCount
 
         GLTFPBRMaterial(const GLTFPBRMaterial&) = delete;
         GLTFPBRMaterial& operator=(const GLTFPBRMaterial&) = delete;
@@ -68,28 +85,50 @@ namespace SVMV
 
         ~GLTFPBRMaterial() = default;
 
-        vk::DescriptorSet createDescriptorSet(std::shared_ptr<Material> material);
+        uint32_t addMaterial(std::shared_ptr<Material> material, ThreadPool* threadPool = nullptr); // uploads the material's textures and returns the index of its parameters, the pool generates mipmaps on the CPU
+        void createDescriptorSet(); // uploads the parameters of all added materials and writes the texture array, called once after the last material
+
+        [[nodiscard]] uint32_t getFeatures(uint32_t materialIndex) const; // the texture features of an added material
 
-        const vk::raii::Pipeline* getPipeline() const;
+        const vk::raii::Pipeline& getPipeline(uint32_t features); // the permutation is created on first use and kept for the lifetime of the material
         const vk::raii::PipelineLayout* getPipelineLayout() const;
+        const vk::raii::DescriptorSet* getDescriptorSet() const;
 
     private:
         void createDefaultResources();
 
-        void processUniformParameters(vk::raii::DescriptorSet& descriptorSet, MaterialResources& resources, std::shared_ptr<Material> material);
-        void processTextures(vk::raii::DescriptorSet& descriptorSet, MaterialResources& resources, std::shared_ptr<Material> material);
+        void processParameters(MaterialParameters& parameters, std::shared_ptr<Material> material);
+        void processTextures(MaterialParameters& parameters, std::shared_ptr<Material> material, ThreadPool* threadPool);
 
         // TODO: change the TextureProperty to be a reference instead
-        void processCombinedImageSampler(vk::raii::DescriptorSet& descriptorSet, int binding, VulkanImage& image, vk::raii::Sampler& sampler, const TextureProperty* textureProperty, vk::Format imageFormat);
+        uint32_t processCombinedImageSampler(const TextureProperty* textureProperty, vk::Format imageFormat, uint32_t defaultTexture, ThreadPool* threadPool); // defaultTexture replaces textures the device cannot sample
+        uint32_t addTexture(const VulkanImage& image, const vk::raii::Sampler& sampler); // returns the index in the texture array
+
+        VulkanImage createImage(const Texture& texture, vk::Format imageFormat, ThreadPool* threadPool); // called by the texture cache when no scene holds the image yet
+
+        bool supportsMipmapBlits(vk::Format format) const; // otherwise the mip chain is generated on the CPU
+
+        static vk::Format getCompressedFormat(TextureEncoding encoding, bool srgb);
+
+        // values of the specialization constants, in the order of their constant_id
+        struct PipelineSpecialization
+        {
+            uint32_t features       { 0 };
+        };
 
     private:
+        const vk::raii::PhysicalDevice* _physicalDevice                 { nullptr };
         vk::raii::Device* _device                                       { nullptr };
         VmaAllocator _memoryAllocator                                   { nullptr };
-        VulkanUtilities::ImmediateSubmit* _immediateSubmit              { nullptr };
-        VulkanUtilities::DescriptorAllocator* _descriptorAllocator      { nullptr };
+        VulkanUploadManager* _uploadManager                             { nullptr };
         VulkanDescriptorWriter* _descriptorWriter                       { nullptr };
+        VulkanTextureCache* _textureCache                               { nullptr };
+        const vk::raii::RenderPass* _renderPass                         { nullptr };
+        const vk::raii::PipelineCache* _pipelineCache                   { nullptr };
+        uint32_t _textureCountLimit                                     { 0 };
+        float _maxAnisotropy                                            { 1.0f };
 
-        vk::raii::Pipeline _pipeline                            { nullptr };
+        std::map<uint32_t, vk::raii::Pipeline> _pipelines; // by features
         vk::raii::PipelineLayout _pipelineLayout                { nullptr };
         vk::raii::DescriptorSetLayout _descriptorSetLayout      { nullptr };
 
@@ -103,7 +142,25 @@ namespace SVMV
         VulkanImage _defaultOcclusionImage;
         VulkanImage _defaultEmissiveImage;
 
-        std::vector<MaterialResources> _resources;
-        std::vector<vk::raii::DescriptorSet> _descriptorSets;
+        // indices of the default images in the texture array, used for missing textures
+        uint32_t _defaultBaseColorTexture               { 0 };
+        uint32_t _defaultNormalTexture                  { 0 };
+        uint32_t _defaultMetallicRoughnessTexture       { 0 };
+        uint32_t _defaultOcclusionTexture               { 0 };
+        uint32_t _defaultEmissiveTexture                { 0 };
+
+        // shared with the other materials through the texture cache, holding them keeps the cache entries alive
+        std::vector<std::shared_ptr<const VulkanImage>> _images;
+        std::vector<std::shared_ptr<const vk::raii::Sampler>> _samplers;
+        std::vector<vk::DescriptorImageInfo> _textures; // contents of the texture array, referencing the images above
+        std::map<std::pair<const Texture*, vk::Format>, uint32_t> _textureIndices; // textures used by several materials of the scene take a single array element
+
+        std::vector<MaterialParameters> _parameters;
+        std::vector<uint32_t> _features; // of each material, in the order of the parameters
+        VulkanGPUBuffer _parameterBuffer;
+
+        // sized for the texture count of the scene, declared before the set which is freed into it
+        vk::raii::DescriptorPool _descriptorPool        { nullptr };
+        vk::raii::DescriptorSet _descriptorSet          { nullptr };
     };
 }
\ No newline at end of file
@@ -3,16 +3,22 @@
 using namespace SVMV;
 
 VulkanImage::VulkanImage(
-    vk::raii::Device* device, VulkanUtilities::ImmediateSubmit* immediateSubmit, VmaAllocator vmaAllocator,
-    vk::Extent2D extent, vk::Format format, vk::ImageUsageFlags imageUsageFlags, void* data, size_t dataSize
+    vk::raii::Device* device, VulkanUploadManager* uploadManager, VmaAllocator vmaAllocator,
+    vk::Extent2D extent, vk::Format format, vk::ImageUsageFlags imageUsageFlags, void* data, size_t dataSize,
+    uint32_t mipLevels/* = 1*/, const std::vector<size_t>& levelOffsets/* = { 0 }*/
 )
-    : _device(device), _immediateSubmit(immediateSubmit), _allocator(vmaAllocator), _extent(extent, 1), _format(format)
+    : _device(device), _allocator(vmaAllocator), _extent(extent, 1), _format(format), _mipLevels(mipLevels)
 {
+    if (_mipLevels > levelOffsets.size())
+    {
+        imageUsageFlags |= vk::ImageUsageFlagBits::eTransferSrc; // the generated levels are blitted from the previous ones
+    }
+
     vk::ImageCreateInfo imageCreateInfo;
     imageCreateInfo.setImageType(vk::ImageType::e2D);
     imageCreateInfo.setFormat(_format);
     imageCreateInfo.setExtent(_extent);
-    imageCreateInfo.setMipLevels(1);
+    imageCreateInfo.setMipLevels(_mipLevels);
     imageCreateInfo.setArrayLayers(1);
     imageCreateInfo.setTiling(vk::ImageTiling::eOptimal);
     imageCreateInfo.setInitialLayout(vk::ImageLayout::eUndefined);
@@ -40,24 +46,24 @@ VulkanImage::VulkanImage(
     imageViewCreateInfo.setViewType(vk::ImageViewType::e2D);
     imageViewCreateInfo.setImage(_image);
     imageViewCreateInfo.setFormat(_format);
-    imageViewCreateInfo.setSubresourceRange(vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 });
+    imageViewCreateInfo.setSubresourceRange(vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, _mipLevels, 0, 1 });
 
     _imageView = vk::raii::ImageView(*_device, imageViewCreateInfo);
 
-    fillImage(data, dataSize);
+    fillImage(uploadManager, data, dataSize, levelOffsets);
 }
 
 VulkanImage::VulkanImage(
-    vk::raii::Device* device, VulkanUtilities::ImmediateSubmit* immediateSubmit, VmaAllocator vmaAllocator,
-    vk::Extent2D extent, vk::Format format, vk::ImageAspectFlags imageAspectFlags, vk::ImageUsageFlags imageUsageFlags
+    vk::raii::Device* device, VmaAllocator vmaAllocator,
+    vk::Extent2D extent, vk::Format format, vk::ImageAspectFlags imageAspectFlags, vk::ImageUsageFlags imageUsageFlags, uint32_t mipLevels/* = 1*/
 )
-    : _device(device), _immediateSubmit(immediateSubmit), _allocator(vmaAllocator), _extent(extent, 1), _format(format)
+    : _device(device), _allocator(vmaAllocator), _extent(extent, 1), _format(format), _mipLevels(mipLevels)
 {
     vk::ImageCreateInfo imageCreateInfo;
     imageCreateInfo.setImageType(vk::ImageType::e2D);
     imageCreateInfo.setFormat(_format);
     imageCreateInfo.setExtent(_extent);
-    imageCreateInfo.setMipLevels(1);
+    imageCreateInfo.setMipLevels(_mipLevels);
     imageCreateInfo.setArrayLayers(1);
     imageCreateInfo.setTiling(vk::ImageTiling::eOptimal);
     imageCreateInfo.setInitialLayout(vk::ImageLayout::eUndefined);
@@ -85,7 +91,7 @@ VulkanImage::VulkanImage(
     imageViewCreateInfo.setViewType(vk::ImageViewType::e2D);
     imageViewCreateInfo.setImage(_image);
     imageViewCreateInfo.setFormat(_format);
-    imageViewCreateInfo.setSubresourceRange(vk::ImageSubresourceRange{ imageAspectFlags, 0, 1, 0, 1 });
+    imageViewCreateInfo.setSubresourceRange(vk::ImageSubresourceRange{ imageAspectFlags, 0, _mipLevels, 0, 1 });
 
     _imageView = vk::raii::ImageView(*_device, imageViewCreateInfo);
 }
@@ -97,16 +103,16 @@ VulkanImage::VulkanImage(VulkanImage&& other) noexcept
     this->_allocator = other._allocator;
     this->_allocation = other._allocation;
     this->_device = other._device;
-    this->_immediateSubmit = other._immediateSubmit;
     this->_format = other._format;
     this->_extent = other._extent;
+    this->_mipLevels = other._mipLevels;
 
     other._allocator = nullptr;
     other._allocation = nullptr;
     other._device = nullptr;
-    other._immediateSubmit = nullptr;
     other._format = vk::Format::eUndefined;
     other._extent = vk::Extent3D{ 0, 0, 0 };
+    other._mipLevels = 1;
 }
 
 VulkanImage& VulkanImage::operator=(VulkanImage&& other) noexcept
@@ -126,16 +132,16 @@ VulkanImage& VulkanImage::operator=(VulkanImage&& other) noexcept
         this->_allocator = other._allocator;
         this->_allocation = other._allocation;
         this->_device = other._device;
-        this->_immediateSubmit = other._immediateSubmit;
         this->_format = other._format;
         this->_extent = other._extent;
+        this->_mipLevels = other._mipLevels;
 
         other._allocator = nullptr;
         other._allocation = nullptr;
         other._device = nullptr;
-        other._immediateSubmit = nullptr;
         other._format = vk::Format::eUndefined;
         other._extent = vk::Extent3D{ 0, 0, 0 };
+        other._mipLevels = 1;
     }
 
     return *this;
@@ -172,51 +178,17 @@ vk::Extent3D VulkanImage::getExtent() const noexcept
     return _extent;
 }
 
+uint32_t VulkanImage::getMipLevels() const noexcept
+{
+    return _mipLevels;
+}
+
 VulkanImage::operator bool() const
 {
     return *_image != nullptr;
 }
 
-void VulkanImage::fillImage(void* data, size_t size)
+void VulkanImage::fillImage(VulkanUploadManager* uploadManager, void* data, size_t size, const std::vector<size_t>& levelOffsets)
 {
-    VulkanStagingBuffer stagingBuffer = VulkanStagingBuffer(_device, _immediateSubmit, _allocator, size);
-    stagingBuffer.pushData(data, size);
-
-    vk::BufferImageCopy bufferImageCopy;
-    bufferImageCopy.setBufferOffset(0);
-    bufferImageCopy.setBufferRowLength(0);
-    bufferImageCopy.setBufferImageHeight(0);
-    bufferImageCopy.setImageSubresource(vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, 0, 0, 1 });
-    bufferImageCopy.setImageOffset(vk::Offset3D{ 0, 0, 0 });
-    bufferImageCopy.setImageExtent(_extent);
-
-    vk::ImageMemoryBarrier imageMemoryBarrierNEW;
-    imageMemoryBarrierNEW.setOldLayout(vk::ImageLayout::eUndefined);
-    imageMemoryBarrierNEW.setNewLayout(vk::ImageLayout::eTransferDstOptimal);
-    imageMemoryBarrierNEW.setSrcAccessMask(vk::AccessFlagBits::eNone);
-    imageMemoryBarrierNEW.setDstAccessMask(vk::AccessFlagBits::eMemoryWrite);
-    imageMemoryBarrierNEW.setImage(_image);
-    imageMemoryBarrierNEW.setSubresourceRange(vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 });
-
-    vk::ImageMemoryBarrier imageMemoryBarrierPostNEW;
-    imageMemoryBarrierPostNEW.setOldLayout(vk::ImageLayout::eTransferDstOptimal);
-    imageMemoryBarrierPostNEW.setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
-    imageMemoryBarrierPostNEW.setSrcAccessMask(vk::AccessFlagBits::eMemoryWrite);
-    imageMemoryBarrierPostNEW.setDstAccessMask(vk::AccessFlagBits::eMemoryRead);
-    imageMemoryBarrierPostNEW.setImage(_image);
-    imageMemoryBarrierPostNEW.setSubresourceRange(vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 });
-
-    vk::raii::Fence* fence = _immediateSubmit->submit([&](vk::CommandBuffer commandBuffer)
-        {
-            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlagBits::eByRegion, nullptr, nullptr, imageMemoryBarrierNEW);
-            commandBuffer.copyBufferToImage(stagingBuffer.getBuffer(), _image, vk::ImageLayout::eTransferDstOptimal, bufferImageCopy);
-            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, vk::DependencyFlagBits::eByRegion, nullptr, nullptr, imageMemoryBarrierPostNEW);
-        });
-
-    vk::Result waitForFencesResult = _device->waitForFences(**fence, true, INT32_MAX);
-
-    if (waitForFencesResult != vk::Result::eSuccess)
-    {
-        throw std::runtime_error("vulkan: failure waiting for fences");
-    }
+    uploadManager->uploadImage(*_image, _extent, data, size, _mipLevels, levelOffsets);
 }
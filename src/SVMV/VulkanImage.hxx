@@ -2,8 +2,10 @@
 
 #include <SVMV/VulkanBuffer.hxx>
 #include <SVMV/VulkanUtilities.hxx>
+#include <SVMV/VulkanUploadManager.hxx>
 
 #include <memory>
+#include <vector>
 
 namespace SVMV
 {
@@ -12,13 +14,15 @@ namespace SVMV
     public:
         VulkanImage() = default;
         VulkanImage(
-            vk::raii::Device* device, VulkanUtilities::ImmediateSubmit* immediateSubmit, VmaAllocator vmaAllocator,
-            vk::Extent2D extent, vk::Format format, vk::ImageUsageFlags imageUsageFlags, void* data, size_t dataSize
-        );
+            vk::raii::Device* device, VulkanUploadManager* uploadManager, VmaAllocator vmaAllocator,
+            vk::Extent2D extent, vk::Format format, vk::ImageUsageFlags imageUsageFlags, void* data, size_t dataSize,
+            uint32_t mipLevels = 1, const std::vector<size_t>& levelOffsets = { 0 }
+        ); // the data is uploaded asynchronously, the image is ready once the upload manager completed the upload
+        // levelOffsets locate the mip levels contained in the data, the remaining ones are generated from the last of them with linear blits
         VulkanImage(
-            vk::raii::Device* device, VulkanUtilities::ImmediateSubmit* immediateSubmit, VmaAllocator vmaAllocator,
-            vk::Extent2D extent, vk::Format format, vk::ImageAspectFlags imageAspectFlags, vk::ImageUsageFlags imageUsageFlags
-        );
+            vk::raii::Device* device, VmaAllocator vmaAllocator,
+            vk::Extent2D extent, vk::Format format, vk::ImageAspectFlags imageAspectFlags, vk::ImageUsageFlags imageUsageFlags, uint32_t mipLevels = 1
+        ); // the levels are left undefined, the view covers all of them
 
         VulkanImage(const VulkanImage&) = delete;
         VulkanImage& operator=(const VulkanImage&) = delete;
@@ -32,11 +36,12 @@ namespace SVMV
         [[nodiscard]] const vk::raii::ImageView& getImageView() const noexcept;
         [[nodiscard]] vk::Format getFormat() const noexcept;
         [[nodiscard]] vk::Extent3D getExtent() const noexcept;
+        [[nodiscard]] uint32_t getMipLevels() const noexcept;
 
         operator bool() const;
 
     private:
-        void fillImage(void* data, size_t size);
+        void fillImage(VulkanUploadManager* uploadManager, void* data, size_t size, const std::vector<size_t>& levelOffsets);
 
     private:
         vk::raii::Image _image          { nullptr };
@@ -45,10 +50,10 @@ namespace SVMV
         VmaAllocator _allocator         { nullptr };
         VmaAllocation _allocation       { nullptr };
 
-        vk::raii::Device* _device                           { nullptr };
-        VulkanUtilities::ImmediateSubmit* _immediateSubmit  { nullptr };
+        vk::raii::Device* _device       { nullptr };
 
         vk::Format _format      { vk::Format::eUndefined };
         vk::Extent3D _extent    { 0 };
+        uint32_t _mipLevels     { 1 };
     };
 }
\ No newline at end of file
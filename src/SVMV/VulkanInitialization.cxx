@@ -2,7 +2,7 @@
 
 using namespace SVMV;
 
-vk::raii::Instance VulkanInitilization::createInstance(const vk::raii::Context& context, const std::string& name, unsigned apiVersionMajor, unsigned apiVersionMinor)
+vk::raii::Instance VulkanInitilization::createInstance(const vk::raii::Context& context, const std::string& name, unsigned apiVersionMajor, unsigned apiVersionMinor, bool headless/* = false*/)
 {
     vkb::InstanceBuilder builder;
     builder.set_app_name(name.c_str());
@@ -10,6 +10,7 @@ vk::raii::Instance VulkanInitilization::createInstance(const vk::raii::Context&
     builder.request_validation_layers();
     builder.use_default_debug_messenger();
     builder.desire_api_version(apiVersionMajor, apiVersionMinor);
+    builder.set_headless(headless); // skips the surface extensions, so no display server is needed
 
     vkb::Result<vkb::Instance> result = builder.build();
     if (!result)
@@ -31,25 +32,14 @@ vk::raii::PhysicalDevice VulkanInitilization::createPhysicalDevice(const vk::rai
 {
     vkb::PhysicalDeviceSelector selector(_bootstrapInstance, *surface);
 
-    for (const auto& extension : extensions)
-    {
-        selector.add_required_extension(extension);
-    }
-
-    // TODO: is this the right way to do this?
-    vk::PhysicalDeviceVulkan12Features features12;
-    features12.setBufferDeviceAddress(true);
-
-    selector.set_required_features_12(features12);
+    return selectPhysicalDevice(instance, selector, extensions);
+}
 
-    vkb::Result<vkb::PhysicalDevice> physicalDeviceResult = selector.select();
-    if (!physicalDeviceResult)
-    {
-        throw std::runtime_error("bk-bootstrap: failed to select physical device");
-    }
+vk::raii::PhysicalDevice VulkanInitilization::createPhysicalDevice(const vk::raii::Instance& instance, std::vector<const char*> extensions)
+{
+    vkb::PhysicalDeviceSelector selector(_bootstrapInstance);
 
-    _bootstrapPhysicalDevice = physicalDeviceResult.value();
-    return vk::raii::PhysicalDevice(instance, _bootstrapPhysicalDevice.physical_device);
+    return selectPhysicalDevice(instance, selector, extensions);
 }
 
 vk::raii::Device VulkanInitilization::createDevice(const vk::raii::PhysicalDevice& physicalDevice)
@@ -106,6 +96,21 @@ std::pair<vk::raii::Queue, unsigned> VulkanInitilization::createQueue(const vk::
     return std::pair<vk::raii::Queue, unsigned>(vk::raii::Queue(device, _bootstrapDevice.get_queue(queueType).value()), _bootstrapDevice.get_queue_index(queueType).value());
 }
 
+bool VulkanInitilization::hasQueue(vkb::QueueType queueType)
+{
+    return _bootstrapDevice.get_queue(queueType).has_value();
+}
+
+std::pair<vk::raii::Queue, unsigned> VulkanInitilization::createDedicatedQueue(const vk::raii::Device& device, vkb::QueueType queueType)
+{
+    return std::pair<vk::raii::Queue, unsigned>(vk::raii::Queue(device, _bootstrapDevice.get_dedicated_queue(queueType).value()), _bootstrapDevice.get_dedicated_queue_index(queueType).value());
+}
+
+bool VulkanInitilization::hasDedicatedQueue(vkb::QueueType queueType)
+{
+    return _bootstrapDevice.get_dedicated_queue(queueType).has_value();
+}
+
 std::vector<vk::raii::ImageView> VulkanInitilization::createSwapchainImageViews(const vk::raii::Device& device)
 {
     std::vector<VkImageView> vkViews = _bootstrapSwapchain.get_image_views().value(); // get_image_views apparently creates the image views as well
@@ -161,6 +166,20 @@ std::vector<vk::raii::Framebuffer> VulkanInitilization::createFramebuffers(const
     return framebuffers;
 }
 
+vk::raii::Framebuffer VulkanInitilization::createFramebuffer(const vk::raii::Device& device, const vk::raii::RenderPass& renderPass, const vk::raii::ImageView& imageView, const vk::raii::ImageView& depthImageView, vk::Extent2D extent)
+{
+    std::array<vk::ImageView, 2> attachments = { *imageView, *depthImageView };
+
+    vk::FramebufferCreateInfo info;
+    info.setRenderPass(renderPass);
+    info.setAttachments(attachments);
+    info.setWidth(extent.width);
+    info.setHeight(extent.height);
+    info.setLayers(1);
+
+    return vk::raii::Framebuffer(device, info);
+}
+
 std::vector<vk::raii::Semaphore> VulkanInitilization::createSemaphores(const vk::raii::Device& device, int count)
 {
     std::vector<vk::raii::Semaphore> semaphores;
@@ -190,6 +209,16 @@ std::vector<vk::raii::Fence> VulkanInitilization::createFences(const vk::raii::D
     return fences;
 }
 
+bool VulkanInitilization::supportsDrawIndirectCount() const noexcept
+{
+    return _drawIndirectCount;
+}
+
+bool VulkanInitilization::supportsTextureCompressionBC() const noexcept
+{
+    return _textureCompressionBC;
+}
+
 vk::Extent2D VulkanInitilization::getSwapchainExtent()
 {
     return vk::Extent2D(_bootstrapSwapchain.extent);
@@ -199,3 +228,61 @@ vk::Format VulkanInitilization::getSwapchainFormat()
 {
     return vk::Format(_bootstrapSwapchain.image_format);
 }
+
+vk::raii::PhysicalDevice VulkanInitilization::selectPhysicalDevice(const vk::raii::Instance& instance, vkb::PhysicalDeviceSelector& selector, const std::vector<const char*>& extensions)
+{
+    for (const auto& extension : extensions)
+    {
+        selector.add_required_extension(extension);
+    }
+
+    vk::PhysicalDeviceFeatures features;
+    features.setMultiDrawIndirect(true); // one indirect draw per batch
+    features.setDrawIndirectFirstInstance(true); // the instance index selects the draw data
+    features.setSamplerAnisotropy(true); // material textures are sampled anisotropically
+
+    selector.set_required_features(features);
+
+    // TODO: is this the right way to do this?
+    vk::PhysicalDeviceVulkan12Features features12;
+    features12.setBufferDeviceAddress(true);
+    features12.setTimelineSemaphore(true); // upload completion tracking
+
+    // bindless materials, all textures of a scene are indexed from a single variable-sized array
+    features12.setRuntimeDescriptorArray(true);
+    features12.setShaderSampledImageArrayNonUniformIndexing(true);
+    features12.setDescriptorBindingPartiallyBound(true);
+    features12.setDescriptorBindingVariableDescriptorCount(true);
+    features12.setDescriptorBindingSampledImageUpdateAfterBind(true); // for the higher descriptor limits of update after bind pools
+
+    vkb::PhysicalDeviceSelector fallbackSelector = selector;
+
+    // optional, without it culled draws are kept in the indirect buffers with an instance count of 0
+    features12.setDrawIndirectCount(true);
+    selector.set_required_features_12(features12);
+
+    vkb::Result<vkb::PhysicalDevice> physicalDeviceResult = selector.select();
+    _drawIndirectCount = static_cast<bool>(physicalDeviceResult);
+
+    if (!physicalDeviceResult)
+    {
+        features12.setDrawIndirectCount(false);
+        fallbackSelector.set_required_features_12(features12);
+
+        physicalDeviceResult = fallbackSelector.select();
+    }
+
+    if (!physicalDeviceResult)
+    {
+        throw std::runtime_error("bk-bootstrap: failed to select physical device");
+    }
+
+    _bootstrapPhysicalDevice = physicalDeviceResult.value();
+    vk::raii::PhysicalDevice physicalDevice(instance, _bootstrapPhysicalDevice.physical_device);
+
+    // optional, textures are only block compressed on load when the device can sample them
+    _textureCompressionBC = physicalDevice.getFeatures().textureCompressionBC;
+    _bootstrapPhysicalDevice.features.textureCompressionBC = _textureCompressionBC; // enabled when the device is built
+
+    return physicalDevice;
+}
@@ -22,27 +22,41 @@ namespace SVMV
 
         ~VulkanInitilization() = default;
 
-        vk::raii::Instance createInstance(const vk::raii::Context& context, const std::string& name, unsigned apiVersionMajor, unsigned apiVersionMinor);
+        vk::raii::Instance createInstance(const vk::raii::Context& context, const std::string& name, unsigned apiVersionMajor, unsigned apiVersionMinor, bool headless = false);
         vk::raii::DebugUtilsMessengerEXT createDebugMessenger(const vk::raii::Instance& instance);
         vk::raii::PhysicalDevice createPhysicalDevice(const vk::raii::Instance& instance, std::vector<const char*> extensions, const vk::raii::SurfaceKHR& surface);
+        vk::raii::PhysicalDevice createPhysicalDevice(const vk::raii::Instance& instance, std::vector<const char*> extensions); // headless, no presentation support required
         vk::raii::Device createDevice(const vk::raii::PhysicalDevice& physicalDevice);
         vk::raii::SwapchainKHR createSwapchain(const vk::raii::Device& device, const vk::raii::SurfaceKHR& surface);
         vk::raii::SwapchainKHR recreateSwapchain(const vk::raii::Device& device, const vk::raii::SurfaceKHR& surface);
         vk::raii::CommandPool createCommandPool(const vk::raii::Device& device);
         std::pair<vk::raii::Queue, unsigned> createQueue(const vk::raii::Device& device, vkb::QueueType queueType);
+        bool hasQueue(vkb::QueueType queueType);
+        std::pair<vk::raii::Queue, unsigned> createDedicatedQueue(const vk::raii::Device& device, vkb::QueueType queueType);
+        bool hasDedicatedQueue(vkb::QueueType queueType); // a queue from a family without graphics support
         std::vector<vk::raii::ImageView> createSwapchainImageViews(const vk::raii::Device& device);
         std::vector<vk::raii::Framebuffer> createFramebuffers(const vk::raii::Device& device, const vk::raii::RenderPass& renderPass, const std::vector<vk::raii::ImageView>& imageViews);
         std::vector<vk::raii::Framebuffer> createFramebuffers(const vk::raii::Device& device, const vk::raii::RenderPass& renderPass, const std::vector<vk::raii::ImageView>& imageViews, const vk::raii::ImageView& depthImageView);
+        vk::raii::Framebuffer createFramebuffer(const vk::raii::Device& device, const vk::raii::RenderPass& renderPass, const vk::raii::ImageView& imageView, const vk::raii::ImageView& depthImageView, vk::Extent2D extent);
         std::vector<vk::raii::Semaphore> createSemaphores(const vk::raii::Device& device, int count);
         std::vector<vk::raii::Fence> createFences(const vk::raii::Device& device, int count);
 
+        bool supportsDrawIndirectCount() const noexcept; // of the selected physical device
+        bool supportsTextureCompressionBC() const noexcept;
+
         vk::Extent2D getSwapchainExtent();
         vk::Format getSwapchainFormat();
 
+    private:
+        vk::raii::PhysicalDevice selectPhysicalDevice(const vk::raii::Instance& instance, vkb::PhysicalDeviceSelector& selector, const std::vector<const char*>& extensions);
+
     private:
         vkb::Instance _bootstrapInstance;
         vkb::PhysicalDevice _bootstrapPhysicalDevice;
         vkb::Device _bootstrapDevice;
         vkb::Swapchain _bootstrapSwapchain;
+
+        bool _drawIndirectCount     { false };
+        bool _textureCompressionBC  { false };
     };
 }
@@ -3,38 +3,54 @@
 using namespace SVMV;
 
 VulkanLight::VulkanLight(
-    glm::vec4 position, glm::vec4 flux, vk::raii::Device* device, VmaAllocator memoryAllocator, const vk::raii::DescriptorSetLayout& lightDescriptorSetLayout,
-    VulkanUtilities::DescriptorAllocator* descriptorAllocator, VulkanDescriptorWriter* descriptorWriter, int framesInFlight
+    const vk::raii::DescriptorSetLayout& lightDescriptorSetLayout, VulkanUtilities::DescriptorAllocator* descriptorAllocator, VulkanDescriptorWriter* descriptorWriter,
+    const VulkanFrameAllocator& frameAllocator
 )
-    : _descriptorWriter(descriptorWriter)
-{;
-    lightData.position_0 = position;
-    lightData.flux_0 = flux;
+{
+    _descriptorSet = descriptorAllocator->allocateSet(lightDescriptorSetLayout);
+    descriptorWriter->writeBuffer(_descriptorSet, frameAllocator.getBuffer(), 0, 0, sizeof(ShaderStructures::LightUniformBuffer), vk::DescriptorType::eUniformBufferDynamic);
+}
 
-    _uniformBuffer = VulkanUniformBuffer(device, memoryAllocator, sizeof(ShaderStructures::LightParametersBuffer));
-    _uniformBuffer.setData(&lightData, sizeof(ShaderStructures::LightParametersBuffer));
+const vk::raii::DescriptorSet& VulkanLight::getDescriptorSet() const
+{
+    return _descriptorSet;
+}
 
-    for (int i = 0; i < framesInFlight; i++)
+vk::DeviceAddress VulkanLight::pushLights(VulkanFrameAllocator& frameAllocator) const
+{
+    size_t size = getLightCount() * sizeof(ShaderStructures::PointLight);
+
+    // room for every light, so the allocations after it land at the same offsets whatever the light count, which keeps recorded command buffers valid
+    VulkanFrameAllocator::Allocation allocation = frameAllocator.allocate(maxLightCount * sizeof(ShaderStructures::PointLight));
+
+    if (size != 0)
     {
-        _descriptorSets.push_back(std::move(descriptorAllocator->allocateSet(lightDescriptorSetLayout)));
-        _descriptorWriter->writeBuffer(_descriptorSets[i], _uniformBuffer, 0, 0, sizeof(ShaderStructures::LightParametersBuffer), vk::DescriptorType::eUniformBuffer);
+        memcpy(allocation.data, lights.data(), size);
     }
+
+    return frameAllocator.getAddress(allocation.offset);
 }
 
-const vk::raii::DescriptorSet* VulkanLight::getDescriptorSet(int frameIndex) const
+uint32_t VulkanLight::pushLightParameters(VulkanFrameAllocator& frameAllocator, vk::DeviceAddress lightsAddress, vk::DeviceAddress clusterLightsAddress, const glm::vec4& clusterParameters) const
 {
-    if (frameIndex < _descriptorSets.size())
-    {
-        return &_descriptorSets[frameIndex];
-    }
-    else
-    {
-        return nullptr;
-    }
+    ShaderStructures::LightUniformBuffer lightUniformBuffer;
+    lightUniformBuffer.ambient = ambient;
+    lightUniformBuffer.lights = lightsAddress;
+    lightUniformBuffer.clusterLights = clusterLightsAddress;
+    lightUniformBuffer.clusterParameters = clusterParameters;
+
+    return frameAllocator.push(lightUniformBuffer);
 }
 
-void VulkanLight::updateLightDescriptor(int frameIndex)
+uint32_t VulkanLight::getLightCount() const noexcept
 {
-    _uniformBuffer.setData(&lightData, sizeof(ShaderStructures::LightParametersBuffer));
-    _descriptorWriter->writeBuffer(_descriptorSets[frameIndex], _uniformBuffer, 0, 0, sizeof(ShaderStructures::LightParametersBuffer), vk::DescriptorType::eUniformBuffer);
+    return static_cast<uint32_t>(std::min<size_t>(lights.size(), maxLightCount));
+}
+
+float VulkanLight::getRange(const glm::vec4& flux)
+{
+    // inverse square falloff, the shaders fade the light out towards the range so the cut is not visible
+    float intensity = std::max({ flux.r, flux.g, flux.b }) * flux.w;
+
+    return std::sqrt(std::max(intensity, 0.0f) / rangeCutoff);
 }
@@ -6,47 +6,43 @@
 #include <SVMV/VulkanShaderStructures.hxx>
 #include <SVMV/VulkanUtilities.hxx>
 #include <SVMV/VulkanDescriptorWriter.hxx>
+#include <SVMV/VulkanFrameAllocator.hxx>
 
 #include <vector>
+#include <algorithm>
+#include <cmath>
 
 namespace SVMV
 {
+    // point lights of the renderer, copied to the frame allocator every frame and shaded through the light lists of the clusters
     class VulkanLight
     {
     public:
-        struct LightData
-        {
-            glm::vec4 position_0    { 0.0f };
-            glm::vec4 flux_0        { 0.0f };
-
-            glm::vec4 position_1    { 0.0f };
-            glm::vec4 flux_1        { 0.0f };
-
-            glm::vec4 position_2    { 0.0f };
-            glm::vec4 flux_2        { 0.0f };
-
-            glm::vec4 ambient       { 0.0f };
-        };
+        static constexpr uint32_t maxLightCount = 1024; // the frame allocator reserves room for this many lights per frame
+        static constexpr float rangeCutoff = 0.01f; // the range of a light ends where its irradiance drops below this
 
     public:
         VulkanLight() = default;
 
         VulkanLight(
-            glm::vec4 position, glm::vec4 flux, vk::raii::Device* device, VmaAllocator memoryAllocator, const vk::raii::DescriptorSetLayout& lightDescriptorSetLayout,
-            VulkanUtilities::DescriptorAllocator* descriptorAllocator, VulkanDescriptorWriter* descriptorWriter, int framesInFlight
-            );
+            const vk::raii::DescriptorSetLayout& lightDescriptorSetLayout, VulkanUtilities::DescriptorAllocator* descriptorAllocator, VulkanDescriptorWriter* descriptorWriter,
+            const VulkanFrameAllocator& frameAllocator
+        ); // the descriptor set points at the frame allocator's buffer and is only written here
+
+        const vk::raii::DescriptorSet& getDescriptorSet() const;
 
-        const vk::raii::DescriptorSet* getDescriptorSet(int frameIndex) const;
+        vk::DeviceAddress pushLights(VulkanFrameAllocator& frameAllocator) const; // returns the address of the copy of the light array for the current frame
+        uint32_t pushLightParameters(VulkanFrameAllocator& frameAllocator, vk::DeviceAddress lightsAddress, vk::DeviceAddress clusterLightsAddress, const glm::vec4& clusterParameters) const; // returns the dynamic offset
+
+        [[nodiscard]] uint32_t getLightCount() const noexcept;
+
+        static float getRange(const glm::vec4& flux);
 
-        void updateLightDescriptor(int frameIndex);
-        
     public:
-        LightData lightData;
+        std::vector<ShaderStructures::PointLight> lights; // at most maxLightCount, the rest are left out
+        glm::vec4 ambient       { 0.0f };
 
     private:
-        std::vector<vk::raii::DescriptorSet> _descriptorSets;
-        VulkanUniformBuffer _uniformBuffer;
-
-        VulkanDescriptorWriter* _descriptorWriter{ nullptr };
+        vk::raii::DescriptorSet _descriptorSet{ nullptr };
     };
-}
\ No newline at end of file
+}
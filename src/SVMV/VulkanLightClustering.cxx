@@ -0,0 +1,109 @@
+#include <SVMV/VulkanLightClustering.hxx>
+
+using namespace SVMV;
+
+VulkanLightClustering::VulkanLightClustering(
+    vk::raii::Device* device, VmaAllocator memoryAllocator, const shaderc::Compiler& compiler, const vk::raii::PipelineCache& pipelineCache, std::vector<uint32_t> queueFamilies, int framesInFlight
+)
+    : _device(device)
+{
+    _shader = VulkanShader(*_device, compiler, VulkanShader::ShaderType::COMPUTE, "light_cluster_comp.glsl");
+
+    vk::PushConstantRange pushConstantRange;
+    pushConstantRange.setOffset(0);
+    pushConstantRange.setSize(sizeof(ShaderStructures::LightClusterPushConstants));
+    pushConstantRange.setStageFlags(vk::ShaderStageFlagBits::eCompute);
+
+    vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo;
+    pipelineLayoutCreateInfo.setPushConstantRanges(pushConstantRange);
+
+    _pipelineLayout = vk::raii::PipelineLayout(*_device, pipelineLayoutCreateInfo);
+
+    _pipeline = VulkanUtilities::createComputePipeline(*_device, pipelineCache, _pipelineLayout, _shader.getModule());
+
+    vk::BufferUsageFlags usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress;
+
+    for (int i = 0; i < framesInFlight; i++)
+    {
+        _clusterLightGPUBuffers.emplace_back(_device, memoryAllocator, clusterCount * (maxClusterLights + 1) * sizeof(uint32_t), usage, queueFamilies);
+    }
+}
+
+VulkanLightClustering::VulkanLightClustering(VulkanLightClustering&& other) noexcept
+{
+    this->_device = other._device;
+    this->_shader = std::move(other._shader);
+    this->_pipelineLayout = std::move(other._pipelineLayout);
+    this->_pipeline = std::move(other._pipeline);
+    this->_clusterLightGPUBuffers = std::move(other._clusterLightGPUBuffers);
+
+    other._device = nullptr;
+}
+
+VulkanLightClustering& VulkanLightClustering::operator=(VulkanLightClustering&& other) noexcept
+{
+    if (this != &other)
+    {
+        this->_device = other._device;
+        this->_shader = std::move(other._shader);
+        this->_pipelineLayout = std::move(other._pipelineLayout);
+        this->_pipeline = std::move(other._pipeline);
+        this->_clusterLightGPUBuffers = std::move(other._clusterLightGPUBuffers);
+
+        other._device = nullptr;
+    }
+
+    return *this;
+}
+
+void VulkanLightClustering::recordClustering(
+    const vk::raii::CommandBuffer& commandBuffer, int frameIndex, const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane,
+    vk::DeviceAddress lights, uint32_t lightCount, bool sameQueue
+) const
+{
+    const VulkanGPUBuffer& clusterLights = _clusterLightGPUBuffers[frameIndex];
+
+    ShaderStructures::LightClusterPushConstants constants;
+    constants.view = view;
+    constants.lights = lights;
+    constants.clusterLights = clusterLights.getAddress(*_device);
+    constants.projectionScale = glm::vec2(projection[0][0], projection[1][1]);
+    constants.nearPlane = nearPlane;
+    constants.farPlane = farPlane;
+    constants.lightCount = lightCount;
+
+    // every cluster writes its whole list, so the buffer needs no clearing
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *_pipeline);
+    commandBuffer.pushConstants<ShaderStructures::LightClusterPushConstants>(*_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, constants);
+    commandBuffer.dispatch((clusterCount + workgroupSize - 1) / workgroupSize, 1, 1);
+
+    // a semaphore wait covers the compute queue, which has no fragment shader stage to wait on
+    if (sameQueue)
+    {
+        vk::BufferMemoryBarrier outputBarrier;
+        outputBarrier.setSrcAccessMask(vk::AccessFlagBits::eShaderWrite);
+        outputBarrier.setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+        outputBarrier.setBuffer(*clusterLights.getBuffer());
+        outputBarrier.setSize(vk::WholeSize);
+
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eFragmentShader, {}, nullptr, outputBarrier, nullptr);
+    }
+}
+
+vk::DeviceAddress VulkanLightClustering::getClusterLightsAddress(int frameIndex) const
+{
+    return _clusterLightGPUBuffers[frameIndex].getAddress(*_device);
+}
+
+glm::vec4 VulkanLightClustering::getClusterParameters(vk::Extent2D extent, float nearPlane, float farPlane)
+{
+    // slice = log(depth) * scale + bias puts the near plane at slice 0 and the far plane at clusterCountZ
+    float depthRange = std::log(farPlane / nearPlane);
+
+    return glm::vec4(
+        static_cast<float>(clusterCountX) / extent.width,
+        static_cast<float>(clusterCountY) / extent.height,
+        clusterCountZ / depthRange,
+        -(clusterCountZ * std::log(nearPlane)) / depthRange
+    );
+}
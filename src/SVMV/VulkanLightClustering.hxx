@@ -0,0 +1,69 @@
+#pragma once
+
+#include <SVMV/VulkanBuffer.hxx>
+#include <SVMV/VulkanShader.hxx>
+#include <SVMV/VulkanShaderStructures.hxx>
+#include <SVMV/VulkanUtilities.hxx>
+
+#include <vulkan/vulkan_raii.hpp>
+#include <vk_mem_alloc.h>
+#include <shaderc/shaderc.hpp>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+
+namespace SVMV
+{
+    // clustered forward lighting: a compute pass splits the view frustum into screen tiles and exponential depth slices and lists the lights
+    // reaching each cluster, so a fragment only shades the lights of its own cluster instead of every light in the scene
+    class VulkanLightClustering
+    {
+    public:
+        // match CLUSTER_COUNT_* and MAX_CLUSTER_LIGHTS in the shaders
+        static constexpr uint32_t clusterCountX = 16;
+        static constexpr uint32_t clusterCountY = 9;
+        static constexpr uint32_t clusterCountZ = 24;
+        static constexpr uint32_t clusterCount = clusterCountX * clusterCountY * clusterCountZ;
+        static constexpr uint32_t maxClusterLights = 127; // further lights reaching a cluster are left out
+
+        static constexpr uint32_t workgroupSize = 64; // local_size_x of the clustering shader
+
+    public:
+        VulkanLightClustering() = default;
+        VulkanLightClustering(
+            vk::raii::Device* device, VmaAllocator memoryAllocator, const shaderc::Compiler& compiler, const vk::raii::PipelineCache& pipelineCache, std::vector<uint32_t> queueFamilies, int framesInFlight
+        ); // queueFamilies are the families that write and read the light lists
+
+        VulkanLightClustering(const VulkanLightClustering&) = delete;
+        VulkanLightClustering& operator=(const VulkanLightClustering&) = delete;
+
+        VulkanLightClustering(VulkanLightClustering&& other) noexcept;
+        VulkanLightClustering& operator=(VulkanLightClustering&& other) noexcept;
+
+        ~VulkanLightClustering() = default;
+
+        // the recorded commands can run on the graphics or the compute queue, with sameQueue the fragment shaders of the command buffer wait for the light lists
+        void recordClustering(
+            const vk::raii::CommandBuffer& commandBuffer, int frameIndex, const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane,
+            vk::DeviceAddress lights, uint32_t lightCount, bool sameQueue
+        ) const;
+
+        [[nodiscard]] vk::DeviceAddress getClusterLightsAddress(int frameIndex) const;
+
+        static glm::vec4 getClusterParameters(vk::Extent2D extent, float nearPlane, float farPlane); // LightUniformBuffer::clusterParameters
+
+    private:
+        vk::raii::Device* _device           { nullptr };
+
+        VulkanShader _shader;
+        vk::raii::PipelineLayout _pipelineLayout    { nullptr };
+        vk::raii::Pipeline _pipeline                { nullptr };
+
+        std::vector<VulkanGPUBuffer> _clusterLightGPUBuffers; // one per frame in flight, the light count of each cluster followed by its light indices
+    };
+}
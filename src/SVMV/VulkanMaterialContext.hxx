@@ -2,6 +2,7 @@
 
 #include <SVMV/VulkanDrawable.hxx>
 #include <SVMV/VulkanMaterial.hxx>
+#include <SVMV/VulkanGLTFPBRMaterial.hxx>
 
 #include <vector>
 
@@ -9,10 +10,21 @@ namespace SVMV
 {
     struct VulkanDrawable;
 
+    // consecutive draws in the indirect buffer that share a pipeline, drawn with a single indirect call
+    struct VulkanDrawBatch
+    {
+        uint32_t index          { 0 }; // of the draw count written by the culling pass
+        uint32_t firstDraw      { 0 };
+        uint32_t drawCount      { 0 };
+        uint32_t features       { 0 }; // shader permutation of the draws, see GLTFPBRMaterial
+    };
+
     struct VulkanMaterialContext
     {
         std::vector<VulkanDrawable> drawables;
-        const vk::raii::Pipeline* pipeline{ nullptr };
+        std::vector<VulkanDrawBatch> batches; // one per shader permutation used by the drawables, the materials are selected per draw in the shaders
+        GLTFPBRMaterial* material{ nullptr }; // creates the pipelines of the batches
         const vk::raii::PipelineLayout* pipelineLayout{ nullptr };
+        const vk::raii::DescriptorSet* descriptorSet{ nullptr }; // parameters and textures of all materials of the context
     };
 }
@@ -0,0 +1,156 @@
+#include <SVMV/VulkanPipelineCache.hxx>
+
+using namespace SVMV;
+
+namespace
+{
+    constexpr char cacheMagic[8] = { 'S', 'V', 'M', 'V', 'P', 'L', 'C', '\0' };
+
+    // the file wraps the driver's data, whose own header is validated as well before it is used
+    struct CacheHeader
+    {
+        char magic[8]       { };
+        uint64_t size       { 0 };
+        uint64_t checksum   { 0 }; // some drivers crash on corrupted data instead of rejecting it
+    };
+}
+
+VulkanPipelineCache::VulkanPipelineCache(vk::raii::Device* device, const vk::raii::PhysicalDevice& physicalDevice, const std::string& filePath)
+    : _device(device), _filePath(filePath)
+{
+    std::vector<std::byte> data = readFile(physicalDevice.getProperties());
+
+    vk::PipelineCacheCreateInfo pipelineCacheCreateInfo;
+    pipelineCacheCreateInfo.setInitialDataSize(data.size());
+    pipelineCacheCreateInfo.setPInitialData(data.data());
+
+    _pipelineCache = vk::raii::PipelineCache(*_device, pipelineCacheCreateInfo);
+    _loadedSize = data.size();
+}
+
+VulkanPipelineCache::VulkanPipelineCache(VulkanPipelineCache&& other) noexcept
+{
+    this->_device = other._device;
+    this->_pipelineCache = std::move(other._pipelineCache);
+    this->_filePath = std::move(other._filePath);
+    this->_loadedSize = other._loadedSize;
+
+    other._device = nullptr;
+    other._loadedSize = 0;
+}
+
+VulkanPipelineCache& VulkanPipelineCache::operator=(VulkanPipelineCache&& other) noexcept
+{
+    if (this != &other)
+    {
+        this->_device = other._device;
+        this->_pipelineCache = std::move(other._pipelineCache);
+        this->_filePath = std::move(other._filePath);
+        this->_loadedSize = other._loadedSize;
+
+        other._device = nullptr;
+        other._loadedSize = 0;
+    }
+
+    return *this;
+}
+
+void VulkanPipelineCache::save()
+{
+    if (*_pipelineCache == nullptr)
+    {
+        return;
+    }
+
+    std::string temporaryPath = _filePath + ".tmp" + std::to_string(std::random_device()()); // several instances can exit at once
+
+    try
+    {
+        std::vector<uint8_t> data = _pipelineCache.getData();
+
+        if (data.size() == _loadedSize)
+        {
+            return; // nothing new was compiled
+        }
+
+        CacheHeader header;
+        memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+        header.size = data.size();
+        header.checksum = SceneCache::hashData(reinterpret_cast<const std::byte*>(data.data()), data.size());
+
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+
+        if (!file.is_open())
+        {
+            throw std::runtime_error("failed to open file for writing");
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+        file.close();
+
+        if (file.fail())
+        {
+            throw std::runtime_error("failed to write file");
+        }
+
+        std::filesystem::rename(temporaryPath, _filePath);
+
+        _loadedSize = data.size();
+    }
+    catch (const std::exception& exception)
+    {
+        std::cout << "pipeline cache: failed to write cache: " << _filePath << " (" << exception.what() << ")" << std::endl;
+
+        std::error_code error;
+        std::filesystem::remove(temporaryPath, error);
+    }
+}
+
+const vk::raii::PipelineCache& VulkanPipelineCache::getPipelineCache() const noexcept
+{
+    return _pipelineCache;
+}
+
+std::vector<std::byte> VulkanPipelineCache::readFile(const vk::PhysicalDeviceProperties& properties) const
+{
+    std::ifstream file(_filePath, std::ios::binary);
+
+    if (!file.is_open())
+    {
+        return {};
+    }
+
+    CacheHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if (!file || memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.size < sizeof(vk::PipelineCacheHeaderVersionOne) || header.size > (1ull << 32))
+    {
+        std::cout << "pipeline cache: ignoring invalid cache: " << _filePath << std::endl;
+
+        return {};
+    }
+
+    std::vector<std::byte> data(header.size);
+    file.read(reinterpret_cast<char*>(data.data()), data.size());
+
+    if (!file || SceneCache::hashData(data.data(), data.size()) != header.checksum)
+    {
+        std::cout << "pipeline cache: ignoring corrupted cache: " << _filePath << std::endl;
+
+        return {};
+    }
+
+    vk::PipelineCacheHeaderVersionOne driverHeader;
+    memcpy(&driverHeader, data.data(), sizeof(driverHeader));
+
+    if (driverHeader.headerVersion != vk::PipelineCacheHeaderVersion::eOne || driverHeader.vendorID != properties.vendorID || driverHeader.deviceID != properties.deviceID ||
+        driverHeader.pipelineCacheUUID != properties.pipelineCacheUUID)
+    {
+        std::cout << "pipeline cache: device or driver changed, ignoring cache: " << _filePath << std::endl;
+
+        return {};
+    }
+
+    return data;
+}
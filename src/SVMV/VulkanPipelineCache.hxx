@@ -0,0 +1,51 @@
+#pragma once
+
+#include <SVMV/SceneCache.hxx>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <random>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace SVMV
+{
+    // VkPipelineCache persisted between runs, so the driver skips compiling pipelines it has already built
+    // the data is only handed to the driver when its header matches the device and its checksum is intact, otherwise the cache starts empty
+    class VulkanPipelineCache
+    {
+    public:
+        static constexpr const char* defaultFilePath = "SVMV.pipelinecache"; // in the working directory, next to the shaders
+
+    public:
+        VulkanPipelineCache() = default;
+        VulkanPipelineCache(vk::raii::Device* device, const vk::raii::PhysicalDevice& physicalDevice, const std::string& filePath);
+
+        VulkanPipelineCache(const VulkanPipelineCache&) = delete;
+        VulkanPipelineCache& operator=(const VulkanPipelineCache&) = delete;
+
+        VulkanPipelineCache(VulkanPipelineCache&& other) noexcept;
+        VulkanPipelineCache& operator=(VulkanPipelineCache&& other) noexcept;
+
+        ~VulkanPipelineCache() = default;
+
+        void save(); // only writes the file when pipelines were added since it was loaded
+
+        [[nodiscard]] const vk::raii::PipelineCache& getPipelineCache() const noexcept;
+
+    private:
+        std::vector<std::byte> readFile(const vk::PhysicalDeviceProperties& properties) const; // empty when the file is missing, invalid or from another device or driver
+
+    private:
+        vk::raii::Device* _device                   { nullptr };
+        vk::raii::PipelineCache _pipelineCache      { nullptr };
+        std::string _filePath;
+        size_t _loadedSize                          { 0 };
+    };
+}
@@ -1,5 +1,10 @@
 #include <SVMV/VulkanRenderer.hxx>
 
+// private copy of the writer, so it does not clash with the one that may be compiled into tinygltf
+#define STB_IMAGE_WRITE_STATIC
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
 using namespace SVMV;
 
 VulkanRenderer::VulkanRenderer(int width, int height, const std::string& name, unsigned framesInFlight, const GLFWwindowWrapper& window)
@@ -16,41 +21,13 @@ VulkanRenderer::VulkanRenderer(int width, int height, const std::string& name, u
     _swapchainExtent = _initilization.getSwapchainExtent();
     _swapchainFormat = _initilization.getSwapchainFormat();
 
-    _commandPool = _initilization.createCommandPool(_device);
-
-    auto graphicsQueuePair = _initilization.createQueue(_device, vkb::QueueType::graphics);
-    _graphicsQueue = std::move(graphicsQueuePair.first);
-    _graphicsQueueIndex = graphicsQueuePair.second;
-
-    auto presentQueuePair = _initilization.createQueue(_device, vkb::QueueType::present);
-    _presentQueue = std::move(presentQueuePair.first);
-    _presentQueueIndex = presentQueuePair.second;
-
-    auto computeQueuePair = _initilization.createQueue(_device, vkb::QueueType::compute);
-    _computeQueue = std::move(computeQueuePair.first);
-    _computeQueueIndex = computeQueuePair.second;
-
-    _descriptorAllocator = VulkanUtilities::DescriptorAllocator(&_device);
-    _descriptorWriter = VulkanDescriptorWriter(&_device);
-    _vmaAllocator = VulkanUtilities::VmaAllocatorWrapper(_instance, _physicalDevice, _device);
-    _immediateSubmit = VulkanUtilities::ImmediateSubmit(&_device, &_graphicsQueue, _graphicsQueueIndex);
-
-    createDepthBuffer();
-    createRenderPass();
+    createQueues();
+    createFrameResources();
 
     _imageViews = _initilization.createSwapchainImageViews(_device);
     _framebuffers = _initilization.createFramebuffers(_device, _renderPass, _imageViews, _depthBuffer.getImageView());
     _imageReadySemaphores = _initilization.createSemaphores(_device, _framesInFlight);
     _renderCompleteSemaphores = _initilization.createSemaphores(_device, _framesInFlight);
-    _inFlightFences = _initilization.createFences(_device, _framesInFlight);
-
-    vk::CommandBufferAllocateInfo commandBufferAllocateInfo;
-    commandBufferAllocateInfo.setLevel(vk::CommandBufferLevel::ePrimary);
-    commandBufferAllocateInfo.setCommandPool(_commandPool);
-    commandBufferAllocateInfo.setCommandBufferCount(_framesInFlight);
-
-    _drawCommandBuffers = vk::raii::CommandBuffers(_device, commandBufferAllocateInfo);
-    createGlobalDescriptorSets();
 
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -132,35 +109,55 @@ VulkanRenderer::VulkanRenderer(int width, int height, const std::string& name, u
     ImGui_ImplVulkan_Init(&init_info);
 
     _imguiFramebuffers = _initilization.createFramebuffers(_device, _imguiRenderPass, _imageViews);
+}
 
-    _light = VulkanLight(
-        glm::vec4(1.0f, 1.0f, 1.0f, 0.0f), glm::vec4(2.0f, 3.0f, 2.0f, 0.0f), &_device, _vmaAllocator.getAllocator(), _lightDescriptorSetLayout, &_descriptorAllocator, &_descriptorWriter, framesInFlight
-    );
+VulkanRenderer::VulkanRenderer(int width, int height, const std::string& name, unsigned framesInFlight)
+    : _framesInFlight(framesInFlight), _headless(true)
+{
+    _instance = _initilization.createInstance(_context, name, 1, 3, true);
+    _messenger = _initilization.createDebugMessenger(_instance);
+
+    _physicalDevice = _initilization.createPhysicalDevice(_instance, std::vector<const char*>{ vk::KHRBufferDeviceAddressExtensionName });
+    _device = _initilization.createDevice(_physicalDevice);
+
+    _swapchainExtent = vk::Extent2D(width, height);
+    _swapchainFormat = vk::Format::eR8G8B8A8Srgb;
+
+    createQueues();
+    createFrameResources();
+    createOffscreenTarget();
+
+    updateLightData();
 }
 
 VulkanRenderer::~VulkanRenderer()
 {
-    ImGui_ImplVulkan_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
+    if (_sceneLoad.valid())
+    {
+        _sceneLoad.wait(); // the loading thread uses the device and the upload manager
+    }
+
+    _pipelineCache.save();
+
+    if (!_headless)
+    {
+        ImGui_ImplVulkan_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui::DestroyContext();
+    }
 }
 
 void VulkanRenderer::draw()
 {
-    if (!_requestedScenePath.empty())
+    if (_headless)
     {
-        try
-        {
-            loadScene(Loader::loadScene(_requestedScenePath));
-        }
-        catch (...)
-        {
-            std::cout << "Error loading glTF file: " << _requestedScenePath << "; skipping model." << std::endl;
-        }
+        drawHeadless();
 
-        _requestedScenePath.clear();
+        return;
     }
 
+    updateSceneLoading();
+
     // wait for this frame index's render to be finished
     vk::Result waitForFencesResult = _device.waitForFences(*_inFlightFences[_activeFrame], vk::True, UINT64_MAX);
 
@@ -169,6 +166,10 @@ void VulkanRenderer::draw()
         throw std::runtime_error("vulkan: failure waiting for fences");
     }
 
+    releaseRetiredScenes();
+
+    _cullStatistics = _drawCulling.getStatistics(_activeFrame);
+
     // acquire an image for color output
     vk::AcquireNextImageInfoKHR acquireNextImageInfo;
     acquireNextImageInfo.setSwapchain(_swapchain);
@@ -193,32 +194,43 @@ void VulkanRenderer::draw()
 
     _device.resetFences(*_inFlightFences[_activeFrame]);
 
-    // set the current frame's camera matrix descriptor set
-    ShaderStructures::GlobalUniformBuffer globalUniformBuffer;
-    globalUniformBuffer.View = _viewMatrix;
-    globalUniformBuffer.ViewProjection = _projectionMatrix * _viewMatrix;
-    globalUniformBuffer.CameraPosition = glm::vec4(_cameraPosition.x, _cameraPosition.y, _cameraPosition.z, 0.0f);
-
-    _globalDescriptorSetBuffers[_activeFrame].setData(&globalUniformBuffer, sizeof(ShaderStructures::GlobalUniformBuffer));
+    updateFrameUniforms(_activeFrame);
 
-    _descriptorWriter.writeBuffer(_globalDescriptorSets[_activeFrame], _globalDescriptorSetBuffers[_activeFrame], 0, 0, sizeof(ShaderStructures::GlobalUniformBuffer), vk::DescriptorType::eUniformBuffer);
+    if (_hostCulling)
+    {
+        _drawCulling.cullOnHost(*_scene, _activeFrame, _projectionMatrix * _viewMatrix, _frustumCulling, *_recordingThreadPool);
+    }
 
-    // update this frame's light descriptor set
-    _light.updateLightDescriptor(_activeFrame);
+    // submitted first, so it sees the same settings as the draw commands, which the UI may change while they are recorded
+    bool waitForCulling = submitCulling(_activeFrame);
 
     // record draw command buffers
     _drawCommandBuffers[_activeFrame].reset();
     recordDrawCommands(_activeFrame, _framebuffers[acquireResult.second], _imguiFramebuffers[acquireResult.second]);
 
     // submit command buffer to graphics queue for execution
+    std::array<vk::Semaphore, 2> waitSemaphores = { *(_imageReadySemaphores[_activeFrame]), nullptr };
+    std::array<vk::PipelineStageFlags, 2> waitDstStageFlags = { vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eDrawIndirect };
+
+    if (waitForCulling)
+    {
+        waitSemaphores[1] = *(_cullCompleteSemaphores[_activeFrame]);
+    }
+
+    uint32_t waitSemaphoreCount = waitForCulling ? 2 : 1;
+
     vk::SubmitInfo submitInfo;
-    submitInfo.setWaitSemaphores(*(_imageReadySemaphores[_activeFrame]));
-    vk::PipelineStageFlags waitDstStageFlags = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-    submitInfo.setWaitDstStageMask(waitDstStageFlags);
+    submitInfo.setWaitSemaphoreCount(waitSemaphoreCount);
+    submitInfo.setPWaitSemaphores(waitSemaphores.data());
+    submitInfo.setPWaitDstStageMask(waitDstStageFlags.data());
     submitInfo.setCommandBuffers(*(_drawCommandBuffers[_activeFrame]));
     submitInfo.setSignalSemaphores(*(_renderCompleteSemaphores[_activeFrame]));
 
-    _graphicsQueue.submit(submitInfo, *_inFlightFences[_activeFrame]);
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex); // the upload manager submits from the loading thread
+
+        _graphicsQueue.submit(submitInfo, *_inFlightFences[_activeFrame]);
+    }
 
     // present the frame to the screen
     vk::PresentInfoKHR presentInfo;
@@ -228,6 +240,8 @@ void VulkanRenderer::draw()
 
     try
     {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+
         _presentQueue.presentKHR(presentInfo);
     }
     catch (vk::OutOfDateKHRError)
@@ -245,18 +259,36 @@ void VulkanRenderer::draw()
 
 void VulkanRenderer::loadScene(std::shared_ptr<Scene> scene)
 {
-    _device.waitIdle(); // wait here for all the frames to finish rendering and presenting
+    if (_sceneLoad.valid())
+    {
+        _sceneLoad.wait(); // the upload manager can only be used by one thread at a time, the result of the pending load is replaced below
+        _sceneLoad = std::future<std::unique_ptr<VulkanScene>>();
+        _loadingScenePath.clear();
+    }
+
+    swapScene(createVulkanScene(scene, _loadOptions.threadCount));
+}
+
+void VulkanRenderer::requestScene(const std::string& filePath)
+{
+    _requestedScenePath = filePath;
+}
+
+void VulkanRenderer::waitIdle()
+{
+    if (_sceneLoad.valid())
+    {
+        _sceneLoad.wait();
+    }
 
-    _scene = VulkanScene();
+    std::lock_guard<std::mutex> lock(_queueMutex);
 
-    preprocessScene(scene);
-    generateDrawablesFromScene(scene->root, scene->root->transform);
-    copyStagingBuffersToGPUBuffers();
+    _device.waitIdle();
 }
 
 void VulkanRenderer::setCamera(glm::vec3 position, glm::vec3 lookDirection, glm::vec3 upDirection, float fieldOfView)
 {
-    _projectionMatrix = glm::perspective(glm::radians(fieldOfView), (float)_swapchainExtent.width / (float)_swapchainExtent.height, 0.01f, 100.0f);
+    _projectionMatrix = glm::perspective(glm::radians(fieldOfView), (float)_swapchainExtent.width / (float)_swapchainExtent.height, nearPlane, farPlane);
     _projectionMatrix[1][1] *= -1;
 
     _viewMatrix = glm::lookAt(position, position + lookDirection, upDirection);
@@ -264,66 +296,470 @@ void VulkanRenderer::setCamera(glm::vec3 position, glm::vec3 lookDirection, glm:
     _cameraPosition = position;
 }
 
+void VulkanRenderer::setLoadOptions(const Loader::LoadOptions& options)
+{
+    _loadOptions = options;
+
+    if (_loadOptions.compressTextures && !_initilization.supportsTextureCompressionBC())
+    {
+        std::cout << "VulkanRenderer: the device does not support BC textures, loading textures uncompressed" << std::endl;
+
+        _loadOptions.compressTextures = false;
+    }
+}
+
+const Loader::LoadOptions& VulkanRenderer::getLoadOptions() const noexcept
+{
+    return _loadOptions;
+}
+
+void VulkanRenderer::saveFrame(const std::string& filePath)
+{
+    if (!_headless)
+    {
+        throw std::runtime_error("VulkanRenderer: frames can only be saved in headless mode");
+    }
+
+    waitIdle(); // the offscreen image holds the most recently submitted frame once the queue is idle
+
+    VulkanReadbackBuffer readbackBuffer(&_device, _vmaAllocator.getAllocator(), _swapchainExtent.width * _swapchainExtent.height * 4);
+
+    vk::ImageMemoryBarrier toTransferBarrier;
+    toTransferBarrier.setOldLayout(vk::ImageLayout::eColorAttachmentOptimal);
+    toTransferBarrier.setNewLayout(vk::ImageLayout::eTransferSrcOptimal);
+    toTransferBarrier.setSrcAccessMask(vk::AccessFlagBits::eColorAttachmentWrite);
+    toTransferBarrier.setDstAccessMask(vk::AccessFlagBits::eTransferRead);
+    toTransferBarrier.setImage(_offscreenImage.getImage());
+    toTransferBarrier.setSubresourceRange(vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 });
+
+    vk::BufferImageCopy bufferImageCopy;
+    bufferImageCopy.setBufferOffset(0);
+    bufferImageCopy.setBufferRowLength(0);
+    bufferImageCopy.setBufferImageHeight(0);
+    bufferImageCopy.setImageSubresource(vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, 0, 0, 1 });
+    bufferImageCopy.setImageOffset(vk::Offset3D{ 0, 0, 0 });
+    bufferImageCopy.setImageExtent(_offscreenImage.getExtent());
+
+    vk::BufferMemoryBarrier toHostBarrier;
+    toHostBarrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+    toHostBarrier.setDstAccessMask(vk::AccessFlagBits::eHostRead);
+    toHostBarrier.setBuffer(readbackBuffer.getBuffer());
+    toHostBarrier.setOffset(0);
+    toHostBarrier.setSize(VK_WHOLE_SIZE);
+
+    vk::raii::Fence* fence = _immediateSubmit.submit([&](vk::CommandBuffer commandBuffer)
+        {
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, toTransferBarrier);
+            commandBuffer.copyImageToBuffer(_offscreenImage.getImage(), vk::ImageLayout::eTransferSrcOptimal, readbackBuffer.getBuffer(), bufferImageCopy);
+            commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, nullptr, toHostBarrier, nullptr);
+        });
+
+    vk::Result waitForFencesResult = _device.waitForFences(**fence, true, UINT64_MAX);
+
+    if (waitForFencesResult != vk::Result::eSuccess)
+    {
+        throw std::runtime_error("vulkan: failure waiting for fences");
+    }
+
+    // the offscreen image is sRGB encoded, so the bytes can be written out as-is
+    int result = stbi_write_png(
+        filePath.c_str(), _swapchainExtent.width, _swapchainExtent.height, 4, readbackBuffer.getData(), _swapchainExtent.width * 4
+    );
+
+    if (result == 0)
+    {
+        throw std::runtime_error("stb_image_write: failed to write file: " + filePath);
+    }
+}
+
 const vk::Device VulkanRenderer::getDevice() const noexcept
 {
     return (*_device);
 }
 
-void VulkanRenderer::recordDrawCommands(int activeFrame, const vk::raii::Framebuffer& framebuffer, const vk::raii::Framebuffer& imguiFramebuffer)
+void VulkanRenderer::setOcclusionCulling(bool enabled)
 {
-    ShaderStructures::PushConstants constants;
+    _occlusionCulling = enabled;
+    _hostCulling = _hostCulling && !enabled;
+}
+
+void VulkanRenderer::setHostCulling(bool enabled)
+{
+    _hostCulling = enabled;
+    _occlusionCulling = _occlusionCulling && !enabled;
+}
+
+ShaderStructures::CullStatistics VulkanRenderer::getCullStatistics()
+{
+    return _drawCulling.getStatistics((_activeFrame + _framesInFlight - 1) % _framesInFlight);
+}
+
+void VulkanRenderer::setScatteredLightCount(uint32_t count)
+{
+    _scatteredLightCount = static_cast<int>(std::min<size_t>(count, VulkanLight::maxLightCount - _lightSettings.size()));
+
+    // a fixed seed, so the lights stay in place when the count changes
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<float> offset(-_scatteredLightExtent, _scatteredLightExtent);
+    std::uniform_real_distribution<float> channel(0.0f, 1.0f);
+
+    _scatteredLights.resize(_scatteredLightCount);
+
+    for (auto& light : _scatteredLights)
+    {
+        glm::vec3 color(channel(generator), channel(generator), channel(generator));
+
+        light.flux = glm::vec4(color / std::max({ color.r, color.g, color.b, 0.001f }), 0.25f);
+        light.position = glm::vec4(offset(generator), offset(generator), offset(generator), VulkanLight::getRange(light.flux));
+    }
+}
+
+void VulkanRenderer::drawHeadless()
+{
+    vk::Result waitForFencesResult = _device.waitForFences(*_inFlightFences[_activeFrame], vk::True, UINT64_MAX);
 
+    if (waitForFencesResult != vk::Result::eSuccess)
+    {
+        throw std::runtime_error("vulkan: failure waiting for fences");
+    }
+
+    releaseRetiredScenes();
+
+    _cullStatistics = _drawCulling.getStatistics(_activeFrame);
+
+    _device.resetFences(*_inFlightFences[_activeFrame]);
+
+    updateLightData();
+    updateFrameUniforms(_activeFrame);
+
+    if (_hostCulling)
+    {
+        _drawCulling.cullOnHost(*_scene, _activeFrame, _projectionMatrix * _viewMatrix, _frustumCulling, *_recordingThreadPool);
+    }
+
+    _drawCommandBuffers[_activeFrame].reset();
+    _drawCommandBuffers[_activeFrame].begin(vk::CommandBufferBeginInfo());
+
+    if (*_computeQueue == nullptr)
+    {
+        recordComputeCommands(_drawCommandBuffers[_activeFrame], _activeFrame, true);
+    }
+
+    recordSceneCommands(_activeFrame, _framebuffers[0]);
+    _drawCommandBuffers[_activeFrame].end();
+
+    bool waitForCulling = submitCulling(_activeFrame);
+
+    // no acquire or present, the frame only has to finish before its fence is waited on
+    vk::PipelineStageFlags waitDstStageFlags = vk::PipelineStageFlagBits::eDrawIndirect;
+
+    vk::SubmitInfo submitInfo;
+    submitInfo.setCommandBuffers(*(_drawCommandBuffers[_activeFrame]));
+
+    if (waitForCulling)
+    {
+        submitInfo.setWaitSemaphores(*(_cullCompleteSemaphores[_activeFrame]));
+        submitInfo.setWaitDstStageMask(waitDstStageFlags);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+
+        _graphicsQueue.submit(submitInfo, *_inFlightFences[_activeFrame]);
+    }
+
+    _activeFrame = (_activeFrame + 1) % _framesInFlight;
+}
+
+void VulkanRenderer::updateFrameUniforms(int activeFrame)
+{
+    // the frame's fence has been waited for, so the GPU no longer reads its previous allocations
+    _frameAllocator.beginFrame(activeFrame);
+
+    ShaderStructures::GlobalUniformBuffer globalUniformBuffer;
+    globalUniformBuffer.View = _viewMatrix;
+    globalUniformBuffer.ViewProjection = _projectionMatrix * _viewMatrix;
+    globalUniformBuffer.CameraPosition = glm::vec4(_cameraPosition.x, _cameraPosition.y, _cameraPosition.z, 0.0f);
+
+    FrameUniformOffsets& offsets = _frameUniformOffsets[activeFrame];
+    offsets.global = _frameAllocator.push(globalUniformBuffer);
+
+    // the clustering pass of the frame reads the light array and writes the light lists the fragment shaders read
+    offsets.lights = _light.pushLights(_frameAllocator);
+    offsets.lightCount = _light.getLightCount();
+    offsets.light = _light.pushLightParameters(
+        _frameAllocator, offsets.lights, _lightClustering.getClusterLightsAddress(activeFrame), VulkanLightClustering::getClusterParameters(_swapchainExtent, nearPlane, farPlane)
+    );
+
+    _frameAllocator.flush();
+}
+
+void VulkanRenderer::updateLightData()
+{
+    _light.lights.clear();
+
+    // disabled lights are left out, they would only take up room in the light lists of the clusters
+    for (int i = 0; i < _lightSettings.size(); i++)
+    {
+        const OrbitingLightSettings& settings = _lightSettings[i];
+
+        if (settings.strength <= 0.0f)
+        {
+            continue;
+        }
+
+        ShaderStructures::PointLight light;
+        light.flux = glm::vec4(settings.color, settings.strength);
+        light.position = glm::vec4(
+            _lightOrbitCenter.x + settings.distance * sin(settings.polar) * cos(settings.azimuthal),
+            _lightOrbitCenter.y + settings.distance * cos(settings.polar),
+            _lightOrbitCenter.z + settings.distance * sin(settings.polar) * sin(settings.azimuthal),
+            VulkanLight::getRange(light.flux)
+        );
+
+        _light.lights.push_back(light);
+    }
+
+    for (int i = 0; i < _scatteredLightCount; i++)
+    {
+        ShaderStructures::PointLight light = _scatteredLights[i];
+        light.position += glm::vec4(_lightOrbitCenter, 0.0f);
+
+        _light.lights.push_back(light);
+    }
+
+    _light.ambient = glm::vec4(_ambientColor, _ambientStrength);
+}
+
+void VulkanRenderer::recordDrawCommands(int activeFrame, const vk::raii::Framebuffer& framebuffer, const vk::raii::Framebuffer& imguiFramebuffer)
+{
     _drawCommandBuffers[activeFrame].begin(vk::CommandBufferBeginInfo());
 
+    if (*_computeQueue == nullptr)
+    {
+        recordComputeCommands(_drawCommandBuffers[activeFrame], activeFrame, true);
+    }
+
+    recordSceneCommands(activeFrame, framebuffer);
+    recordImguiCommands(activeFrame, imguiFramebuffer);
+
+    _drawCommandBuffers[activeFrame].end();
+}
+
+void VulkanRenderer::recordSceneCommands(int activeFrame, const vk::raii::Framebuffer& framebuffer)
+{
+    RecordedScenePass& recordedScenePass = _recordedScenePasses[activeFrame];
+    const FrameUniformOffsets& offsets = _frameUniformOffsets[activeFrame];
+
+    // camera, lights and culling results are read from buffers, so a static scene needs no recording at all
+    bool reuse = _reuseSceneCommands && recordedScenePass.valid && recordedScenePass.globalOffset == offsets.global && recordedScenePass.lightOffset == offsets.light;
+
+    if (!reuse)
+    {
+        recordScenePass(activeFrame);
+    }
+
+    std::vector<vk::CommandBuffer> secondaryCommandBuffers;
+
+    for (size_t chunk = 0; chunk < recordedScenePass.chunkCount; chunk++)
+    {
+        secondaryCommandBuffers.push_back(*_recordingCommandBuffers[activeFrame * _recordingThreadCount + chunk]);
+    }
+
+    const vk::raii::CommandBuffer& commandBuffer = _drawCommandBuffers[activeFrame];
+
     vk::RenderPassBeginInfo renderPassBeginInfo;
-    renderPassBeginInfo.setRenderPass(_renderPass);
+    renderPassBeginInfo.setRenderPass(_occlusionCulling ? _earlyRenderPass : _renderPass);
     renderPassBeginInfo.setFramebuffer(framebuffer);
     renderPassBeginInfo.setRenderArea(vk::Rect2D(vk::Offset2D(0, 0), _swapchainExtent));
 
-    glm::vec3 backgroundColor = glm::vec3(_light.lightData.ambient.x, _light.lightData.ambient.y, _light.lightData.ambient.z) * 0.3f;
+    glm::vec3 backgroundColor = glm::vec3(_light.ambient.x, _light.ambient.y, _light.ambient.z) * 0.3f;
 
     vk::ClearValue clearValues[2] = { vk::ClearColorValue(backgroundColor.x, backgroundColor.y, backgroundColor.z, 1.0f), vk::ClearDepthStencilValue(1.0f, 0.0f) };
     renderPassBeginInfo.setClearValues(clearValues);
 
-    _drawCommandBuffers[activeFrame].beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eInline);
+    if (!_occlusionCulling)
+    {
+        commandBuffer.beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eSecondaryCommandBuffers);
+        commandBuffer.executeCommands(secondaryCommandBuffers);
+        commandBuffer.endRenderPass();
+
+        return;
+    }
+
+    // the instances visible in the previous frame are drawn first, the rest is tested against the depth they leave behind and drawn on top,
+    // both passes draw from the same indirect buffers, so they execute the same secondary command buffers
+    vk::DeviceAddress camera = _frameAllocator.getAddress(_frameUniformOffsets[activeFrame].global);
+
+    _drawCulling.recordCulling(commandBuffer, *_scene, activeFrame, camera, _frustumCulling, VulkanDrawCulling::CullPass::EARLY, _depthPyramid);
+
+    commandBuffer.beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eSecondaryCommandBuffers);
+    commandBuffer.executeCommands(secondaryCommandBuffers);
+    commandBuffer.endRenderPass();
+
+    _depthPyramid.recordBuild(commandBuffer);
+
+    _drawCulling.recordCulling(commandBuffer, *_scene, activeFrame, camera, _frustumCulling, VulkanDrawCulling::CullPass::LATE, _depthPyramid);
+
+    renderPassBeginInfo.setRenderPass(_lateRenderPass);
+
+    commandBuffer.beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eSecondaryCommandBuffers);
+    commandBuffer.executeCommands(secondaryCommandBuffers);
+    commandBuffer.endRenderPass();
+}
+
+void VulkanRenderer::recordScenePass(int activeFrame)
+{
+    std::vector<RecordedBatch> batches;
+
+    for (const auto& context : _scene->contexts)
+    {
+        for (const auto& batch : context.second.batches)
+        {
+            batches.push_back({ &context.second, &batch, &context.second.material->getPipeline(batch.features) });
+        }
+    }
+
+    size_t chunkCount = std::clamp<size_t>(batches.size() / minBatchesPerChunk, 1, _recordingThreadCount);
+    size_t chunkSize = (batches.size() + chunkCount - 1) / chunkCount;
+
+    // no framebuffer, the buffers of a frame index are executed with whichever swapchain image is acquired
+    vk::CommandBufferInheritanceInfo inheritanceInfo;
+    inheritanceInfo.setRenderPass(_renderPass);
+    inheritanceInfo.setSubpass(0);
 
+    // every chunk uses the pool of its own slot, so no pool is accessed by two threads at once
+    auto recordChunk = [&](size_t chunk)
+    {
+        size_t slot = activeFrame * _recordingThreadCount + chunk;
+        size_t begin = std::min(chunk * chunkSize, batches.size());
+        size_t end = std::min(begin + chunkSize, batches.size());
+
+        _recordingCommandPools[slot].reset();
+
+        // executed twice per frame with occlusion culling
+        vk::CommandBufferBeginInfo beginInfo;
+        beginInfo.setFlags(vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eSimultaneousUse);
+        beginInfo.setPInheritanceInfo(&inheritanceInfo);
+
+        _recordingCommandBuffers[slot].begin(beginInfo);
+        recordBatches(_recordingCommandBuffers[slot], activeFrame, std::span<const RecordedBatch>(batches).subspan(begin, end - begin));
+        _recordingCommandBuffers[slot].end();
+    };
+
+    if (chunkCount == 1)
+    {
+        recordChunk(0);
+    }
+    else
+    {
+        _recordingThreadPool->parallelFor(chunkCount, recordChunk);
+    }
+
+    RecordedScenePass& recordedScenePass = _recordedScenePasses[activeFrame];
+    recordedScenePass.valid = true;
+    recordedScenePass.chunkCount = chunkCount;
+    recordedScenePass.globalOffset = _frameUniformOffsets[activeFrame].global;
+    recordedScenePass.lightOffset = _frameUniformOffsets[activeFrame].light;
+}
+
+void VulkanRenderer::invalidateSceneCommands()
+{
+    for (auto& recordedScenePass : _recordedScenePasses)
+    {
+        recordedScenePass.valid = false;
+    }
+}
+
+void VulkanRenderer::recordBatches(const vk::raii::CommandBuffer& commandBuffer, int activeFrame, std::span<const RecordedBatch> batches) const
+{
+    // secondary command buffers inherit no state, not even the dynamic one
     vk::Viewport viewport(0.0f, 0.0f, _swapchainExtent.width, _swapchainExtent.height, 0.0f, 1.0f);
-    _drawCommandBuffers[activeFrame].setViewport(0, viewport);
+    commandBuffer.setViewport(0, viewport);
 
     vk::Rect2D scissor(vk::Offset2D(0, 0), _swapchainExtent);
-    _drawCommandBuffers[activeFrame].setScissor(0, scissor);
+    commandBuffer.setScissor(0, scissor);
 
-    for (const auto& context : _scene.contexts)
+    if (batches.empty())
     {
-        _drawCommandBuffers[activeFrame].bindPipeline(vk::PipelineBindPoint::eGraphics, *context.second.pipeline);
+        return;
+    }
 
-        _drawCommandBuffers[activeFrame].bindIndexBuffer(_scene.indexGPUBuffer.getBuffer(), vk::DeviceSize(0), vk::IndexType::eUint32);
+    ShaderStructures::PushConstants constants;
+    constants.drawData = _scene->drawDataGPUBuffer.getAddress(_device);
+    constants.visibleInstances = _scene->visibleInstanceGPUBuffers[activeFrame].getAddress(_device);
+    constants.modelMatrices = _scene->modelMatrixGPUBuffer.getAddress(_device);
+    constants.normalMatrices = _scene->normalMatrixGPUBuffer.getAddress(_device);
 
-        _drawCommandBuffers[activeFrame].bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *context.second.pipelineLayout, 0, *_globalDescriptorSets[activeFrame], nullptr);
+    commandBuffer.bindIndexBuffer(_scene->indexGPUBuffer.getBuffer(), vk::DeviceSize(0), vk::IndexType::eUint32);
 
-        _drawCommandBuffers[activeFrame].bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *context.second.pipelineLayout, 1, **_light.getDescriptorSet(activeFrame), nullptr);
+    const VulkanMaterialContext* boundContext = nullptr;
 
-        for (const auto& drawable : context.second.drawables)
+    for (const auto& recordedBatch : batches)
+    {
+        // the material set holds the parameters and textures of all materials, so the sets are bound once for all draws of the context
+        if (recordedBatch.context != boundContext)
         {
-            _drawCommandBuffers[activeFrame].bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *context.second.pipelineLayout, 2, drawable.descriptorSet, nullptr);
-
-            constants.positions = drawable.attributeAddresses.positions;
-            constants.normals = drawable.attributeAddresses.normals;
-            constants.tangents = drawable.attributeAddresses.tangents;
-            constants.texcoords_0 = drawable.attributeAddresses.texcoords_0;
-            constants.colors_0 = drawable.attributeAddresses.colors_0;
-            constants.modelMatrix = drawable.modelMatrixAddress;
-            constants.normalMatrix = drawable.normalMatrixAddress;
-
-            _drawCommandBuffers[activeFrame].pushConstants<ShaderStructures::PushConstants>(*context.second.pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, constants);
-            _drawCommandBuffers[activeFrame].drawIndexed(drawable.indexCount, 1, drawable.firstIndex, 0, 0);
+            vk::DescriptorSet descriptorSets[3] = { *_globalDescriptorSet, *_light.getDescriptorSet(), **recordedBatch.context->descriptorSet };
+            uint32_t dynamicOffsets[2] = { _frameUniformOffsets[activeFrame].global, _frameUniformOffsets[activeFrame].light };
+
+            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *recordedBatch.context->pipelineLayout, 0, descriptorSets, dynamicOffsets);
+            commandBuffer.pushConstants<ShaderStructures::PushConstants>(*recordedBatch.context->pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, constants);
+
+            boundContext = recordedBatch.context;
         }
+
+        // the draws were written by the culling pass, one indirect call per batch with the pipeline of its permutation
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, **recordedBatch.pipeline);
+
+        _drawCulling.recordDraws(commandBuffer, *_scene, *recordedBatch.batch, activeFrame);
     }
+}
 
-    _drawCommandBuffers[activeFrame].endRenderPass();
+void VulkanRenderer::recordComputeCommands(const vk::raii::CommandBuffer& commandBuffer, int activeFrame, bool sameQueue)
+{
+    const FrameUniformOffsets& offsets = _frameUniformOffsets[activeFrame];
+
+    // occlusion culling depends on the depth of the frame, so it is recorded with the scene pass instead
+    if (_hostCulling)
+    {
+        _drawCulling.recordHostCulling(commandBuffer, *_scene, activeFrame);
+    }
+    else if (!_occlusionCulling)
+    {
+        _drawCulling.recordCulling(
+            commandBuffer, *_scene, activeFrame, _frameAllocator.getAddress(offsets.global), _frustumCulling, VulkanDrawCulling::CullPass::FULL, _depthPyramid
+        );
+    }
+    _lightClustering.recordClustering(commandBuffer, activeFrame, _viewMatrix, _projectionMatrix, nearPlane, farPlane, offsets.lights, offsets.lightCount, sameQueue);
+}
+
+bool VulkanRenderer::submitCulling(int activeFrame)
+{
+    if (*_computeQueue == nullptr || _scene->drawCount == 0)
+    {
+        return false;
+    }
 
-    // imgui render pass
+    // the compute queue is otherwise idle, so culling the next frame overlaps with the graphics work still in flight
+    _cullCommandBuffers[activeFrame].reset();
+    _cullCommandBuffers[activeFrame].begin(vk::CommandBufferBeginInfo());
+    recordComputeCommands(_cullCommandBuffers[activeFrame], activeFrame, false);
+    _cullCommandBuffers[activeFrame].end();
 
+    vk::SubmitInfo submitInfo;
+    submitInfo.setCommandBuffers(*(_cullCommandBuffers[activeFrame]));
+    submitInfo.setSignalSemaphores(*(_cullCompleteSemaphores[activeFrame]));
+
+    std::lock_guard<std::mutex> lock(_queueMutex);
+
+    _computeQueue.submit(submitInfo);
+
+    return true;
+}
+
+void VulkanRenderer::recordImguiCommands(int activeFrame, const vk::raii::Framebuffer& imguiFramebuffer)
+{
     ImGui_ImplVulkan_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
@@ -359,6 +795,31 @@ void VulkanRenderer::recordDrawCommands(int activeFrame, const vk::raii::Framebu
 
                 ImGuiFileDialog::Instance()->Close();
             }
+            if (!_loadingScenePath.empty())
+            {
+                ImGui::TextWrapped("Loading %s...", _loadingScenePath.c_str());
+            }
+            ImGui::Dummy(ImVec2(0.0f, 10.0f));
+
+            ImGui::SeparatorText("Rendering:");
+            ImGui::Checkbox("Frustum culling", &_frustumCulling);
+            if (ImGui::Checkbox("Occlusion culling", &_occlusionCulling))
+            {
+                setOcclusionCulling(_occlusionCulling);
+            }
+            if (ImGui::Checkbox("CPU culling", &_hostCulling))
+            {
+                setHostCulling(_hostCulling);
+            }
+            ImGui::Checkbox("Reuse scene commands", &_reuseSceneCommands);
+            ImGui::Text("%u instances in %u draws, %u batches", _scene->instanceCount, _scene->drawCount, _scene->batchCount);
+
+            if (_scene->drawCount > 0)
+            {
+                ImGui::Text("Drawn: %u instances, %u triangles, %u commands", _cullStatistics.drawnInstances, _cullStatistics.drawnTriangles, _cullStatistics.drawnCommands);
+                ImGui::Text("Frustum culled: %u instances, %u triangles", _cullStatistics.frustumCulledInstances, _cullStatistics.frustumCulledTriangles);
+                ImGui::Text("Occlusion culled: %u instances, %u triangles", _cullStatistics.occlusionCulledInstances, _cullStatistics.occlusionCulledTriangles);
+            }
             ImGui::Dummy(ImVec2(0.0f, 10.0f));
 
             ImGui::SeparatorText("Controls:");
@@ -393,67 +854,49 @@ void VulkanRenderer::recordDrawCommands(int activeFrame, const vk::raii::Framebu
             ImGui::BeginGroup();
 
             float sensitivity = 0.02f;
-            static ImVec4 lightOrbitCenter = ImVec4(0.0f, 0.0f, 0.0f, 0.0f);
-            ImGui::DragFloat("X", &lightOrbitCenter.x, sensitivity);
-            ImGui::DragFloat("Y", &lightOrbitCenter.y, sensitivity);
-            ImGui::DragFloat("Z", &lightOrbitCenter.z, sensitivity);
+            ImGui::DragFloat("X", &_lightOrbitCenter.x, sensitivity);
+            ImGui::DragFloat("Y", &_lightOrbitCenter.y, sensitivity);
+            ImGui::DragFloat("Z", &_lightOrbitCenter.z, sensitivity);
 
             ImGui::EndGroup();
 
-            ImGui::Dummy(ImVec2(0.0f, 10.0f));
-            ImGui::SeparatorText("Light #1");
-            ImGui::BeginGroup();
-
-                static ImVec4 color0 = ImVec4(103.0f / 255.0f, 18.0f / 255.0f, 211.0f / 255.0f, 1.0f);
-                ImGui::ColorEdit3("Color 1", (float*)&color0);
-
-                static float strength0 = 3.5f;
-                ImGui::SliderFloat("Strength 1", &strength0, 0.0f, 10.0f);
-
-                static float distance0 = 1.0f;
-                ImGui::SliderFloat("Distance 1", &distance0, 0.1f, 20.0f);
-                static float azimuthal0 = 0.514f;
-                ImGui::SliderFloat("Azimuthal Angle 1", &azimuthal0, -2 * 3.141592f, 2 * 3.141592f);
-                static float polar0 = 1.5f;
-                ImGui::SliderFloat("Polar Angle 1", &polar0, 0.0f, 3.141592f);
-
-            ImGui::EndGroup();
+            for (int i = 0; i < _lightSettings.size(); i++)
+            {
+                std::string suffix = " " + std::to_string(i + 1);
+                OrbitingLightSettings& settings = _lightSettings[i];
 
-            ImGui::Dummy(ImVec2(0.0f, 10.0f));
-            ImGui::SeparatorText("Light #2");
-            ImGui::BeginGroup();
+                ImGui::Dummy(ImVec2(0.0f, 10.0f));
+                ImGui::SeparatorText(("Light #" + std::to_string(i + 1)).c_str());
+                ImGui::BeginGroup();
 
-                static ImVec4 color1 = ImVec4(201.0f / 255.0f, 7.0f / 255.0f, 7.0f / 255.0f, 1.0f);
-                ImGui::ColorEdit3("Color 2", (float*)&color1);
+                    ImGui::ColorEdit3(("Color" + suffix).c_str(), &settings.color.x);
 
-                static float strength1 = 2.0f;
-                ImGui::SliderFloat("Strength 2", &strength1, 0.0f, 10.0f);
+                    ImGui::SliderFloat(("Strength" + suffix).c_str(), &settings.strength, 0.0f, 10.0f);
 
-                static float distance1 = 1.0f;
-                ImGui::SliderFloat("Distance 2", &distance1, 0.1f, 20.0f);
-                static float azimuthal1 = -0.22f;
-                ImGui::SliderFloat("Azimuthal Angle 2", &azimuthal1, -2 * 3.141592f, 2 * 3.141592f);
-                static float polar1 = 1.977f;
-                ImGui::SliderFloat("Polar Angle 2", &polar1, 0.0f, 3.141592f);
+                    ImGui::SliderFloat(("Distance" + suffix).c_str(), &settings.distance, 0.1f, 20.0f);
+                    ImGui::SliderFloat(("Azimuthal Angle" + suffix).c_str(), &settings.azimuthal, -2 * 3.141592f, 2 * 3.141592f);
+                    ImGui::SliderFloat(("Polar Angle" + suffix).c_str(), &settings.polar, 0.0f, 3.141592f);
 
-            ImGui::EndGroup();
+                ImGui::EndGroup();
+            }
 
             ImGui::Dummy(ImVec2(0.0f, 10.0f));
-            ImGui::SeparatorText("Light #3");
+            ImGui::SeparatorText("Scattered Lights");
             ImGui::BeginGroup();
 
-                static ImVec4 color2 = ImVec4(37.0f / 255.0f, 200.0f / 255.0f, 42.0f / 255.0f, 1.0f);
-                ImGui::ColorEdit3("Color 3", (float*)&color2);
+                int scatteredLightCount = _scatteredLightCount;
 
-                static float strength2 = 1.67f;
-                ImGui::SliderFloat("Strength 3", &strength2, 0.0f, 10.0f);
+                if (ImGui::SliderInt("Count", &scatteredLightCount, 0, VulkanLight::maxLightCount - static_cast<int>(_lightSettings.size())))
+                {
+                    setScatteredLightCount(scatteredLightCount);
+                }
 
-                static float distance2 = 1.0f;
-                ImGui::SliderFloat("Distance 3", &distance2, 0.1f, 20.0f);
-                static float azimuthal2 = 1.39f;
-                ImGui::SliderFloat("Azimuthal Angle 3", &azimuthal2, -2 * 3.141592f, 2 * 3.141592f);
-                static float polar2 = 1.5f;
-                ImGui::SliderFloat("Polar Angle 3", &polar2, 0.0f, 3.141592f);
+                ImGui::SliderFloat("Extent", &_scatteredLightExtent, 1.0f, 50.0f);
+
+                if (ImGui::IsItemDeactivatedAfterEdit())
+                {
+                    setScatteredLightCount(_scatteredLightCount); // spreads the lights over the new extent
+                }
 
             ImGui::EndGroup();
 
@@ -461,24 +904,13 @@ void VulkanRenderer::recordDrawCommands(int activeFrame, const vk::raii::Framebu
             ImGui::SeparatorText("Ambient Light");
             ImGui::BeginGroup();
 
-                static ImVec4 ambientColor = ImVec4(157.0f / 255.0f, 223.0f / 255.0f, 250.0f / 255.0f, 1.0f);
-                ImGui::ColorEdit3("Ambient Color", (float*)&ambientColor);
+                ImGui::ColorEdit3("Ambient Color", &_ambientColor.x);
 
-                static float ambientStrength = 0.01f;
-                ImGui::SliderFloat("Ambient Strength", &ambientStrength, 0.0f, 0.1f);
+                ImGui::SliderFloat("Ambient Strength", &_ambientStrength, 0.0f, 0.1f);
 
             ImGui::EndGroup();
 
-            _light.lightData.position_0 = glm::vec4(lightOrbitCenter.x + distance0 * sin(polar0) * cos(azimuthal0), lightOrbitCenter.y + distance0 * cos(polar0), lightOrbitCenter.z + distance0 * sin(polar0) * sin(azimuthal0), 0.0f);
-            _light.lightData.flux_0 = glm::vec4(color0.x, color0.y, color0.z, strength0);
-
-            _light.lightData.position_1 = glm::vec4(lightOrbitCenter.x + distance1 * sin(polar1) * cos(azimuthal1), lightOrbitCenter.y + distance1 * cos(polar1), lightOrbitCenter.z + distance1 * sin(polar1) * sin(azimuthal1), 0.0f);
-            _light.lightData.flux_1 = glm::vec4(color1.x, color1.y, color1.z, strength1);
-
-            _light.lightData.position_2 = glm::vec4(lightOrbitCenter.x + distance2 * sin(polar2) * cos(azimuthal2), lightOrbitCenter.y + distance2 * cos(polar2), lightOrbitCenter.z + distance2 * sin(polar2) * sin(azimuthal2), 0.0f);
-            _light.lightData.flux_2 = glm::vec4(color2.x, color2.y, color2.z, strength2);
-
-            _light.lightData.ambient = glm::vec4(ambientColor.x, ambientColor.y, ambientColor.z, ambientStrength);
+            updateLightData();
         }
         ImGui::End();
     }
@@ -502,22 +934,108 @@ void VulkanRenderer::recordDrawCommands(int activeFrame, const vk::raii::Framebu
     ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), *_drawCommandBuffers[activeFrame]);
 
     _drawCommandBuffers[activeFrame].endRenderPass();
+}
 
-    _drawCommandBuffers[activeFrame].end();
+std::unique_ptr<VulkanScene> VulkanRenderer::createVulkanScene(std::shared_ptr<Scene> scene, unsigned threadCount)
+{
+    std::unique_ptr<VulkanScene> vulkanScene = std::make_unique<VulkanScene>();
+    vulkanScene->descriptorWriter = VulkanDescriptorWriter(&_device);
+
+    ThreadPool threadPool(threadCount); // shared by the mipmap generation and the deferred geometry writes
+
+    preprocessScene(scene, *vulkanScene);
+    generateDrawablesFromScene(*vulkanScene, *scene, threadPool);
+    _drawCulling.createDrawBuffers(*vulkanScene, &_uploadManager);
+
+    // the permutations of the scene are created while loading, so no pipeline is compiled while drawing
+    for (auto& context : vulkanScene->contexts)
+    {
+        for (const auto& batch : context.second.batches)
+        {
+            context.second.material->getPipeline(batch.features);
+        }
+    }
+
+    writeDeferredGeometry(scene, *vulkanScene, threadPool);
+    copyStagingBuffersToGPUBuffers(*vulkanScene);
+
+    // the GPU buffers now hold all geometry, neither the staging memory nor the primitives are needed anymore
+    vulkanScene->primitiveDrawableMap.clear();
+    vulkanScene->materialIndices.clear();
+    vulkanScene->indexStagingBuffer = VulkanStagingBuffer();
+    vulkanScene->modelMatrixStagingBuffer = VulkanStagingBuffer();
+    vulkanScene->normalMatrixStagingBuffer = VulkanStagingBuffer();
+
+    for (auto& attribute : vulkanScene->attributes)
+    {
+        attribute.stagingBuffer = VulkanStagingBuffer();
+    }
+
+    return vulkanScene;
+}
+
+void VulkanRenderer::updateSceneLoading()
+{
+    if (_sceneLoad.valid() && _sceneLoad.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        try
+        {
+            swapScene(_sceneLoad.get());
+        }
+        catch (...)
+        {
+            std::cout << "Error loading glTF file: " << _loadingScenePath << "; skipping model." << std::endl;
+        }
+
+        _loadingScenePath.clear();
+    }
+
+    // a request made while another scene is loading is picked up once that load finishes
+    if (!_requestedScenePath.empty() && !_sceneLoad.valid())
+    {
+        _loadingScenePath = _requestedScenePath;
+        _requestedScenePath.clear();
+
+        _sceneLoad = std::async(std::launch::async, [this, filePath = _loadingScenePath, options = _loadOptions]()
+            {
+                return createVulkanScene(Loader::loadScene(filePath, options), options.threadCount);
+            });
+    }
+}
+
+void VulkanRenderer::swapScene(std::unique_ptr<VulkanScene> scene)
+{
+    // frames that are still in flight may reference the current scene, so it is only released once all of them finished
+    _retiredScenes.push_back(RetiredScene{ std::move(_scene), _framesInFlight });
+
+    _scene = std::move(scene);
+
+    invalidateSceneCommands();
 }
 
-void VulkanRenderer::preprocessScene(std::shared_ptr<Scene> scene)
+void VulkanRenderer::releaseRetiredScenes()
+{
+    // called after waiting for the fence of the active frame, after framesInFlight such waits every frame recorded before the swap has finished
+    for (auto& retiredScene : _retiredScenes)
+    {
+        retiredScene.remainingFrames--;
+    }
+
+    std::erase_if(_retiredScenes, [](const RetiredScene& retiredScene) { return retiredScene.remainingFrames <= 0; });
+
+    _textureCache.evictUnused(); // entries of the images only the released scenes used
+}
+
+void VulkanRenderer::preprocessScene(std::shared_ptr<Scene> scene, VulkanScene& vulkanScene)
 {
     std::unordered_map<AttributeType, int> attributeSizeMap;
     int indexSize = 0;
-    int modelMatrixCount = 0;
 
     for (const auto& mesh : scene->meshes)
     {
         for (const auto& primitive : mesh->primitives)
         {
-            indexSize += primitive->indices.size() * sizeof(decltype(primitive->indices)::value_type);
-            modelMatrixCount++;
+            indexSize += primitive->indexCount * sizeof(decltype(primitive->indices)::value_type);
 
             for (const auto& attribute : primitive->attributes)
             {
@@ -538,14 +1056,30 @@ void VulkanRenderer::preprocessScene(std::shared_ptr<Scene> scene)
         throw std::runtime_error("VulkanRenderer: loaded scene must contain indices");
     }
 
-    _scene.indexGPUBuffer = VulkanGPUBuffer(&_device, _vmaAllocator.getAllocator(), indexSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer);
-    _scene.indexStagingBuffer = VulkanStagingBuffer(&_device, _scene.indexGPUBuffer, &_immediateSubmit);
+    // every node referencing a mesh adds an instance of each of its primitives, with its own model and normal matrix
+    int modelMatrixCount = 0;
+
+    for (int32_t meshIndex : scene->nodes.meshIndices)
+    {
+        if (meshIndex != SceneGraph::noMesh)
+        {
+            modelMatrixCount += static_cast<int>(scene->meshes[meshIndex]->primitives.size());
+        }
+    }
+
+    if (modelMatrixCount <= 0)
+    {
+        throw std::runtime_error("VulkanRenderer: loaded scene must contain nodes referencing meshes");
+    }
+
+    vulkanScene.indexGPUBuffer = VulkanGPUBuffer(&_device, _vmaAllocator.getAllocator(), indexSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer);
+    vulkanScene.indexStagingBuffer = VulkanStagingBuffer(&_device, vulkanScene.indexGPUBuffer, &_immediateSubmit);
 
-    _scene.modelMatrixGPUBuffer = VulkanGPUBuffer(&_device, _vmaAllocator.getAllocator(), modelMatrixCount * sizeof(glm::mat4), vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress);
-    _scene.modelMatrixStagingBuffer = VulkanStagingBuffer(&_device, _scene.modelMatrixGPUBuffer, &_immediateSubmit);
+    vulkanScene.modelMatrixGPUBuffer = VulkanGPUBuffer(&_device, _vmaAllocator.getAllocator(), modelMatrixCount * sizeof(glm::mat4), vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress);
+    vulkanScene.modelMatrixStagingBuffer = VulkanStagingBuffer(&_device, vulkanScene.modelMatrixGPUBuffer, &_immediateSubmit);
 
-    _scene.normalMatrixGPUBuffer = VulkanGPUBuffer(&_device, _vmaAllocator.getAllocator(), modelMatrixCount * sizeof(glm::mat4), vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress);
-    _scene.normalMatrixStagingBuffer = VulkanStagingBuffer(&_device, _scene.normalMatrixGPUBuffer, &_immediateSubmit);
+    vulkanScene.normalMatrixGPUBuffer = VulkanGPUBuffer(&_device, _vmaAllocator.getAllocator(), modelMatrixCount * sizeof(glm::mat4), vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress);
+    vulkanScene.normalMatrixStagingBuffer = VulkanStagingBuffer(&_device, vulkanScene.normalMatrixGPUBuffer, &_immediateSubmit);
 
     for (const auto& attributeSize : attributeSizeMap)
     {
@@ -555,111 +1089,349 @@ void VulkanRenderer::preprocessScene(std::shared_ptr<Scene> scene)
         vertexAttribute.gpuBufferAddressCounter = vertexAttribute.gpuBuffer.getAddress(_device);
         vertexAttribute.stagingBuffer = VulkanStagingBuffer(&_device, vertexAttribute.gpuBuffer, &_immediateSubmit);
 
-        _scene.attributes.push_back(std::move(vertexAttribute));
+        vulkanScene.attributes.push_back(std::move(vertexAttribute));
     }
 }
 
-void VulkanRenderer::generateDrawablesFromScene(std::shared_ptr<Node> node, glm::mat4 baseTransform)
+void VulkanRenderer::generateDrawablesFromScene(VulkanScene& vulkanScene, const Scene& scene, ThreadPool& threadPool)
 {
-    if (node->mesh != nullptr)
+    const SceneGraph& nodes = scene.nodes;
+
+    for (size_t nodeIndex = 0; nodeIndex < nodes.getNodeCount(); nodeIndex++)
     {
-        for (const auto& primitive : node->mesh->primitives)
+        if (nodes.meshIndices[nodeIndex] == SceneGraph::noMesh)
         {
-            VulkanDrawable drawable;
+            continue;
+        }
 
-            if (_scene.primitiveDrawableMap.find(primitive) != _scene.primitiveDrawableMap.end())
-            {
-                drawable = _scene.primitiveDrawableMap[primitive];
-            }
-            else
-            {
-                drawable.firstIndex = _scene.indexCounter;
-                drawable.indexCount = primitive->indices.size();
-                _scene.indexCounter += primitive->indices.size();
+        const glm::mat4& worldTransform = nodes.worldTransforms[nodeIndex];
 
-                _scene.indexStagingBuffer.pushData(primitive->indices.data(), primitive->indices.size() * sizeof(decltype(primitive->indices)::value_type));
+        for (const auto& primitive : scene.meshes[nodes.meshIndices[nodeIndex]]->primitives)
+        {
+            auto drawableIterator = vulkanScene.primitiveDrawableMap.find(primitive);
 
-                _scene.modelMatrixStagingBuffer.pushData(&baseTransform, sizeof(glm::mat4));
-                drawable.modelMatrixAddress = _scene.modelMatrixGPUBuffer.getAddress(_device) + _scene.drawableCounter * sizeof(glm::mat4);
+            // the geometry of a primitive is uploaded once, further nodes referencing it only add instances
+            if (drawableIterator == vulkanScene.primitiveDrawableMap.end())
+            {
+                VulkanDrawable drawable;
+                drawable.firstIndex = vulkanScene.indexCounter;
+                drawable.indexCount = primitive->indexCount;
+                vulkanScene.indexCounter += primitive->indexCount;
 
-                // create and push normal matrix
-                glm::mat4 normalMatrix = glm::transpose(glm::inverse(baseTransform)); // mat4 for alignment, 4th dimension is dropped in shader
-                _scene.normalMatrixStagingBuffer.pushData(&normalMatrix, sizeof(glm::mat4));
-                drawable.normalMatrixAddress = _scene.normalMatrixGPUBuffer.getAddress(_device) + _scene.drawableCounter * sizeof(glm::mat4);
+                // primitives loaded without their data get their staging regions reserved and filled in later by the geometry source
+                bool deferred = primitive->isDeferred();
 
-                _scene.drawableCounter++;
+                DeferredPrimitiveWrite deferredWrite;
+                deferredWrite.primitive = primitive.get();
+
+                if (deferred)
+                {
+                    deferredWrite.indexDestination = reinterpret_cast<uint32_t*>(vulkanScene.indexStagingBuffer.allocate(primitive->indexCount * sizeof(decltype(primitive->indices)::value_type)));
+                }
+                else
+                {
+                    vulkanScene.indexStagingBuffer.pushData(primitive->getIndices(), primitive->indexCount * sizeof(decltype(primitive->indices)::value_type));
+                }
 
                 for (const auto& attribute : primitive->attributes)
                 {
-                    auto vertexAttributeIterator = std::find_if(_scene.attributes.begin(), _scene.attributes.end(), [&](const VertexAttribute& vertexAttribute) { return vertexAttribute.type == attribute.attributeType; });
-                    vertexAttributeIterator->stagingBuffer.pushData(attribute.elements.get(), attribute.size);
+                    auto vertexAttributeIterator = std::find_if(vulkanScene.attributes.begin(), vulkanScene.attributes.end(), [&](const VertexAttribute& vertexAttribute) { return vertexAttribute.type == attribute.attributeType; });
+
+                    if (attribute.getData() != nullptr)
+                    {
+                        vertexAttributeIterator->stagingBuffer.pushData(attribute.getData(), attribute.size);
+
+                        deferredWrite.attributeDestinations.push_back(nullptr);
+                    }
+                    else
+                    {
+                        deferred = true;
+
+                        deferredWrite.attributeDestinations.push_back(vertexAttributeIterator->stagingBuffer.allocate(attribute.size));
+                    }
+
                     drawable.setAddress(attribute.attributeType, vertexAttributeIterator->gpuBufferAddressCounter);
                     vertexAttributeIterator->gpuBufferAddressCounter += attribute.size;
                 }
 
-                _scene.primitiveDrawableMap[primitive] = drawable;
+                if (deferred)
+                {
+                    vulkanScene.deferredWrites.push_back(std::move(deferredWrite));
+                }
 
                 // all scenes loaded using the glTF loader contain the glTFPBR material 
-                if (!_scene.contexts.contains(primitive->material->materialTypeName))
+                if (!vulkanScene.contexts.contains(primitive->material->materialTypeName))
                 {
-                    _scene.contexts[primitive->material->materialTypeName] = VulkanMaterialContext();
+                    vulkanScene.contexts[primitive->material->materialTypeName] = VulkanMaterialContext();
                     if (primitive->material->materialTypeName == "glTFPBR")
                     {
-                        _scene.glTFPBRMaterial = GLTFPBRMaterial(
-                            &_device, _vmaAllocator.getAllocator(), &_immediateSubmit, _renderPass, _globalDescriptorSetLayout,
-                            _lightDescriptorSetLayout, &_descriptorAllocator, &_descriptorWriter, _shaderCompiler
+                        vulkanScene.glTFPBRMaterial = GLTFPBRMaterial(
+                            &_physicalDevice, &_device, _vmaAllocator.getAllocator(), &_uploadManager, _renderPass, _globalDescriptorSetLayout,
+                            _lightDescriptorSetLayout, &vulkanScene.descriptorWriter, _shaderCompiler, _pipelineCache.getPipelineCache(), &_textureCache, _maxMaterialTextures
                         );
-                        _scene.contexts[primitive->material->materialTypeName].pipeline = _scene.glTFPBRMaterial.getPipeline();
-                        _scene.contexts[primitive->material->materialTypeName].pipelineLayout = _scene.glTFPBRMaterial.getPipelineLayout();
-
-                        drawable.descriptorSet = _scene.glTFPBRMaterial.createDescriptorSet(primitive->material);
+                        vulkanScene.contexts[primitive->material->materialTypeName].material = &vulkanScene.glTFPBRMaterial;
+                        vulkanScene.contexts[primitive->material->materialTypeName].pipelineLayout = vulkanScene.glTFPBRMaterial.getPipelineLayout();
                     }
                     else
                     {
                         throw std::runtime_error("unsupported material type.");
                     }
                 }
-                else if (primitive->material->materialTypeName == "glTFPBR")
+                else if (primitive->material->materialTypeName != "glTFPBR")
                 {
-                    drawable.descriptorSet = _scene.glTFPBRMaterial.createDescriptorSet(primitive->material);
+                    throw std::runtime_error("unsupported material type.");
                 }
-                else
+
+                // primitives with the same material share its parameters and textures
+                auto materialIterator = vulkanScene.materialIndices.find(primitive->material.get());
+
+                if (materialIterator == vulkanScene.materialIndices.end())
                 {
-                    throw std::runtime_error("unsupported material type.");
+                    materialIterator = vulkanScene.materialIndices.emplace(primitive->material.get(), vulkanScene.glTFPBRMaterial.addMaterial(primitive->material, &threadPool)).first;
+                }
+
+                drawable.materialIndex = materialIterator->second;
+                drawable.features = vulkanScene.glTFPBRMaterial.getFeatures(drawable.materialIndex);
+
+                if (std::any_of(primitive->attributes.begin(), primitive->attributes.end(), [](const Attribute& attribute) { return attribute.attributeType == AttributeType::COLOR_0; }))
+                {
+                    drawable.features |= GLTFPBRMaterial::featureVertexColors;
+                }
+
+                std::vector<VulkanDrawable>& drawables = vulkanScene.contexts[primitive->material->materialTypeName].drawables;
+
+                drawableIterator = vulkanScene.primitiveDrawableMap.emplace(primitive, drawables.size()).first;
+                drawables.push_back(std::move(drawable));
+            }
+
+            VulkanDrawable& drawable = vulkanScene.contexts[primitive->material->materialTypeName].drawables[drawableIterator->second];
+
+            VulkanDrawableInstance instance;
+            instance.matrixIndex = vulkanScene.instanceCounter++;
+
+            vulkanScene.modelMatrixStagingBuffer.pushData(&worldTransform, sizeof(glm::mat4));
+            vulkanScene.normalMatrixStagingBuffer.pushData(&nodes.normalMatrices[nodeIndex], sizeof(glm::mat4));
+
+            // world space bounds for the culling pass, from the transformed corners of the object space box
+            if (glm::all(glm::lessThanEqual(primitive->boundsMin, primitive->boundsMax)))
+            {
+                instance.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+                instance.boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+                instance.bounded = true;
+
+                for (int corner = 0; corner < 8; corner++)
+                {
+                    glm::vec3 position = glm::vec3(
+                        (corner & 1) ? primitive->boundsMax.x : primitive->boundsMin.x,
+                        (corner & 2) ? primitive->boundsMax.y : primitive->boundsMin.y,
+                        (corner & 4) ? primitive->boundsMax.z : primitive->boundsMin.z
+                    );
+                    glm::vec3 transformedPosition = glm::vec3(worldTransform * glm::vec4(position, 1.0f));
+
+                    instance.boundsMin = glm::min(instance.boundsMin, transformedPosition);
+                    instance.boundsMax = glm::max(instance.boundsMax, transformedPosition);
                 }
             }
 
-            _scene.contexts[primitive->material->materialTypeName].drawables.push_back(drawable);
+            drawable.instances.push_back(instance);
         }
     }
 
-    for (const auto& child : node->children)
+    // all materials are known now, so their parameters and textures can be written into the one descriptor set of the context
+    auto contextIterator = vulkanScene.contexts.find("glTFPBR");
+
+    if (contextIterator != vulkanScene.contexts.end())
     {
-        generateDrawablesFromScene(child, child->transform * baseTransform);
+        vulkanScene.glTFPBRMaterial.createDescriptorSet();
+        contextIterator->second.descriptorSet = vulkanScene.glTFPBRMaterial.getDescriptorSet();
     }
 }
 
-void VulkanRenderer::copyStagingBuffersToGPUBuffers()
+void VulkanRenderer::writeDeferredGeometry(std::shared_ptr<Scene> scene, VulkanScene& vulkanScene, ThreadPool& threadPool)
 {
-    _scene.indexStagingBuffer.copyToBuffer(_scene.indexGPUBuffer);
-    _graphicsQueue.waitIdle();
+    if (vulkanScene.deferredWrites.empty())
+    {
+        return;
+    }
+
+    if (scene->geometrySource == nullptr)
+    {
+        throw std::runtime_error("VulkanRenderer: scene contains primitives without data and no geometry source");
+    }
 
-    _scene.modelMatrixStagingBuffer.copyToBuffer(_scene.modelMatrixGPUBuffer);
-    _graphicsQueue.waitIdle();
+    threadPool.parallelFor(vulkanScene.deferredWrites.size(), [&](size_t index)
+        {
+            const DeferredPrimitiveWrite& deferredWrite = vulkanScene.deferredWrites[index];
+
+            scene->geometrySource->writePrimitive(*deferredWrite.primitive, deferredWrite.indexDestination, deferredWrite.attributeDestinations);
+        });
+
+    vulkanScene.deferredWrites.clear();
+    scene->geometrySource = nullptr; // releases the parsed source file
+}
 
-    _scene.normalMatrixStagingBuffer.copyToBuffer(_scene.normalMatrixGPUBuffer);
-    _graphicsQueue.waitIdle();
+void VulkanRenderer::copyStagingBuffersToGPUBuffers(VulkanScene& vulkanScene)
+{
+    _uploadManager.copyBuffer(vulkanScene.indexStagingBuffer, vulkanScene.indexGPUBuffer, vulkanScene.indexGPUBuffer.getSize());
+    _uploadManager.copyBuffer(vulkanScene.modelMatrixStagingBuffer, vulkanScene.modelMatrixGPUBuffer, vulkanScene.modelMatrixGPUBuffer.getSize());
+    _uploadManager.copyBuffer(vulkanScene.normalMatrixStagingBuffer, vulkanScene.normalMatrixGPUBuffer, vulkanScene.normalMatrixGPUBuffer.getSize());
 
-    for (auto& attribute : _scene.attributes)
+    for (auto& attribute : vulkanScene.attributes)
     {
-        attribute.stagingBuffer.copyToBuffer(attribute.gpuBuffer);
-        _graphicsQueue.waitIdle();
+        _uploadManager.copyBuffer(attribute.stagingBuffer, attribute.gpuBuffer, attribute.gpuBuffer.getSize());
     }
+
+    // a single wait for the geometry and all textures recorded while generating the drawables
+    _uploadManager.waitIdle();
+}
+
+void VulkanRenderer::createQueues()
+{
+    auto graphicsQueuePair = _initilization.createQueue(_device, vkb::QueueType::graphics);
+    _graphicsQueue = std::move(graphicsQueuePair.first);
+    _graphicsQueueIndex = graphicsQueuePair.second;
+
+    if (!_headless)
+    {
+        auto presentQueuePair = _initilization.createQueue(_device, vkb::QueueType::present);
+        _presentQueue = std::move(presentQueuePair.first);
+        _presentQueueIndex = presentQueuePair.second;
+    }
+
+    // software implementations such as lavapipe expose a single queue family
+    if (_initilization.hasQueue(vkb::QueueType::compute))
+    {
+        auto computeQueuePair = _initilization.createQueue(_device, vkb::QueueType::compute);
+        _computeQueue = std::move(computeQueuePair.first);
+        _computeQueueIndex = computeQueuePair.second;
+    }
+
+    _transferQueueIndex = _graphicsQueueIndex;
+
+    if (_initilization.hasDedicatedQueue(vkb::QueueType::transfer))
+    {
+        auto transferQueuePair = _initilization.createDedicatedQueue(_device, vkb::QueueType::transfer);
+        _transferQueue = std::move(transferQueuePair.first);
+        _transferQueueIndex = transferQueuePair.second;
+    }
+}
+
+void VulkanRenderer::createFrameResources()
+{
+    _commandPool = _initilization.createCommandPool(_device);
+
+    _descriptorAllocator = VulkanUtilities::DescriptorAllocator(&_device);
+    _descriptorWriter = VulkanDescriptorWriter(&_device);
+    _vmaAllocator = VulkanUtilities::VmaAllocatorWrapper(_instance, _physicalDevice, _device);
+
+    // size of the bindless texture array of the materials, the storage buffer next to it is well within the resource limits
+    vk::StructureChain<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceVulkan12Properties> properties = _physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceVulkan12Properties>();
+    const vk::PhysicalDeviceVulkan12Properties& properties12 = properties.get<vk::PhysicalDeviceVulkan12Properties>();
+
+    _maxMaterialTextures = std::min({
+        properties12.maxPerStageDescriptorUpdateAfterBindSamplers, properties12.maxPerStageDescriptorUpdateAfterBindSampledImages,
+        properties12.maxDescriptorSetUpdateAfterBindSamplers, properties12.maxDescriptorSetUpdateAfterBindSampledImages, GLTFPBRMaterial::maxTextureCount
+    });
+    _frameUniformOffsets.resize(_framesInFlight);
+    _immediateSubmit = VulkanUtilities::ImmediateSubmit(&_device, &_graphicsQueue, _graphicsQueueIndex);
+    _uploadManager = VulkanUploadManager(
+        &_device, _vmaAllocator.getAllocator(), (*_transferQueue != nullptr) ? &_transferQueue : &_graphicsQueue, _transferQueueIndex, &_graphicsQueue, _graphicsQueueIndex, &_queueMutex
+    );
+    _textureCache = VulkanTextureCache(&_device);
+    _pipelineCache = VulkanPipelineCache(&_device, _physicalDevice, VulkanPipelineCache::defaultFilePath);
+
+    std::vector<uint32_t> cullingQueueFamilies = { static_cast<uint32_t>(_graphicsQueueIndex), static_cast<uint32_t>(_transferQueueIndex) };
+    std::vector<uint32_t> computeQueueFamilies = { static_cast<uint32_t>(_graphicsQueueIndex) };
+
+    if (*_computeQueue != nullptr)
+    {
+        cullingQueueFamilies.push_back(_computeQueueIndex);
+        computeQueueFamilies.push_back(_computeQueueIndex);
+
+        vk::CommandPoolCreateInfo computeCommandPoolCreateInfo;
+        computeCommandPoolCreateInfo.setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer);
+        computeCommandPoolCreateInfo.setQueueFamilyIndex(_computeQueueIndex);
+
+        _computeCommandPool = vk::raii::CommandPool(_device, computeCommandPoolCreateInfo);
+
+        vk::CommandBufferAllocateInfo cullCommandBufferAllocateInfo;
+        cullCommandBufferAllocateInfo.setLevel(vk::CommandBufferLevel::ePrimary);
+        cullCommandBufferAllocateInfo.setCommandPool(_computeCommandPool);
+        cullCommandBufferAllocateInfo.setCommandBufferCount(_framesInFlight);
+
+        _cullCommandBuffers = vk::raii::CommandBuffers(_device, cullCommandBufferAllocateInfo);
+        _cullCompleteSemaphores = _initilization.createSemaphores(_device, _framesInFlight);
+    }
+
+    _depthPyramid = VulkanDepthPyramid(&_device, _vmaAllocator.getAllocator(), _shaderCompiler, _pipelineCache.getPipelineCache());
+    _drawCulling = VulkanDrawCulling(
+        &_device, _vmaAllocator.getAllocator(), _shaderCompiler, _pipelineCache.getPipelineCache(), cullingQueueFamilies, _framesInFlight, _initilization.supportsDrawIndirectCount(),
+        _depthPyramid.getDescriptorSetLayout()
+    );
+    _lightClustering = VulkanLightClustering(&_device, _vmaAllocator.getAllocator(), _shaderCompiler, _pipelineCache.getPipelineCache(), computeQueueFamilies, _framesInFlight);
+
+    // the light array is read by the clustering pass as well, which may run on the compute queue
+    _frameAllocator = VulkanFrameAllocator(
+        &_device, _vmaAllocator.getAllocator(), _physicalDevice.getProperties().limits, _framesInFlight,
+        VulkanFrameAllocator::defaultFrameSize + VulkanLight::maxLightCount * sizeof(ShaderStructures::PointLight), computeQueueFamilies
+    );
+
+    createDepthBuffer();
+    createRenderPass();
+
+    _inFlightFences = _initilization.createFences(_device, _framesInFlight);
+
+    vk::CommandBufferAllocateInfo commandBufferAllocateInfo;
+    commandBufferAllocateInfo.setLevel(vk::CommandBufferLevel::ePrimary);
+    commandBufferAllocateInfo.setCommandPool(_commandPool);
+    commandBufferAllocateInfo.setCommandBufferCount(_framesInFlight);
+
+    _drawCommandBuffers = vk::raii::CommandBuffers(_device, commandBufferAllocateInfo);
+
+    // command pools are externally synchronized, so every chunk of every frame in flight gets its own
+    _recordingThreadCount = std::clamp(std::thread::hardware_concurrency(), 1u, maxRecordingThreads);
+    _recordingThreadPool = std::make_unique<ThreadPool>(_recordingThreadCount);
+    _recordedScenePasses.resize(_framesInFlight);
+
+    for (unsigned i = 0; i < _framesInFlight * _recordingThreadCount; i++)
+    {
+        vk::CommandPoolCreateInfo recordingCommandPoolCreateInfo;
+        recordingCommandPoolCreateInfo.setFlags(vk::CommandPoolCreateFlagBits::eTransient);
+        recordingCommandPoolCreateInfo.setQueueFamilyIndex(_graphicsQueueIndex);
+
+        _recordingCommandPools.emplace_back(_device, recordingCommandPoolCreateInfo);
+
+        vk::CommandBufferAllocateInfo recordingCommandBufferAllocateInfo;
+        recordingCommandBufferAllocateInfo.setLevel(vk::CommandBufferLevel::eSecondary);
+        recordingCommandBufferAllocateInfo.setCommandPool(_recordingCommandPools.back());
+        recordingCommandBufferAllocateInfo.setCommandBufferCount(1);
+
+        _recordingCommandBuffers.push_back(std::move(vk::raii::CommandBuffers(_device, recordingCommandBufferAllocateInfo).front()));
+    }
+
+    createGlobalDescriptorSets();
+
+    _light = VulkanLight(_lightDescriptorSetLayout, &_descriptorAllocator, &_descriptorWriter, _frameAllocator);
+}
+
+void VulkanRenderer::createOffscreenTarget()
+{
+    _offscreenImage = VulkanImage(
+        &_device, _vmaAllocator.getAllocator(), _swapchainExtent, _swapchainFormat, vk::ImageAspectFlagBits::eColor,
+        vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc
+    );
+
+    _framebuffers.clear();
+    _framebuffers.push_back(_initilization.createFramebuffer(_device, _renderPass, _offscreenImage.getImageView(), _depthBuffer.getImageView(), _swapchainExtent));
 }
 
 void VulkanRenderer::recreateSwapchain()
 {
-    (*_device).waitIdle();
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+
+        (*_device).waitIdle();
+    }
 
     _framebuffers.clear();
     _imguiFramebuffers.clear();
@@ -685,6 +1457,8 @@ void VulkanRenderer::recreateSwapchain()
     commandBufferAllocateInfo.setCommandBufferCount(_framesInFlight);
 
     _drawCommandBuffers = vk::raii::CommandBuffers(_device, commandBufferAllocateInfo);
+
+    invalidateSceneCommands(); // the viewport and scissor are recorded with the old extent
 }
 
 void VulkanRenderer::createRenderPass()
@@ -729,16 +1503,67 @@ void VulkanRenderer::createRenderPass()
     renderPassCreateInfo.setSubpasses(subpassDescription);
 
     _renderPass = vk::raii::RenderPass(_device, renderPassCreateInfo);
+
+    // occlusion culling splits the scene pass in two, the early pass stores the depth for the depth pyramid and the late pass continues on it
+    // all three passes are compatible, so they share the framebuffers and the secondary command buffers
+    attachments[1].setStoreOp(vk::AttachmentStoreOp::eStore);
+    attachments[1].setFinalLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+
+    // the previous frame's pyramid build read the depth buffer
+    vk::SubpassDependency earlyDependencies[2];
+    earlyDependencies[0].setSrcSubpass(vk::SubpassExternal);
+    earlyDependencies[0].setDstSubpass(0);
+    earlyDependencies[0].setSrcStageMask(vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eLateFragmentTests | vk::PipelineStageFlagBits::eColorAttachmentOutput);
+    earlyDependencies[0].setSrcAccessMask(vk::AccessFlagBits::eDepthStencilAttachmentWrite | vk::AccessFlagBits::eColorAttachmentWrite);
+    earlyDependencies[0].setDstStageMask(vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests | vk::PipelineStageFlagBits::eColorAttachmentOutput);
+    earlyDependencies[0].setDstAccessMask(vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite | vk::AccessFlagBits::eColorAttachmentWrite);
+
+    // the pyramid build reads the stored depth
+    earlyDependencies[1].setSrcSubpass(0);
+    earlyDependencies[1].setDstSubpass(vk::SubpassExternal);
+    earlyDependencies[1].setSrcStageMask(vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests);
+    earlyDependencies[1].setSrcAccessMask(vk::AccessFlagBits::eDepthStencilAttachmentWrite);
+    earlyDependencies[1].setDstStageMask(vk::PipelineStageFlagBits::eComputeShader);
+    earlyDependencies[1].setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+
+    renderPassCreateInfo.setAttachments(attachments);
+    renderPassCreateInfo.setDependencies(earlyDependencies);
+
+    _earlyRenderPass = vk::raii::RenderPass(_device, renderPassCreateInfo);
+
+    attachments[0].setLoadOp(vk::AttachmentLoadOp::eLoad);
+    attachments[0].setInitialLayout(vk::ImageLayout::eColorAttachmentOptimal);
+
+    attachments[1].setLoadOp(vk::AttachmentLoadOp::eLoad);
+    attachments[1].setStoreOp(vk::AttachmentStoreOp::eDontCare);
+    attachments[1].setInitialLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+    attachments[1].setFinalLayout(vk::ImageLayout::eDepthStencilAttachmentOptimal);
+
+    // the attachments written by the early pass, after the pyramid build finished reading the depth
+    vk::SubpassDependency lateDependency;
+    lateDependency.setSrcSubpass(vk::SubpassExternal);
+    lateDependency.setDstSubpass(0);
+    lateDependency.setSrcStageMask(vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eLateFragmentTests | vk::PipelineStageFlagBits::eColorAttachmentOutput);
+    lateDependency.setSrcAccessMask(vk::AccessFlagBits::eDepthStencilAttachmentWrite | vk::AccessFlagBits::eColorAttachmentWrite);
+    lateDependency.setDstStageMask(vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests | vk::PipelineStageFlagBits::eColorAttachmentOutput);
+    lateDependency.setDstAccessMask(
+        vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite | vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite
+    );
+
+    renderPassCreateInfo.setAttachments(attachments);
+    renderPassCreateInfo.setDependencies(lateDependency);
+
+    _lateRenderPass = vk::raii::RenderPass(_device, renderPassCreateInfo);
 }
 
 void VulkanRenderer::createGlobalDescriptorSets()
 {
     vk::DescriptorSetLayoutBinding descriptorSetLayoutBinding;
 
-    // camera parameters
+    // camera parameters, the set points at the frame allocator and every frame binds it with the offset of its own copy
     descriptorSetLayoutBinding.setBinding(0);
     descriptorSetLayoutBinding.setDescriptorCount(1);
-    descriptorSetLayoutBinding.setDescriptorType(vk::DescriptorType::eUniformBuffer);
+    descriptorSetLayoutBinding.setDescriptorType(vk::DescriptorType::eUniformBufferDynamic);
     descriptorSetLayoutBinding.setStageFlags(vk::ShaderStageFlagBits::eVertex);
 
     vk::DescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo;
@@ -746,17 +1571,14 @@ void VulkanRenderer::createGlobalDescriptorSets()
 
     _globalDescriptorSetLayout = vk::raii::DescriptorSetLayout(_device, descriptorSetLayoutCreateInfo);
 
-    for (int i = 0; i < _framesInFlight; i++)
-    {
-        _globalDescriptorSetBuffers.push_back(VulkanUniformBuffer(&_device, _vmaAllocator.getAllocator(), sizeof(ShaderStructures::GlobalUniformBuffer)));
-        _globalDescriptorSets.push_back(std::move(_descriptorAllocator.allocateSet(_globalDescriptorSetLayout)));
-    }
+    _globalDescriptorSet = _descriptorAllocator.allocateSet(_globalDescriptorSetLayout);
+    _descriptorWriter.writeBuffer(_globalDescriptorSet, _frameAllocator.getBuffer(), 0, 0, sizeof(ShaderStructures::GlobalUniformBuffer), vk::DescriptorType::eUniformBufferDynamic);
 
-    // light parameters
+    // light parameters, written once by VulkanLight, the lights and their clusters are read through the addresses in it
     descriptorSetLayoutBinding.setBinding(0);
     descriptorSetLayoutBinding.setDescriptorCount(1);
-    descriptorSetLayoutBinding.setDescriptorType(vk::DescriptorType::eUniformBuffer);
-    descriptorSetLayoutBinding.setStageFlags(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment);
+    descriptorSetLayoutBinding.setDescriptorType(vk::DescriptorType::eUniformBufferDynamic);
+    descriptorSetLayoutBinding.setStageFlags(vk::ShaderStageFlagBits::eFragment);
 
     descriptorSetLayoutCreateInfo.setBindings(descriptorSetLayoutBinding);
 
@@ -765,5 +1587,11 @@ void VulkanRenderer::createGlobalDescriptorSets()
 
 void VulkanRenderer::createDepthBuffer()
 {
-    _depthBuffer = VulkanImage(&_device, &_immediateSubmit, _vmaAllocator.getAllocator(), _swapchainExtent, vk::Format::eD32Sfloat, vk::ImageAspectFlagBits::eDepth, vk::ImageUsageFlagBits::eDepthStencilAttachment);
+    // sampled by the depth pyramid build
+    _depthBuffer = VulkanImage(
+        &_device, _vmaAllocator.getAllocator(), _swapchainExtent, vk::Format::eD32Sfloat, vk::ImageAspectFlagBits::eDepth,
+        vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled
+    );
+
+    _depthPyramid.resize(_depthBuffer);
 }
@@ -20,16 +20,24 @@
 #include <SVMV/Loader.hxx>
 #include <SVMV/GLFWwindowWrapper.hxx>
 #include <SVMV/Scene.hxx>
-#include <SVMV/Node.hxx>
+#include <SVMV/SceneGraph.hxx>
 #include <SVMV/Mesh.hxx>
 #include <SVMV/Primitive.hxx>
 #include <SVMV/Attribute.hxx>
 #include <SVMV/VulkanInitialization.hxx>
 #include <SVMV/VulkanScene.hxx>
 #include <SVMV/VulkanBuffer.hxx>
+#include <SVMV/VulkanUploadManager.hxx>
+#include <SVMV/VulkanFrameAllocator.hxx>
+#include <SVMV/VulkanDrawCulling.hxx>
+#include <SVMV/VulkanDepthPyramid.hxx>
+#include <SVMV/VulkanLightClustering.hxx>
+#include <SVMV/VulkanTextureCache.hxx>
+#include <SVMV/VulkanPipelineCache.hxx>
 #include <SVMV/VulkanShaderStructures.hxx>
 #include <SVMV/VulkanDescriptorWriter.hxx>
 #include <SVMV/VulkanLight.hxx>
+#include <SVMV/ThreadPool.hxx>
 
 #include <memory>
 #include <vector>
@@ -37,6 +45,16 @@
 #include <iostream>
 #include <sstream>
 #include <cmath>
+#include <array>
+#include <algorithm>
+#include <limits>
+#include <future>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <span>
+#include <thread>
 
 namespace SVMV
 {
@@ -45,6 +63,7 @@ namespace SVMV
     public:
         VulkanRenderer() = default;
         VulkanRenderer(int width, int height, const std::string& name, unsigned framesInFlight, const GLFWwindowWrapper& window);
+        VulkanRenderer(int width, int height, const std::string& name, unsigned framesInFlight); // headless, renders into an offscreen target
 
         VulkanRenderer(const VulkanRenderer&) = delete;
         VulkanRenderer& operator=(const VulkanRenderer&) = delete;
@@ -56,18 +75,103 @@ namespace SVMV
 
         void draw();
 
-        void loadScene(std::shared_ptr<Scene> scene);
+        void loadScene(std::shared_ptr<Scene> scene); // blocks until the scene is uploaded
+        void requestScene(const std::string& filePath); // loads and uploads the scene on a background thread, it replaces the current one once it is ready
+
+        void waitIdle(); // waits for a pending scene load and for the device
 
         void setCamera(glm::vec3 position, glm::vec3 lookDirection, glm::vec3 upDirection, float fieldOfView);
+        void setLoadOptions(const Loader::LoadOptions& options); // used for scenes opened through the UI, options the device does not support are turned off
+        const Loader::LoadOptions& getLoadOptions() const noexcept;
+
+        void setScatteredLightCount(uint32_t count); // point lights spread around the light orbit center in addition to the orbiting ones
+        void setOcclusionCulling(bool enabled); // turns host culling off
+        void setHostCulling(bool enabled); // frustum culls on the host instead of in the culling pass, turns occlusion culling off
+
+        [[nodiscard]] ShaderStructures::CullStatistics getCullStatistics(); // of the most recently drawn frame, complete once the device is idle
+
+        void saveFrame(const std::string& filePath); // headless only, writes the offscreen target as a PNG
 
         [[nodiscard]] const vk::Device getDevice() const noexcept;
 
     private:
-        void recordDrawCommands(int activeFrame, const vk::raii::Framebuffer& framebuffer, const vk::raii::Framebuffer& imguiFramebuffer);
+        struct OrbitingLightSettings
+        {
+            glm::vec3 color     { 1.0f };
+            float strength      { 0.0f };
+            float distance      { 1.0f };
+            float azimuthal     { 0.0f };
+            float polar         { 0.0f };
+        };
+
+        struct RetiredScene
+        {
+            std::unique_ptr<VulkanScene> scene;
+            int remainingFrames     { 0 }; // frame fences left to wait for before the scene is unused
+        };
+
+        // dynamic offsets into the frame allocator, written by updateFrameUniforms
+        struct FrameUniformOffsets
+        {
+            uint32_t global     { 0 };
+            uint32_t light      { 0 };
+
+            vk::DeviceAddress lights    { 0 }; // light array read by the clustering pass
+            uint32_t lightCount         { 0 };
+        };
+
+        // a batch of the scene pass, with its pipeline looked up on the render thread so the recording threads only read
+        struct RecordedBatch
+        {
+            const VulkanMaterialContext* context    { nullptr };
+            const VulkanDrawBatch* batch            { nullptr };
+            const vk::raii::Pipeline* pipeline      { nullptr };
+        };
+
+        // secondary command buffers of the scene pass of a frame index, executed again by later frames with the same index until they are invalidated
+        struct RecordedScenePass
+        {
+            bool valid              { false };
+            size_t chunkCount       { 0 };
+
+            // the dynamic offsets are recorded into the buffers
+            uint32_t globalOffset   { 0 };
+            uint32_t lightOffset    { 0 };
+        };
+
+        static constexpr unsigned maxRecordingThreads = 4;
+        static constexpr size_t minBatchesPerChunk = 16; // fewer batches are not worth another thread
+
+        static constexpr float nearPlane = 0.01f;
+        static constexpr float farPlane = 100.0f;
+
+    private:
+        void drawHeadless();
+        void updateFrameUniforms(int activeFrame);
+        void updateLightData();
 
-        void preprocessScene(std::shared_ptr<Scene> scene);
-        void generateDrawablesFromScene(std::shared_ptr<Node> node, glm::mat4 baseTransform);
-        void copyStagingBuffersToGPUBuffers();
+        void recordDrawCommands(int activeFrame, const vk::raii::Framebuffer& framebuffer, const vk::raii::Framebuffer& imguiFramebuffer);
+        void recordSceneCommands(int activeFrame, const vk::raii::Framebuffer& framebuffer);
+        void recordScenePass(int activeFrame); // records the secondary command buffers of the frame index
+        void recordBatches(const vk::raii::CommandBuffer& commandBuffer, int activeFrame, std::span<const RecordedBatch> batches) const; // into a secondary buffer inside the scene pass
+        void invalidateSceneCommands(); // the scene pass of every frame index is recorded again, after the scene, the swapchain or the materials changed
+        void recordImguiCommands(int activeFrame, const vk::raii::Framebuffer& imguiFramebuffer);
+        void recordComputeCommands(const vk::raii::CommandBuffer& commandBuffer, int activeFrame, bool sameQueue); // culling and light clustering
+        bool submitCulling(int activeFrame); // returns whether the compute passes signal the frame's cull semaphore
+
+        std::unique_ptr<VulkanScene> createVulkanScene(std::shared_ptr<Scene> scene, unsigned threadCount); // safe to call from the loading thread
+        void updateSceneLoading();
+        void swapScene(std::unique_ptr<VulkanScene> scene);
+        void releaseRetiredScenes();
+
+        void preprocessScene(std::shared_ptr<Scene> scene, VulkanScene& vulkanScene);
+        void generateDrawablesFromScene(VulkanScene& vulkanScene, const Scene& scene, ThreadPool& threadPool);
+        void writeDeferredGeometry(std::shared_ptr<Scene> scene, VulkanScene& vulkanScene, ThreadPool& threadPool);
+        void copyStagingBuffersToGPUBuffers(VulkanScene& vulkanScene);
+
+        void createQueues();
+        void createFrameResources();
+        void createOffscreenTarget();
 
         void recreateSwapchain();
         void createRenderPass();
@@ -78,6 +182,7 @@ namespace SVMV
         shaderc::Compiler _shaderCompiler;
 
         bool _resized           { false };
+        bool _headless          { false };
         int _framesInFlight     { 0 };
         int _activeFrame        { 0 };
 
@@ -97,6 +202,8 @@ namespace SVMV
         vk::raii::Device _device                    { nullptr };
         vk::raii::SwapchainKHR _swapchain           { nullptr };
         vk::raii::RenderPass _renderPass            { nullptr };
+        vk::raii::RenderPass _earlyRenderPass       { nullptr }; // the scene pass is split in two with occlusion culling, see createRenderPass
+        vk::raii::RenderPass _lateRenderPass        { nullptr };
         vk::raii::CommandPool _commandPool          { nullptr };
         vk::raii::Queue _graphicsQueue              { nullptr };
         int _graphicsQueueIndex                     { 0 };
@@ -104,9 +211,19 @@ namespace SVMV
         int _presentQueueIndex                      { 0 };
         vk::raii::Queue _computeQueue               { nullptr };
         int _computeQueueIndex                      { 0 };
+        vk::raii::Queue _transferQueue              { nullptr }; // only created when the device has a dedicated transfer queue family
+        int _transferQueueIndex                     { 0 };
 
         vk::raii::CommandBuffers _drawCommandBuffers    { nullptr };
 
+        // the scene pass is split into chunks of batches recorded into secondary command buffers on the recording threads
+        std::unique_ptr<ThreadPool> _recordingThreadPool;
+        std::vector<vk::raii::CommandPool> _recordingCommandPools; // one per chunk and frame in flight, reset before the chunk is recorded
+        std::vector<vk::raii::CommandBuffer> _recordingCommandBuffers; // a secondary buffer from each pool
+        unsigned _recordingThreadCount  { 1 }; // also the most chunks per frame
+        std::vector<RecordedScenePass> _recordedScenePasses; // per frame in flight
+        bool _reuseSceneCommands        { true }; // otherwise the scene pass is recorded every frame
+
         vk::raii::RenderPass _imguiRenderPass               { nullptr };
         vk::raii::CommandPool _imguiCommandPool             { nullptr }; // unused?
         vk::raii::CommandBuffers _imguiCommandBuffers       { nullptr }; // unused?
@@ -117,26 +234,65 @@ namespace SVMV
         VulkanDescriptorWriter _descriptorWriter;
         VulkanUtilities::VmaAllocatorWrapper _vmaAllocator;
         VulkanUtilities::ImmediateSubmit _immediateSubmit;
+        VulkanUploadManager _uploadManager;
+        VulkanDepthPyramid _depthPyramid; // built from the depth of the early pass with occlusion culling
+        VulkanDrawCulling _drawCulling;
+        VulkanLightClustering _lightClustering;
+        VulkanTextureCache _textureCache; // images and samplers shared between the materials of all scenes
+        VulkanPipelineCache _pipelineCache; // saved when the renderer is destroyed
+
+        // the culling and light clustering passes run on the compute queue if there is one, and are recorded into the draw command buffers otherwise
+        vk::raii::CommandPool _computeCommandPool       { nullptr };
+        vk::raii::CommandBuffers _cullCommandBuffers    { nullptr };
+        std::vector<vk::raii::Semaphore> _cullCompleteSemaphores;
+        bool _frustumCulling                            { true };
+        bool _occlusionCulling                          { false }; // culls and draws on the graphics queue, in two passes around the depth pyramid build
+        bool _hostCulling                               { false }; // on the recording threads, the culling pass only copies the results
+        ShaderStructures::CullStatistics _cullStatistics; // of the last frame whose fence was waited for
 
         std::vector<vk::raii::ImageView> _imageViews;
         std::vector<vk::raii::Framebuffer> _framebuffers;
         
         VulkanImage _depthBuffer;
+        VulkanImage _offscreenImage; // color target used instead of the swapchain images in headless mode
 
         std::vector<vk::raii::Semaphore> _imageReadySemaphores;
         std::vector<vk::raii::Semaphore> _renderCompleteSemaphores;
         std::vector<vk::raii::Fence> _inFlightFences;
 
+        // per-frame uniform data lives in the frame allocator, its descriptor sets are written once and bound with dynamic offsets
+        VulkanFrameAllocator _frameAllocator;
+        std::vector<FrameUniformOffsets> _frameUniformOffsets;
+
+        uint32_t _maxMaterialTextures       { 0 }; // texture array size of the bindless materials, from the device limits
+
         vk::raii::DescriptorSetLayout _globalDescriptorSetLayout        { nullptr };
-        std::vector<VulkanUniformBuffer> _globalDescriptorSetBuffers;
-        std::vector<vk::raii::DescriptorSet> _globalDescriptorSets;
+        vk::raii::DescriptorSet _globalDescriptorSet                    { nullptr };
 
         vk::raii::DescriptorSetLayout _lightDescriptorSetLayout         { nullptr };
 
-        VulkanScene _scene;
+        std::unique_ptr<VulkanScene> _scene     { std::make_unique<VulkanScene>() };
+        std::vector<RetiredScene> _retiredScenes;
         std::string _requestedScenePath;
+        std::string _loadingScenePath;
+        std::future<std::unique_ptr<VulkanScene>> _sceneLoad;
+        Loader::LoadOptions _loadOptions;
+
+        std::mutex _queueMutex; // queue submissions happen on the rendering thread and the loading thread
 
         VulkanLight _light;
+        std::vector<ShaderStructures::PointLight> _scatteredLights; // positions relative to the light orbit center
+        int _scatteredLightCount        { 0 };
+        float _scatteredLightExtent     { 10.0f }; // half the size of the cube the scattered lights are spread over
+
+        glm::vec3 _lightOrbitCenter     { 0.0f };
+        glm::vec3 _ambientColor         { 157.0f / 255.0f, 223.0f / 255.0f, 250.0f / 255.0f };
+        float _ambientStrength          { 0.01f };
+        std::array<OrbitingLightSettings, 3> _lightSettings{ {
+            { glm::vec3(103.0f / 255.0f, 18.0f / 255.0f, 211.0f / 255.0f), 3.5f, 1.0f, 0.514f, 1.5f },
+            { glm::vec3(201.0f / 255.0f, 7.0f / 255.0f, 7.0f / 255.0f), 2.0f, 1.0f, -0.22f, 1.977f },
+            { glm::vec3(37.0f / 255.0f, 200.0f / 255.0f, 42.0f / 255.0f), 1.67f, 1.0f, 1.39f, 1.5f }
+        } };
 
         VulkanInitilization _initilization;
     };
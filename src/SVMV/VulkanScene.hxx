@@ -5,6 +5,10 @@
 #include <SVMV/VulkanDrawable.hxx>
 #include <SVMV/VulkanGLTFPBRMaterial.hxx>
 #include <SVMV/VulkanMaterialContext.hxx>
+#include <SVMV/VulkanUtilities.hxx>
+#include <SVMV/VulkanDescriptorWriter.hxx>
+#include <SVMV/VulkanShaderStructures.hxx>
+#include <SVMV/FrustumCulling.hxx>
 
 #include <vector>
 #include <string>
@@ -22,8 +26,20 @@ namespace SVMV
         VulkanStagingBuffer stagingBuffer;
     };
 
+    // staging regions reserved for a primitive whose geometry is written by the scene's GeometrySource
+    struct DeferredPrimitiveWrite
+    {
+        const Primitive* primitive{ nullptr };
+
+        uint32_t* indexDestination{ nullptr };
+        std::vector<std::byte*> attributeDestinations; // in the order of primitive->attributes
+    };
+
     struct VulkanScene
     {
+        // owned per scene so a scene can be built on a loading thread
+        VulkanDescriptorWriter descriptorWriter;
+
         VulkanGPUBuffer indexGPUBuffer;
         VulkanStagingBuffer indexStagingBuffer;
         int indexCounter{ 0 };
@@ -33,13 +49,35 @@ namespace SVMV
 
         VulkanGPUBuffer normalMatrixGPUBuffer;
         VulkanStagingBuffer normalMatrixStagingBuffer;
-        int drawableCounter{ 0 };
+        int instanceCounter{ 0 };
 
         std::vector<VertexAttribute> attributes; // holds the buffers containing attribute data for all drawables in the scene
 
         std::unordered_map<std::string, VulkanMaterialContext> contexts;
-        std::unordered_map<std::shared_ptr<Primitive>, VulkanDrawable> primitiveDrawableMap;
+        std::unordered_map<std::shared_ptr<Primitive>, size_t> primitiveDrawableMap; // index into the drawables of the primitive's material context, only used while generating drawables, cleared afterwards so the CPU-side geometry can be released
+        std::unordered_map<const Material*, uint32_t> materialIndices; // into the parameters of the material, only used while generating drawables
+        std::vector<DeferredPrimitiveWrite> deferredWrites;
 
         GLTFPBRMaterial glTFPBRMaterial;
+
+        // GPU-driven drawing, see VulkanDrawCulling
+        VulkanGPUBuffer drawDataGPUBuffer; // ShaderStructures::DrawData for each draw, in the order of the batches
+        VulkanGPUBuffer cullDataGPUBuffer; // ShaderStructures::DrawCullData for each draw
+        VulkanGPUBuffer instanceCullDataGPUBuffer; // ShaderStructures::InstanceCullData for each instance, grouped by draw
+        VulkanGPUBuffer instanceVisibilityGPUBuffer; // whether each instance passed the last occlusion test, shared by all frames as they are culled in order
+        std::vector<VulkanGPUBuffer> instanceCountGPUBuffers; // per frame in flight, visible instances of each draw
+        std::vector<VulkanGPUBuffer> visibleInstanceGPUBuffers; // per frame in flight, matrix and draw index of the visible instances
+        std::vector<VulkanGPUBuffer> indirectCommandGPUBuffers; // per frame in flight, written by the culling pass
+        std::vector<VulkanGPUBuffer> drawCountGPUBuffers; // per frame in flight, one count per batch
+        uint32_t drawCount{ 0 };
+        uint32_t instanceCount{ 0 };
+        uint32_t batchCount{ 0 };
+
+        // host culling, see VulkanDrawCulling::cullOnHost
+        FrustumCulling::Bounds instanceBounds; // world space bounds of each instance, in the order of the instance cull data
+        std::vector<uint32_t> instanceMatrices; // matrix index of each instance
+        std::vector<ShaderStructures::DrawCullData> drawCullData; // the contents of cullDataGPUBuffer
+        std::vector<uint8_t> instanceVisibilityMasks; // one bit per instance, written by the frustum test
+        std::vector<VulkanStagingBuffer> hostCullStagingBuffers; // per frame in flight, created on first use
     };
 }
@@ -2,13 +2,31 @@
 
 using namespace SVMV;
 
-VulkanShader::VulkanShader(const vk::raii::Device& device, const shaderc::Compiler& shaderCompiler, ShaderType type, const std::string& file)
+VulkanShader::VulkanShader(const vk::raii::Device& device, const shaderc::Compiler& shaderCompiler, ShaderType type, const std::string& file, bool optimize/* = true*/)
 {
+    _type = type;
+
+    std::span<const uint32_t> embeddedCode = EmbeddedShaders::find(file);
+
+    if (!embeddedCode.empty())
+    {
+        createShaderModule(device, embeddedCode);
+
+        return;
+    }
+
     auto shaderCode = readFile(file);
 
-    _type = type;
+    uint64_t cacheKey = ShaderCache::getKey(shaderCode, "kind=" + std::to_string(static_cast<int>(convertShaderType(_type))) + ";optimize=" + std::to_string(optimize));
+    std::vector<uint32_t> code = ShaderCache::load(file, cacheKey);
+
+    if (code.empty())
+    {
+        code = compileShader(shaderCompiler, file, shaderCode, convertShaderType(_type), optimize);
+        ShaderCache::save(file, cacheKey, code);
+    }
 
-    createShaderModule(device, compileShader(shaderCompiler, file, shaderCode, convertShaderType(_type), false));
+    createShaderModule(device, code);
 }
 
 VulkanShader::VulkanShader(VulkanShader&& other) noexcept
@@ -68,8 +86,9 @@ std::vector<uint32_t> VulkanShader::compileShader(const shaderc::Compiler& shade
     shaderc::CompileOptions options;
 
     options.SetSourceLanguage(shaderc_source_language_glsl);
+    options.SetOptimizationLevel(optimize ? shaderc_optimization_level_performance : shaderc_optimization_level_zero);
 
-    shaderc::SpvCompilationResult result = shaderCompiler.CompileGlslToSpv(shaderCode, shaderKind, name.c_str());
+    shaderc::SpvCompilationResult result = shaderCompiler.CompileGlslToSpv(shaderCode, shaderKind, name.c_str(), options);
 
     if (result.GetCompilationStatus() != shaderc_compilation_status_success)
     {
@@ -79,11 +98,11 @@ std::vector<uint32_t> VulkanShader::compileShader(const shaderc::Compiler& shade
     return std::vector<uint32_t>(result.cbegin(), result.cend());
 }
 
-void VulkanShader::createShaderModule(const vk::raii::Device& device, const std::vector<uint32_t> code)
+void VulkanShader::createShaderModule(const vk::raii::Device& device, std::span<const uint32_t> code)
 {
     vk::ShaderModuleCreateInfo shaderModuleCreateInfo;
     shaderModuleCreateInfo.setCodeSize(code.size() * sizeof(uint32_t));
-    shaderModuleCreateInfo.setCode(code);
+    shaderModuleCreateInfo.setPCode(code.data());
 
     _module = vk::raii::ShaderModule(device, shaderModuleCreateInfo);
 }
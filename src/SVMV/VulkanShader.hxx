@@ -1,10 +1,14 @@
 #pragma once
 
+#include <SVMV/ShaderCache.hxx>
+#include <SVMV/EmbeddedShaders.hxx>
+
 #include <vulkan/vulkan_raii.hpp>
 #include <shaderc/shaderc.hpp>
 
 #include <fstream>
 #include <sstream>
+#include <span>
 
 namespace SVMV
 {
@@ -18,7 +22,8 @@ namespace SVMV
 
     public:
         VulkanShader() = default;
-        VulkanShader(const vk::raii::Device& device, const shaderc::Compiler& shaderCompiler, ShaderType type, const std::string& file);
+        // embedded SPIR-V is used when the build has it, otherwise the source is compiled unless the shader cache has it already
+        VulkanShader(const vk::raii::Device& device, const shaderc::Compiler& shaderCompiler, ShaderType type, const std::string& file, bool optimize = true);
 
         VulkanShader(const VulkanShader&) = delete;
         VulkanShader& operator=(const VulkanShader&) = delete;
@@ -35,7 +40,7 @@ namespace SVMV
         std::string readFile(const std::string& file);
 
         std::vector<uint32_t> compileShader(const shaderc::Compiler& shaderCompiler, const std::string& name, const std::string& shaderCode, shaderc_shader_kind shaderKind, bool optimize);
-        void createShaderModule(const vk::raii::Device& device, const std::vector<uint32_t> code);
+        void createShaderModule(const vk::raii::Device& device, std::span<const uint32_t> code);
 
         shaderc_shader_kind convertShaderType(ShaderType type);
 
@@ -10,36 +10,121 @@ namespace SVMV
     namespace ShaderStructures
     {
         struct PushConstants
+        {
+            vk::DeviceAddress drawData          { 0 }; // DrawData array
+            vk::DeviceAddress visibleInstances  { 0 }; // instance and draw index pairs written by the culling pass, indexed with the instance index
+            vk::DeviceAddress modelMatrices     { 0 };
+            vk::DeviceAddress normalMatrices    { 0 };
+        };
+
+        struct DrawData
         {
             vk::DeviceAddress positions         { 0 };
             vk::DeviceAddress normals           { 0 };
             vk::DeviceAddress tangents          { 0 };
             vk::DeviceAddress texcoords_0       { 0 };
             vk::DeviceAddress colors_0          { 0 };
-            vk::DeviceAddress modelMatrix       { 0 };
-            vk::DeviceAddress normalMatrix      { 0 };
+
+            uint32_t material                   { 0 }; // index into the material parameters, forwarded to the fragment shader
+            uint32_t padding                    { 0 }; // std430 array stride
         };
 
-        struct GlobalUniformBuffer
+        struct DrawCullData
         {
-            glm::mat4 View              { 1.0f };
-            glm::mat4 ViewProjection    { 1.0f };
-            glm::vec4 CameraPosition    { 0.0f };
+            uint32_t firstIndex         { 0 };
+            uint32_t indexCount         { 0 };
+            uint32_t firstInstance      { 0 }; // first slot of the draw in the visible instances
+            uint32_t batch              { 0 }; // index of the draw count of the batch
+            uint32_t batchFirstDraw     { 0 }; // first command of the batch in the indirect buffer
+        };
 
-            // padding to align to 256 bytes
-            glm::vec4 padding1;
-            glm::vec4 padding2;
-            glm::vec4 padding3;
-            glm::mat4 padding4;
+        struct InstanceCullData
+        {
+            glm::vec4 boundsMin         { 0.0f }; // world space, w set to 1 for instances without bounds that are never culled
+            glm::vec4 boundsMax         { 0.0f };
+
+            uint32_t draw               { 0 };
+            uint32_t matrix             { 0 }; // index into the model and normal matrices
+
+            uint32_t padding[2]         { 0, 0 }; // std430 array stride
         };
 
-        struct LightParametersBuffer
+        struct CullPushConstants
         {
-            glm::vec4 position;
-            glm::vec4 flux;
+            vk::DeviceAddress camera                { 0 }; // GlobalUniformBuffer in the frame allocator
+
+            vk::DeviceAddress cullData              { 0 };
+            vk::DeviceAddress instanceCullData      { 0 };
+            vk::DeviceAddress instanceCounts        { 0 };
+            vk::DeviceAddress visibleInstances      { 0 };
+            vk::DeviceAddress commands              { 0 };
+            vk::DeviceAddress drawCounts            { 0 };
+            vk::DeviceAddress instanceVisibility    { 0 }; // one flag per instance, whether it passed the occlusion test of the previous frame
+            vk::DeviceAddress statistics            { 0 }; // CullStatistics
+
+            glm::uvec2 depthExtent                  { 0 }; // of the depth buffer the depth pyramid was built from
+            uint32_t depthPyramidLevels             { 0 };
+
+            uint32_t drawCount                      { 0 };
+            uint32_t instanceCount                  { 0 };
+            uint32_t flags                          { 0 };
+        }; // stays within the 128 bytes every device supports
 
-            // padding to align to 256 bytes
-            glm::vec4 padding[14];
+        enum CullFlags : uint32_t
+        {
+            CULL_FLAGS_FRUSTUM      = 1 << 0, // without it all instances are kept
+            CULL_FLAGS_COMPACT      = 1 << 1, // draws with visible instances are appended to their batch and counted, otherwise culled draws get an instance count of 0
+            CULL_FLAGS_COMMANDS     = 1 << 2, // second dispatch, writes one command per draw from the counted instances
+            CULL_FLAGS_EARLY        = 1 << 3, // only keeps the instances that were visible in the previous frame
+            CULL_FLAGS_OCCLUSION    = 1 << 4  // tests the instances against the depth pyramid, records their visibility and keeps the visible ones the early pass left out
         };
+
+        struct CullStatistics
+        {
+            uint32_t frustumCulledInstances     { 0 };
+            uint32_t frustumCulledTriangles     { 0 };
+            uint32_t occlusionCulledInstances   { 0 };
+            uint32_t occlusionCulledTriangles   { 0 };
+            uint32_t drawnInstances             { 0 };
+            uint32_t drawnTriangles             { 0 };
+            uint32_t drawnCommands              { 0 }; // indirect commands with at least one visible instance
+            uint32_t padding                    { 0 };
+        }; // summed over the culling passes of a frame
+
+        struct LightClusterPushConstants
+        {
+            glm::mat4 view                      { 1.0f };
+
+            vk::DeviceAddress lights            { 0 };
+            vk::DeviceAddress clusterLights     { 0 };
+
+            glm::vec2 projectionScale           { 1.0f }; // [0][0] and [1][1] of the projection matrix
+            float nearPlane                     { 0.0f };
+            float farPlane                      { 0.0f };
+            uint32_t lightCount                 { 0 };
+        };
+
+        struct PointLight
+        {
+            glm::vec4 position          { 0.0f }; // world space, w is the range beyond which the light contributes nothing
+            glm::vec4 flux              { 0.0f }; // color and strength
+        };
+
+        struct LightUniformBuffer
+        {
+            glm::vec4 ambient                   { 0.0f };
+
+            vk::DeviceAddress lights            { 0 }; // PointLight array in the frame allocator
+            vk::DeviceAddress clusterLights     { 0 }; // light lists of the clusters, written by the clustering pass
+
+            glm::vec4 clusterParameters         { 0.0f }; // x and y scale fragment coordinates to tiles, z and w scale and bias the log of the view depth to slices
+        };
+
+        struct GlobalUniformBuffer
+        {
+            glm::mat4 View              { 1.0f };
+            glm::mat4 ViewProjection    { 1.0f };
+            glm::vec4 CameraPosition    { 0.0f };
+        }; // offsets are aligned by the frame allocator
     }
 }
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include <SVMV/VulkanTextureCache.hxx>
+
+#include <algorithm>
+
+using namespace SVMV;
+
+VulkanTextureCache::VulkanTextureCache(vk::raii::Device* device)
+    : _device(device)
+{
+}
+
+VulkanTextureCache::VulkanTextureCache(VulkanTextureCache&& other) noexcept
+{
+    std::lock_guard<std::mutex> lock(other._mutex);
+
+    this->_device = other._device;
+    this->_images = std::move(other._images);
+    this->_samplers = std::move(other._samplers);
+
+    other._device = nullptr;
+}
+
+VulkanTextureCache& VulkanTextureCache::operator=(VulkanTextureCache&& other) noexcept
+{
+    if (this != &other)
+    {
+        std::scoped_lock lock(_mutex, other._mutex);
+
+        this->_device = other._device;
+        this->_images = std::move(other._images);
+        this->_samplers = std::move(other._samplers);
+
+        other._device = nullptr;
+    }
+
+    return *this;
+}
+
+std::shared_ptr<const VulkanImage> VulkanTextureCache::getImage(const Texture& texture, vk::Format format, const std::function<VulkanImage()>& createImage)
+{
+    ImageKey key;
+    key.hash = SceneCache::hashData(texture.getData(), texture.size);
+    key.size = texture.size;
+    key.width = texture.width;
+    key.height = texture.height;
+    key.encoding = texture.encoding;
+    key.format = format;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto iterator = _images.find(key);
+
+        if (iterator != _images.end())
+        {
+            if (std::shared_ptr<const VulkanImage> image = iterator->second.lock())
+            {
+                return image;
+            }
+        }
+    }
+
+    // uploaded without holding the lock, so releasing scenes on the rendering thread does not wait for it
+    std::shared_ptr<const VulkanImage> image = std::make_shared<const VulkanImage>(createImage());
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    std::weak_ptr<const VulkanImage>& entry = _images[key];
+
+    if (std::shared_ptr<const VulkanImage> existingImage = entry.lock())
+    {
+        return existingImage; // created by another thread in the meantime
+    }
+
+    entry = image;
+
+    return image;
+}
+
+std::shared_ptr<const vk::raii::Sampler> VulkanTextureCache::getSampler(const vk::SamplerCreateInfo& createInfo)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (auto& [cachedCreateInfo, cachedSampler] : _samplers)
+    {
+        if (cachedCreateInfo == createInfo)
+        {
+            if (std::shared_ptr<const vk::raii::Sampler> sampler = cachedSampler.lock())
+            {
+                return sampler;
+            }
+        }
+    }
+
+    std::shared_ptr<const vk::raii::Sampler> sampler = std::make_shared<const vk::raii::Sampler>(*_device, createInfo);
+
+    std::erase_if(_samplers, [&](const auto& entry) { return entry.first == createInfo; }); // an expired entry with the same create info
+    _samplers.emplace_back(createInfo, sampler);
+
+    return sampler;
+}
+
+void VulkanTextureCache::evictUnused()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    std::erase_if(_images, [](const auto& entry) { return entry.second.expired(); });
+    std::erase_if(_samplers, [](const auto& entry) { return entry.second.expired(); });
+}
+
+size_t VulkanTextureCache::getImageCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    return static_cast<size_t>(std::count_if(_images.begin(), _images.end(), [](const auto& entry) { return !entry.second.expired(); }));
+}
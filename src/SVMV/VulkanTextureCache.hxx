@@ -0,0 +1,72 @@
+#pragma once
+
+#include <SVMV/Texture.hxx>
+#include <SVMV/VulkanImage.hxx>
+#include <SVMV/SceneCache.hxx>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <mutex>
+#include <cstdint>
+
+namespace SVMV
+{
+    // images and samplers shared by the materials of every loaded scene, images are matched by the content of their source texture,
+    // so identical images are uploaded once even when they come from different files
+    // the cache only holds weak references, the materials using an entry keep it alive and it is released with the last scene referencing it
+    class VulkanTextureCache
+    {
+    public:
+        VulkanTextureCache() = default;
+        VulkanTextureCache(vk::raii::Device* device);
+
+        VulkanTextureCache(const VulkanTextureCache&) = delete;
+        VulkanTextureCache& operator=(const VulkanTextureCache&) = delete;
+
+        VulkanTextureCache(VulkanTextureCache&& other) noexcept;
+        VulkanTextureCache& operator=(VulkanTextureCache&& other) noexcept;
+
+        ~VulkanTextureCache() = default;
+
+        // createImage is only called when there is no live image with the same content and format
+        std::shared_ptr<const VulkanImage> getImage(const Texture& texture, vk::Format format, const std::function<VulkanImage()>& createImage);
+        std::shared_ptr<const vk::raii::Sampler> getSampler(const vk::SamplerCreateInfo& createInfo);
+
+        void evictUnused(); // drops the entries of released images and samplers, called after a scene is unloaded
+
+        [[nodiscard]] size_t getImageCount() const; // live images
+
+    private:
+        struct ImageKey
+        {
+            uint64_t hash               { 0 };
+            size_t size                 { 0 };
+            uint32_t width              { 0 };
+            uint32_t height             { 0 };
+            TextureEncoding encoding    { TextureEncoding::RGBA8 };
+            vk::Format format           { vk::Format::eUndefined };
+
+            bool operator==(const ImageKey&) const = default;
+        };
+
+        struct ImageKeyHash
+        {
+            size_t operator()(const ImageKey& key) const noexcept
+            {
+                return static_cast<size_t>(key.hash ^ (static_cast<uint64_t>(key.format) << 32));
+            }
+        };
+
+    private:
+        vk::raii::Device* _device   { nullptr };
+
+        std::unordered_map<ImageKey, std::weak_ptr<const VulkanImage>, ImageKeyHash> _images;
+        std::vector<std::pair<vk::SamplerCreateInfo, std::weak_ptr<const vk::raii::Sampler>>> _samplers; // only a handful, searched linearly
+
+        mutable std::mutex _mutex; // scenes are created on the loading thread and released on the rendering thread
+    };
+}
@@ -0,0 +1,651 @@
+#include <SVMV/VulkanUploadManager.hxx>
+
+using namespace SVMV;
+
+namespace
+{
+    vk::Extent3D getLevelExtent(vk::Extent3D extent, uint32_t level)
+    {
+        return vk::Extent3D{ std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u), std::max(extent.depth >> level, 1u) };
+    }
+}
+
+VulkanUploadManager::VulkanUploadManager(
+    vk::raii::Device* device, VmaAllocator vmaAllocator, vk::raii::Queue* transferQueue, unsigned transferQueueFamily,
+    vk::raii::Queue* graphicsQueue, unsigned graphicsQueueFamily, std::mutex* queueMutex, size_t stagingRingSize/* = defaultStagingRingSize*/
+)
+    : _device(device), _allocator(vmaAllocator), _transferQueue(transferQueue), _graphicsQueue(graphicsQueue),
+    _transferQueueFamily(transferQueueFamily), _graphicsQueueFamily(graphicsQueueFamily), _queueMutex(queueMutex)
+{
+    vk::CommandPoolCreateInfo commandPoolCreateInfo;
+    commandPoolCreateInfo.setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer);
+    commandPoolCreateInfo.setQueueFamilyIndex(_transferQueueFamily);
+
+    _transferCommandPool = vk::raii::CommandPool(*_device, commandPoolCreateInfo);
+
+    vk::CommandBufferAllocateInfo commandBufferAllocateInfo;
+    commandBufferAllocateInfo.setLevel(vk::CommandBufferLevel::ePrimary);
+    commandBufferAllocateInfo.setCommandPool(_transferCommandPool);
+    commandBufferAllocateInfo.setCommandBufferCount(batchCount);
+
+    vk::raii::CommandBuffers transferCommandBuffers(*_device, commandBufferAllocateInfo);
+
+    for (size_t i = 0; i < batchCount; i++)
+    {
+        _batches[i].transferCommandBuffer = std::move(transferCommandBuffers[i]);
+    }
+
+    if (isSeparateFamily())
+    {
+        commandPoolCreateInfo.setQueueFamilyIndex(_graphicsQueueFamily);
+
+        _acquireCommandPool = vk::raii::CommandPool(*_device, commandPoolCreateInfo);
+
+        commandBufferAllocateInfo.setCommandPool(_acquireCommandPool);
+
+        vk::raii::CommandBuffers acquireCommandBuffers(*_device, commandBufferAllocateInfo);
+
+        for (size_t i = 0; i < batchCount; i++)
+        {
+            _batches[i].acquireCommandBuffer = std::move(acquireCommandBuffers[i]);
+        }
+    }
+
+    vk::SemaphoreTypeCreateInfo semaphoreTypeCreateInfo;
+    semaphoreTypeCreateInfo.setSemaphoreType(vk::SemaphoreType::eTimeline);
+    semaphoreTypeCreateInfo.setInitialValue(0);
+
+    vk::SemaphoreCreateInfo semaphoreCreateInfo;
+    semaphoreCreateInfo.setPNext(&semaphoreTypeCreateInfo);
+
+    _timelineSemaphore = vk::raii::Semaphore(*_device, semaphoreCreateInfo);
+
+    _stagingRing = VulkanBuffer(_device, _allocator, stagingRingSize, vk::BufferUsageFlagBits::eTransferSrc, true);
+    vmaMapMemory(_allocator, _stagingRing.getAllocation(), reinterpret_cast<void**>(&_stagingRingData));
+}
+
+VulkanUploadManager::VulkanUploadManager(VulkanUploadManager&& other) noexcept
+{
+    this->_device = other._device;
+    this->_allocator = other._allocator;
+    this->_transferQueue = other._transferQueue;
+    this->_graphicsQueue = other._graphicsQueue;
+    this->_transferQueueFamily = other._transferQueueFamily;
+    this->_graphicsQueueFamily = other._graphicsQueueFamily;
+    this->_queueMutex = other._queueMutex;
+    this->_transferCommandPool = std::move(other._transferCommandPool);
+    this->_acquireCommandPool = std::move(other._acquireCommandPool);
+    this->_timelineSemaphore = std::move(other._timelineSemaphore);
+    this->_batches = std::move(other._batches);
+    this->_currentBatch = other._currentBatch;
+    this->_timelineCounter = other._timelineCounter;
+    this->_lastSubmittedValue = other._lastSubmittedValue;
+    this->_stagingRing = std::move(other._stagingRing);
+    this->_stagingRingData = other._stagingRingData;
+    this->_stagingRingHead = other._stagingRingHead;
+    this->_stagingRegions = std::move(other._stagingRegions);
+
+    other._device = nullptr;
+    other._allocator = nullptr;
+    other._transferQueue = nullptr;
+    other._graphicsQueue = nullptr;
+    other._queueMutex = nullptr;
+    other._stagingRingData = nullptr;
+    other._stagingRegions.clear();
+}
+
+VulkanUploadManager& VulkanUploadManager::operator=(VulkanUploadManager&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+
+        this->_device = other._device;
+        this->_allocator = other._allocator;
+        this->_transferQueue = other._transferQueue;
+        this->_graphicsQueue = other._graphicsQueue;
+        this->_transferQueueFamily = other._transferQueueFamily;
+        this->_graphicsQueueFamily = other._graphicsQueueFamily;
+        this->_queueMutex = other._queueMutex;
+        this->_transferCommandPool = std::move(other._transferCommandPool);
+        this->_acquireCommandPool = std::move(other._acquireCommandPool);
+        this->_timelineSemaphore = std::move(other._timelineSemaphore);
+        this->_batches = std::move(other._batches);
+        this->_currentBatch = other._currentBatch;
+        this->_timelineCounter = other._timelineCounter;
+        this->_lastSubmittedValue = other._lastSubmittedValue;
+        this->_stagingRing = std::move(other._stagingRing);
+        this->_stagingRingData = other._stagingRingData;
+        this->_stagingRingHead = other._stagingRingHead;
+        this->_stagingRegions = std::move(other._stagingRegions);
+
+        other._device = nullptr;
+        other._allocator = nullptr;
+        other._transferQueue = nullptr;
+        other._graphicsQueue = nullptr;
+        other._queueMutex = nullptr;
+        other._stagingRingData = nullptr;
+        other._stagingRegions.clear();
+    }
+
+    return *this;
+}
+
+VulkanUploadManager::~VulkanUploadManager()
+{
+    release();
+}
+
+void VulkanUploadManager::uploadBuffer(const VulkanBuffer& destination, const void* data, size_t size, size_t destinationOffset/* = 0*/)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    size_t stagingOffset = 0;
+    vk::Buffer stagingBuffer = getStagingBuffer(data, size, stagingOffset); // may submit the current batch, so it has to happen before recording
+
+    Batch& batch = beginBatch();
+
+    vk::BufferCopy copy;
+    copy.setSize(size);
+    copy.setSrcOffset(stagingOffset);
+    copy.setDstOffset(destinationOffset);
+
+    batch.transferCommandBuffer.copyBuffer(stagingBuffer, *destination.getBuffer(), copy);
+
+    if (isSeparateFamily() && !destination.isConcurrent())
+    {
+        vk::BufferMemoryBarrier releaseBarrier;
+        releaseBarrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+        releaseBarrier.setSrcQueueFamilyIndex(_transferQueueFamily);
+        releaseBarrier.setDstQueueFamilyIndex(_graphicsQueueFamily);
+        releaseBarrier.setBuffer(*destination.getBuffer());
+        releaseBarrier.setOffset(destinationOffset);
+        releaseBarrier.setSize(size);
+
+        batch.bufferReleaseBarriers.push_back(releaseBarrier);
+    }
+}
+
+void VulkanUploadManager::copyBuffer(const VulkanBuffer& source, const VulkanBuffer& destination, size_t size, size_t sourceOffset/* = 0*/, size_t destinationOffset/* = 0*/)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    vmaFlushAllocation(_allocator, source.getAllocation(), sourceOffset, size); // no-op for host-coherent memory
+
+    Batch& batch = beginBatch();
+
+    vk::BufferCopy copy;
+    copy.setSize(size);
+    copy.setSrcOffset(sourceOffset);
+    copy.setDstOffset(destinationOffset);
+
+    batch.transferCommandBuffer.copyBuffer(*source.getBuffer(), *destination.getBuffer(), copy);
+
+    if (isSeparateFamily() && !destination.isConcurrent())
+    {
+        vk::BufferMemoryBarrier releaseBarrier;
+        releaseBarrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+        releaseBarrier.setSrcQueueFamilyIndex(_transferQueueFamily);
+        releaseBarrier.setDstQueueFamilyIndex(_graphicsQueueFamily);
+        releaseBarrier.setBuffer(*destination.getBuffer());
+        releaseBarrier.setOffset(destinationOffset);
+        releaseBarrier.setSize(size);
+
+        batch.bufferReleaseBarriers.push_back(releaseBarrier);
+    }
+}
+
+void VulkanUploadManager::uploadImage(vk::Image image, vk::Extent3D extent, const void* data, size_t size, uint32_t mipLevels/* = 1*/, const std::vector<size_t>& levelOffsets/* = { 0 }*/)
+{
+    uint32_t suppliedLevels = static_cast<uint32_t>(levelOffsets.size());
+
+    if (suppliedLevels == 0 || suppliedLevels > mipLevels)
+    {
+        throw std::runtime_error("upload manager: the image data has to contain between one and all mip levels");
+    }
+
+    size_t stagingOffset = 0;
+    vk::Buffer stagingBuffer = getStagingBuffer(data, size, stagingOffset);
+
+    Batch& batch = beginBatch();
+
+    std::vector<vk::BufferImageCopy> bufferImageCopies(suppliedLevels);
+
+    for (uint32_t level = 0; level < suppliedLevels; level++)
+    {
+        bufferImageCopies[level].setBufferOffset(stagingOffset + levelOffsets[level]);
+        bufferImageCopies[level].setBufferRowLength(0);
+        bufferImageCopies[level].setBufferImageHeight(0);
+        bufferImageCopies[level].setImageSubresource(vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, level, 0, 1 });
+        bufferImageCopies[level].setImageOffset(vk::Offset3D{ 0, 0, 0 });
+        bufferImageCopies[level].setImageExtent(getLevelExtent(extent, level));
+    }
+
+    vk::ImageMemoryBarrier toTransferBarrier;
+    toTransferBarrier.setOldLayout(vk::ImageLayout::eUndefined);
+    toTransferBarrier.setNewLayout(vk::ImageLayout::eTransferDstOptimal);
+    toTransferBarrier.setSrcAccessMask(vk::AccessFlagBits::eNone);
+    toTransferBarrier.setDstAccessMask(vk::AccessFlagBits::eTransferWrite);
+    toTransferBarrier.setImage(image);
+    toTransferBarrier.setSubresourceRange(vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, suppliedLevels, 0, 1 });
+
+    batch.transferCommandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, toTransferBarrier);
+    batch.transferCommandBuffer.copyBufferToImage(stagingBuffer, image, vk::ImageLayout::eTransferDstOptimal, bufferImageCopies);
+
+    // the supplied levels are ready to be sampled, except for the last one when further levels are generated from it
+    uint32_t generatedLevels = mipLevels - suppliedLevels;
+    uint32_t finishedLevels = (generatedLevels > 0) ? suppliedLevels - 1 : suppliedLevels;
+
+    std::vector<vk::ImageMemoryBarrier> barriers;
+
+    if (finishedLevels > 0)
+    {
+        vk::ImageMemoryBarrier toShaderReadBarrier;
+        toShaderReadBarrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal);
+        toShaderReadBarrier.setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+        toShaderReadBarrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+        toShaderReadBarrier.setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+        toShaderReadBarrier.setImage(image);
+        toShaderReadBarrier.setSubresourceRange(vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, finishedLevels, 0, 1 });
+
+        barriers.push_back(toShaderReadBarrier);
+    }
+
+    if (generatedLevels > 0)
+    {
+        vk::ImageMemoryBarrier toTransferSourceBarrier;
+        toTransferSourceBarrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal);
+        toTransferSourceBarrier.setNewLayout(vk::ImageLayout::eTransferSrcOptimal);
+        toTransferSourceBarrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+        toTransferSourceBarrier.setDstAccessMask(vk::AccessFlagBits::eTransferRead);
+        toTransferSourceBarrier.setImage(image);
+        toTransferSourceBarrier.setSubresourceRange(vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, finishedLevels, 1, 0, 1 });
+
+        barriers.push_back(toTransferSourceBarrier);
+    }
+
+    MipGeneration mipGeneration;
+    mipGeneration.image = image;
+    mipGeneration.extent = extent;
+    mipGeneration.firstLevel = suppliedLevels;
+    mipGeneration.levelCount = generatedLevels;
+
+    if (isSeparateFamily())
+    {
+        // the layout transitions happen as part of the ownership transfer, recorded when the batch is flushed,
+        // the generated levels have no contents yet and are only ever touched by the graphics queue
+        for (auto& barrier : barriers)
+        {
+            barrier.setDstAccessMask(vk::AccessFlagBits::eNone);
+            barrier.setSrcQueueFamilyIndex(_transferQueueFamily);
+            barrier.setDstQueueFamilyIndex(_graphicsQueueFamily);
+
+            batch.imageReleaseBarriers.push_back(barrier);
+        }
+
+        if (generatedLevels > 0)
+        {
+            batch.mipGenerations.push_back(mipGeneration);
+        }
+    }
+    else
+    {
+        batch.transferCommandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eFragmentShader, {}, nullptr, nullptr, barriers);
+
+        if (generatedLevels > 0)
+        {
+            recordMipGeneration(batch.transferCommandBuffer, mipGeneration);
+        }
+    }
+}
+
+uint64_t VulkanUploadManager::flush()
+{
+    Batch& batch = _batches[_currentBatch];
+
+    if (!batch.recording)
+    {
+        return _lastSubmittedValue;
+    }
+
+    if (isSeparateFamily())
+    {
+        batch.transferCommandBuffer.pipelineBarrier(
+            vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, nullptr, batch.bufferReleaseBarriers, batch.imageReleaseBarriers
+        );
+    }
+    else
+    {
+        vk::MemoryBarrier memoryBarrier;
+        memoryBarrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+        memoryBarrier.setDstAccessMask(vk::AccessFlagBits::eMemoryRead);
+
+        batch.transferCommandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, {}, memoryBarrier, nullptr, nullptr);
+    }
+
+    batch.transferCommandBuffer.end();
+
+    uint64_t transferValue = ++_timelineCounter;
+
+    vk::TimelineSemaphoreSubmitInfo transferTimelineSubmitInfo;
+    transferTimelineSubmitInfo.setSignalSemaphoreValues(transferValue);
+
+    vk::SubmitInfo transferSubmitInfo;
+    transferSubmitInfo.setCommandBuffers(*batch.transferCommandBuffer);
+    transferSubmitInfo.setSignalSemaphores(*_timelineSemaphore);
+    transferSubmitInfo.setPNext(&transferTimelineSubmitInfo);
+
+    submit(_transferQueue, transferSubmitInfo);
+
+    batch.timelineValue = transferValue;
+
+    if (isSeparateFamily())
+    {
+        // acquire the ownership of everything released above on the graphics queue, once the transfer completed
+        for (auto& barrier : batch.bufferReleaseBarriers)
+        {
+            barrier.setSrcAccessMask(vk::AccessFlagBits::eNone);
+            barrier.setDstAccessMask(vk::AccessFlagBits::eMemoryRead);
+        }
+
+        for (auto& barrier : batch.imageReleaseBarriers)
+        {
+            barrier.setSrcAccessMask(vk::AccessFlagBits::eNone);
+            barrier.setDstAccessMask((barrier.newLayout == vk::ImageLayout::eTransferSrcOptimal) ? vk::AccessFlagBits::eTransferRead : vk::AccessFlagBits::eShaderRead);
+        }
+
+        vk::CommandBufferBeginInfo commandBufferBeginInfo;
+        commandBufferBeginInfo.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+
+        batch.acquireCommandBuffer.reset();
+        batch.acquireCommandBuffer.begin(commandBufferBeginInfo);
+        batch.acquireCommandBuffer.pipelineBarrier(
+            vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eAllCommands, {}, nullptr, batch.bufferReleaseBarriers, batch.imageReleaseBarriers
+        );
+
+        for (const auto& mipGeneration : batch.mipGenerations)
+        {
+            recordMipGeneration(batch.acquireCommandBuffer, mipGeneration);
+        }
+
+        batch.acquireCommandBuffer.end();
+
+        uint64_t acquireValue = ++_timelineCounter;
+        vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eAllCommands;
+
+        vk::TimelineSemaphoreSubmitInfo acquireTimelineSubmitInfo;
+        acquireTimelineSubmitInfo.setWaitSemaphoreValues(transferValue);
+        acquireTimelineSubmitInfo.setSignalSemaphoreValues(acquireValue);
+
+        vk::SubmitInfo acquireSubmitInfo;
+        acquireSubmitInfo.setWaitSemaphores(*_timelineSemaphore);
+        acquireSubmitInfo.setWaitDstStageMask(waitStage);
+        acquireSubmitInfo.setCommandBuffers(*batch.acquireCommandBuffer);
+        acquireSubmitInfo.setSignalSemaphores(*_timelineSemaphore);
+        acquireSubmitInfo.setPNext(&acquireTimelineSubmitInfo);
+
+        submit(_graphicsQueue, acquireSubmitInfo);
+
+        batch.timelineValue = acquireValue;
+    }
+
+    for (auto& region : _stagingRegions)
+    {
+        if (region.timelineValue == 0)
+        {
+            region.timelineValue = batch.timelineValue;
+        }
+    }
+
+    batch.recording = false;
+    _lastSubmittedValue = batch.timelineValue;
+    _currentBatch = (_currentBatch + 1) % batchCount;
+
+    return _lastSubmittedValue;
+}
+
+void VulkanUploadManager::wait(uint64_t timelineValue) const
+{
+    if (timelineValue == 0)
+    {
+        return;
+    }
+
+    vk::SemaphoreWaitInfo semaphoreWaitInfo;
+    semaphoreWaitInfo.setSemaphores(*_timelineSemaphore);
+    semaphoreWaitInfo.setValues(timelineValue);
+
+    vk::Result waitResult = _device->waitSemaphores(semaphoreWaitInfo, UINT64_MAX);
+
+    if (waitResult != vk::Result::eSuccess)
+    {
+        throw std::runtime_error("vulkan: failure waiting for upload semaphore");
+    }
+}
+
+void VulkanUploadManager::waitIdle()
+{
+    wait(flush());
+}
+
+bool VulkanUploadManager::isComplete(uint64_t timelineValue) const
+{
+    return _timelineSemaphore.getCounterValue() >= timelineValue;
+}
+
+VulkanUploadManager::Batch& VulkanUploadManager::beginBatch()
+{
+    Batch& batch = _batches[_currentBatch];
+
+    if (batch.recording)
+    {
+        return batch;
+    }
+
+    wait(batch.timelineValue); // the previous submission of this batch may still be reading its temporary buffers
+
+    batch.temporaryBuffers.clear();
+    batch.bufferReleaseBarriers.clear();
+    batch.imageReleaseBarriers.clear();
+    batch.mipGenerations.clear();
+
+    vk::CommandBufferBeginInfo commandBufferBeginInfo;
+    commandBufferBeginInfo.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+
+    batch.transferCommandBuffer.reset();
+    batch.transferCommandBuffer.begin(commandBufferBeginInfo);
+
+    batch.recording = true;
+
+    return batch;
+}
+
+bool VulkanUploadManager::allocateStaging(size_t size, size_t& offset)
+{
+    if (size > _stagingRing.getSize())
+    {
+        return false;
+    }
+
+    while (true)
+    {
+        uint64_t completedValue = _timelineSemaphore.getCounterValue();
+
+        while (!_stagingRegions.empty() && _stagingRegions.front().timelineValue != 0 && _stagingRegions.front().timelineValue <= completedValue)
+        {
+            _stagingRegions.pop_front();
+        }
+
+        offset = (_stagingRingHead + stagingAlignment - 1) / stagingAlignment * stagingAlignment;
+
+        if (offset + size > _stagingRing.getSize())
+        {
+            offset = 0; // wrap around, the rest of the ring stays unused in this round
+        }
+
+        bool blocked = false;
+        bool blockedByCurrentBatch = false;
+        uint64_t blockingValue = 0;
+
+        for (const auto& region : _stagingRegions)
+        {
+            if (offset < region.end && region.begin < offset + size)
+            {
+                blocked = true;
+                blockedByCurrentBatch |= (region.timelineValue == 0);
+                blockingValue = (region.timelineValue > blockingValue) ? region.timelineValue : blockingValue;
+            }
+        }
+
+        if (!blocked)
+        {
+            break;
+        }
+
+        if (blockedByCurrentBatch)
+        {
+            blockingValue = flush();
+        }
+
+        wait(blockingValue);
+    }
+
+    _stagingRegions.push_back(StagingRegion{ offset, offset + size, 0 });
+    _stagingRingHead = offset + size;
+
+    return true;
+}
+
+vk::Buffer VulkanUploadManager::getStagingBuffer(const void* data, size_t size, size_t& offset)
+{
+    if (allocateStaging(size, offset))
+    {
+        memcpy(_stagingRingData + offset, data, size);
+        vmaFlushAllocation(_allocator, _stagingRing.getAllocation(), offset, size); // no-op for host-coherent memory
+
+        return *_stagingRing.getBuffer();
+    }
+
+    // larger than the whole ring, staged through a buffer of its own that lives until the batch completes
+    Batch& batch = beginBatch();
+
+    VulkanStagingBuffer temporaryBuffer(_device, nullptr, _allocator, size);
+    temporaryBuffer.pushData(data, size);
+    vmaFlushAllocation(_allocator, temporaryBuffer.getAllocation(), 0, size);
+
+    batch.temporaryBuffers.push_back(std::move(temporaryBuffer));
+
+    offset = 0;
+
+    return *batch.temporaryBuffers.back().getBuffer();
+}
+
+void VulkanUploadManager::submit(vk::raii::Queue* queue, const vk::SubmitInfo& submitInfo)
+{
+    if (_queueMutex != nullptr)
+    {
+        std::lock_guard<std::mutex> lock(*_queueMutex);
+
+        queue->submit(submitInfo);
+    }
+    else
+    {
+        queue->submit(submitInfo);
+    }
+}
+
+void VulkanUploadManager::release() noexcept
+{
+    if (_device == nullptr)
+    {
+        return;
+    }
+
+    try
+    {
+        wait(_lastSubmittedValue);
+    }
+    catch (...)
+    {
+        // nothing sensible to do while destroying, the device is most likely lost
+    }
+
+    if (_stagingRingData != nullptr)
+    {
+        vmaUnmapMemory(_allocator, _stagingRing.getAllocation());
+    }
+
+    _stagingRingData = nullptr;
+    _stagingRegions.clear();
+    _stagingRing = VulkanBuffer();
+
+    for (auto& batch : _batches)
+    {
+        batch = Batch();
+    }
+
+    _timelineSemaphore.clear();
+    _acquireCommandPool.clear();
+    _transferCommandPool.clear();
+
+    _device = nullptr;
+}
+
+void VulkanUploadManager::recordMipGeneration(const vk::raii::CommandBuffer& commandBuffer, const MipGeneration& mipGeneration) const
+{
+    vk::ImageMemoryBarrier toTransferBarrier;
+    toTransferBarrier.setOldLayout(vk::ImageLayout::eUndefined);
+    toTransferBarrier.setNewLayout(vk::ImageLayout::eTransferDstOptimal);
+    toTransferBarrier.setSrcAccessMask(vk::AccessFlagBits::eNone);
+    toTransferBarrier.setDstAccessMask(vk::AccessFlagBits::eTransferWrite);
+    toTransferBarrier.setImage(mipGeneration.image);
+    toTransferBarrier.setSubresourceRange(vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, mipGeneration.firstLevel, mipGeneration.levelCount, 0, 1 });
+
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, toTransferBarrier);
+
+    uint32_t endLevel = mipGeneration.firstLevel + mipGeneration.levelCount;
+
+    for (uint32_t level = mipGeneration.firstLevel; level < endLevel; level++)
+    {
+        vk::Extent3D sourceExtent = getLevelExtent(mipGeneration.extent, level - 1);
+        vk::Extent3D destinationExtent = getLevelExtent(mipGeneration.extent, level);
+
+        vk::ImageBlit imageBlit;
+        imageBlit.setSrcSubresource(vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, level - 1, 0, 1 });
+        imageBlit.setSrcOffsets({ vk::Offset3D{ 0, 0, 0 }, vk::Offset3D{ static_cast<int32_t>(sourceExtent.width), static_cast<int32_t>(sourceExtent.height), 1 } });
+        imageBlit.setDstSubresource(vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, level, 0, 1 });
+        imageBlit.setDstOffsets({ vk::Offset3D{ 0, 0, 0 }, vk::Offset3D{ static_cast<int32_t>(destinationExtent.width), static_cast<int32_t>(destinationExtent.height), 1 } });
+
+        // sRGB formats are filtered in linear space by the blit
+        commandBuffer.blitImage(mipGeneration.image, vk::ImageLayout::eTransferSrcOptimal, mipGeneration.image, vk::ImageLayout::eTransferDstOptimal, imageBlit, vk::Filter::eLinear);
+
+        // the source level is done, the new one is the source of the next blit
+        vk::ImageMemoryBarrier levelBarriers[2];
+        levelBarriers[0].setOldLayout(vk::ImageLayout::eTransferSrcOptimal);
+        levelBarriers[0].setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal);
+        levelBarriers[0].setSrcAccessMask(vk::AccessFlagBits::eTransferRead);
+        levelBarriers[0].setDstAccessMask(vk::AccessFlagBits::eShaderRead);
+        levelBarriers[0].setImage(mipGeneration.image);
+        levelBarriers[0].setSubresourceRange(vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, level - 1, 1, 0, 1 });
+
+        levelBarriers[1].setOldLayout(vk::ImageLayout::eTransferDstOptimal);
+        levelBarriers[1].setNewLayout((level + 1 < endLevel) ? vk::ImageLayout::eTransferSrcOptimal : vk::ImageLayout::eShaderReadOnlyOptimal);
+        levelBarriers[1].setSrcAccessMask(vk::AccessFlagBits::eTransferWrite);
+        levelBarriers[1].setDstAccessMask((level + 1 < endLevel) ? vk::AccessFlagBits::eTransferRead : vk::AccessFlagBits::eShaderRead);
+        levelBarriers[1].setImage(mipGeneration.image);
+        levelBarriers[1].setSubresourceRange(vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, level, 1, 0, 1 });
+
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eFragmentShader, {}, nullptr, nullptr, levelBarriers);
+    }
+}
+
+bool VulkanUploadManager::isSeparateFamily() const noexcept
+{
+    return _transferQueueFamily != _graphicsQueueFamily;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <SVMV/VulkanBuffer.hxx>
+
+#include <vulkan/vulkan_raii.hpp>
+#include <vk_mem_alloc.h>
+
+#include <array>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace SVMV
+{
+    // records buffer and image uploads into batches that are submitted together, preferably to a dedicated transfer queue;
+    // completion is tracked with a timeline semaphore and data is staged through a fixed-size ring that is reused once the batches reading it complete
+    // not thread-safe, all calls have to come from the same thread (which does not have to be the rendering thread)
+    class VulkanUploadManager
+    {
+    public:
+        static constexpr size_t defaultStagingRingSize = 64 * 1024 * 1024;
+
+        VulkanUploadManager() = default;
+        VulkanUploadManager(
+            vk::raii::Device* device, VmaAllocator vmaAllocator, vk::raii::Queue* transferQueue, unsigned transferQueueFamily,
+            vk::raii::Queue* graphicsQueue, unsigned graphicsQueueFamily, std::mutex* queueMutex, size_t stagingRingSize = defaultStagingRingSize
+        ); // queueMutex guards all submissions, as the queues are shared with the renderer
+
+        VulkanUploadManager(const VulkanUploadManager&) = delete;
+        VulkanUploadManager& operator=(const VulkanUploadManager&) = delete;
+
+        VulkanUploadManager(VulkanUploadManager&& other) noexcept;
+        VulkanUploadManager& operator=(VulkanUploadManager&& other) noexcept;
+
+        ~VulkanUploadManager();
+
+        void uploadBuffer(const VulkanBuffer& destination, const void* data, size_t size, size_t destinationOffset = 0);
+        void copyBuffer(const VulkanBuffer& source, const VulkanBuffer& destination, size_t size, size_t sourceOffset = 0, size_t destinationOffset = 0); // the source has to stay alive until the upload completes
+        // whole color image, left in the shader read-only layout; levelOffsets locate the mip levels supplied in the data,
+        // the remaining levels up to mipLevels are generated with linear blits on the graphics queue, which needs the transfer source usage
+        void uploadImage(vk::Image image, vk::Extent3D extent, const void* data, size_t size, uint32_t mipLevels = 1, const std::vector<size_t>& levelOffsets = { 0 });
+
+        uint64_t flush(); // submits the recorded uploads, returns the timeline value that is reached once they are visible to the graphics queue
+        void wait(uint64_t timelineValue) const;
+        void waitIdle(); // flushes and waits for all uploads
+
+        [[nodiscard]] bool isComplete(uint64_t timelineValue) const;
+
+    private:
+        struct MipGeneration
+        {
+            vk::Image image         { nullptr };
+            vk::Extent3D extent     { 0, 0, 0 };
+            uint32_t firstLevel     { 0 }; // blitted from the level before, which is in the transfer source layout
+            uint32_t levelCount     { 0 };
+        };
+
+        struct Batch
+        {
+            vk::raii::CommandBuffer transferCommandBuffer   { nullptr };
+            vk::raii::CommandBuffer acquireCommandBuffer    { nullptr }; // graphics queue side of the ownership transfers, unused when both queues share a family
+
+            uint64_t timelineValue  { 0 }; // reached once the previous submission of this batch completed
+            bool recording          { false };
+
+            std::vector<VulkanStagingBuffer> temporaryBuffers; // staging for uploads that do not fit into the ring
+
+            std::vector<vk::BufferMemoryBarrier> bufferReleaseBarriers;
+            std::vector<vk::ImageMemoryBarrier> imageReleaseBarriers;
+
+            std::vector<MipGeneration> mipGenerations; // blits need a graphics queue, so they follow the acquire barriers of a separate transfer family
+        };
+
+        struct StagingRegion
+        {
+            size_t begin            { 0 };
+            size_t end              { 0 };
+            uint64_t timelineValue  { 0 }; // 0 while the batch using the region has not been submitted yet
+        };
+
+        static constexpr size_t batchCount = 3;
+        static constexpr size_t stagingAlignment = 16; // covers the texel block sizes of all used formats
+
+        Batch& beginBatch();
+        bool allocateStaging(size_t size, size_t& offset); // false if the size exceeds the ring
+        vk::Buffer getStagingBuffer(const void* data, size_t size, size_t& offset); // copies the data into the ring or a temporary buffer
+
+        void submit(vk::raii::Queue* queue, const vk::SubmitInfo& submitInfo);
+        void recordMipGeneration(const vk::raii::CommandBuffer& commandBuffer, const MipGeneration& mipGeneration) const;
+
+        void release() noexcept;
+
+        [[nodiscard]] bool isSeparateFamily() const noexcept;
+
+    private:
+        vk::raii::Device* _device           { nullptr };
+        VmaAllocator _allocator             { nullptr };
+
+        vk::raii::Queue* _transferQueue     { nullptr };
+        vk::raii::Queue* _graphicsQueue     { nullptr };
+        unsigned _transferQueueFamily       { 0 };
+        unsigned _graphicsQueueFamily       { 0 };
+        std::mutex* _queueMutex             { nullptr };
+
+        vk::raii::CommandPool _transferCommandPool  { nullptr };
+        vk::raii::CommandPool _acquireCommandPool   { nullptr };
+        vk::raii::Semaphore _timelineSemaphore      { nullptr };
+
+        std::array<Batch, batchCount> _batches;
+        size_t _currentBatch            { 0 };
+        uint64_t _timelineCounter       { 0 }; // last value handed out to a submission
+        uint64_t _lastSubmittedValue    { 0 };
+
+        VulkanBuffer _stagingRing;
+        std::byte* _stagingRingData     { nullptr };
+        size_t _stagingRingHead         { 0 };
+        std::deque<StagingRegion> _stagingRegions; // in allocation order
+    };
+}
@@ -190,13 +190,20 @@ std::shared_ptr<vk::raii::DescriptorPool> VulkanUtilities::DescriptorAllocator::
 
 std::shared_ptr<vk::raii::DescriptorPool> VulkanUtilities::DescriptorAllocator::createPool()
 {
-    vk::DescriptorPoolSize poolSizes[2];
+    vk::DescriptorPoolSize poolSizes[4];
     poolSizes[0].setType(vk::DescriptorType::eUniformBuffer);
     poolSizes[0].setDescriptorCount(_setsPerPool);
 
     poolSizes[1].setType(vk::DescriptorType::eCombinedImageSampler);
     poolSizes[1].setDescriptorCount(_setsPerPool);
 
+    // per-frame data from the frame allocator
+    poolSizes[2].setType(vk::DescriptorType::eUniformBufferDynamic);
+    poolSizes[2].setDescriptorCount(_setsPerPool);
+
+    poolSizes[3].setType(vk::DescriptorType::eStorageBufferDynamic);
+    poolSizes[3].setDescriptorCount(_setsPerPool);
+
     vk::DescriptorPoolCreateInfo info;
     info.setMaxSets(_setsPerPool);
     info.setPoolSizes(poolSizes);
@@ -265,16 +272,18 @@ VmaAllocator VulkanUtilities::VmaAllocatorWrapper::getAllocator() const noexcept
     return _allocator;
 }
 
-vk::raii::Pipeline VulkanUtilities::createPipeline(const vk::raii::Device& device, const vk::raii::PipelineLayout& pipelineLayout, const vk::raii::RenderPass& renderPass, const vk::raii::ShaderModule& vertexShader, const vk::raii::ShaderModule& fragmentShader)
+vk::raii::Pipeline VulkanUtilities::createPipeline(const vk::raii::Device& device, const vk::raii::PipelineCache& pipelineCache, const vk::raii::PipelineLayout& pipelineLayout, const vk::raii::RenderPass& renderPass, const vk::raii::ShaderModule& vertexShader, const vk::raii::ShaderModule& fragmentShader, const vk::SpecializationInfo* specializationInfo/* = nullptr*/)
 {
     vk::PipelineShaderStageCreateInfo shaderStages[2];
     shaderStages[0].setStage(vk::ShaderStageFlagBits::eVertex);
     shaderStages[0].setModule(vertexShader);
     shaderStages[0].setPName("main");
+    shaderStages[0].setPSpecializationInfo(specializationInfo);
 
     shaderStages[1].setStage(vk::ShaderStageFlagBits::eFragment);
     shaderStages[1].setModule(fragmentShader);
     shaderStages[1].setPName("main");
+    shaderStages[1].setPSpecializationInfo(specializationInfo);
 
     vk::PipelineVertexInputStateCreateInfo vertexInputStateInfo;
     vertexInputStateInfo.setVertexBindingDescriptionCount(0);
@@ -344,5 +353,19 @@ vk::raii::Pipeline VulkanUtilities::createPipeline(const vk::raii::Device& devic
     pipelineInfo.setRenderPass(renderPass);
     pipelineInfo.setSubpass(0);
 
-    return vk::raii::Pipeline(device, nullptr, pipelineInfo);
+    return vk::raii::Pipeline(device, pipelineCache, pipelineInfo);
+}
+
+vk::raii::Pipeline VulkanUtilities::createComputePipeline(const vk::raii::Device& device, const vk::raii::PipelineCache& pipelineCache, const vk::raii::PipelineLayout& pipelineLayout, const vk::raii::ShaderModule& computeShader)
+{
+    vk::PipelineShaderStageCreateInfo shaderStage;
+    shaderStage.setStage(vk::ShaderStageFlagBits::eCompute);
+    shaderStage.setModule(computeShader);
+    shaderStage.setPName("main");
+
+    vk::ComputePipelineCreateInfo pipelineInfo;
+    pipelineInfo.setStage(shaderStage);
+    pipelineInfo.setLayout(pipelineLayout);
+
+    return vk::raii::Pipeline(device, pipelineCache, pipelineInfo);
 }
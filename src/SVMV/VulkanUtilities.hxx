@@ -89,6 +89,7 @@ namespace SVMV
             VmaAllocator _allocator{ nullptr };
         };
 
-        vk::raii::Pipeline createPipeline(const vk::raii::Device& device, const vk::raii::PipelineLayout& pipelineLayout, const vk::raii::RenderPass& renderPass, const vk::raii::ShaderModule& vertexShader, const vk::raii::ShaderModule& fragmentShader);
+        vk::raii::Pipeline createPipeline(const vk::raii::Device& device, const vk::raii::PipelineCache& pipelineCache, const vk::raii::PipelineLayout& pipelineLayout, const vk::raii::RenderPass& renderPass, const vk::raii::ShaderModule& vertexShader, const vk::raii::ShaderModule& fragmentShader, const vk::SpecializationInfo* specializationInfo = nullptr); // the specialization applies to both stages
+        vk::raii::Pipeline createComputePipeline(const vk::raii::Device& device, const vk::raii::PipelineCache& pipelineCache, const vk::raii::PipelineLayout& pipelineLayout, const vk::raii::ShaderModule& computeShader);
     }
 }
\ No newline at end of file
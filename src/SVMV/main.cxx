@@ -1,17 +1,202 @@
 #include <SVMV/Application.hxx>
+#include <SVMV/HeadlessApplication.hxx>
+
+#include <string>
+#include <iostream>
+#include <stdexcept>
+
+namespace
+{
+    // printed for invalid arguments
+    constexpr const char* usage =
+        "usage: SVMV [file] [--lights count] [--occlusion] [--cpu-culling] [--threads count] [--no-cache] [--stream-geometry] [--compress-textures] "
+        "[--headless [--out file.png] [--camera x y z pitch yaw] [--size width height] [--frames count]]";
+
+    const char* takeValue(int argc, char** argv, int& i, const std::string& option)
+    {
+        if (i + 1 >= argc)
+        {
+            throw std::runtime_error("missing value for " + option);
+        }
+
+        return argv[++i];
+    }
+
+    // the whole value has to be a number, so a flag following an option with too few values is not read as one
+    int parseInt(const char* value, const std::string& option, int minimum)
+    {
+        size_t length = 0;
+        int result = 0;
+
+        try
+        {
+            result = std::stoi(value, &length);
+        }
+        catch (const std::exception&)
+        {
+            length = 0;
+        }
+
+        if (length == 0 || value[length] != '\0')
+        {
+            throw std::runtime_error("invalid value for " + option + ": " + value);
+        }
+
+        if (result < minimum)
+        {
+            throw std::runtime_error(option + " has to be at least " + std::to_string(minimum));
+        }
+
+        return result;
+    }
+
+    float parseFloat(const char* value, const std::string& option)
+    {
+        size_t length = 0;
+        float result = 0.0f;
+
+        try
+        {
+            result = std::stof(value, &length);
+        }
+        catch (const std::exception&)
+        {
+            length = 0;
+        }
+
+        if (length == 0 || value[length] != '\0')
+        {
+            throw std::runtime_error("invalid value for " + option + ": " + value);
+        }
+
+        return result;
+    }
+
+    void parseArguments(int argc, char** argv, bool& headless, SVMV::HeadlessApplication::Options& options)
+    {
+        std::string headlessOption; // the window has its own camera and size, and renders until it is closed
+
+        for (int i = 1; i < argc; i++)
+        {
+            std::string argument = argv[i];
+
+            if (argument == "--out" || argument == "--camera" || argument == "--size" || argument == "--frames")
+            {
+                headlessOption = argument;
+            }
+
+            if (argument == "--headless")
+            {
+                headless = true;
+            }
+            else if (argument == "--out")
+            {
+                options.outputFile = takeValue(argc, argv, i, argument);
+            }
+            else if (argument == "--camera")
+            {
+                options.cameraPosition.x = parseFloat(takeValue(argc, argv, i, argument), argument);
+                options.cameraPosition.y = parseFloat(takeValue(argc, argv, i, argument), argument);
+                options.cameraPosition.z = parseFloat(takeValue(argc, argv, i, argument), argument);
+                options.cameraPitch = parseFloat(takeValue(argc, argv, i, argument), argument);
+                options.cameraYaw = parseFloat(takeValue(argc, argv, i, argument), argument);
+            }
+            else if (argument == "--size")
+            {
+                options.width = parseInt(takeValue(argc, argv, i, argument), argument, 1);
+                options.height = parseInt(takeValue(argc, argv, i, argument), argument, 1);
+            }
+            else if (argument == "--frames")
+            {
+                options.frameCount = parseInt(takeValue(argc, argv, i, argument), argument, 1);
+            }
+            else if (argument == "--lights")
+            {
+                options.lightCount = parseInt(takeValue(argc, argv, i, argument), argument, 0);
+            }
+            else if (argument == "--occlusion")
+            {
+                options.occlusionCulling = true;
+            }
+            else if (argument == "--cpu-culling")
+            {
+                options.hostCulling = true;
+            }
+            else if (argument == "--threads")
+            {
+                options.loadOptions.threadCount = static_cast<unsigned>(parseInt(takeValue(argc, argv, i, argument), argument, 1));
+            }
+            else if (argument == "--no-cache")
+            {
+                options.loadOptions.useSceneCache = false;
+            }
+            else if (argument == "--stream-geometry")
+            {
+                options.loadOptions.deferGeometry = true;
+            }
+            else if (argument == "--compress-textures")
+            {
+                options.loadOptions.compressTextures = true;
+            }
+            else if (argument.starts_with("--"))
+            {
+                throw std::runtime_error("unknown option " + argument);
+            }
+            else
+            {
+                options.fileToLoad = argument;
+            }
+        }
+
+        if (!headless && !headlessOption.empty())
+        {
+            throw std::runtime_error(headlessOption + " requires --headless");
+        }
+    }
+}
 
 int main(int argc, char** argv)
 {
-    if (argc > 1)
+    bool headless = false;
+    SVMV::HeadlessApplication::Options options;
+
+    try
     {
-        SVMV::Application application(800, 600, "SVMV", argv[1]);
+        parseArguments(argc, argv, headless, options);
     }
-    else
+    catch (const std::exception& exception)
     {
-        SVMV::Application application(800, 600, "SVMV", "");
+        std::cerr << "SVMV: " << exception.what() << std::endl << usage << std::endl;
+
+        return 1;
     }
 
-    glfwTerminate(); // TODO: move this somewhere out of main
+    if (headless)
+    {
+        // a failed load or save has to fail the run, the output would look valid otherwise
+        try
+        {
+            SVMV::HeadlessApplication application(options);
+        }
+        catch (const std::exception& exception)
+        {
+            std::cerr << "SVMV: " << exception.what() << std::endl;
+
+            return 1;
+        }
+    }
+    else
+    {
+        SVMV::Application::Options applicationOptions;
+        applicationOptions.lightCount = options.lightCount;
+        applicationOptions.occlusionCulling = options.occlusionCulling;
+        applicationOptions.hostCulling = options.hostCulling;
+        applicationOptions.loadOptions = options.loadOptions;
+
+        SVMV::Application application(800, 600, "SVMV", options.fileToLoad, applicationOptions);
+
+        glfwTerminate(); // TODO: move this somewhere out of main
+    }
 
     return 0;
 }